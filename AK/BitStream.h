@@ -39,19 +39,18 @@ public:
     {
     }
 
+    // NOTE: Any bits of a partially consumed byte are dropped before reading whole bytes.
     size_t read(Bytes bytes) override
     {
         if (has_any_error())
             return 0;
 
-        size_t nread = 0;
-        if (bytes.size() >= 1) {
-            if (m_next_byte.has_value()) {
-                bytes[0] = m_next_byte.value();
-                m_next_byte.clear();
+        align_to_byte_boundary();
 
-                ++nread;
-            }
+        size_t nread = 0;
+        while (nread < bytes.size() && m_bit_count > 0) {
+            bytes[nread++] = static_cast<u8>(m_bit_buffer);
+            discard_bits(8);
         }
 
         return nread + m_stream.read(bytes.slice(nread));
@@ -67,15 +66,15 @@ public:
         return true;
     }
 
-    bool unreliable_eof() const override { return !m_next_byte.has_value() && m_stream.unreliable_eof(); }
+    bool unreliable_eof() const override { return m_bit_count == 0 && m_stream.unreliable_eof(); }
 
     bool discard_or_error(size_t count) override
     {
-        if (count >= 1) {
-            if (m_next_byte.has_value()) {
-                m_next_byte.clear();
-                --count;
-            }
+        align_to_byte_boundary();
+
+        while (count > 0 && m_bit_count > 0) {
+            discard_bits(8);
+            --count;
         }
 
         return m_stream.discard_or_error(count);
@@ -83,39 +82,59 @@ public:
 
     u32 read_bits(size_t count)
     {
-        u32 result = 0;
-
-        size_t nread = 0;
-        while (nread < count) {
-            if (m_stream.has_any_error()) {
-                set_fatal_error();
-                return 0;
-            }
-
-            if (m_next_byte.has_value()) {
-                const auto bit = (m_next_byte.value() >> m_bit_offset) & 1;
-                result |= bit << nread;
-                ++nread;
+        VERIFY(count <= 32);
 
-                if (m_bit_offset++ == 7)
-                    m_next_byte.clear();
-            } else {
-                m_stream >> m_next_byte;
-                m_bit_offset = 0;
-            }
+        if (!try_fill_bits(count)) {
+            set_fatal_error();
+            return 0;
         }
 
+        const auto result = peek_bits(count);
+        discard_bits(count);
         return result;
     }
 
     bool read_bit() { return static_cast<bool>(read_bits(1)); }
 
-    void align_to_byte_boundary()
+    // Pulls bytes from the underlying stream (one at a time, so we never read past what the caller
+    // actually consumes) until at least count bits are buffered.
+    bool try_fill_bits(size_t count)
     {
-        if (m_next_byte.has_value())
-            m_next_byte.clear();
+        VERIFY(count <= max_buffered_bits);
+
+        while (m_bit_count < count) {
+            if (m_stream.has_any_error())
+                return false;
+
+            u8 byte;
+            if (m_stream.read({ &byte, sizeof(byte) }) != sizeof(byte))
+                return false;
+
+            m_bit_buffer |= static_cast<u64>(byte) << m_bit_count;
+            m_bit_count += 8;
+        }
+
+        return true;
     }
 
+    // Bits past buffered_bit_count() read as zero.
+    u32 peek_bits(size_t count) const
+    {
+        VERIFY(count <= 32);
+        return static_cast<u32>(m_bit_buffer & ((1ull << count) - 1));
+    }
+
+    void discard_bits(size_t count)
+    {
+        VERIFY(count <= m_bit_count);
+        m_bit_buffer >>= count;
+        m_bit_count -= count;
+    }
+
+    size_t buffered_bit_count() const { return m_bit_count; }
+
+    void align_to_byte_boundary() { discard_bits(m_bit_count % 8); }
+
     bool handle_any_error() override
     {
         bool handled_errors = m_stream.handle_any_error();
@@ -123,8 +142,10 @@ public:
     }
 
 private:
-    Optional<u8> m_next_byte;
-    size_t m_bit_offset { 0 };
+    static constexpr size_t max_buffered_bits = 64 - 8;
+
+    u64 m_bit_buffer { 0 };
+    size_t m_bit_count { 0 };
     InputStream& m_stream;
 };
 
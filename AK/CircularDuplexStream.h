@@ -116,6 +116,31 @@ public:
     bool unreliable_eof() const override { return eof(); }
     bool eof() const { return m_queue.size() == 0; }
 
+    size_t remaining_space() const { return Capacity - m_queue.size(); }
+
+    // Appends count bytes starting seekback bytes behind the end of the stream, the source may overlap the
+    // bytes that are being appended (which is how LZ77 encodes runs).
+    bool copy_from_seekback(size_t seekback, size_t count)
+    {
+        if (seekback == 0 || seekback > Capacity || seekback > m_total_written || count > remaining_space()) {
+            set_recoverable_error();
+            return false;
+        }
+
+        auto* storage = m_queue.elements();
+        auto source = (m_total_written - seekback) % Capacity;
+        auto destination = m_total_written % Capacity;
+        for (size_t idx = 0; idx < count; ++idx) {
+            storage[destination] = storage[source];
+            source = source + 1 == Capacity ? 0 : source + 1;
+            destination = destination + 1 == Capacity ? 0 : destination + 1;
+        }
+
+        m_queue.m_size += count;
+        m_total_written += count;
+        return true;
+    }
+
     size_t remaining_contigous_space() const
     {
         return min(Capacity - m_queue.size(), m_queue.capacity() - (m_queue.head_index() + m_queue.size()) % Capacity);
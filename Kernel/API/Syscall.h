@@ -193,7 +193,8 @@ namespace Kernel {
     S(anon_create)            \
     S(msyscall)               \
     S(readv)                  \
-    S(emuctl)
+    S(emuctl)                 \
+    S(sendfile)
 
 namespace Syscall {
 
@@ -248,6 +249,13 @@ struct SC_mmap_params {
     StringArgument name;
 };
 
+struct SC_sendfile_params {
+    int out_fd;
+    int in_fd;
+    int64_t* offset;
+    size_t count;
+};
+
 struct SC_mremap_params {
     uintptr_t old_address;
     size_t old_size;
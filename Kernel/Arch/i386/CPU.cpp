@@ -831,6 +831,10 @@ FlatPtr read_cr3()
 
 void write_cr3(FlatPtr cr3)
 {
+    // Publish the new page directory before loading it. Loading CR3 serializes, so a TLB shootdown
+    // that doesn't see this store yet can count on this processor picking up the new mappings.
+    if (Processor::is_initialized())
+        Processor::current().set_active_cr3(cr3);
     // NOTE: If you're here from a GPF crash, it's very likely that a PDPT entry is incorrect, not this!
 #if ARCH(I386)
     asm volatile("mov %%eax, %%cr3" ::"a"(cr3)
@@ -1154,6 +1158,7 @@ UNMAP_AFTER_INIT void Processor::early_initialize(u32 cpu)
     m_scheduler_initialized = false;
 
     m_message_queue = nullptr;
+    m_active_cr3 = read_cr3();
     m_idle_thread = nullptr;
     m_current_thread = nullptr;
     m_scheduler_data = nullptr;
@@ -1821,10 +1826,26 @@ void Processor::flush_tlb_local(VirtualAddress vaddr, size_t page_count)
 
 void Processor::flush_tlb(const PageDirectory* page_directory, VirtualAddress vaddr, size_t page_count)
 {
-    if (s_smp_enabled && (!is_user_address(vaddr) || Process::current()->thread_count() > 1))
-        smp_broadcast_flush_tlb(page_directory, vaddr, page_count);
-    else
-        flush_tlb_local(vaddr, page_count);
+    TLBFlushRange range { vaddr.as_ptr(), page_count };
+    flush_tlb(page_directory, &range, 1);
+}
+
+void Processor::flush_tlb(const PageDirectory* page_directory, const TLBFlushRange* ranges, size_t range_count)
+{
+    // Kernel mappings are shared by all page directories, so every processor needs to flush those.
+    if (range_count && !is_user_address(VirtualAddress(ranges[0].ptr)))
+        page_directory = nullptr;
+
+    if (s_smp_enabled) {
+        smp_broadcast_flush_tlb(page_directory, ranges, range_count);
+        return;
+    }
+    if (!range_count) {
+        flush_entire_tlb_local();
+        return;
+    }
+    for (size_t i = 0; i < range_count; ++i)
+        flush_tlb_local(VirtualAddress(ranges[i].ptr), ranges[i].page_count);
 }
 
 static volatile ProcessorMessage* s_message_pool;
@@ -1866,6 +1887,8 @@ ProcessorMessage& Processor::smp_get_from_pool()
 }
 
 Atomic<u32> Processor::s_idle_cpu_mask { 0 };
+Atomic<u32, AK::MemoryOrder::memory_order_relaxed> Processor::s_tlb_shootdowns_sent { 0 };
+Atomic<u32, AK::MemoryOrder::memory_order_relaxed> Processor::s_tlb_shootdowns_avoided { 0 };
 
 u32 Processor::smp_wake_n_idle_processors(u32 wake_count)
 {
@@ -1988,16 +2011,21 @@ bool Processor::smp_process_pending_messages()
                 msg->callback_with_data.handler(msg->callback_with_data.data);
                 break;
             case ProcessorMessage::FlushTlb:
-                if (is_user_address(VirtualAddress(msg->flush_tlb.ptr))) {
+                if (msg->flush_tlb.page_directory && read_cr3() != msg->flush_tlb.page_directory->cr3()) {
+                    // We switched away from this page directory since the request was sent, which already flushed our TLB
+                    dbgln_if(SMP_DEBUG, "SMP[{}]: No need to flush {} range(s)", id(), msg->flush_tlb.range_count);
+                    break;
+                }
+                if (!msg->flush_tlb.range_count) {
+                    flush_entire_tlb_local();
+                    break;
+                }
+                for (size_t i = 0; i < msg->flush_tlb.range_count; ++i) {
+                    auto& range = msg->flush_tlb.ranges[i];
                     // We assume that we don't cross into kernel land!
-                    VERIFY(is_user_range(VirtualAddress(msg->flush_tlb.ptr), msg->flush_tlb.page_count * PAGE_SIZE));
-                    if (read_cr3() != msg->flush_tlb.page_directory->cr3()) {
-                        // This processor isn't using this page directory right now, we can ignore this request
-                        dbgln_if(SMP_DEBUG, "SMP[{}]: No need to flush {} pages at {}", id(), msg->flush_tlb.page_count, VirtualAddress(msg->flush_tlb.ptr));
-                        break;
-                    }
+                    VERIFY(!msg->flush_tlb.page_directory || is_user_range(VirtualAddress(range.ptr), range.page_count * PAGE_SIZE));
+                    flush_tlb_local(VirtualAddress(range.ptr), range.page_count);
                 }
-                flush_tlb_local(VirtualAddress(msg->flush_tlb.ptr), msg->flush_tlb.page_count);
                 break;
             }
 
@@ -2062,6 +2090,25 @@ void Processor::smp_broadcast_message(ProcessorMessage& msg)
         APIC::the().broadcast_ipi();
 }
 
+void Processor::smp_multicast_message(u32 cpu_mask, ProcessorMessage& msg)
+{
+    auto& cur_proc = Processor::current();
+    VERIFY(!(cpu_mask & (1u << cur_proc.get_id())));
+
+    dbgln_if(SMP_DEBUG, "SMP[{}]: Multicast message {} to cpu mask {:x} proc: {}", cur_proc.get_id(), VirtualAddress(&msg), cpu_mask, VirtualAddress(&cur_proc));
+
+    atomic_store(&msg.refs, (u32)__builtin_popcount(cpu_mask), AK::MemoryOrder::memory_order_release);
+    VERIFY(msg.refs > 0);
+    for_each(
+        [&](Processor& proc) -> IterationDecision {
+            if (cpu_mask & (1u << proc.get_id())) {
+                if (proc.smp_queue_message(msg))
+                    APIC::the().send_ipi(proc.get_id());
+            }
+            return IterationDecision::Continue;
+        });
+}
+
 void Processor::smp_broadcast_wait_sync(ProcessorMessage& msg)
 {
     auto& cur_proc = Processor::current();
@@ -2154,19 +2201,56 @@ void Processor::smp_unicast(u32 cpu, void (*callback)(), bool async)
     smp_unicast_message(cpu, msg, async);
 }
 
-void Processor::smp_broadcast_flush_tlb(const PageDirectory* page_directory, VirtualAddress vaddr, size_t page_count)
+u32 Processor::smp_tlb_shootdown_targets(const PageDirectory* page_directory)
 {
-    auto& msg = smp_get_from_pool();
-    msg.async = false;
-    msg.type = ProcessorMessage::FlushTlb;
-    msg.flush_tlb.page_directory = page_directory;
-    msg.flush_tlb.ptr = vaddr.as_ptr();
-    msg.flush_tlb.page_count = page_count;
-    smp_broadcast_message(msg);
+    // Make sure our page table updates are visible before we look at which page directory
+    // everybody else is using. This pairs with the CR3 load in write_cr3().
+    atomic_thread_fence(AK::MemoryOrder::memory_order_seq_cst);
+
+    auto& cur_proc = Processor::current();
+    u32 cpu_mask = 0;
+    for_each(
+        [&](Processor& proc) -> IterationDecision {
+            if (&proc == &cur_proc)
+                return IterationDecision::Continue;
+            if (!page_directory || proc.m_active_cr3.load() == page_directory->cr3())
+                cpu_mask |= 1u << proc.get_id();
+            else
+                ++s_tlb_shootdowns_avoided;
+            return IterationDecision::Continue;
+        });
+    return cpu_mask;
+}
+
+void Processor::smp_broadcast_flush_tlb(const PageDirectory* page_directory, const TLBFlushRange* ranges, size_t range_count)
+{
+    // Don't get moved to another processor while we figure out which ones need to flush
+    ScopedCritical critical;
+
+    u32 cpu_mask = smp_tlb_shootdown_targets(page_directory);
+    ProcessorMessage* msg = nullptr;
+    if (cpu_mask) {
+        msg = &smp_get_from_pool();
+        msg->async = false;
+        msg->type = ProcessorMessage::FlushTlb;
+        msg->flush_tlb.page_directory = page_directory;
+        msg->flush_tlb.ranges = ranges;
+        msg->flush_tlb.range_count = range_count;
+        smp_multicast_message(cpu_mask, *msg);
+        s_tlb_shootdowns_sent += __builtin_popcount(cpu_mask);
+    }
+
     // While the other processors handle this request, we'll flush ours
-    flush_tlb_local(vaddr, page_count);
+    if (!range_count) {
+        flush_entire_tlb_local();
+    } else {
+        for (size_t i = 0; i < range_count; ++i)
+            flush_tlb_local(VirtualAddress(ranges[i].ptr), ranges[i].page_count);
+    }
+
     // Now wait until everybody is done as well
-    smp_broadcast_wait_sync(msg);
+    if (msg)
+        smp_broadcast_wait_sync(*msg);
 }
 
 void Processor::smp_broadcast_halt()
@@ -44,6 +44,8 @@
 #define PAGE_SIZE 4096
 #define GENERIC_INTERRUPT_HANDLERS_COUNT (256 - IRQ_VECTOR_BASE)
 #define PAGE_MASK ((FlatPtr)0xfffff000u)
+#define HUGE_PAGE_SIZE 0x200000
+#define HUGE_PAGE_MASK ((FlatPtr)0xffe00000u)
 
 namespace Kernel {
 
@@ -69,11 +71,20 @@ public:
         m_raw |= value & 0xfffff000;
     }
 
+    // When the Huge bit is set, this entry maps a 2 MiB page directly instead of pointing to a page table.
+    void* huge_page_base() const { return reinterpret_cast<void*>(m_raw & 0xffe00000u); }
+    void set_huge_page_base(u32 value)
+    {
+        m_raw &= 0x8000000000000fffULL;
+        m_raw |= value & 0xffe00000;
+    }
+
     bool is_null() const { return m_raw == 0; }
     void clear() { m_raw = 0; }
 
     u64 raw() const { return m_raw; }
     void copy_from(Badge<PageDirectory>, const PageDirectoryEntry& other) { m_raw = other.m_raw; }
+    void copy_from(Badge<MemoryManager>, const PageDirectoryEntry& other) { m_raw = other.m_raw; }
 
     enum Flags {
         Present = 1 << 0,
@@ -524,6 +535,11 @@ class SchedulerPerProcessorData;
 struct MemoryManagerData;
 struct ProcessorMessageEntry;
 
+struct TLBFlushRange {
+    u8* ptr;
+    size_t page_count;
+};
+
 struct ProcessorMessage {
     enum Type {
         FlushTlb,
@@ -543,9 +559,9 @@ struct ProcessorMessage {
             void (*free)(void*);
         } callback_with_data;
         struct {
-            const PageDirectory* page_directory;
-            u8* ptr;
-            size_t page_count;
+            const PageDirectory* page_directory; // nullptr for kernel addresses
+            const TLBFlushRange* ranges;
+            size_t range_count; // 0 means the entire TLB
         } flush_tlb;
     };
 
@@ -606,6 +622,12 @@ class Processor {
 
     volatile ProcessorMessageEntry* m_message_queue; // atomic, LIFO
 
+    // The CR3 this processor has loaded (or is about to load). TLB shootdowns for user
+    // addresses skip processors that aren't using the affected page directory.
+    Atomic<FlatPtr, AK::MemoryOrder::memory_order_relaxed> m_active_cr3;
+    static Atomic<u32, AK::MemoryOrder::memory_order_relaxed> s_tlb_shootdowns_sent;
+    static Atomic<u32, AK::MemoryOrder::memory_order_relaxed> s_tlb_shootdowns_avoided;
+
     bool m_invoke_scheduler_async;
     bool m_scheduler_initialized;
     Atomic<bool> m_halt_requested;
@@ -627,6 +649,8 @@ class Processor {
     static void smp_broadcast_message(ProcessorMessage& msg);
     static void smp_broadcast_wait_sync(ProcessorMessage& msg);
     static void smp_broadcast_halt();
+    static u32 smp_tlb_shootdown_targets(const PageDirectory*);
+    static void smp_multicast_message(u32 cpu_mask, ProcessorMessage& msg);
 
     void deferred_call_pool_init();
     void deferred_call_execute_pending();
@@ -677,6 +701,11 @@ public:
 
     static void flush_tlb_local(VirtualAddress vaddr, size_t page_count);
     static void flush_tlb(const PageDirectory*, VirtualAddress, size_t);
+    static void flush_tlb(const PageDirectory*, const TLBFlushRange*, size_t range_count);
+
+    ALWAYS_INLINE void set_active_cr3(FlatPtr cr3) { m_active_cr3 = cr3; }
+    static u32 tlb_shootdowns_sent() { return s_tlb_shootdowns_sent; }
+    static u32 tlb_shootdowns_avoided() { return s_tlb_shootdowns_avoided; }
 
     Descriptor& get_gdt_entry(u16 selector);
     void flush_gdt();
@@ -901,7 +930,7 @@ public:
     }
     static void smp_unicast(u32 cpu, void (*callback)(), bool async);
     static void smp_unicast(u32 cpu, void (*callback)(void*), void* data, void (*free_data)(void*), bool async);
-    static void smp_broadcast_flush_tlb(const PageDirectory*, VirtualAddress, size_t);
+    static void smp_broadcast_flush_tlb(const PageDirectory*, const TLBFlushRange*, size_t range_count);
     static u32 smp_wake_n_idle_processors(u32 wake_count);
 
     template<typename Callback>
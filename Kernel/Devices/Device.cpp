@@ -83,11 +83,30 @@ String Device::absolute_path(const FileDescription&) const
 void Device::process_next_queued_request(Badge<AsyncDeviceRequest>, const AsyncDeviceRequest& completed_request)
 {
     ScopedSpinLock lock(m_requests_lock);
-    VERIFY(!m_requests.is_empty());
-    VERIFY(m_requests.first().ptr() == &completed_request);
-    m_requests.remove(m_requests.begin());
-    if (!m_requests.is_empty()) {
-        auto* next_request = m_requests.first().ptr();
+    VERIFY(m_in_flight_requests > 0);
+    // Requests are started in the order they were queued, so the ones in flight
+    // are always the first m_in_flight_requests entries, but they may complete
+    // in any order.
+    auto it = m_requests.begin();
+    size_t index = 0;
+    for (; it != m_requests.end(); ++it, ++index) {
+        if ((*it).ptr() == &completed_request)
+            break;
+    }
+    VERIFY(index < m_in_flight_requests);
+    m_requests.remove(it);
+    m_in_flight_requests--;
+
+    AsyncDeviceRequest* next_request = nullptr;
+    index = 0;
+    for (auto& request : m_requests) {
+        if (index++ == m_in_flight_requests) {
+            next_request = request.ptr();
+            break;
+        }
+    }
+    if (next_request) {
+        m_in_flight_requests++;
         next_request->do_start(move(lock));
     }
 
@@ -68,15 +68,20 @@ public:
 
     void process_next_queued_request(Badge<AsyncDeviceRequest>, const AsyncDeviceRequest&);
 
+    // How many requests may be started before the earliest of them completes.
+    // Drivers that queue commands in hardware can accept more than one.
+    virtual size_t max_in_flight_requests() const { return 1; }
+
     template<typename AsyncRequestType, typename... Args>
     NonnullRefPtr<AsyncRequestType> make_request(Args&&... args)
     {
         auto request = adopt(*new AsyncRequestType(*this, forward<Args>(args)...));
         ScopedSpinLock lock(m_requests_lock);
-        bool was_empty = m_requests.is_empty();
         m_requests.append(request);
-        if (was_empty)
+        if (m_in_flight_requests < max_in_flight_requests()) {
+            m_in_flight_requests++;
             request->do_start(move(lock));
+        }
         return request;
     }
 
@@ -95,6 +100,7 @@ private:
 
     SpinLock<u8> m_requests_lock;
     DoublyLinkedList<RefPtr<AsyncDeviceRequest>> m_requests;
+    size_t m_in_flight_requests { 0 };
 };
 
 }
@@ -25,9 +25,14 @@
  */
 
 #include <AK/IntrusiveList.h>
+#include <AK/NonnullOwnPtrVector.h>
+#include <AK/QuickSort.h>
 #include <Kernel/Debug.h>
 #include <Kernel/FileSystem/BlockBasedFileSystem.h>
 #include <Kernel/Process.h>
+#include <Kernel/Tasks/SyncTask.h>
+#include <Kernel/Time/TimeManagement.h>
+#include <Kernel/VM/MemoryManager.h>
 
 namespace Kernel {
 
@@ -36,19 +41,35 @@ struct CacheEntry {
     BlockBasedFS::BlockIndex block_index { 0 };
     u8* data { nullptr };
     bool has_data { false };
+    bool is_dirty { false };
+    bool is_frequent { false };
+    bool is_read_ahead { false };
+    Time dirtied_at;
 };
 
+// The cache keeps clean entries on two LRU lists: blocks that have only been
+// touched once since entering the cache, and blocks that have been touched at
+// least twice. Eviction prefers the former, so that a single large sequential
+// scan can't push out the blocks that are used over and over (LRU-2/2Q style).
 class DiskCache {
 public:
+    static constexpr size_t entries_per_segment = 1024;
+    static constexpr size_t min_entry_count = entries_per_segment;
+    static constexpr size_t max_entry_count = 64 * entries_per_segment;
+    static constexpr size_t max_read_ahead_blocks = 32;
+    static constexpr size_t max_write_coalesce_blocks = max_read_ahead_blocks;
+
     explicit DiskCache(BlockBasedFS& fs)
         : m_fs(fs)
-        , m_cached_block_data(KBuffer::create_with_size(m_entry_count * m_fs.block_size()))
-        , m_entries(KBuffer::create_with_size(m_entry_count * sizeof(CacheEntry)))
+        , m_read_ahead_buffer(KBuffer::create_with_size(max_read_ahead_blocks * m_fs.block_size()))
+        , m_write_back_buffer(KBuffer::create_with_size(max_write_coalesce_blocks * m_fs.block_size()))
     {
-        for (size_t i = 0; i < m_entry_count; ++i) {
-            entries()[i].data = m_cached_block_data.data() + i * m_fs.block_size();
-            m_clean_list.append(entries()[i]);
+        auto segments = initial_entry_count() / entries_per_segment;
+        for (size_t i = 0; i < segments; ++i) {
+            if (!try_grow())
+                break;
         }
+        VERIFY(m_entry_count > 0);
     }
 
     ~DiskCache() = default;
@@ -59,53 +80,87 @@ public:
     void mark_all_clean()
     {
         while (auto* entry = m_dirty_list.first())
-            m_clean_list.prepend(*entry);
+            mark_clean(*entry);
         m_dirty = false;
     }
 
     void mark_dirty(CacheEntry& entry)
     {
+        if (!entry.is_dirty) {
+            if (!entry.is_frequent)
+                --m_clean_once_count;
+            entry.dirtied_at = TimeManagement::the().monotonic_time();
+            ++m_dirty_count;
+        }
+        entry.is_dirty = true;
         m_dirty_list.prepend(entry);
         m_dirty = true;
     }
 
     void mark_clean(CacheEntry& entry)
     {
-        m_clean_list.prepend(entry);
+        if (entry.is_dirty) {
+            if (!entry.is_frequent)
+                ++m_clean_once_count;
+            --m_dirty_count;
+        }
+        entry.is_dirty = false;
+        clean_list_for(entry).prepend(entry);
+        if (m_dirty_count == 0)
+            m_dirty = false;
+    }
+
+    size_t dirty_count() const { return m_dirty_count; }
+
+    // Once this many blocks are dirty, the SyncTask is asked to start writing
+    // them back instead of waiting for them to expire.
+    size_t background_dirty_limit() const { return m_entry_count / 10; }
+
+    CacheEntry* find(BlockBasedFS::BlockIndex block_index) const
+    {
+        auto it = m_hash.find(block_index);
+        if (it == m_hash.end())
+            return nullptr;
+        VERIFY(it->value->block_index == block_index);
+        return it->value;
     }
 
-    CacheEntry& get(BlockBasedFS::BlockIndex block_index) const
+    CacheEntry& get(BlockBasedFS::BlockIndex block_index)
     {
-        if (auto it = m_hash.find(block_index); it != m_hash.end()) {
-            auto& entry = const_cast<CacheEntry&>(*it->value);
-            VERIFY(entry.block_index == block_index);
-            return entry;
+        if (auto* entry = find(block_index)) {
+            did_reference(*entry);
+            return *entry;
         }
 
-        if (m_clean_list.is_empty()) {
-            // Not a single clean entry! Flush writes and try again.
+        auto* victim = pick_victim();
+        if (!victim) {
+            // Not a single clean entry! Write back the oldest part of the
+            // dirty blocks and try again. Writing back everything would make
+            // the unlucky caller pay for all the dirty blocks in the cache.
             // NOTE: We want to make sure we only call FileBackedFS flush here,
             //       not some FileBackedFS subclass flush!
-            m_fs.flush_writes_impl();
+            m_fs.flush_oldest_writes_impl(max(m_dirty_count / 8, (size_t)1));
             return get(block_index);
         }
 
-        VERIFY(m_clean_list.last());
-        auto& new_entry = *m_clean_list.last();
-        m_clean_list.prepend(new_entry);
+        auto& new_entry = *victim;
+        if (new_entry.is_frequent) {
+            new_entry.is_frequent = false;
+            ++m_clean_once_count;
+        }
+        m_clean_once_list.prepend(new_entry);
 
-        m_hash.remove(new_entry.block_index);
+        if (find(new_entry.block_index) == &new_entry)
+            m_hash.remove(new_entry.block_index);
         m_hash.set(block_index, &new_entry);
 
         new_entry.block_index = block_index;
         new_entry.has_data = false;
+        new_entry.is_read_ahead = false;
 
         return new_entry;
     }
 
-    const CacheEntry* entries() const { return (const CacheEntry*)m_entries.data(); }
-    CacheEntry* entries() { return (CacheEntry*)m_entries.data(); }
-
     template<typename Callback>
     void for_each_dirty_entry(Callback callback)
     {
@@ -113,14 +168,156 @@ public:
             callback(entry);
     }
 
+    // Returns how many blocks following a miss on `block_index` are worth
+    // reading in the same request. Reads that continue where the previous
+    // miss left off double the window, anything else resets it.
+    size_t read_ahead_count_for_miss(BlockBasedFS::BlockIndex block_index)
+    {
+        if (block_index.value() == m_next_sequential_block.value())
+            m_read_ahead_window = min(max(m_read_ahead_window * 2, (size_t)2), max_read_ahead_blocks);
+        else
+            m_read_ahead_window = 1;
+        m_next_sequential_block = block_index.value() + m_read_ahead_window;
+        return m_read_ahead_window;
+    }
+
+    // Gives the most recently added segment back once the cache takes up more than twice the share of
+    // memory try_grow() allows, so that the cache follows free memory down as well as up.
+    bool try_shrink()
+    {
+        if (m_entry_count <= min_entry_count)
+            return false;
+        auto cache_size = m_entry_count * m_fs.block_size();
+        if (cache_size <= (free_memory() + cache_size) / 4)
+            return false;
+
+        auto* entries = (CacheEntry*)m_entry_segments.last().data();
+        for (size_t i = 0; i < entries_per_segment; ++i) {
+            // Dirty blocks have to be written back first, we'll try again later.
+            if (entries[i].is_dirty)
+                return false;
+        }
+        for (size_t i = 0; i < entries_per_segment; ++i) {
+            auto& entry = entries[i];
+            if (find(entry.block_index) == &entry)
+                m_hash.remove(entry.block_index);
+            if (!entry.is_frequent)
+                --m_clean_once_count;
+            entry.~CacheEntry();
+        }
+        m_entry_count -= entries_per_segment;
+        m_entry_segments.take_last();
+        m_block_data_segments.take_last();
+        dbgln_if(BBFS_DEBUG, "DiskCache: Shrunk to {} entries", m_entry_count);
+        return true;
+    }
+
+    // NOTE: These are separate, since filling in the read-ahead blocks may have to write back dirty blocks.
+    KBuffer& read_ahead_buffer() { return m_read_ahead_buffer; }
+    KBuffer& write_back_buffer() { return m_write_back_buffer; }
+
 private:
+    static size_t free_memory()
+    {
+        return (size_t)(MM.user_physical_pages() - MM.user_physical_pages_used()) * PAGE_SIZE;
+    }
+
+    size_t initial_entry_count() const
+    {
+        // Start out with 1/32th of the currently free user memory, and let
+        // try_grow() take it from there.
+        return clamp(free_memory() / 32 / m_fs.block_size(), min_entry_count, max_entry_count);
+    }
+
+    IntrusiveList<CacheEntry, &CacheEntry::list_node>& clean_list_for(const CacheEntry& entry)
+    {
+        return entry.is_frequent ? m_clean_frequent_list : m_clean_once_list;
+    }
+
+    void did_reference(CacheEntry& entry)
+    {
+        if (entry.is_read_ahead) {
+            // The first real access to a block we read ahead of time is just
+            // that: the first access, it doesn't make the block frequently used.
+            entry.is_read_ahead = false;
+            if (!entry.is_dirty && !entry.is_frequent)
+                m_clean_once_list.prepend(entry);
+            return;
+        }
+        if (entry.is_dirty) {
+            entry.is_frequent = true;
+            return;
+        }
+        if (!entry.is_frequent) {
+            entry.is_frequent = true;
+            --m_clean_once_count;
+        }
+        m_clean_frequent_list.prepend(entry);
+    }
+
+    CacheEntry* pick_victim()
+    {
+        // Keep at least a quarter of the cache for blocks we have only seen
+        // once, so newly read blocks get a chance to be referenced again.
+        bool prefer_once = m_clean_once_count > m_entry_count / 4 || m_clean_frequent_list.is_empty();
+        if (prefer_once && !m_clean_once_list.is_empty())
+            return m_clean_once_list.last();
+        if (!m_clean_frequent_list.is_empty()) {
+            // Before throwing out a block that has proven useful, see if
+            // there's enough free memory around to just make the cache larger.
+            if (m_clean_once_list.is_empty() && try_grow())
+                return m_clean_once_list.last();
+            return m_clean_frequent_list.last();
+        }
+        if (try_grow())
+            return m_clean_once_list.last();
+        return nullptr;
+    }
+
+    bool try_grow()
+    {
+        if (m_entry_count + entries_per_segment > max_entry_count)
+            return false;
+        if (m_entry_count >= min_entry_count) {
+            // Don't let the cache grow beyond 1/8th of the memory it could use.
+            auto cache_size = m_entry_count * m_fs.block_size();
+            auto segment_size = entries_per_segment * m_fs.block_size();
+            if (cache_size + segment_size > (free_memory() + cache_size) / 8)
+                return false;
+        }
+        auto block_data = KBuffer::try_create_with_size(entries_per_segment * m_fs.block_size());
+        auto entries = KBuffer::try_create_with_size(entries_per_segment * sizeof(CacheEntry));
+        if (!block_data || !entries)
+            return false;
+        auto* new_entries = (CacheEntry*)entries->data();
+        for (size_t i = 0; i < entries_per_segment; ++i) {
+            new (&new_entries[i]) CacheEntry;
+            new_entries[i].data = block_data->data() + i * m_fs.block_size();
+            // Fresh entries don't hold a block yet, so they are the first to be reused.
+            m_clean_once_list.append(new_entries[i]);
+        }
+        m_clean_once_count += entries_per_segment;
+        m_entry_count += entries_per_segment;
+        m_block_data_segments.append(block_data.release_nonnull());
+        m_entry_segments.append(entries.release_nonnull());
+        dbgln_if(BBFS_DEBUG, "DiskCache: Grew to {} entries", m_entry_count);
+        return true;
+    }
+
     BlockBasedFS& m_fs;
-    size_t m_entry_count { 10000 };
-    mutable HashMap<BlockBasedFS::BlockIndex, CacheEntry*> m_hash;
-    mutable IntrusiveList<CacheEntry, &CacheEntry::list_node> m_clean_list;
-    mutable IntrusiveList<CacheEntry, &CacheEntry::list_node> m_dirty_list;
-    KBuffer m_cached_block_data;
-    KBuffer m_entries;
+    size_t m_entry_count { 0 };
+    size_t m_clean_once_count { 0 };
+    size_t m_dirty_count { 0 };
+    HashMap<BlockBasedFS::BlockIndex, CacheEntry*> m_hash;
+    IntrusiveList<CacheEntry, &CacheEntry::list_node> m_clean_once_list;
+    IntrusiveList<CacheEntry, &CacheEntry::list_node> m_clean_frequent_list;
+    IntrusiveList<CacheEntry, &CacheEntry::list_node> m_dirty_list;
+    NonnullOwnPtrVector<KBuffer> m_block_data_segments;
+    NonnullOwnPtrVector<KBuffer> m_entry_segments;
+    KBuffer m_read_ahead_buffer;
+    KBuffer m_write_back_buffer;
+    BlockBasedFS::BlockIndex m_next_sequential_block { 0 };
+    size_t m_read_ahead_window { 1 };
     bool m_dirty { false };
 };
 
@@ -154,18 +351,21 @@ KResult BlockBasedFS::write_block(BlockIndex index, const UserOrKernelBuffer& da
         return KSuccess;
     }
 
-    auto& entry = cache().get(index);
     if (count < block_size()) {
         // Fill the cache first.
+        // NOTE: This has to happen before we look up our entry, since reading ahead may recycle entries.
         auto result = read_block(index, nullptr, block_size());
         if (result.is_error())
             return result;
     }
+    auto& entry = cache().get(index);
     if (!data.read(entry.data + offset, count))
         return EFAULT;
 
     cache().mark_dirty(entry);
     entry.has_data = true;
+    if (cache().dirty_count() > cache().background_dirty_limit())
+        SyncTask::request_writeback();
     return KSuccess;
 }
 
@@ -196,24 +396,24 @@ bool BlockBasedFS::raw_write(BlockIndex index, const UserOrKernelBuffer& buffer)
 bool BlockBasedFS::raw_read_blocks(BlockIndex index, size_t count, UserOrKernelBuffer& buffer)
 {
     LOCKER(m_lock);
-    auto current = buffer;
-    for (unsigned block = index.value(); block < (index.value() + count); block++) {
-        if (!raw_read(BlockIndex { block }, current))
-            return false;
-        current = current.offset(logical_block_size());
-    }
+    u32 base_offset = index.value() * m_logical_block_size;
+    auto seek_result = file_description().seek(base_offset, SEEK_SET);
+    VERIFY(!seek_result.is_error());
+    auto nread = file_description().read(buffer, count * m_logical_block_size);
+    VERIFY(!nread.is_error());
+    VERIFY(nread.value() == count * m_logical_block_size);
     return true;
 }
 
 bool BlockBasedFS::raw_write_blocks(BlockIndex index, size_t count, const UserOrKernelBuffer& buffer)
 {
     LOCKER(m_lock);
-    auto current = buffer;
-    for (unsigned block = index.value(); block < (index.value() + count); block++) {
-        if (!raw_write(block, current))
-            return false;
-        current = current.offset(logical_block_size());
-    }
+    size_t base_offset = index.value() * m_logical_block_size;
+    auto seek_result = file_description().seek(base_offset, SEEK_SET);
+    VERIFY(!seek_result.is_error());
+    auto nwritten = file_description().write(buffer, count * m_logical_block_size);
+    VERIFY(!nwritten.is_error());
+    VERIFY(nwritten.value() == count * m_logical_block_size);
     return true;
 }
 
@@ -250,24 +450,82 @@ KResult BlockBasedFS::read_block(BlockIndex index, UserOrKernelBuffer* buffer, s
         return KSuccess;
     }
 
-    auto& entry = cache().get(index);
-    if (!entry.has_data) {
+    auto* entry = &cache().get(index);
+    if (!entry->has_data) {
+        auto read_ahead_count = cache().read_ahead_count_for_miss(index);
+        if (read_ahead_count > 1) {
+            auto result = read_ahead(index, read_ahead_count);
+            if (result.is_error())
+                return result;
+            // NOTE: Filling in the read-ahead blocks may have recycled our entry.
+            entry = cache().find(index);
+            if (!entry)
+                entry = &cache().get(index);
+        }
+    }
+    if (!entry->has_data) {
         auto base_offset = index.value() * block_size();
         auto seek_result = file_description().seek(base_offset, SEEK_SET);
         if (seek_result.is_error())
             return seek_result.error();
-        auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry.data);
+        auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry->data);
         auto nread = file_description().read(entry_data_buffer, block_size());
         if (nread.is_error())
             return nread.error();
         VERIFY(nread.value() == block_size());
-        entry.has_data = true;
+        entry->has_data = true;
     }
-    if (buffer && !buffer->write(entry.data + offset, count))
+    if (buffer && !buffer->write(entry->data + offset, count))
         return EFAULT;
     return KSuccess;
 }
 
+KResult BlockBasedFS::read_ahead(BlockIndex index, size_t count) const
+{
+    LOCKER(m_lock);
+    auto& read_ahead_buffer = cache().read_ahead_buffer();
+    VERIFY(count * block_size() <= read_ahead_buffer.size());
+    dbgln_if(BBFS_DEBUG, "BlockBasedFileSystem::read_ahead {}, count={}", index, count);
+
+    auto base_offset = index.value() * block_size();
+    auto seek_result = file_description().seek(base_offset, SEEK_SET);
+    if (seek_result.is_error())
+        return seek_result.error();
+    // The device may read less than we asked for (StorageDevice does at most a page at a time),
+    // so keep going until we have everything or run into the end of the device.
+    auto data_buffer = UserOrKernelBuffer::for_kernel_buffer(read_ahead_buffer.data());
+    size_t read_size = count * block_size();
+    size_t nread = 0;
+    while (nread < read_size) {
+        auto chunk_buffer = data_buffer.offset(nread);
+        auto result = file_description().read(chunk_buffer, read_size - nread);
+        if (result.is_error()) {
+            if (!nread)
+                return result.error();
+            break;
+        }
+        if (result.value() == 0)
+            break;
+        nread += result.value();
+    }
+
+    // We may have run into the end of the device, so only use what we got.
+    size_t blocks_read = nread / block_size();
+    for (size_t i = 0; i < blocks_read; ++i) {
+        BlockIndex block_index { index.value() + i };
+        auto* entry = cache().find(block_index);
+        if (entry && entry->has_data)
+            continue;
+        if (!entry) {
+            entry = &cache().get(block_index);
+            entry->is_read_ahead = true;
+        }
+        memcpy(entry->data, read_ahead_buffer.data() + i * block_size(), block_size());
+        entry->has_data = true;
+    }
+    return KSuccess;
+}
+
 KResult BlockBasedFS::read_blocks(BlockIndex index, unsigned count, UserOrKernelBuffer& buffer, bool allow_cache) const
 {
     LOCKER(m_lock);
@@ -310,23 +568,111 @@ void BlockBasedFS::flush_specific_block_if_needed(BlockIndex index)
         cache().mark_clean(*entry);
 }
 
+void BlockBasedFS::write_back_entries(Vector<CacheEntry*>& entries)
+{
+    LOCKER(m_lock);
+    quick_sort(entries, [](auto* a, auto* b) { return a->block_index < b->block_index; });
+
+    // Write out runs of consecutive blocks with a single request each.
+    auto& write_back_buffer = cache().write_back_buffer();
+    size_t max_run_length = write_back_buffer.size() / block_size();
+    for (size_t i = 0; i < entries.size();) {
+        size_t run_length = 1;
+        while (i + run_length < entries.size()
+            && run_length < max_run_length
+            && entries[i + run_length]->block_index.value() == entries[i]->block_index.value() + run_length)
+            ++run_length;
+
+        u8* data = entries[i]->data;
+        if (run_length > 1) {
+            data = write_back_buffer.data();
+            for (size_t j = 0; j < run_length; ++j)
+                memcpy(data + j * block_size(), entries[i + j]->data, block_size());
+        }
+
+        u32 base_offset = entries[i]->block_index.value() * block_size();
+        auto seek_result = file_description().seek(base_offset, SEEK_SET);
+        VERIFY(!seek_result.is_error());
+        // The device may write less than we asked for (StorageDevice does at most a page at a time),
+        // so keep going until the whole run is out.
+        auto data_buffer = UserOrKernelBuffer::for_kernel_buffer(data);
+        size_t run_size = run_length * block_size();
+        size_t nwritten = 0;
+        while (nwritten < run_size) {
+            auto result = file_description().write(data_buffer.offset(nwritten), run_size - nwritten);
+            // FIXME: Should this error path be surfaced somehow?
+            if (result.is_error() || result.value() == 0) {
+                dbgln("{}: Failed to write back block {}", class_name(), entries[i]->block_index.value() + nwritten / block_size());
+                break;
+            }
+            nwritten += result.value();
+        }
+
+        // Whatever didn't make it to the disk stays dirty, so we'll try again later.
+        size_t blocks_written = nwritten / block_size();
+        for (size_t j = 0; j < blocks_written; ++j)
+            cache().mark_clean(*entries[i + j]);
+        i += run_length;
+    }
+}
+
 void BlockBasedFS::flush_writes_impl()
 {
     LOCKER(m_lock);
     if (!cache().is_dirty())
         return;
-    u32 count = 0;
+    Vector<CacheEntry*> entries;
     cache().for_each_dirty_entry([&](CacheEntry& entry) {
-        u32 base_offset = entry.block_index.value() * block_size();
-        auto seek_result = file_description().seek(base_offset, SEEK_SET);
-        VERIFY(!seek_result.is_error());
-        // FIXME: Should this error path be surfaced somehow?
-        auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry.data);
-        [[maybe_unused]] auto rc = file_description().write(entry_data_buffer, block_size());
-        ++count;
+        entries.append(&entry);
+    });
+    write_back_entries(entries);
+    dbgln("{}: Flushed {} blocks to disk", class_name(), entries.size());
+}
+
+void BlockBasedFS::flush_oldest_writes_impl(size_t count)
+{
+    LOCKER(m_lock);
+    if (!cache().is_dirty())
+        return;
+    Vector<CacheEntry*> entries;
+    cache().for_each_dirty_entry([&](CacheEntry& entry) {
+        entries.append(&entry);
+    });
+    if (entries.size() > count) {
+        quick_sort(entries, [](auto* a, auto* b) { return a->dirtied_at < b->dirtied_at; });
+        entries.shrink(count);
+    }
+    write_back_entries(entries);
+    dbgln_if(BBFS_DEBUG, "{}: Flushed {} oldest blocks to disk", class_name(), entries.size());
+}
+
+void BlockBasedFS::flush_old_writes()
+{
+    LOCKER(m_lock);
+    // This runs periodically, so it's also a good time to give memory back if it's getting scarce.
+    cache().try_shrink();
+    if (!cache().is_dirty())
+        return;
+
+    // Write back every block that has been dirty for too long, plus the oldest
+    // blocks beyond the background dirty limit.
+    auto expired_before = TimeManagement::the().monotonic_time() - Time::from_seconds(dirty_expire_seconds);
+    Vector<CacheEntry*> entries;
+    cache().for_each_dirty_entry([&](CacheEntry& entry) {
+        entries.append(&entry);
     });
-    cache().mark_all_clean();
-    dbgln("{}: Flushed {} blocks to disk", class_name(), count);
+    quick_sort(entries, [](auto* a, auto* b) { return a->dirtied_at < b->dirtied_at; });
+
+    auto background_dirty_limit = cache().background_dirty_limit();
+    size_t count = 0;
+    while (count < entries.size()
+        && (entries[count]->dirtied_at <= expired_before || entries.size() - count > background_dirty_limit))
+        ++count;
+    if (count == 0)
+        return;
+    entries.shrink(count);
+    write_back_entries(entries);
+    dbgln_if(BBFS_DEBUG, "{}: Wrote back {} blocks", class_name(), count);
 }
 
 void BlockBasedFS::flush_writes()
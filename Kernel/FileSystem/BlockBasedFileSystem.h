@@ -30,6 +30,8 @@
 
 namespace Kernel {
 
+struct CacheEntry;
+
 class BlockBasedFS : public FileBackedFS {
 public:
     TYPEDEF_DISTINCT_ORDERED_ID(u64, BlockIndex);
@@ -39,7 +41,12 @@ public:
     size_t logical_block_size() const { return m_logical_block_size; };
 
     virtual void flush_writes() override;
+    virtual void flush_old_writes() override;
     void flush_writes_impl();
+    void flush_oldest_writes_impl(size_t count);
+
+    // Dirty blocks are written back by the SyncTask once they are this old.
+    static constexpr i64 dirty_expire_seconds = 5;
 
 protected:
     explicit BlockBasedFS(FileDescription&);
@@ -60,6 +67,8 @@ protected:
 
 private:
     DiskCache& cache() const;
+    KResult read_ahead(BlockIndex, size_t count) const;
+    void write_back_entries(Vector<CacheEntry*>&);
     void flush_specific_block_if_needed(BlockIndex index);
 
     mutable OwnPtr<DiskCache> m_cache;
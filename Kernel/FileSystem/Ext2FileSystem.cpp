@@ -711,7 +711,7 @@ void Ext2FS::flush_block_group_descriptor_table()
         dbgln("Ext2FS[{}]::flush_block_group_descriptor_table(): Failed to write blocks: {}", fsid(), result.error());
 }
 
-void Ext2FS::flush_writes()
+void Ext2FS::flush_cached_metadata()
 {
     LOCKER(m_lock);
     if (m_super_block_dirty) {
@@ -727,14 +727,17 @@ void Ext2FS::flush_writes()
             auto buffer = UserOrKernelBuffer::for_kernel_buffer(cached_bitmap->buffer.data());
             auto result = write_block(cached_bitmap->bitmap_block_index, buffer, block_size());
             if (result.is_error()) {
-                dbgln("Ext2FS[{}]::flush_writes(): Failed to write blocks: {}", fsid(), result.error());
+                dbgln("Ext2FS[{}]::flush_cached_metadata(): Failed to write blocks: {}", fsid(), result.error());
             }
             cached_bitmap->dirty = false;
-            dbgln_if(EXT2_DEBUG, "Ext2FS[{}]::flush_writes(): Flushed bitmap block {}", fsid(), cached_bitmap->bitmap_block_index);
+            dbgln_if(EXT2_DEBUG, "Ext2FS[{}]::flush_cached_metadata(): Flushed bitmap block {}", fsid(), cached_bitmap->bitmap_block_index);
         }
     }
+}
 
-    BlockBasedFS::flush_writes();
+void Ext2FS::uncache_unused_inodes()
+{
+    LOCKER(m_lock);
 
     // Uncache Inodes that are only kept alive by the index-to-inode lookup cache.
     // We don't uncache Inodes that are being watched by at least one InodeWatcher.
@@ -754,6 +757,22 @@ void Ext2FS::flush_writes()
         uncache_inode(index);
 }
 
+void Ext2FS::flush_writes()
+{
+    LOCKER(m_lock);
+    flush_cached_metadata();
+    BlockBasedFS::flush_writes();
+    uncache_unused_inodes();
+}
+
+void Ext2FS::flush_old_writes()
+{
+    LOCKER(m_lock);
+    flush_cached_metadata();
+    BlockBasedFS::flush_old_writes();
+    uncache_unused_inodes();
+}
+
 Ext2FSInode::Ext2FSInode(Ext2FS& fs, InodeIndex index)
     : Inode(fs, index)
 {
@@ -147,6 +147,8 @@ private:
     bool find_block_containing_inode(InodeIndex, BlockIndex& block_index, unsigned& offset) const;
 
     bool flush_super_block();
+    void flush_cached_metadata();
+    void uncache_unused_inodes();
 
     virtual const char* class_name() const override;
     virtual NonnullRefPtr<Inode> root_inode() const override;
@@ -154,6 +156,7 @@ private:
     KResultOr<NonnullRefPtr<Inode>> create_inode(Ext2FSInode& parent_inode, const String& name, mode_t, dev_t, uid_t, gid_t);
     KResult create_directory(Ext2FSInode& parent_inode, const String& name, mode_t, uid_t, gid_t);
     virtual void flush_writes() override;
+    virtual void flush_old_writes() override;
 
     BlockIndex first_block_index() const;
     KResultOr<InodeIndex> allocate_inode(GroupIndex preferred_group = 0);
@@ -54,6 +54,7 @@ public:
     unsigned fsid() const { return m_fsid; }
     static FS* from_fsid(u32);
     static void sync();
+    static void writeback();
     static void lock_all();
 
     virtual bool initialize() = 0;
@@ -79,6 +80,8 @@ public:
     };
 
     virtual void flush_writes() { }
+    // Called periodically to write back data that has been dirty for a while.
+    virtual void flush_old_writes() { flush_writes(); }
 
     size_t block_size() const { return m_block_size; }
 
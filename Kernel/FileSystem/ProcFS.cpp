@@ -89,6 +89,7 @@ enum ProcFileType {
     FI_Root_cpuinfo,
     FI_Root_dmesg,
     FI_Root_interrupts,
+    FI_Root_lockstat,
     FI_Root_dmi,
     FI_Root_smbios_entry_point,
     FI_Root_keymap,
@@ -415,6 +416,21 @@ static bool procfs$interrupts(InodeIdentifier, KBufferBuilder& builder)
     return true;
 }
 
+static bool procfs$lockstat(InodeIdentifier, KBufferBuilder& builder)
+{
+    JsonArraySerializer array { builder };
+    Lock::for_each_statistics([&array](auto& statistics) {
+        auto obj = array.add_object();
+        obj.add("name", statistics.name);
+        obj.add("contended", statistics.contended);
+        obj.add("acquired_by_spinning", statistics.acquired_by_spinning);
+        obj.add("blocked", statistics.blocked);
+        obj.add("wait_time_ns", statistics.wait_time_ns);
+    });
+    array.finish();
+    return true;
+}
+
 static bool procfs$keymap(InodeIdentifier, KBufferBuilder& builder)
 {
     JsonObjectSerializer<KBufferBuilder> json { builder };
@@ -513,6 +529,7 @@ static bool procfs$net_adapters(InodeIdentifier, KBufferBuilder& builder)
         obj.add("bytes_in", adapter.bytes_in());
         obj.add("packets_out", adapter.packets_out());
         obj.add("bytes_out", adapter.bytes_out());
+        obj.add("packets_coalesced", adapter.packets_coalesced());
         obj.add("link_up", adapter.link_up());
         obj.add("mtu", adapter.mtu());
     });
@@ -549,6 +566,11 @@ static bool procfs$net_tcp(InodeIdentifier, KBufferBuilder& builder)
         obj.add("bytes_in", socket.bytes_in());
         obj.add("packets_out", socket.packets_out());
         obj.add("bytes_out", socket.bytes_out());
+        obj.add("mss", socket.send_mss());
+        obj.add("send_window", socket.send_window());
+        obj.add("congestion_window", socket.congestion_window());
+        obj.add("bytes_in_flight", socket.bytes_in_flight());
+        obj.add("rtt_us", socket.round_trip_time().to_microseconds());
     });
     array.finish();
     return true;
@@ -739,6 +761,13 @@ static bool procfs$memstat(InodeIdentifier, KBufferBuilder& builder)
 
     auto super_physical_total = MM.super_physical_pages();
     auto super_physical_used = MM.super_physical_pages_used();
+    auto zeroed_page_pool_size = MM.zeroed_page_pool_size();
+    auto zeroed_page_pool_hits = MM.zeroed_page_pool_hits();
+    auto zeroed_page_pool_misses = MM.zeroed_page_pool_misses();
+    auto huge_pages_mapped = MM.huge_pages_mapped();
+    auto huge_pages_split = MM.huge_pages_split();
+    auto tlb_shootdowns_sent = Processor::tlb_shootdowns_sent();
+    auto tlb_shootdowns_avoided = Processor::tlb_shootdowns_avoided();
     mm_lock.unlock();
 
     JsonObjectSerializer<KBufferBuilder> json { builder };
@@ -751,6 +780,13 @@ static bool procfs$memstat(InodeIdentifier, KBufferBuilder& builder)
     json.add("user_physical_uncommitted", user_physical_pages_uncommitted);
     json.add("super_physical_allocated", super_physical_used);
     json.add("super_physical_available", super_physical_total - super_physical_used);
+    json.add("zeroed_page_pool_size", zeroed_page_pool_size);
+    json.add("zeroed_page_pool_hits", zeroed_page_pool_hits);
+    json.add("zeroed_page_pool_misses", zeroed_page_pool_misses);
+    json.add("huge_pages_mapped", huge_pages_mapped);
+    json.add("huge_pages_split", huge_pages_split);
+    json.add("tlb_shootdowns_sent", tlb_shootdowns_sent);
+    json.add("tlb_shootdowns_avoided", tlb_shootdowns_avoided);
     json.add("kmalloc_call_count", stats.kmalloc_call_count);
     json.add("kfree_call_count", stats.kfree_call_count);
     slab_alloc_stats([&json](size_t slab_size, size_t num_allocated, size_t num_free) {
@@ -1706,6 +1742,7 @@ ProcFS::ProcFS()
     m_entries[FI_Root_self] = { "self", FI_Root_self, false, procfs$self };
     m_entries[FI_Root_pci] = { "pci", FI_Root_pci, false, procfs$pci };
     m_entries[FI_Root_interrupts] = { "interrupts", FI_Root_interrupts, false, procfs$interrupts };
+    m_entries[FI_Root_lockstat] = { "lockstat", FI_Root_lockstat, false, procfs$lockstat };
     m_entries[FI_Root_dmi] = { "DMI", FI_Root_dmi, false, procfs$dmi };
     m_entries[FI_Root_smbios_entry_point] = { "smbios_entry_point", FI_Root_smbios_entry_point, false, procfs$smbios_entry_point };
     m_entries[FI_Root_keymap] = { "keymap", FI_Root_keymap, false, procfs$keymap };
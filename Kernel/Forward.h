@@ -69,6 +69,7 @@ class RecursiveSpinLock;
 template<typename LockType>
 class ScopedSpinLock;
 class TCPSocket;
+class TLBFlushBatch;
 class TTY;
 class Thread;
 class UDPSocket;
@@ -28,10 +28,87 @@
 #include <Kernel/Debug.h>
 #include <Kernel/KSyms.h>
 #include <Kernel/Lock.h>
+#include <Kernel/SpinLock.h>
+#include <Kernel/StdLib.h>
 #include <Kernel/Thread.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
+// m_lock is only ever held for a handful of instructions inside a critical
+// section, so it is worth spinning on for a while before giving up the CPU.
+static constexpr size_t guard_spin_limit = 1000;
+
+// How long a contended acquisition may spin while the lock holder is running
+// on another CPU before it goes to sleep on the wait queue.
+static constexpr size_t adaptive_spin_limit = 2000;
+
+struct LockStatisticsEntry {
+    LockStatistics statistics;
+    SpinLock<u8> lock;
+};
+
+static constexpr size_t max_lock_statistics_entries = 256;
+static LockStatisticsEntry s_lock_statistics[max_lock_statistics_entries];
+static size_t s_lock_statistics_count;
+static SpinLock<u8> s_lock_statistics_lock;
+
+static LockStatisticsEntry& lock_statistics_entry_for(const char* name)
+{
+    if (!name)
+        name = "(unnamed)";
+    ScopedSpinLock lock(s_lock_statistics_lock);
+    for (size_t i = 0; i < s_lock_statistics_count; ++i) {
+        if (!strcmp(s_lock_statistics[i].statistics.name, name))
+            return s_lock_statistics[i];
+    }
+    // Once the table is full, everything else is lumped into the last entry.
+    if (s_lock_statistics_count == max_lock_statistics_entries)
+        return s_lock_statistics[max_lock_statistics_entries - 1];
+    if (s_lock_statistics_count == max_lock_statistics_entries - 1)
+        name = "(other)";
+    auto& entry = s_lock_statistics[s_lock_statistics_count++];
+    entry.statistics.name = name;
+    return entry;
+}
+
+void Lock::for_each_statistics(Function<void(const LockStatistics&)> callback)
+{
+    size_t count;
+    {
+        ScopedSpinLock lock(s_lock_statistics_lock);
+        count = s_lock_statistics_count;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        LockStatistics statistics;
+        {
+            ScopedSpinLock lock(s_lock_statistics[i].lock);
+            statistics = s_lock_statistics[i].statistics;
+        }
+        callback(statistics);
+    }
+}
+
+static void acquire_guard(Atomic<bool>& guard)
+{
+    size_t spins = 0;
+    while (guard.exchange(true, AK::memory_order_acq_rel) != false) {
+        // Nobody else can be holding it on a single processor, so spinning won't help there.
+        if (Processor::count() > 1 && ++spins < guard_spin_limit) {
+            Processor::wait_check();
+            continue;
+        }
+        // I don't know *who* is using "m_lock", so just yield.
+        Scheduler::yield_from_critical();
+        spins = 0;
+    }
+}
+
+static void release_guard(Atomic<bool>& guard)
+{
+    guard.store(false, AK::memory_order_release);
+}
+
 #if LOCK_DEBUG
 void Lock::lock(Mode mode)
 {
@@ -47,89 +124,145 @@ void Lock::lock(Mode mode)
     // and also from within critical sections!
     VERIFY(!Processor::current().in_irq());
     VERIFY(mode != Mode::Unlocked);
+    if (mode != Mode::Shared || !try_lock_shared_fast())
+        lock_slow(mode, 1);
+#if LOCK_DEBUG
+    Thread::current()->holding_lock(*this, 1, file, line);
+#endif
+}
+
+bool Lock::try_lock_shared_fast()
+{
+    auto state = m_state.load(AK::memory_order_relaxed);
+    while (!(state & exclusive_bit)) {
+        if (m_state.compare_exchange_strong(state, state + 1, AK::memory_order_acquire)) {
+            dbgln_if(LOCK_TRACE_DEBUG, "Lock::lock @ {} ({}): acquire shared, locks held {}", this, m_name, state + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Lock::lock_slow(Mode mode, u32 count)
+{
     auto current_thread = Thread::current();
     ScopedCritical critical; // in case we're not in a critical section already
+    bool contended = false;
+    bool blocked = false;
+    size_t spin_budget = Processor::count() > 1 ? adaptive_spin_limit : 0;
+    Time wait_start;
     for (;;) {
-        if (m_lock.exchange(true, AK::memory_order_acq_rel) != false) {
-            // I don't know *who* is using "m_lock", so just yield.
-            Scheduler::yield_from_critical();
+        acquire_guard(m_lock);
+        // Exclusive ownership is only ever taken or given up while holding
+        // m_lock, but shared holders come and go without it.
+        auto state = m_state.load(AK::memory_order_relaxed);
+        if (state & exclusive_bit) {
+            VERIFY(m_holder);
+            if (m_holder == current_thread) {
+                dbgln_if(LOCK_TRACE_DEBUG, "Lock::lock @ {} ({}): acquire {}, currently exclusive, holding: {}", this, m_name, mode_to_string(mode), m_times_locked);
+                VERIFY(m_times_locked > 0);
+                m_times_locked += count;
+                release_guard(m_lock);
+                break;
+            }
+        } else if (mode == Mode::Shared) {
+            dbgln_if(LOCK_TRACE_DEBUG, "Lock::lock @ {} ({}): acquire shared, locks held {}", this, m_name, state);
+            m_state.fetch_add(count, AK::memory_order_acquire);
+            release_guard(m_lock);
+            // Let the next waiter in as well, it may be a reader too.
+            if (blocked)
+                wake_waiters();
+            break;
+        } else if (state == 0) {
+            if (m_state.compare_exchange_strong(state, exclusive_bit, AK::memory_order_acquire)) {
+                dbgln_if(LOCK_TRACE_DEBUG, "Lock::lock @ {} ({}): acquire exclusive, currently unlocked", this, m_name);
+                VERIFY(!m_holder);
+                VERIFY(m_times_locked == 0);
+                m_holder = current_thread;
+                m_times_locked = count;
+                release_guard(m_lock);
+                break;
+            }
+            // A reader got in first.
+            release_guard(m_lock);
             continue;
         }
 
-        // FIXME: Do not add new readers if writers are queued.
-        Mode current_mode = m_mode;
-        switch (current_mode) {
-        case Mode::Unlocked: {
-            dbgln_if(LOCK_TRACE_DEBUG, "Lock::lock @ ({}) {}: acquire {}, currently unlocked", this, m_name, mode_to_string(mode));
-            m_mode = mode;
-            VERIFY(!m_holder);
-            VERIFY(m_shared_holders.is_empty());
-            if (mode == Mode::Exclusive) {
-                m_holder = current_thread;
-            } else {
-                VERIFY(mode == Mode::Shared);
-                m_shared_holders.set(current_thread, 1);
-            }
-            VERIFY(m_times_locked == 0);
-            m_times_locked++;
-#if LOCK_DEBUG
-            current_thread->holding_lock(*this, 1, file, line);
-#endif
-            m_queue.should_block(true);
-            m_lock.store(false, AK::memory_order_release);
-            return;
+        if (!contended) {
+            contended = true;
+            if (TimeManagement::initialized())
+                wait_start = TimeManagement::the().monotonic_time();
         }
-        case Mode::Exclusive: {
-            VERIFY(m_holder);
-            if (m_holder != current_thread)
-                break;
-            VERIFY(m_shared_holders.is_empty());
 
-            if constexpr (LOCK_TRACE_DEBUG) {
-                if (mode == Mode::Exclusive)
-                    dbgln("Lock::lock @ {} ({}): acquire {}, currently exclusive, holding: {}", this, m_name, mode_to_string(mode), m_times_locked);
-                else
-                    dbgln("Lock::lock @ {} ({}): acquire exclusive (requested {}), currently exclusive, holding: {}", this, m_name, mode_to_string(mode), m_times_locked);
+        // If whoever holds the lock is running on another processor, it will
+        // most likely release it very soon, and spinning until then is much
+        // cheaper than a round trip through the scheduler. Readers aren't
+        // tracked, so a writer waiting on them assumes they are running.
+        bool holder_is_running = !(state & exclusive_bit) || m_holder->state() == Thread::Running;
+        if (spin_budget > 0 && holder_is_running) {
+            release_guard(m_lock);
+            while (spin_budget > 0) {
+                --spin_budget;
+                Processor::wait_check();
+                state = m_state.load(AK::memory_order_relaxed);
+                if (mode == Mode::Shared ? !(state & exclusive_bit) : state == 0)
+                    break;
             }
+            continue;
+        }
 
-            VERIFY(mode == Mode::Exclusive || mode == Mode::Shared);
-            VERIFY(m_times_locked > 0);
-            m_times_locked++;
-#if LOCK_DEBUG
-            current_thread->holding_lock(*this, 1, file, line);
-#endif
-            m_lock.store(false, AK::memory_order_release);
-            return;
+        // Announce ourselves before the final check, this pairs with the
+        // release paths storing the new state before looking at m_waiters.
+        m_waiters.fetch_add(1);
+        state = m_state.load();
+        bool is_available = mode == Mode::Shared ? !(state & exclusive_bit) : state == 0;
+        release_guard(m_lock);
+        if (!is_available) {
+            dbgln_if(LOCK_TRACE_DEBUG, "Lock::lock @ {} ({}) waiting...", this, m_name);
+            blocked = true;
+            m_queue.wait_forever(m_name);
+            dbgln_if(LOCK_TRACE_DEBUG, "Lock::lock @ {} ({}) waited", this, m_name);
         }
-        case Mode::Shared: {
-            VERIFY(!m_holder);
-            if (mode != Mode::Shared)
-                break;
+        m_waiters.fetch_sub(1, AK::memory_order_relaxed);
+    }
 
-            dbgln_if(LOCK_TRACE_DEBUG, "Lock::lock @ {} ({}): acquire {}, currently shared, locks held {}", this, m_name, mode_to_string(mode), m_times_locked);
+    if (contended)
+        account_contention(blocked, TimeManagement::initialized() ? TimeManagement::the().monotonic_time() - wait_start : Time());
+}
 
-            VERIFY(m_times_locked > 0);
-            m_times_locked++;
-            VERIFY(!m_shared_holders.is_empty());
-            auto it = m_shared_holders.find(current_thread);
-            if (it != m_shared_holders.end())
-                it->value++;
-            else
-                m_shared_holders.set(current_thread, 1);
-#if LOCK_DEBUG
-            current_thread->holding_lock(*this, 1, file, line);
-#endif
-            m_lock.store(false, AK::memory_order_release);
-            return;
-        }
-        default:
-            VERIFY_NOT_REACHED();
-        }
-        m_lock.store(false, AK::memory_order_release);
-        dbgln_if(LOCK_TRACE_DEBUG, "Lock::lock @ {} ({}) waiting...", this, m_name);
-        m_queue.wait_forever(m_name);
-        dbgln_if(LOCK_TRACE_DEBUG, "Lock::lock @ {} ({}) waited", this, m_name);
+void Lock::account_contention(bool blocked, const Time& wait_time)
+{
+    auto* entry = m_statistics.load();
+    if (!entry) {
+        entry = &lock_statistics_entry_for(m_name);
+        m_statistics.store(entry);
     }
+    ScopedSpinLock lock(entry->lock);
+    auto& statistics = entry->statistics;
+    statistics.contended++;
+    if (blocked)
+        statistics.blocked++;
+    else
+        statistics.acquired_by_spinning++;
+    statistics.wait_time_ns += wait_time.to_nanoseconds();
+}
+
+void Lock::wake_waiters()
+{
+    if (m_waiters.load() == 0)
+        return;
+    u32 did_wake = m_queue.wake_one();
+    dbgln_if(LOCK_TRACE_DEBUG, "Lock::unlock @ {} ({})  wake one ({})", this, m_name, did_wake);
+}
+
+void Lock::unlock_shared(u32 count)
+{
+    auto previous_state = m_state.fetch_sub(count);
+    dbgln_if(LOCK_TRACE_DEBUG, "Lock::unlock @ {} ({}): release shared, locks held: {}", this, m_name, previous_state - count);
+    VERIFY(!(previous_state & exclusive_bit));
+    VERIFY(previous_state >= count);
+    if (previous_state == count)
+        wake_waiters();
 }
 
 void Lock::unlock()
@@ -138,66 +271,32 @@ void Lock::unlock()
     // and also from within critical sections!
     VERIFY(!Processor::current().in_irq());
     auto current_thread = Thread::current();
-    ScopedCritical critical; // in case we're not in a critical section already
-    for (;;) {
-        if (m_lock.exchange(true, AK::memory_order_acq_rel) == false) {
-            Mode current_mode = m_mode;
-            if constexpr (LOCK_TRACE_DEBUG) {
-                if (current_mode == Mode::Shared)
-                    dbgln("Lock::unlock @ {} ({}): release {}, locks held: {}", this, m_name, mode_to_string(current_mode), m_times_locked);
-                else
-                    dbgln("Lock::unlock @ {} ({}): release {}, holding: {}", this, m_name, mode_to_string(current_mode), m_times_locked);
-            }
-
-            VERIFY(current_mode != Mode::Unlocked);
-
-            VERIFY(m_times_locked > 0);
-            m_times_locked--;
-
-            switch (current_mode) {
-            case Mode::Exclusive:
-                VERIFY(m_holder == current_thread);
-                VERIFY(m_shared_holders.is_empty());
-                if (m_times_locked == 0)
-                    m_holder = nullptr;
-                break;
-            case Mode::Shared: {
-                VERIFY(!m_holder);
-                auto it = m_shared_holders.find(current_thread);
-                VERIFY(it != m_shared_holders.end());
-                if (it->value > 1) {
-                    it->value--;
-                } else {
-                    VERIFY(it->value > 0);
-                    m_shared_holders.remove(it);
-                }
-                break;
-            }
-            default:
-                VERIFY_NOT_REACHED();
-            }
-
-            bool unlocked_last = (m_times_locked == 0);
-            if (unlocked_last) {
-                VERIFY(current_mode == Mode::Exclusive ? !m_holder : m_shared_holders.is_empty());
-                m_mode = Mode::Unlocked;
-                m_queue.should_block(false);
-            }
-
 #if LOCK_DEBUG
-            current_thread->holding_lock(*this, -1);
+    current_thread->holding_lock(*this, -1);
 #endif
 
-            m_lock.store(false, AK::memory_order_release);
-            if (unlocked_last) {
-                u32 did_wake = m_queue.wake_one();
-                dbgln_if(LOCK_TRACE_DEBUG, "Lock::unlock @ {} ({})  wake one ({})", this, m_name, did_wake);
-            }
-            return;
-        }
-        // I don't know *who* is using "m_lock", so just yield.
-        Scheduler::yield_from_critical();
+    // Nobody can take the lock exclusively while we hold it shared, so if the
+    // exclusive bit is clear, ours must be a shared hold.
+    auto state = m_state.load(AK::memory_order_relaxed);
+    VERIFY(state != 0);
+    if (!(state & exclusive_bit)) {
+        unlock_shared(1);
+        return;
     }
+
+    ScopedCritical critical; // in case we're not in a critical section already
+    acquire_guard(m_lock);
+    dbgln_if(LOCK_TRACE_DEBUG, "Lock::unlock @ {} ({}): release exclusive, holding: {}", this, m_name, m_times_locked);
+    VERIFY(m_holder == current_thread);
+    VERIFY(m_times_locked > 0);
+    bool unlocked_last = --m_times_locked == 0;
+    if (unlocked_last) {
+        m_holder = nullptr;
+        m_state.store(0);
+    }
+    release_guard(m_lock);
+    if (unlocked_last)
+        wake_waiters();
 }
 
 auto Lock::force_unlock_if_locked(u32& lock_count_to_restore) -> Mode
@@ -207,76 +306,27 @@ auto Lock::force_unlock_if_locked(u32& lock_count_to_restore) -> Mode
     VERIFY(!Processor::current().in_irq());
     auto current_thread = Thread::current();
     ScopedCritical critical; // in case we're not in a critical section already
-    for (;;) {
-        if (m_lock.exchange(true, AK::memory_order_acq_rel) == false) {
-            Mode previous_mode;
-            auto current_mode = m_mode.load(AK::MemoryOrder::memory_order_relaxed);
-            switch (current_mode) {
-            case Mode::Exclusive: {
-                if (m_holder != current_thread) {
-                    m_lock.store(false, AK::MemoryOrder::memory_order_release);
-                    lock_count_to_restore = 0;
-                    return Mode::Unlocked;
-                }
+    acquire_guard(m_lock);
 
-                dbgln_if(LOCK_RESTORE_DEBUG, "Lock::force_unlock_if_locked @ {}: unlocking exclusive with lock count: {}", this, m_times_locked);
-#if LOCK_DEBUG
-                m_holder->holding_lock(*this, -(int)lock_count_to_restore);
-#endif
-                m_holder = nullptr;
-                VERIFY(m_times_locked > 0);
-                lock_count_to_restore = m_times_locked;
-                m_times_locked = 0;
-                m_mode = Mode::Unlocked;
-                m_queue.should_block(false);
-                m_lock.store(false, AK::memory_order_release);
-                previous_mode = Mode::Exclusive;
-                break;
-            }
-            case Mode::Shared: {
-                VERIFY(!m_holder);
-                auto it = m_shared_holders.find(current_thread);
-                if (it == m_shared_holders.end()) {
-                    m_lock.store(false, AK::MemoryOrder::memory_order_release);
-                    lock_count_to_restore = 0;
-                    return Mode::Unlocked;
-                }
-
-                dbgln_if(LOCK_RESTORE_DEBUG, "Lock::force_unlock_if_locked @ {}: unlocking exclusive with lock count: {}, total locks: {}",
-                    this, it->value, m_times_locked);
+    // Shared holders are not tracked, so only exclusive ownership can be given up here.
+    if (!(m_state.load(AK::memory_order_relaxed) & exclusive_bit) || m_holder != current_thread) {
+        release_guard(m_lock);
+        lock_count_to_restore = 0;
+        return Mode::Unlocked;
+    }
 
-                VERIFY(it->value > 0);
-                lock_count_to_restore = it->value;
-                VERIFY(lock_count_to_restore > 0);
+    dbgln_if(LOCK_RESTORE_DEBUG, "Lock::force_unlock_if_locked @ {}: unlocking exclusive with lock count: {}", this, m_times_locked);
 #if LOCK_DEBUG
-                m_holder->holding_lock(*this, -(int)lock_count_to_restore);
+    m_holder->holding_lock(*this, -(int)m_times_locked);
 #endif
-                m_shared_holders.remove(it);
-                VERIFY(m_times_locked >= lock_count_to_restore);
-                m_times_locked -= lock_count_to_restore;
-                if (m_times_locked == 0) {
-                    m_mode = Mode::Unlocked;
-                    m_queue.should_block(false);
-                }
-                m_lock.store(false, AK::memory_order_release);
-                previous_mode = Mode::Shared;
-                break;
-            }
-            case Mode::Unlocked: {
-                m_lock.store(false, AK::memory_order_relaxed);
-                lock_count_to_restore = 0;
-                previous_mode = Mode::Unlocked;
-                break;
-            }
-            default:
-                VERIFY_NOT_REACHED();
-            }
-            m_queue.wake_one();
-            return previous_mode;
-        }
-        // I don't know *who* is using "m_lock", so just yield.
-        Scheduler::yield_from_critical();
-    }
+    VERIFY(m_times_locked > 0);
+    lock_count_to_restore = m_times_locked;
+    m_times_locked = 0;
+    m_holder = nullptr;
+    m_state.store(0);
+    release_guard(m_lock);
+    wake_waiters();
+    return Mode::Exclusive;
 }
 
 #if LOCK_DEBUG
@@ -293,66 +343,16 @@ void Lock::restore_lock(Mode mode, u32 lock_count)
     VERIFY(mode != Mode::Unlocked);
     VERIFY(lock_count > 0);
     VERIFY(!Processor::current().in_irq());
-    auto current_thread = Thread::current();
-    ScopedCritical critical; // in case we're not in a critical section already
-    for (;;) {
-        if (m_lock.exchange(true, AK::memory_order_acq_rel) == false) {
-            switch (mode) {
-            case Mode::Exclusive: {
-                auto expected_mode = Mode::Unlocked;
-                if (!m_mode.compare_exchange_strong(expected_mode, Mode::Exclusive))
-                    break;
-
-                dbgln_if(LOCK_RESTORE_DEBUG, "Lock::restore_lock @ {}: restoring {} with lock count {}, was unlocked", this, mode_to_string(mode), lock_count);
-
-                VERIFY(m_times_locked == 0);
-                m_times_locked = lock_count;
-                VERIFY(!m_holder);
-                VERIFY(m_shared_holders.is_empty());
-                m_holder = current_thread;
-                m_queue.should_block(true);
-                m_lock.store(false, AK::memory_order_release);
-#if LOCK_DEBUG
-                m_holder->holding_lock(*this, (int)lock_count, file, line);
-#endif
-                return;
-            }
-            case Mode::Shared: {
-                auto expected_mode = Mode::Unlocked;
-                if (!m_mode.compare_exchange_strong(expected_mode, Mode::Shared) && expected_mode != Mode::Shared)
-                    break;
-
-                dbgln_if(LOCK_RESTORE_DEBUG, "Lock::restore_lock @ {}: restoring {} with lock count {}, was {}",
-                    this, mode_to_string(mode), lock_count, mode_to_string(expected_mode));
-
-                VERIFY(expected_mode == Mode::Shared || m_times_locked == 0);
-                m_times_locked += lock_count;
-                VERIFY(!m_holder);
-                VERIFY((expected_mode == Mode::Unlocked) == m_shared_holders.is_empty());
-                auto set_result = m_shared_holders.set(current_thread, lock_count);
-                // There may be other shared lock holders already, but we should not have an entry yet
-                VERIFY(set_result == AK::HashSetResult::InsertedNewEntry);
-                m_queue.should_block(true);
-                m_lock.store(false, AK::memory_order_release);
+    dbgln_if(LOCK_RESTORE_DEBUG, "Lock::restore_lock @ {}: restoring {} with lock count {}", this, mode_to_string(mode), lock_count);
+    lock_slow(mode, lock_count);
 #if LOCK_DEBUG
-                m_holder->holding_lock(*this, (int)lock_count, file, line);
+    Thread::current()->holding_lock(*this, (int)lock_count, file, line);
 #endif
-                return;
-            }
-            default:
-                VERIFY_NOT_REACHED();
-            }
-
-            m_lock.store(false, AK::memory_order_relaxed);
-        }
-        // I don't know *who* is using "m_lock", so just yield.
-        Scheduler::yield_from_critical();
-    }
 }
 
 void Lock::clear_waiters()
 {
-    VERIFY(m_mode != Mode::Shared);
+    VERIFY(!(m_state.load(AK::memory_order_relaxed) & ~exclusive_bit));
     m_queue.wake_all();
 }
 
@@ -28,7 +28,8 @@
 
 #include <AK/Assertions.h>
 #include <AK/Atomic.h>
-#include <AK/HashMap.h>
+#include <AK/Function.h>
+#include <AK/Time.h>
 #include <AK/Types.h>
 #include <Kernel/Arch/x86/CPU.h>
 #include <Kernel/Forward.h>
@@ -37,6 +38,17 @@
 
 namespace Kernel {
 
+// Contention counters, aggregated over all locks with the same name.
+struct LockStatistics {
+    const char* name { nullptr };
+    u32 contended { 0 };
+    u32 acquired_by_spinning { 0 };
+    u32 blocked { 0 };
+    u64 wait_time_ns { 0 };
+};
+
+struct LockStatisticsEntry;
+
 class Lock {
     AK_MAKE_NONCOPYABLE(Lock);
     AK_MAKE_NONMOVABLE(Lock);
@@ -58,11 +70,13 @@ public:
     void unlock();
     [[nodiscard]] Mode force_unlock_if_locked(u32&);
     void restore_lock(Mode, u32);
-    [[nodiscard]] bool is_locked() const { return m_mode != Mode::Unlocked; }
+    [[nodiscard]] bool is_locked() const { return m_state.load(AK::memory_order_relaxed) != 0; }
     void clear_waiters();
 
     [[nodiscard]] const char* name() const { return m_name; }
 
+    static void for_each_statistics(Function<void(const LockStatistics&)>);
+
     static const char* mode_to_string(Mode mode)
     {
         switch (mode) {
@@ -78,22 +92,36 @@ public:
     }
 
 private:
+    static constexpr u32 exclusive_bit = 0x80000000;
+
+    bool try_lock_shared_fast();
+    void lock_slow(Mode, u32 count);
+    void unlock_shared(u32 count);
+    void wake_waiters();
+    void account_contention(bool blocked, const Time& wait_time);
+
     Atomic<bool> m_lock { false };
     const char* m_name { nullptr };
     WaitQueue m_queue;
-    Atomic<Mode, AK::MemoryOrder::memory_order_relaxed> m_mode { Mode::Unlocked };
 
-    // When locked exclusively, only the thread already holding the lock can
-    // lock it again. When locked in shared mode, any thread can do that.
+    // Either exclusive_bit, or the number of times the lock is held in shared
+    // mode. Shared holders are only counted, not tracked, so that uncontended
+    // shared acquisition and release are a single atomic operation without
+    // taking m_lock.
+    Atomic<u32> m_state { 0 };
+
+    // Threads that are (about to be) blocked on m_queue.
+    Atomic<u32> m_waiters { 0 };
+
+    // How often the exclusive holder has locked this lock. Only the thread
+    // already holding the lock exclusively can lock it again; a shared request
+    // from that thread is counted here as well.
     u32 m_times_locked { 0 };
 
-    // One of the threads that hold this lock, or nullptr. When locked in shared
-    // mode, this is stored on best effort basis: nullptr value does *not* mean
-    // the lock is unlocked, it just means we don't know which threads hold it.
-    // When locked exclusively, this is always the one thread that holds the
-    // lock.
+    // The thread that holds this lock exclusively, or nullptr.
     RefPtr<Thread> m_holder;
-    HashMap<Thread*, u32> m_shared_holders;
+
+    Atomic<LockStatisticsEntry*, AK::MemoryOrder::memory_order_relaxed> m_statistics { nullptr };
 };
 
 class Locker {
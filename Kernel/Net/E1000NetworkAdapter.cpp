@@ -444,22 +444,27 @@ void E1000NetworkAdapter::send_raw(ReadonlyBytes payload)
 void E1000NetworkAdapter::receive()
 {
     auto* rx_descriptors = (e1000_tx_desc*)m_rx_descriptors_region->vaddr().as_ptr();
-    u32 rx_current;
-    for (;;) {
-        rx_current = in32(REG_RXDESCTAIL) % number_of_rx_descriptors;
-        if (rx_current == (in32(REG_RXDESCHEAD) % number_of_rx_descriptors))
-            return;
-        rx_current = (rx_current + 1) % number_of_rx_descriptors;
+    // Drain every descriptor the NIC has completed, then hand them all back with a single tail update
+    // and wake the network stack once for the whole batch.
+    u32 rx_tail = in32(REG_RXDESCTAIL) % number_of_rx_descriptors;
+    size_t received_count = 0;
+    while (received_count < number_of_rx_descriptors - 1) {
+        u32 rx_current = (rx_tail + 1) % number_of_rx_descriptors;
         if (!(rx_descriptors[rx_current].status & 1))
             break;
         auto* buffer = m_rx_buffers_regions[rx_current].vaddr().as_ptr();
         u16 length = rx_descriptors[rx_current].length;
         VERIFY(length <= 8192);
         dbgln_if(E1000_DEBUG, "E1000: Received 1 packet @ {:p} ({} bytes)", buffer, length);
-        did_receive({ buffer, length });
+        queue_received_packet({ buffer, length });
         rx_descriptors[rx_current].status = 0;
-        out32(REG_RXDESCTAIL, rx_current);
+        rx_tail = rx_current;
+        ++received_count;
     }
+    if (!received_count)
+        return;
+    out32(REG_RXDESCTAIL, rx_tail);
+    notify_received_packets();
 }
 
 }
@@ -67,6 +67,7 @@ KResultOr<NonnullRefPtr<Socket>> IPv4Socket::create(int type, int protocol)
 
 IPv4Socket::IPv4Socket(int type, int protocol)
     : Socket(AF_INET, type, protocol)
+    , m_receive_buffer(type == SOCK_STREAM ? stream_receive_buffer_size : 64 * KiB)
 {
     dbgln_if(IPV4_SOCKET_DEBUG, "IPv4Socket({}) created with type={}, protocol={}", this, type, protocol);
     m_buffer_mode = type == SOCK_STREAM ? BufferMode::Bytes : BufferMode::Packets;
@@ -190,9 +191,9 @@ int IPv4Socket::allocate_local_port_if_needed()
     return port;
 }
 
-KResultOr<size_t> IPv4Socket::sendto(FileDescription&, const UserOrKernelBuffer& data, size_t data_length, [[maybe_unused]] int flags, Userspace<const sockaddr*> addr, socklen_t addr_length)
+KResultOr<size_t> IPv4Socket::sendto(FileDescription& description, const UserOrKernelBuffer& data, size_t data_length, [[maybe_unused]] int flags, Userspace<const sockaddr*> addr, socklen_t addr_length)
 {
-    LOCKER(lock());
+    Locker locker(lock());
 
     if (addr && addr_length != sizeof(sockaddr_in))
         return EINVAL;
@@ -231,6 +232,27 @@ KResultOr<size_t> IPv4Socket::sendto(FileDescription&, const UserOrKernelBuffer&
         return data_length;
     }
 
+    if (type() == SOCK_STREAM) {
+        // Stream sockets only buffer so much, so wait until the peer has acknowledged enough to make room.
+        while (is_connected() && !can_write(description, data_length)) {
+            if (!description.is_blocking())
+                return EAGAIN;
+
+            locker.unlock();
+            auto unblocked_flags = BlockFlags::None;
+            auto res = Thread::current()->block<Thread::WriteBlocker>({}, description, unblocked_flags);
+            locker.lock();
+
+            if (unblocked_flags == BlockFlags::None) {
+                if (res.was_interrupted())
+                    return EINTR;
+
+                // Unblocked due to timeout.
+                return EAGAIN;
+            }
+        }
+    }
+
     auto nsent_or_error = protocol_send(data, data_length);
     if (!nsent_or_error.is_error())
         Thread::current()->did_ipv4_socket_write(nsent_or_error.value());
@@ -262,8 +284,10 @@ KResultOr<size_t> IPv4Socket::receive_byte_buffered(FileDescription& description
 
     VERIFY(!m_receive_buffer.is_empty());
     int nreceived = m_receive_buffer.read(buffer, buffer_length);
-    if (nreceived > 0)
+    if (nreceived > 0) {
         Thread::current()->did_ipv4_socket_read((size_t)nreceived);
+        protocol_did_consume_received_bytes();
+    }
 
     set_can_read(!m_receive_buffer.is_empty());
     return nreceived;
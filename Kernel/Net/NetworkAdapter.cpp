@@ -173,6 +173,13 @@ KResult NetworkAdapter::send_ipv4_fragmented(const MACAddress& destination_mac,
 }
 
 void NetworkAdapter::did_receive(ReadonlyBytes payload)
+{
+    InterruptDisabler disabler;
+    queue_received_packet(payload);
+    notify_received_packets();
+}
+
+void NetworkAdapter::queue_received_packet(ReadonlyBytes payload)
 {
     InterruptDisabler disabler;
     m_packets_in++;
@@ -194,27 +201,35 @@ void NetworkAdapter::did_receive(ReadonlyBytes payload)
     }
 
     m_packet_queue.append({ buffer.value(), kgettimeofday() });
+}
 
+void NetworkAdapter::notify_received_packets()
+{
     if (on_receive)
         on_receive();
 }
 
-size_t NetworkAdapter::dequeue_packet(u8* buffer, size_t buffer_size, Time& packet_timestamp)
+size_t NetworkAdapter::dequeue_packets(PacketBatch& batch)
 {
+    // The batch has inline capacity for a full load, so nothing here allocates with interrupts disabled.
     InterruptDisabler disabler;
-    if (m_packet_queue.is_empty())
-        return 0;
-    auto packet_with_timestamp = m_packet_queue.take_first();
-    packet_timestamp = packet_with_timestamp.timestamp;
-    auto packet = move(packet_with_timestamp.packet);
-    size_t packet_size = packet.size();
-    VERIFY(packet_size <= buffer_size);
-    memcpy(buffer, packet.data(), packet_size);
-    if (m_unused_packet_buffers_count < 100) {
-        m_unused_packet_buffers.append(packet);
-        ++m_unused_packet_buffers_count;
+    while (!m_packet_queue.is_empty() && batch.size() < max_packet_batch_size)
+        batch.unchecked_append(m_packet_queue.take_first());
+    return batch.size();
+}
+
+void NetworkAdapter::recycle_packet_buffers(PacketBatch& batch)
+{
+    {
+        InterruptDisabler disabler;
+        for (auto& packet_with_timestamp : batch) {
+            if (m_unused_packet_buffers_count >= 100)
+                break;
+            m_unused_packet_buffers.append(packet_with_timestamp.packet);
+            ++m_unused_packet_buffers_count;
+        }
     }
-    return packet_size;
+    batch.clear_with_capacity();
 }
 
 void NetworkAdapter::set_ipv4_address(const IPv4Address& address)
@@ -31,6 +31,7 @@
 #include <AK/MACAddress.h>
 #include <AK/SinglyLinkedList.h>
 #include <AK/Types.h>
+#include <AK/Vector.h>
 #include <AK/WeakPtr.h>
 #include <AK/Weakable.h>
 #include <Kernel/KBuffer.h>
@@ -67,7 +68,16 @@ public:
     KResult send_ipv4(const MACAddress&, const IPv4Address&, IPv4Protocol, const UserOrKernelBuffer& payload, size_t payload_size, u8 ttl);
     KResult send_ipv4_fragmented(const MACAddress&, const IPv4Address&, IPv4Protocol, const UserOrKernelBuffer& payload, size_t payload_size, u8 ttl);
 
-    size_t dequeue_packet(u8* buffer, size_t buffer_size, Time& packet_timestamp);
+    struct PacketWithTimestamp {
+        KBuffer packet;
+        Time timestamp;
+    };
+
+    static constexpr size_t max_packet_batch_size = 32;
+    using PacketBatch = Vector<PacketWithTimestamp, max_packet_batch_size>;
+
+    size_t dequeue_packets(PacketBatch&);
+    void recycle_packet_buffers(PacketBatch&);
 
     bool has_queued_packets() const { return !m_packet_queue.is_empty(); }
 
@@ -78,6 +88,8 @@ public:
     u32 bytes_in() const { return m_bytes_in; }
     u32 packets_out() const { return m_packets_out; }
     u32 bytes_out() const { return m_bytes_out; }
+    u32 packets_coalesced() const { return m_packets_coalesced; }
+    void did_coalesce_packets(size_t count) { m_packets_coalesced += count; }
 
     Function<void()> on_receive;
 
@@ -88,17 +100,16 @@ protected:
     virtual void send_raw(ReadonlyBytes) = 0;
     void did_receive(ReadonlyBytes);
 
+    // Drivers that drain several packets per interrupt queue them one by one and wake the receiver once.
+    void queue_received_packet(ReadonlyBytes);
+    void notify_received_packets();
+
 private:
     MACAddress m_mac_address;
     IPv4Address m_ipv4_address;
     IPv4Address m_ipv4_netmask;
     IPv4Address m_ipv4_gateway;
 
-    struct PacketWithTimestamp {
-        KBuffer packet;
-        Time timestamp;
-    };
-
     SinglyLinkedList<PacketWithTimestamp> m_packet_queue;
     SinglyLinkedList<KBuffer> m_unused_packet_buffers;
     size_t m_unused_packet_buffers_count { 0 };
@@ -107,6 +118,7 @@ private:
     u32 m_bytes_in { 0 };
     u32 m_packets_out { 0 };
     u32 m_bytes_out { 0 };
+    u32 m_packets_coalesced { 0 };
     u32 m_mtu { 1500 };
 };
 
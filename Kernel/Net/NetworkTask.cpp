@@ -40,16 +40,26 @@
 #include <Kernel/Net/UDP.h>
 #include <Kernel/Net/UDPSocket.h>
 #include <Kernel/Process.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
+static constexpr Time retransmit_check_interval = Time::from_milliseconds(100);
+
+static void handle_frame(const u8* frame, size_t frame_size, const Time& packet_timestamp);
 static void handle_arp(const EthernetFrameHeader&, size_t frame_size);
 static void handle_ipv4(const EthernetFrameHeader&, size_t frame_size, const Time& packet_timestamp);
 static void handle_icmp(const EthernetFrameHeader&, const IPv4Packet&, const Time& packet_timestamp);
 static void handle_udp(const IPv4Packet&, const Time& packet_timestamp);
 static void handle_tcp(const IPv4Packet&, const Time& packet_timestamp);
 
+struct ReceiveWorker {
+    NetworkAdapter& adapter;
+    WaitQueue wait_queue;
+};
+
 [[noreturn]] static void NetworkTask_main(void*);
+[[noreturn]] static void NetworkTask_receive_main(void*);
 
 void NetworkTask::spawn()
 {
@@ -59,8 +69,6 @@ void NetworkTask::spawn()
 
 void NetworkTask_main(void*)
 {
-    WaitQueue packet_wait_queue;
-    int pending_packets = 0;
     NetworkAdapter::for_each([&](auto& adapter) {
         dmesgln("NetworkTask: {} network adapter found: hw={}", adapter.class_name(), adapter.mac_address().to_string());
 
@@ -70,57 +78,178 @@ void NetworkTask_main(void*)
             adapter.set_ipv4_gateway({ 0, 0, 0, 0 });
         }
 
-        adapter.on_receive = [&]() {
-            pending_packets++;
-            packet_wait_queue.wake_all();
+        // Each adapter gets its own receive thread, so the scheduler can spread them across CPUs
+        // and a busy interface never holds up packets arriving on another one.
+        auto* worker = new ReceiveWorker { adapter, {} };
+        adapter.on_receive = [worker]() {
+            worker->wait_queue.wake_all();
         };
+        auto receive_thread = Process::current()->create_kernel_thread(NetworkTask_receive_main, worker, THREAD_PRIORITY_NORMAL, String::formatted("NetworkTask RX [{}]", adapter.name()), THREAD_AFFINITY_DEFAULT, false);
+        if (!receive_thread)
+            dmesgln("NetworkTask: Failed to create receive thread for {}", adapter.name());
     });
 
-    auto dequeue_packet = [&pending_packets](u8* buffer, size_t buffer_size, Time& packet_timestamp) -> size_t {
-        if (pending_packets == 0)
-            return 0;
-        size_t packet_size = 0;
-        NetworkAdapter::for_each([&](auto& adapter) {
-            if (packet_size || !adapter.has_queued_packets())
-                return;
-            packet_size = adapter.dequeue_packet(buffer, buffer_size, packet_timestamp);
-            pending_packets--;
-            dbgln_if(NETWORK_TASK_DEBUG, "NetworkTask: Dequeued packet from {} ({} bytes)", adapter.name(), packet_size);
-        });
-        return packet_size;
-    };
-
-    size_t buffer_size = 64 * KiB;
-    auto buffer_region = MM.allocate_kernel_region(buffer_size, "Kernel Packet Buffer", Region::Access::Read | Region::Access::Write);
-    auto buffer = (u8*)buffer_region->vaddr().get();
-    Time packet_timestamp;
-
+    // Drive TCP retransmission timers for connections that aren't seeing any incoming traffic.
     for (;;) {
-        size_t packet_size = dequeue_packet(buffer, buffer_size, packet_timestamp);
-        if (!packet_size) {
-            packet_wait_queue.wait_forever("NetworkTask");
-            continue;
-        }
-        if (packet_size < sizeof(EthernetFrameHeader)) {
-            dbgln("NetworkTask: Packet is too small to be an Ethernet packet! ({})", packet_size);
-            continue;
-        }
-        auto& eth = *(const EthernetFrameHeader*)buffer;
-        dbgln_if(ETHERNET_DEBUG, "NetworkTask: From {} to {}, ether_type={:#04x}, packet_size={}", eth.source().to_string(), eth.destination().to_string(), eth.ether_type(), packet_size);
+        TCPSocket::retransmit_packets();
+        (void)Thread::current()->sleep(retransmit_check_interval);
+    }
+}
+
+struct TCPSegment {
+    const IPv4Packet* ipv4_packet;
+    const TCPPacket* tcp_packet;
+    size_t payload_size;
+};
+
+// Returns the TCP segment carried by this frame if it may be merged with its neighbours.
+static Optional<TCPSegment> coalescable_tcp_segment(const KBuffer& frame)
+{
+    if (frame.size() < sizeof(EthernetFrameHeader) + sizeof(IPv4Packet) + sizeof(TCPPacket))
+        return {};
+    auto& eth = *(const EthernetFrameHeader*)frame.data();
+    if (eth.ether_type() != EtherType::IPv4)
+        return {};
+    auto& ipv4_packet = *static_cast<const IPv4Packet*>(eth.payload());
+    if (ipv4_packet.version() != 4 || ipv4_packet.internet_header_length() != 5 || ipv4_packet.protocol() != (u8)IPv4Protocol::TCP || ipv4_packet.is_a_fragment())
+        return {};
+    if (ipv4_packet.length() < sizeof(IPv4Packet) + sizeof(TCPPacket) || ipv4_packet.length() > frame.size() - sizeof(EthernetFrameHeader))
+        return {};
+    auto& tcp_packet = *static_cast<const TCPPacket*>(ipv4_packet.payload());
+    if (tcp_packet.header_size() < sizeof(TCPPacket) || tcp_packet.header_size() >= ipv4_packet.payload_size())
+        return {};
+    // Only plain data segments are merged, anything that changes the connection state is handled on its own.
+    if ((tcp_packet.flags() & ~TCPFlags::PUSH) != TCPFlags::ACK)
+        return {};
+    return TCPSegment { &ipv4_packet, &tcp_packet, ipv4_packet.payload_size() - tcp_packet.header_size() };
+}
 
-        switch (eth.ether_type()) {
-        case EtherType::ARP:
-            handle_arp(eth, packet_size);
+static bool is_continuation_of(const TCPSegment& segment, const TCPSegment& previous)
+{
+    auto& ipv4_packet = *segment.ipv4_packet;
+    auto& tcp_packet = *segment.tcp_packet;
+    auto& previous_ipv4_packet = *previous.ipv4_packet;
+    auto& previous_tcp_packet = *previous.tcp_packet;
+    if (ipv4_packet.source() != previous_ipv4_packet.source() || ipv4_packet.destination() != previous_ipv4_packet.destination())
+        return false;
+    if (tcp_packet.source_port() != previous_tcp_packet.source_port() || tcp_packet.destination_port() != previous_tcp_packet.destination_port())
+        return false;
+    if (tcp_packet.sequence_number() != previous_tcp_packet.sequence_number() + previous.payload_size)
+        return false;
+    if (tcp_packet.ack_number() != previous_tcp_packet.ack_number() || tcp_packet.header_size() != previous_tcp_packet.header_size())
+        return false;
+    // Options (e.g. timestamps) have to match exactly, or the merged segment would misreport them.
+    return !memcmp((const u8*)&tcp_packet + sizeof(TCPPacket), (const u8*)&previous_tcp_packet + sizeof(TCPPacket), tcp_packet.options_size());
+}
+
+// Generic receive offload: merges a run of consecutive in-order segments of the same TCP flow at the
+// front of the batch into a single frame in the given buffer, so handle_tcp() and the socket only see
+// it once. Returns how many packets were consumed; 1 means nothing was merged and the buffer is unused.
+static size_t coalesce_tcp_segments(Span<NetworkAdapter::PacketWithTimestamp> packets, u8* buffer, size_t buffer_size, size_t& frame_size)
+{
+    auto first = coalescable_tcp_segment(packets[0].packet);
+    if (!first.has_value() || (first->tcp_packet->flags() & TCPFlags::PUSH))
+        return 1;
+
+    size_t header_size = sizeof(IPv4Packet) + first->tcp_packet->header_size();
+    size_t total_payload_size = first->payload_size;
+    auto previous = first.value();
+    size_t count = 1;
+    while (count < packets.size()) {
+        auto segment = coalescable_tcp_segment(packets[count].packet);
+        if (!segment.has_value() || !is_continuation_of(*segment, previous))
             break;
-        case EtherType::IPv4:
-            handle_ipv4(eth, packet_size, packet_timestamp);
+        if (header_size + total_payload_size + segment->payload_size > NumericLimits<u16>::max())
             break;
-        case EtherType::IPv6:
-            // ignore
+        total_payload_size += segment->payload_size;
+        previous = segment.value();
+        ++count;
+        // PSH marks the end of what the sender wanted delivered together.
+        if (segment->tcp_packet->flags() & TCPFlags::PUSH)
             break;
-        default:
-            dbgln("NetworkTask: Unknown ethernet type {:#04x}", eth.ether_type());
+    }
+    if (count == 1)
+        return 1;
+
+    frame_size = sizeof(EthernetFrameHeader) + header_size + total_payload_size;
+    VERIFY(frame_size <= buffer_size);
+    size_t offset = sizeof(EthernetFrameHeader) + header_size + first->payload_size;
+    memcpy(buffer, packets[0].packet.data(), offset);
+    for (size_t i = 1; i < count; ++i) {
+        auto segment = coalescable_tcp_segment(packets[i].packet);
+        memcpy(buffer + offset, segment->tcp_packet->payload(), segment->payload_size);
+        offset += segment->payload_size;
+    }
+
+    auto& ipv4_packet = *(IPv4Packet*)(buffer + sizeof(EthernetFrameHeader));
+    ipv4_packet.set_length(header_size + total_payload_size);
+    ipv4_packet.set_checksum(0);
+    ipv4_packet.set_checksum(ipv4_packet.compute_checksum());
+    // The last segment carries the most recent window and the PSH flag, if any.
+    // The TCP checksum is left stale, since incoming segments are never verified against it.
+    auto& tcp_packet = *(TCPPacket*)ipv4_packet.payload();
+    tcp_packet.set_window_size(previous.tcp_packet->window_size());
+    tcp_packet.set_flags(previous.tcp_packet->flags());
+    return count;
+}
+
+void NetworkTask_receive_main(void* data)
+{
+    auto& worker = *static_cast<ReceiveWorker*>(data);
+    auto& adapter = worker.adapter;
+
+    size_t coalesce_buffer_size = page_round_up(sizeof(EthernetFrameHeader) + NumericLimits<u16>::max());
+    auto coalesce_buffer_region = MM.allocate_kernel_region(coalesce_buffer_size, "Kernel GRO Buffer", Region::Access::Read | Region::Access::Write);
+    VERIFY(coalesce_buffer_region);
+    auto coalesce_buffer = coalesce_buffer_region->vaddr().as_ptr();
+
+    NetworkAdapter::PacketBatch batch;
+    for (;;) {
+        if (!adapter.dequeue_packets(batch)) {
+            worker.wait_queue.wait_forever("NetworkTask");
+            continue;
         }
+        dbgln_if(NETWORK_TASK_DEBUG, "NetworkTask: Dequeued {} packets from {}", batch.size(), adapter.name());
+
+        for (size_t i = 0; i < batch.size();) {
+            auto& packet = batch[i];
+            size_t frame_size = 0;
+            size_t consumed = coalesce_tcp_segments(batch.span().slice(i), coalesce_buffer, coalesce_buffer_size, frame_size);
+            if (consumed > 1) {
+                dbgln_if(NETWORK_TASK_DEBUG, "NetworkTask: Coalesced {} TCP segments from {} ({} bytes)", consumed, adapter.name(), frame_size);
+                adapter.did_coalesce_packets(consumed);
+                handle_frame(coalesce_buffer, frame_size, packet.timestamp);
+            } else {
+                handle_frame(packet.packet.data(), packet.packet.size(), packet.timestamp);
+            }
+            i += consumed;
+        }
+
+        adapter.recycle_packet_buffers(batch);
+    }
+}
+
+void handle_frame(const u8* frame, size_t frame_size, const Time& packet_timestamp)
+{
+    if (frame_size < sizeof(EthernetFrameHeader)) {
+        dbgln("NetworkTask: Packet is too small to be an Ethernet packet! ({})", frame_size);
+        return;
+    }
+    auto& eth = *(const EthernetFrameHeader*)frame;
+    dbgln_if(ETHERNET_DEBUG, "NetworkTask: From {} to {}, ether_type={:#04x}, packet_size={}", eth.source().to_string(), eth.destination().to_string(), eth.ether_type(), frame_size);
+
+    switch (eth.ether_type()) {
+    case EtherType::ARP:
+        handle_arp(eth, frame_size);
+        break;
+    case EtherType::IPv4:
+        handle_ipv4(eth, frame_size, packet_timestamp);
+        break;
+    case EtherType::IPv6:
+        // ignore
+        break;
+    default:
+        dbgln("NetworkTask: Unknown ethernet type {:#04x}", eth.ether_type());
     }
 }
 
@@ -297,6 +426,7 @@ void handle_tcp(const IPv4Packet& ipv4_packet, const Time& packet_timestamp)
     size_t maximum_tcp_header_size = 15 * sizeof(u32);
     if (tcp_packet.header_size() < minimum_tcp_header_size || tcp_packet.header_size() > maximum_tcp_header_size) {
         dbgln("handle_tcp: TCP packet header has invalid size {}", tcp_packet.header_size());
+        return;
     }
 
     if (ipv4_packet.payload_size() < tcp_packet.header_size()) {
@@ -385,6 +515,7 @@ void handle_tcp(const IPv4Packet& ipv4_packet, const Time& packet_timestamp)
             dbgln_if(TCP_DEBUG, "handle_tcp: created new client socket with tuple {}", client->tuple().to_string());
             client->set_sequence_number(1000);
             client->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            client->process_syn_options(tcp_packet);
             [[maybe_unused]] auto rc2 = client->send_tcp_packet(TCPFlags::SYN | TCPFlags::ACK);
             client->set_state(TCPSocket::State::SynReceived);
             return;
@@ -398,11 +529,13 @@ void handle_tcp(const IPv4Packet& ipv4_packet, const Time& packet_timestamp)
         switch (tcp_packet.flags()) {
         case TCPFlags::SYN:
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            socket->process_syn_options(tcp_packet);
             unused_rc = socket->send_tcp_packet(TCPFlags::ACK);
             socket->set_state(TCPSocket::State::SynReceived);
             return;
         case TCPFlags::ACK | TCPFlags::SYN:
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            socket->process_syn_options(tcp_packet);
             unused_rc = socket->send_tcp_packet(TCPFlags::ACK);
             socket->set_state(TCPSocket::State::Established);
             socket->set_setup_state(Socket::SetupState::Completed);
@@ -469,6 +602,9 @@ void handle_tcp(const IPv4Packet& ipv4_packet, const Time& packet_timestamp)
         }
     case TCPSocket::State::CloseWait:
         switch (tcp_packet.flags()) {
+        case TCPFlags::ACK:
+            // We may still be sending; the acknowledgement was already processed above.
+            return;
         default:
             dbgln("handle_tcp: unexpected flags in CloseWait state");
             unused_rc = socket->send_tcp_packet(TCPFlags::RST);
@@ -479,7 +615,8 @@ void handle_tcp(const IPv4Packet& ipv4_packet, const Time& packet_timestamp)
         switch (tcp_packet.flags()) {
         case TCPFlags::ACK:
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size);
-            socket->set_state(TCPSocket::State::Closed);
+            if (!socket->has_unacked_packets())
+                socket->set_state(TCPSocket::State::Closed);
             return;
         default:
             dbgln("handle_tcp: unexpected flags in LastAck state");
@@ -491,7 +628,8 @@ void handle_tcp(const IPv4Packet& ipv4_packet, const Time& packet_timestamp)
         switch (tcp_packet.flags()) {
         case TCPFlags::ACK:
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size);
-            socket->set_state(TCPSocket::State::FinWait2);
+            if (!socket->has_unacked_packets())
+                socket->set_state(TCPSocket::State::FinWait2);
             return;
         case TCPFlags::FIN:
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
@@ -522,7 +660,8 @@ void handle_tcp(const IPv4Packet& ipv4_packet, const Time& packet_timestamp)
         switch (tcp_packet.flags()) {
         case TCPFlags::ACK:
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size);
-            socket->set_state(TCPSocket::State::TimeWait);
+            if (!socket->has_unacked_packets())
+                socket->set_state(TCPSocket::State::TimeWait);
             return;
         default:
             dbgln("handle_tcp: unexpected flags in Closing state");
@@ -531,6 +670,14 @@ void handle_tcp(const IPv4Packet& ipv4_packet, const Time& packet_timestamp)
             return;
         }
     case TCPSocket::State::Established:
+        if (tcp_packet.sequence_number() != socket->ack_number()) {
+            // We only accept segments in order; a duplicate ACK tells the peer where the hole is.
+            dbgln_if(TCP_DEBUG, "handle_tcp: out of order segment seq_no={}, expected {}", tcp_packet.sequence_number(), socket->ack_number());
+            if (payload_size || tcp_packet.has_fin())
+                unused_rc = socket->send_tcp_packet(TCPFlags::ACK);
+            return;
+        }
+
         if (tcp_packet.has_fin()) {
             if (payload_size != 0)
                 socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()), packet_timestamp);
@@ -542,14 +689,15 @@ void handle_tcp(const IPv4Packet& ipv4_packet, const Time& packet_timestamp)
             return;
         }
 
-        socket->set_ack_number(tcp_packet.sequence_number() + payload_size);
-
-        dbgln_if(TCP_DEBUG, "Got packet with ack_no={}, seq_no={}, payload_size={}, acking it with new ack_no={}, seq_no={}",
-            tcp_packet.ack_number(), tcp_packet.sequence_number(), payload_size, socket->ack_number(), socket->sequence_number());
-
         if (payload_size) {
+            // If the receive buffer is full the segment is dropped, and the ACK re-advertises our (closed) window.
             if (socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()), packet_timestamp))
-                unused_rc = socket->send_tcp_packet(TCPFlags::ACK);
+                socket->set_ack_number(tcp_packet.sequence_number() + payload_size);
+
+            dbgln_if(TCP_DEBUG, "Got packet with ack_no={}, seq_no={}, payload_size={}, acking it with new ack_no={}, seq_no={}",
+                tcp_packet.ack_number(), tcp_packet.sequence_number(), payload_size, socket->ack_number(), socket->sequence_number());
+
+            unused_rc = socket->send_tcp_packet(TCPFlags::ACK);
         }
     }
 }
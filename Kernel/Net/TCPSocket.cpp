@@ -24,11 +24,13 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/NonnullRefPtrVector.h>
 #include <AK/Singleton.h>
 #include <AK/Time.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Devices/RandomDevice.h>
 #include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/Net/EthernetFrameHeader.h>
 #include <Kernel/Net/NetworkAdapter.h>
 #include <Kernel/Net/Routing.h>
 #include <Kernel/Net/TCP.h>
@@ -38,6 +40,41 @@
 
 namespace Kernel {
 
+static constexpr u16 default_mss = 536;
+static constexpr u16 minimum_mss = 64;
+static constexpr u8 maximum_window_scale = 14;
+static constexpr size_t send_buffer_size = 128 * KiB;
+static constexpr size_t maximum_congestion_window = 4 * MiB;
+static constexpr i64 minimum_retransmission_timeout_us = 200'000;
+static constexpr i64 maximum_retransmission_timeout_us = 60'000'000;
+
+// did_receive() needs room for the whole IPv4 packet, so keep the headers of one segment out of the advertised window.
+static constexpr size_t receive_window_slack = sizeof(IPv4Packet) + 15 * sizeof(u32);
+
+static constexpr u8 window_scale_for(size_t buffer_size)
+{
+    u8 shift = 0;
+    while ((buffer_size >> shift) > 0xffff && shift < maximum_window_scale)
+        ++shift;
+    return shift;
+}
+
+// RFC 3390
+static constexpr size_t initial_congestion_window(size_t mss)
+{
+    return min(4 * mss, max(2 * mss, (size_t)4380));
+}
+
+static inline bool is_sequence_number_before(u32 a, u32 b)
+{
+    return (i32)(a - b) < 0;
+}
+
+static inline bool is_sequence_number_before_or_equal(u32 a, u32 b)
+{
+    return (i32)(a - b) <= 0;
+}
+
 void TCPSocket::for_each(Function<void(const TCPSocket&)> callback)
 {
     LOCKER(sockets_by_tuple().lock(), Lock::Mode::Shared);
@@ -146,6 +183,7 @@ void TCPSocket::release_for_accept(RefPtr<TCPSocket> socket)
 
 TCPSocket::TCPSocket(int protocol)
     : IPv4Socket(SOCK_STREAM, protocol)
+    , m_receive_window_scale(window_scale_for(stream_receive_buffer_size))
 {
 }
 
@@ -176,48 +214,161 @@ KResultOr<size_t> TCPSocket::protocol_receive(ReadonlyBytes raw_ipv4_packet, Use
 
 KResultOr<size_t> TCPSocket::protocol_send(const UserOrKernelBuffer& data, size_t data_length)
 {
-    int err = send_tcp_packet(TCPFlags::PUSH | TCPFlags::ACK, &data, data_length);
-    if (err < 0)
-        return KResult((ErrnoCode)-err);
-    return data_length;
+    // Queue as much as fits in the send buffer and let the receive and congestion windows decide
+    // when it goes out. IPv4Socket::sendto() waits for room in the buffer if there is none.
+    size_t space = m_bytes_queued < send_buffer_size ? send_buffer_size - m_bytes_queued : 0;
+    if (space == 0)
+        return EAGAIN;
+    size_t bytes_to_queue = min(data_length, space);
+    size_t nqueued = 0;
+    while (nqueued < bytes_to_queue) {
+        size_t segment_size = min(bytes_to_queue - nqueued, (size_t)m_send_mss);
+        auto segment = data.offset(nqueued);
+        auto result = send_tcp_packet(TCPFlags::PUSH | TCPFlags::ACK, &segment, segment_size);
+        if (result.is_error()) {
+            if (nqueued)
+                break;
+            return result;
+        }
+        nqueued += segment_size;
+    }
+    return nqueued;
+}
+
+bool TCPSocket::can_write(const FileDescription& description, size_t size) const
+{
+    return IPv4Socket::can_write(description, size) && m_bytes_queued < send_buffer_size;
+}
+
+u16 TCPSocket::local_mss() const
+{
+    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
+    if (routing_decision.is_zero())
+        return default_mss;
+    // Keep whole frames within the 64 KiB buffers used on the receive path.
+    size_t mtu = min((size_t)routing_decision.adapter->mtu(), (size_t)(64 * KiB) - sizeof(EthernetFrameHeader));
+    return mtu - sizeof(IPv4Packet) - sizeof(TCPPacket);
+}
+
+size_t TCPSocket::receive_window() const
+{
+    size_t space = receive_buffer_space();
+    return space > receive_window_slack ? space - receive_window_slack : 0;
+}
+
+u16 TCPSocket::window_size_to_advertise(bool is_syn)
+{
+    // The window field of a SYN segment is never scaled.
+    u8 scale = (!is_syn && m_window_scaling_enabled) ? m_receive_window_scale : 0;
+    size_t window = min(receive_window() >> scale, (size_t)0xffff);
+    m_last_advertised_window = window << scale;
+    return window;
+}
+
+void TCPSocket::process_syn_options(const TCPPacket& packet)
+{
+    u16 peer_mss = default_mss;
+    bool peer_offered_window_scale = false;
+    u8 peer_window_scale = 0;
+
+    auto* options = packet.options();
+    size_t options_size = packet.options_size();
+    for (size_t i = 0; i < options_size;) {
+        u8 kind = options[i];
+        if (kind == TCPOptionKind::End)
+            break;
+        if (kind == TCPOptionKind::NoOperation) {
+            ++i;
+            continue;
+        }
+        if (i + 1 >= options_size)
+            break;
+        u8 length = options[i + 1];
+        if (length < 2 || i + length > options_size)
+            break;
+        if (kind == TCPOptionKind::MaximumSegmentSize && length == 4) {
+            peer_mss = (options[i + 2] << 8) | options[i + 3];
+        } else if (kind == TCPOptionKind::WindowScale && length == 3) {
+            peer_offered_window_scale = true;
+            peer_window_scale = min(options[i + 2], maximum_window_scale);
+        }
+        i += length;
+    }
+
+    m_send_mss = max(min(peer_mss, local_mss()), minimum_mss);
+    m_window_scaling_enabled = peer_offered_window_scale;
+    m_send_window_scale = peer_offered_window_scale ? peer_window_scale : 0;
+    m_send_window = packet.window_size();
+    m_congestion_window = initial_congestion_window(m_send_mss);
+
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}): negotiated mss={}, window scaling={} (send shift {}, receive shift {})",
+        this, m_send_mss, m_window_scaling_enabled, m_send_window_scale, m_receive_window_scale);
 }
 
 KResult TCPSocket::send_tcp_packet(u16 flags, const UserOrKernelBuffer* payload, size_t payload_size)
 {
-    const size_t buffer_size = sizeof(TCPPacket) + payload_size;
+    const bool has_syn = flags & TCPFlags::SYN;
+    const bool has_fin = flags & TCPFlags::FIN;
+    // MSS goes on every SYN. Window scaling is offered on our own SYN, and only echoed on a SYN/ACK if the peer offered it.
+    const bool include_window_scale = has_syn && (!(flags & TCPFlags::ACK) || m_window_scaling_enabled);
+    size_t options_size = 0;
+    if (has_syn)
+        options_size = include_window_scale ? 8 : 4;
+
+    const size_t header_size = sizeof(TCPPacket) + options_size;
+    const size_t buffer_size = header_size + payload_size;
     auto buffer = ByteBuffer::create_zeroed(buffer_size);
     auto& tcp_packet = *(TCPPacket*)(buffer.data());
     VERIFY(local_port());
     tcp_packet.set_source_port(local_port());
     tcp_packet.set_destination_port(peer_port());
-    tcp_packet.set_window_size(1024);
-    tcp_packet.set_sequence_number(m_sequence_number);
-    tcp_packet.set_data_offset(sizeof(TCPPacket) / sizeof(u32));
+    tcp_packet.set_window_size(window_size_to_advertise(has_syn));
+    tcp_packet.set_data_offset(header_size / sizeof(u32));
     tcp_packet.set_flags(flags);
 
+    // SYN, FIN and data occupy sequence space and are delivered reliably. Everything else goes out right away
+    // and carries the sequence number following the last segment we actually sent.
+    const bool is_reliable = has_syn || has_fin || payload_size > 0;
+    tcp_packet.set_sequence_number(is_reliable ? m_sequence_number : m_send_next);
+
     if (flags & TCPFlags::ACK)
         tcp_packet.set_ack_number(m_ack_number);
 
+    if (has_syn) {
+        auto* options = tcp_packet.options();
+        u16 mss = local_mss();
+        options[0] = TCPOptionKind::MaximumSegmentSize;
+        options[1] = 4;
+        options[2] = mss >> 8;
+        options[3] = mss & 0xff;
+        if (include_window_scale) {
+            options[4] = TCPOptionKind::NoOperation;
+            options[5] = TCPOptionKind::WindowScale;
+            options[6] = 3;
+            options[7] = m_receive_window_scale;
+        }
+    }
+
     if (payload && !payload->read(tcp_packet.payload(), payload_size))
         return EFAULT;
 
-    if (flags & TCPFlags::SYN) {
+    m_sequence_number += payload_size;
+    if (has_syn || has_fin)
         ++m_sequence_number;
-    } else {
-        m_sequence_number += payload_size;
-    }
 
     tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
 
-    if (tcp_packet.has_syn() || payload_size > 0) {
+    if (is_reliable) {
         LOCKER(m_not_acked_lock);
-        m_not_acked.append({ m_sequence_number, move(buffer) });
+        m_not_acked.append({ m_sequence_number, move(buffer), payload_size });
+        m_bytes_queued += payload_size;
         send_outgoing_packets();
         return KSuccess;
     }
 
     auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
-    VERIFY(!routing_decision.is_zero());
+    if (routing_decision.is_zero())
+        return EHOSTUNREACH;
 
     auto packet_buffer = UserOrKernelBuffer::for_kernel_buffer(buffer.data());
     auto result = routing_decision.adapter->send_ipv4(
@@ -231,59 +382,178 @@ KResult TCPSocket::send_tcp_packet(u16 flags, const UserOrKernelBuffer* payload,
     return KSuccess;
 }
 
+void TCPSocket::transmit(OutgoingPacket& packet, RoutingDecision& routing_decision)
+{
+    packet.tx_time = kgettimeofday();
+    packet.tx_counter++;
+
+    if constexpr (TCP_SOCKET_DEBUG) {
+        auto& tcp_packet = *(const TCPPacket*)(packet.buffer.data());
+        dbgln("Sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
+            local_address(), local_port(),
+            peer_address(), peer_port(),
+            (tcp_packet.has_syn() ? "SYN " : ""),
+            (tcp_packet.has_ack() ? "ACK " : ""),
+            (tcp_packet.has_fin() ? "FIN " : ""),
+            (tcp_packet.has_rst() ? "RST " : ""),
+            tcp_packet.sequence_number(),
+            tcp_packet.ack_number(),
+            packet.tx_counter);
+    }
+
+    auto packet_buffer = UserOrKernelBuffer::for_kernel_buffer(packet.buffer.data());
+    int err = routing_decision.adapter->send_ipv4(
+        routing_decision.next_hop, peer_address(), IPv4Protocol::TCP,
+        packet_buffer, packet.buffer.size(), ttl());
+    if (err < 0) {
+        auto& tcp_packet = *(const TCPPacket*)(packet.buffer.data());
+        dmesgln("Error ({}) sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
+            err,
+            local_address(),
+            local_port(),
+            peer_address(),
+            peer_port(),
+            (tcp_packet.has_syn() ? "SYN " : ""),
+            (tcp_packet.has_ack() ? "ACK " : ""),
+            (tcp_packet.has_fin() ? "FIN " : ""),
+            (tcp_packet.has_rst() ? "RST " : ""),
+            tcp_packet.sequence_number(),
+            tcp_packet.ack_number(),
+            packet.tx_counter);
+    } else {
+        m_packets_out++;
+        m_bytes_out += packet.buffer.size();
+    }
+}
+
 void TCPSocket::send_outgoing_packets()
 {
+    LOCKER(m_not_acked_lock);
+    if (m_not_acked.is_empty())
+        return;
+
     auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
-    VERIFY(!routing_decision.is_zero());
+    if (routing_decision.is_zero())
+        return;
 
-    auto now = kgettimeofday();
+    auto& oldest_packet = m_not_acked.first();
+    if (oldest_packet.in_flight && kgettimeofday() - oldest_packet.tx_time > Time::from_microseconds(m_retransmission_timeout_us))
+        did_time_out();
 
-    LOCKER(m_not_acked_lock, Lock::Mode::Shared);
+    // New segments only go out while both the peer's receive window and the congestion window have room.
+    // With nothing in flight we always send one, which doubles as the zero window probe.
+    size_t window = min(m_send_window, m_congestion_window);
     for (auto& packet : m_not_acked) {
-        auto diff = now - packet.tx_time;
-        if (diff <= Time::from_nanoseconds(500'000'000))
+        if (packet.in_flight)
             continue;
-        packet.tx_time = now;
-        packet.tx_counter++;
-
-        if constexpr (TCP_SOCKET_DEBUG) {
-            auto& tcp_packet = *(const TCPPacket*)(packet.buffer.data());
-            dbgln("Sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
-                local_address(), local_port(),
-                peer_address(), peer_port(),
-                (tcp_packet.has_syn() ? "SYN " : ""),
-                (tcp_packet.has_ack() ? "ACK " : ""),
-                (tcp_packet.has_fin() ? "FIN " : ""),
-                (tcp_packet.has_rst() ? "RST " : ""),
-                tcp_packet.sequence_number(),
-                tcp_packet.ack_number(),
-                packet.tx_counter);
-        }
+        if (m_bytes_in_flight > 0 && m_bytes_in_flight + packet.payload_size > window)
+            break;
+        transmit(packet, routing_decision);
+        packet.in_flight = true;
+        m_bytes_in_flight += packet.payload_size;
+        if (is_sequence_number_before(m_send_next, packet.ack_number))
+            m_send_next = packet.ack_number;
+    }
+}
+
+void TCPSocket::retransmit_first_packet()
+{
+    if (m_not_acked.is_empty() || !m_not_acked.first().in_flight)
+        return;
+    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
+    if (routing_decision.is_zero())
+        return;
+    transmit(m_not_acked.first(), routing_decision);
+}
+
+void TCPSocket::retransmit_packets()
+{
+    NonnullRefPtrVector<TCPSocket> sockets;
+    {
+        LOCKER(sockets_by_tuple().lock(), Lock::Mode::Shared);
+        for (auto& it : sockets_by_tuple().resource())
+            sockets.append(*it.value);
+    }
+
+    for (auto& socket : sockets) {
+        LOCKER(socket.lock());
+        socket.send_outgoing_packets();
+    }
+}
 
-        auto packet_buffer = UserOrKernelBuffer::for_kernel_buffer(packet.buffer.data());
-        int err = routing_decision.adapter->send_ipv4(
-            routing_decision.next_hop, peer_address(), IPv4Protocol::TCP,
-            packet_buffer, packet.buffer.size(), ttl());
-        if (err < 0) {
-            auto& tcp_packet = *(const TCPPacket*)(packet.buffer.data());
-            dmesgln("Error ({}) sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
-                err,
-                local_address(),
-                local_port(),
-                peer_address(),
-                peer_port(),
-                (tcp_packet.has_syn() ? "SYN " : ""),
-                (tcp_packet.has_ack() ? "ACK " : ""),
-                (tcp_packet.has_fin() ? "FIN " : ""),
-                (tcp_packet.has_rst() ? "RST " : ""),
-                tcp_packet.sequence_number(),
-                tcp_packet.ack_number(),
-                packet.tx_counter);
-        } else {
-            m_packets_out++;
-            m_bytes_out += packet.buffer.size();
+void TCPSocket::update_round_trip_time(Time sample)
+{
+    // RFC 6298 section 2.
+    i64 rtt_us = max(sample.to_microseconds(), (i64)1);
+    if (m_smoothed_rtt_us == 0) {
+        m_smoothed_rtt_us = rtt_us;
+        m_rtt_variance_us = rtt_us / 2;
+    } else {
+        i64 delta_us = m_smoothed_rtt_us - rtt_us;
+        if (delta_us < 0)
+            delta_us = -delta_us;
+        m_rtt_variance_us = (3 * m_rtt_variance_us + delta_us) / 4;
+        m_smoothed_rtt_us = (7 * m_smoothed_rtt_us + rtt_us) / 8;
+    }
+    m_retransmission_timeout_us = clamp(m_smoothed_rtt_us + 4 * m_rtt_variance_us, minimum_retransmission_timeout_us, maximum_retransmission_timeout_us);
+}
+
+void TCPSocket::did_acknowledge(size_t acked_bytes, u32 ack_number)
+{
+    m_duplicate_ack_count = 0;
+
+    if (m_in_fast_recovery) {
+        if (is_sequence_number_before(ack_number, m_recovery_point)) {
+            // A partial acknowledgement means the next segment was lost as well (RFC 6582 section 3.2).
+            retransmit_first_packet();
+            m_congestion_window -= min(acked_bytes, m_congestion_window);
+            m_congestion_window += m_send_mss;
+            return;
         }
+        m_congestion_window = m_slow_start_threshold;
+        m_in_fast_recovery = false;
+        return;
     }
+
+    if (m_congestion_window < m_slow_start_threshold)
+        m_congestion_window += min(acked_bytes, (size_t)m_send_mss);
+    else
+        m_congestion_window += max((size_t)m_send_mss * m_send_mss / m_congestion_window, (size_t)1);
+    m_congestion_window = min(m_congestion_window, maximum_congestion_window);
+}
+
+void TCPSocket::did_receive_duplicate_ack()
+{
+    ++m_duplicate_ack_count;
+    if (m_in_fast_recovery) {
+        m_congestion_window += m_send_mss;
+        return;
+    }
+    if (m_duplicate_ack_count < 3)
+        return;
+
+    // Fast retransmit and fast recovery (RFC 5681 section 3.2).
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}): fast retransmit, {} bytes in flight", this, m_bytes_in_flight);
+    m_slow_start_threshold = max(m_bytes_in_flight / 2, 2 * (size_t)m_send_mss);
+    m_congestion_window = m_slow_start_threshold + 3 * m_send_mss;
+    m_in_fast_recovery = true;
+    m_recovery_point = m_send_next;
+    retransmit_first_packet();
+}
+
+void TCPSocket::did_time_out()
+{
+    // RFC 5681 section 3.1 and RFC 6298 section 5: collapse the congestion window, back off the
+    // timer and resend everything outstanding from the oldest unacknowledged segment onwards.
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}): retransmission timeout after {} us", this, m_retransmission_timeout_us);
+    m_slow_start_threshold = max(m_bytes_in_flight / 2, 2 * (size_t)m_send_mss);
+    m_congestion_window = m_send_mss;
+    m_retransmission_timeout_us = min(m_retransmission_timeout_us * 2, maximum_retransmission_timeout_us);
+    m_in_fast_recovery = false;
+    m_duplicate_ack_count = 0;
+    for (auto& packet : m_not_acked)
+        packet.in_flight = false;
+    m_bytes_in_flight = 0;
 }
 
 void TCPSocket::receive_tcp_packet(const TCPPacket& packet, u16 size)
@@ -293,28 +563,70 @@ void TCPSocket::receive_tcp_packet(const TCPPacket& packet, u16 size)
 
         dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet: {}", ack_number);
 
-        int removed = 0;
         LOCKER(m_not_acked_lock);
+        size_t previous_send_window = m_send_window;
+        if (!packet.has_syn())
+            m_send_window = (size_t)packet.window_size() << m_send_window_scale;
+
+        int removed = 0;
+        size_t acked_bytes = 0;
+        Optional<Time> rtt_sample;
+        auto now = kgettimeofday();
         while (!m_not_acked.is_empty()) {
-            auto& packet = m_not_acked.first();
+            auto& outgoing_packet = m_not_acked.first();
 
-            dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: iterate: {}", packet.ack_number);
+            dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: iterate: {}", outgoing_packet.ack_number);
 
-            if (packet.ack_number <= ack_number) {
-                m_not_acked.take_first();
-                removed++;
-            } else {
+            if (!is_sequence_number_before_or_equal(outgoing_packet.ack_number, ack_number))
                 break;
-            }
+
+            // Karn's algorithm: a retransmitted segment doesn't tell us which transmission was acknowledged.
+            if (outgoing_packet.tx_counter == 1)
+                rtt_sample = now - outgoing_packet.tx_time;
+            if (outgoing_packet.in_flight)
+                m_bytes_in_flight -= outgoing_packet.payload_size;
+            m_bytes_queued -= outgoing_packet.payload_size;
+            acked_bytes += outgoing_packet.payload_size;
+            m_not_acked.take_first();
+            removed++;
         }
 
         dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet acknowledged {} packets", removed);
+
+        if (rtt_sample.has_value())
+            update_round_trip_time(rtt_sample.value());
+
+        if (removed) {
+            did_acknowledge(acked_bytes, ack_number);
+        } else if (ack_number == m_last_ack_number && size == packet.header_size() && !packet.has_syn() && !packet.has_fin()
+            && m_send_window == previous_send_window && m_bytes_in_flight > 0) {
+            did_receive_duplicate_ack();
+        }
+        m_last_ack_number = ack_number;
+
+        send_outgoing_packets();
+        if (removed)
+            evaluate_block_conditions();
     }
 
     m_packets_in++;
     m_bytes_in += packet.header_size() + size;
 }
 
+void TCPSocket::protocol_did_consume_received_bytes()
+{
+    if (m_state != State::Established)
+        return;
+
+    // Receiver side silly window avoidance (RFC 1122 section 4.2.3.3): only announce the reopened window
+    // if what we last advertised may be holding the peer back, and it has grown by a useful amount.
+    if (m_last_advertised_window >= stream_receive_buffer_size / 2)
+        return;
+    if (receive_window() < m_last_advertised_window + min(stream_receive_buffer_size / 2, (size_t)m_send_mss))
+        return;
+    [[maybe_unused]] auto rc = send_tcp_packet(TCPFlags::ACK);
+}
+
 NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket& packet, u16 payload_size)
 {
     struct [[gnu::packed]] PseudoHeader {
@@ -325,7 +637,7 @@ NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, c
         NetworkOrdered<u16> payload_size;
     };
 
-    PseudoHeader pseudo_header { source, destination, 0, (u8)IPv4Protocol::TCP, sizeof(TCPPacket) + payload_size };
+    PseudoHeader pseudo_header { source, destination, 0, (u8)IPv4Protocol::TCP, (u16)(packet.header_size() + payload_size) };
 
     u32 checksum = 0;
     auto* w = (const NetworkOrdered<u16>*)&pseudo_header;
@@ -335,12 +647,11 @@ NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, c
             checksum = (checksum >> 16) + (checksum & 0xffff);
     }
     w = (const NetworkOrdered<u16>*)&packet;
-    for (size_t i = 0; i < sizeof(packet) / sizeof(u16); ++i) {
+    for (size_t i = 0; i < packet.header_size() / sizeof(u16); ++i) {
         checksum += w[i];
         if (checksum > 0xffff)
             checksum = (checksum >> 16) + (checksum & 0xffff);
     }
-    VERIFY(packet.data_offset() * 4 == sizeof(TCPPacket));
     w = (const NetworkOrdered<u16>*)packet.payload();
     for (size_t i = 0; i < payload_size / sizeof(u16); ++i) {
         checksum += w[i];
@@ -391,7 +702,7 @@ KResult TCPSocket::protocol_connect(FileDescription& description, ShouldBlock sh
 
     allocate_local_port_if_needed();
 
-    m_sequence_number = get_good_random<u32>();
+    set_sequence_number(get_good_random<u32>());
     m_ack_number = 0;
 
     set_setup_state(SetupState::InProgress);
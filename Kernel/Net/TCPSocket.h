@@ -34,6 +34,8 @@
 
 namespace Kernel {
 
+struct RoutingDecision;
+
 class TCPSocket final : public IPv4Socket {
 public:
     static void for_each(Function<void(const TCPSocket&)>);
@@ -140,7 +142,11 @@ public:
     void set_error(Error error) { m_error = error; }
 
     void set_ack_number(u32 n) { m_ack_number = n; }
-    void set_sequence_number(u32 n) { m_sequence_number = n; }
+    void set_sequence_number(u32 n)
+    {
+        m_sequence_number = n;
+        m_send_next = n;
+    }
     u32 ack_number() const { return m_ack_number; }
     u32 sequence_number() const { return m_sequence_number; }
     u32 packets_in() const { return m_packets_in; }
@@ -151,6 +157,16 @@ public:
     KResult send_tcp_packet(u16 flags, const UserOrKernelBuffer* = nullptr, size_t = 0);
     void send_outgoing_packets();
     void receive_tcp_packet(const TCPPacket&, u16 size);
+    void process_syn_options(const TCPPacket&);
+    bool has_unacked_packets() const { return !m_not_acked.is_empty(); }
+
+    u16 send_mss() const { return m_send_mss; }
+    size_t send_window() const { return m_send_window; }
+    size_t congestion_window() const { return m_congestion_window; }
+    size_t bytes_in_flight() const { return m_bytes_in_flight; }
+    Time round_trip_time() const { return Time::from_microseconds(m_smoothed_rtt_us); }
+
+    static void retransmit_packets();
 
     static Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& sockets_by_tuple();
     static RefPtr<TCPSocket> from_tuple(const IPv4SocketTuple& tuple);
@@ -165,6 +181,7 @@ public:
     void release_for_accept(RefPtr<TCPSocket>);
 
     virtual KResult close() override;
+    virtual bool can_write(const FileDescription&, size_t) const override;
 
 protected:
     void set_direction(Direction direction) { m_direction = direction; }
@@ -175,6 +192,25 @@ private:
 
     static NetworkOrdered<u16> compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket&, u16 payload_size);
 
+    struct OutgoingPacket {
+        u32 ack_number { 0 };
+        ByteBuffer buffer;
+        size_t payload_size { 0 };
+        bool in_flight { false };
+        int tx_counter { 0 };
+        Time tx_time {};
+    };
+
+    u16 local_mss() const;
+    size_t receive_window() const;
+    u16 window_size_to_advertise(bool is_syn);
+    void transmit(OutgoingPacket&, RoutingDecision&);
+    void retransmit_first_packet();
+    void update_round_trip_time(Time sample);
+    void did_acknowledge(size_t acked_bytes, u32 ack_number);
+    void did_receive_duplicate_ack();
+    void did_time_out();
+
     virtual void shut_down_for_writing() override;
 
     virtual KResultOr<size_t> protocol_receive(ReadonlyBytes raw_ipv4_packet, UserOrKernelBuffer& buffer, size_t buffer_size, int flags) override;
@@ -184,6 +220,7 @@ private:
     virtual bool protocol_is_disconnected() const override;
     virtual KResult protocol_bind() override;
     virtual KResult protocol_listen() override;
+    virtual void protocol_did_consume_received_bytes() override;
 
     WeakPtr<TCPSocket> m_originator;
     HashMap<IPv4SocketTuple, NonnullRefPtr<TCPSocket>> m_pending_release_for_accept;
@@ -191,6 +228,7 @@ private:
     Error m_error { Error::None };
     RefPtr<NetworkAdapter> m_adapter;
     u32 m_sequence_number { 0 };
+    u32 m_send_next { 0 };
     u32 m_ack_number { 0 };
     State m_state { State::Closed };
     u32 m_packets_in { 0 };
@@ -198,12 +236,28 @@ private:
     u32 m_packets_out { 0 };
     u32 m_bytes_out { 0 };
 
-    struct OutgoingPacket {
-        u32 ack_number { 0 };
-        ByteBuffer buffer;
-        int tx_counter { 0 };
-        Time tx_time {};
-    };
+    // MSS and window scaling as negotiated on the SYN segments (RFC 6691, RFC 7323).
+    u16 m_send_mss { 536 };
+    u8 m_send_window_scale { 0 };
+    u8 m_receive_window_scale { 0 };
+    bool m_window_scaling_enabled { false };
+    size_t m_send_window { 0 };
+    size_t m_last_advertised_window { 0 };
+
+    // NewReno congestion control (RFC 5681, RFC 6582).
+    size_t m_congestion_window { 0 };
+    size_t m_slow_start_threshold { 64 * KiB };
+    size_t m_bytes_in_flight { 0 };
+    size_t m_bytes_queued { 0 };
+    u32 m_last_ack_number { 0 };
+    int m_duplicate_ack_count { 0 };
+    bool m_in_fast_recovery { false };
+    u32 m_recovery_point { 0 };
+
+    // Retransmission timer (RFC 6298), all in microseconds.
+    i64 m_smoothed_rtt_us { 0 };
+    i64 m_rtt_variance_us { 0 };
+    i64 m_retransmission_timeout_us { 1'000'000 };
 
     Lock m_not_acked_lock { "TCPSocket unacked packets" };
     SinglyLinkedList<OutgoingPacket> m_not_acked;
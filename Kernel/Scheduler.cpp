@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Optional.h>
 #include <AK/QuickSort.h>
 #include <AK/ScopeGuard.h>
 #include <AK/TemporaryChange.h>
@@ -75,15 +76,27 @@ READONLY_AFTER_INIT static Process* s_colonel_process;
 struct ThreadReadyQueue {
     IntrusiveList<Thread, &Thread::m_ready_queue_node> thread_list;
 };
-static SpinLock<u8> g_ready_queues_lock;
-static u32 g_ready_queues_mask;
-static constexpr u32 g_ready_queue_buckets = sizeof(g_ready_queues_mask) * 8;
-READONLY_AFTER_INIT static ThreadReadyQueue* g_ready_queues; // g_ready_queue_buckets entries
+
+// Each processor owns its own set of ready queues so that queueing and
+// picking threads only contends with other processors when they steal work.
+static constexpr u32 g_ready_queue_buckets = sizeof(u32) * 8;
+static constexpr u32 g_max_ready_queue_sets = sizeof(u32) * 8; // One per bit in a thread's affinity mask
+
+struct ThreadReadyQueues {
+    Thread* take_first_runnable_thread(u32 cpu);
+    void remove(Thread&);
+
+    SpinLock<u8> lock;
+    u32 mask { 0 };
+    Atomic<u32> runnable_count { 0 };
+    ThreadReadyQueue queues[g_ready_queue_buckets];
+};
+READONLY_AFTER_INIT static ThreadReadyQueues* g_ready_queues[g_max_ready_queue_sets];
 
 static inline u32 thread_priority_to_priority_index(u32 thread_priority)
 {
     // Converts the priority in the range of THREAD_PRIORITY_MIN...THREAD_PRIORITY_MAX
-    // to a index into g_ready_queues where 0 is the highest priority bucket
+    // to a index into ThreadReadyQueues::queues where 0 is the highest priority bucket
     VERIFY(thread_priority >= THREAD_PRIORITY_MIN && thread_priority <= THREAD_PRIORITY_MAX);
     constexpr u32 thread_priority_count = THREAD_PRIORITY_MAX - THREAD_PRIORITY_MIN + 1;
     static_assert(thread_priority_count > 0);
@@ -92,26 +105,22 @@ static inline u32 thread_priority_to_priority_index(u32 thread_priority)
     return priority_bucket;
 }
 
-Thread& Scheduler::pull_next_runnable_thread()
+Thread* ThreadReadyQueues::take_first_runnable_thread(u32 cpu)
 {
-    auto affinity_mask = 1u << Processor::current().id();
-
-    ScopedSpinLock lock(g_ready_queues_lock);
-    auto priority_mask = g_ready_queues_mask;
+    VERIFY(lock.is_locked());
+    auto affinity_mask = 1u << cpu;
+    auto priority_mask = mask;
     while (priority_mask != 0) {
         auto priority = __builtin_ffsl(priority_mask);
         VERIFY(priority > 0);
-        auto& ready_queue = g_ready_queues[--priority];
+        auto& ready_queue = queues[--priority];
         for (auto& thread : ready_queue.thread_list) {
             VERIFY(thread.m_runnable_priority == (int)priority);
             if (thread.is_active())
                 continue;
             if (!(thread.affinity() & affinity_mask))
                 continue;
-            thread.m_runnable_priority = -1;
-            ready_queue.thread_list.remove(thread);
-            if (ready_queue.thread_list.is_empty())
-                g_ready_queues_mask &= ~(1u << priority);
+            remove(thread);
             // Mark it as active because we are using this thread. This is similar
             // to comparing it with Processor::current_thread, but when there are
             // multiple processors there's no easy way to check whether the thread
@@ -123,10 +132,95 @@ Thread& Scheduler::pull_next_runnable_thread()
             // switching to it.
             // FIXME: Figure out a better way maybe?
             thread.set_active(true);
-            return thread;
+            return &thread;
         }
         priority_mask &= ~(1u << priority);
     }
+    return nullptr;
+}
+
+void ThreadReadyQueues::remove(Thread& thread)
+{
+    VERIFY(lock.is_locked());
+    auto priority = thread.m_runnable_priority;
+    VERIFY(priority >= 0);
+    VERIFY(mask & (1u << priority));
+    auto& ready_queue = queues[priority];
+    thread.m_runnable_priority = -1;
+    thread.m_runnable_cpu = -1;
+    ready_queue.thread_list.remove(thread);
+    if (ready_queue.thread_list.is_empty())
+        mask &= ~(1u << priority);
+    runnable_count.fetch_sub(1, AK::MemoryOrder::memory_order_relaxed);
+}
+
+static Thread* steal_runnable_thread(u32 cpu)
+{
+    // Our own queues ran dry, so look for the processor with the most
+    // runnable threads and take one of them that is allowed to run here.
+    ThreadReadyQueues* victim = nullptr;
+    u32 victim_count = 0;
+    for (u32 i = 1; i < g_max_ready_queue_sets; i++) {
+        auto* ready_queues = g_ready_queues[(cpu + i) % g_max_ready_queue_sets];
+        if (!ready_queues)
+            continue;
+        auto count = ready_queues->runnable_count.load(AK::MemoryOrder::memory_order_relaxed);
+        if (count > victim_count) {
+            victim = ready_queues;
+            victim_count = count;
+        }
+    }
+    if (!victim)
+        return nullptr;
+
+    // If the busiest processor has nothing we are allowed to run (or it was
+    // drained in the meantime) we don't go on to try every other processor,
+    // but rather let the idle thread run until the next scheduling decision.
+    ScopedSpinLock lock(victim->lock);
+    auto* thread = victim->take_first_runnable_thread(cpu);
+    if (thread)
+        dbgln_if(SCHEDULER_DEBUG, "Scheduler[{}]: Stole thread {}", cpu, *thread);
+    return thread;
+}
+
+static u32 ready_queues_for_thread(const Thread& thread)
+{
+#if !SCHEDULE_ON_ALL_PROCESSORS
+    if (thread.affinity() & 1u)
+        return 0;
+#endif
+    // Prefer the processor the thread last ran on to keep its caches warm.
+    auto last_cpu = thread.cpu();
+    if ((thread.affinity() & (1u << last_cpu)) && g_ready_queues[last_cpu])
+        return last_cpu;
+
+    // Otherwise pick the least loaded processor the thread is allowed on.
+    Optional<u32> best_cpu;
+    u32 best_count = 0;
+    for (u32 cpu = 0; cpu < g_max_ready_queue_sets; cpu++) {
+        if (!(thread.affinity() & (1u << cpu)) || !g_ready_queues[cpu])
+            continue;
+        auto count = g_ready_queues[cpu]->runnable_count.load(AK::MemoryOrder::memory_order_relaxed);
+        if (!best_cpu.has_value() || count < best_count) {
+            best_cpu = cpu;
+            best_count = count;
+        }
+    }
+    VERIFY(best_cpu.has_value());
+    return best_cpu.value();
+}
+
+Thread& Scheduler::pull_next_runnable_thread()
+{
+    auto cpu = Processor::current().id();
+    {
+        auto& ready_queues = *g_ready_queues[cpu];
+        ScopedSpinLock lock(ready_queues.lock);
+        if (auto* thread = ready_queues.take_first_runnable_thread(cpu))
+            return *thread;
+    }
+    if (auto* thread = steal_runnable_thread(cpu))
+        return *thread;
     return *Processor::current().idle_thread();
 }
 
@@ -134,23 +228,27 @@ bool Scheduler::dequeue_runnable_thread(Thread& thread, bool check_affinity)
 {
     if (&thread == Processor::current().idle_thread())
         return true;
-    ScopedSpinLock lock(g_ready_queues_lock);
-    auto priority = thread.m_runnable_priority;
-    if (priority < 0) {
-        VERIFY(!thread.m_ready_queue_node.is_in_list());
-        return false;
-    }
 
-    if (check_affinity && !(thread.affinity() & (1 << Processor::current().id())))
-        return false;
+    for (;;) {
+        auto cpu = thread.m_runnable_cpu;
+        if (cpu < 0) {
+            VERIFY(!thread.m_ready_queue_node.is_in_list());
+            return false;
+        }
 
-    VERIFY(g_ready_queues_mask & (1u << priority));
-    auto& ready_queue = g_ready_queues[priority];
-    thread.m_runnable_priority = -1;
-    ready_queue.thread_list.remove(thread);
-    if (ready_queue.thread_list.is_empty())
-        g_ready_queues_mask &= ~(1u << priority);
-    return true;
+        auto& ready_queues = *g_ready_queues[cpu];
+        ScopedSpinLock lock(ready_queues.lock);
+        if (thread.m_runnable_cpu != cpu) {
+            // Another processor took or moved the thread before we got the lock.
+            continue;
+        }
+
+        if (check_affinity && !(thread.affinity() & (1 << Processor::current().id())))
+            return false;
+
+        ready_queues.remove(thread);
+        return true;
+    }
 }
 
 void Scheduler::queue_runnable_thread(Thread& thread)
@@ -159,16 +257,21 @@ void Scheduler::queue_runnable_thread(Thread& thread)
     if (&thread == Processor::current().idle_thread())
         return;
     auto priority = thread_priority_to_priority_index(thread.priority());
+    auto cpu = ready_queues_for_thread(thread);
 
-    ScopedSpinLock lock(g_ready_queues_lock);
+    auto& ready_queues = *g_ready_queues[cpu];
+    ScopedSpinLock lock(ready_queues.lock);
     VERIFY(thread.m_runnable_priority < 0);
+    VERIFY(thread.m_runnable_cpu < 0);
     thread.m_runnable_priority = (int)priority;
+    thread.m_runnable_cpu = (int)cpu;
     VERIFY(!thread.m_ready_queue_node.is_in_list());
-    auto& ready_queue = g_ready_queues[priority];
+    auto& ready_queue = ready_queues.queues[priority];
     bool was_empty = ready_queue.thread_list.is_empty();
     ready_queue.thread_list.append(thread);
     if (was_empty)
-        g_ready_queues_mask |= (1u << priority);
+        ready_queues.mask |= (1u << priority);
+    ready_queues.runnable_count.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
 }
 
 UNMAP_AFTER_INIT void Scheduler::start()
@@ -497,7 +600,7 @@ UNMAP_AFTER_INIT void Scheduler::initialize()
 
     RefPtr<Thread> idle_thread;
     g_finalizer_wait_queue = new WaitQueue;
-    g_ready_queues = new ThreadReadyQueue[g_ready_queue_buckets];
+    g_ready_queues[0] = new ThreadReadyQueues;
 
     g_finalizer_has_work.store(false, AK::MemoryOrder::memory_order_release);
     s_colonel_process = Process::create_kernel_process(idle_thread, "colonel", idle_loop, nullptr, 1).leak_ref();
@@ -521,6 +624,10 @@ UNMAP_AFTER_INIT Thread* Scheduler::create_ap_idle_thread(u32 cpu)
     // This function is called on the bsp, but creates an idle thread for another AP
     VERIFY(Processor::id() == 0);
 
+    VERIFY(cpu < g_max_ready_queue_sets);
+    VERIFY(!g_ready_queues[cpu]);
+    g_ready_queues[cpu] = new ThreadReadyQueues;
+
     VERIFY(s_colonel_process);
     Thread* idle_thread = s_colonel_process->create_kernel_thread(idle_loop, nullptr, THREAD_PRIORITY_MIN, String::format("idle thread #%u", cpu), 1 << cpu, false);
     VERIFY(idle_thread);
@@ -72,10 +72,13 @@ AHCIPort::AHCIPort(const AHCIPortHandler& handler, volatile AHCI::PortRegisters&
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: Command list page at {}", representative_port_index(), m_command_list_page->paddr());
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: FIS receive page at {}", representative_port_index(), m_command_list_page->paddr());
 
-    for (size_t index = 0; index < 1; index++) {
+    // We don't know yet whether the device supports NCQ, so prepare a command table
+    // and DMA buffers for every command slot the HBA implements.
+    size_t command_slots_count = min(m_parent_handler->hba_capabilities().max_command_list_entries_count, m_command_slots.size());
+    for (size_t index = 0; index < command_slots_count * dma_pages_per_command_slot; index++) {
         m_dma_buffers.append(MM.allocate_supervisor_physical_page().release_nonnull());
     }
-    for (size_t index = 0; index < 1; index++) {
+    for (size_t index = 0; index < command_slots_count; index++) {
         m_command_table_pages.append(MM.allocate_supervisor_physical_page().release_nonnull());
     }
     m_command_list_region = MM.allocate_kernel_region(m_command_list_page->paddr(), PAGE_SIZE, "AHCI Port Command List", Region::Access::Read | Region::Access::Write, Region::Cacheable::No);
@@ -114,31 +117,20 @@ void AHCIPort::handle_interrupt()
         });
         return;
     }
-    if (m_interrupt_status.is_set(AHCI::PortInterruptFlag::DHR) || m_interrupt_status.is_set(AHCI::PortInterruptFlag::PS)) {
+    // Queued commands are completed with a Set Device Bits FIS, everything else with a
+    // Device to Host Register FIS (or a PIO Setup FIS).
+    if (m_interrupt_status.is_set(AHCI::PortInterruptFlag::DHR) || m_interrupt_status.is_set(AHCI::PortInterruptFlag::PS) || m_interrupt_status.is_set(AHCI::PortInterruptFlag::SDB)) {
         m_wait_for_completion = false;
 
-        // Now schedule reading/writing the buffer as soon as we leave the irq handler.
+        // Now schedule reading/writing the buffers as soon as we leave the irq handler.
         // This is important so that we can safely access the buffers, which could
-        // trigger page faults
-        if (!m_current_request) {
+        // trigger page faults. Which commands finished is worked out there as well,
+        // so it doesn't matter if several interrupts get coalesced into one work item.
+        if (!m_issued_command_slots) {
             dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request handled, probably identify request", representative_port_index());
         } else {
             g_io_work->queue([this]() {
-                dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request handled", representative_port_index());
-                LOCKER(m_lock);
-                VERIFY(m_current_request);
-                VERIFY(m_current_scatter_list);
-                if (m_current_request->request_type() == AsyncBlockDeviceRequest::Read) {
-                    if (!m_current_request->write_to_buffer(m_current_request->buffer(), m_current_scatter_list->dma_region().as_ptr(), m_connected_device->block_size() * m_current_request->block_count())) {
-                        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure, memory fault occurred when reading in data.", representative_port_index());
-                        m_current_scatter_list = nullptr;
-                        complete_current_request(AsyncDeviceRequest::MemoryFault);
-                        return;
-                    }
-                }
-                m_current_scatter_list = nullptr;
-                dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request success", representative_port_index());
-                complete_current_request(AsyncDeviceRequest::Success);
+                complete_finished_requests();
             });
         }
     }
@@ -160,6 +152,8 @@ void AHCIPort::recover_from_fatal_error()
     stop_command_list_processing();
     stop_fis_receiving();
     m_interrupt_enable.clear();
+    lock.unlock();
+    fail_all_requests();
 }
 
 void AHCIPort::eject()
@@ -315,6 +309,15 @@ bool AHCIPort::initialize(ScopedSpinLock<SpinLock<u8>>& main_lock)
             m_port_registers.cmd = m_port_registers.cmd | (1 << 24);
         }
 
+        // Word 76 bit 8 advertises NCQ support, word 75 holds the maximum queue depth minus one.
+        m_ncq_enabled = false;
+        m_command_slots_count = 1;
+        if (!is_atapi_attached() && m_parent_handler->hba_capabilities().native_command_queuing_supported && (identify_block->serial_ata_capabilities & (1 << 8))) {
+            m_ncq_enabled = true;
+            m_command_slots_count = min(m_command_table_pages.size(), (size_t)(identify_block->queue_depth & 0x1f) + 1);
+            dmesgln("AHCI Port {}: Native Command Queuing enabled, {} command slots", representative_port_index(), m_command_slots_count);
+        }
+
         dmesgln("AHCI Port {}: Device found, Capacity={}, Bytes per logical sector={}, Bytes per physical sector={}", representative_port_index(), max_addressable_sector * logical_sector_size, logical_sector_size, physical_sector_size);
 
         // FIXME: We don't support ATAPI devices yet, so for now we don't "create" them
@@ -453,19 +456,20 @@ size_t AHCIPort::calculate_descriptors_count(size_t block_count) const
     return needed_dma_regions_count;
 }
 
-Optional<AsyncDeviceRequest::RequestResult> AHCIPort::prepare_and_set_scatter_list(AsyncBlockDeviceRequest& request)
+Optional<AsyncDeviceRequest::RequestResult> AHCIPort::prepare_and_set_scatter_list(u8 slot, AsyncBlockDeviceRequest& request)
 {
     VERIFY(m_lock.is_locked());
     VERIFY(request.block_count() > 0);
 
     NonnullRefPtrVector<PhysicalPage> allocated_dma_regions;
     for (size_t index = 0; index < calculate_descriptors_count(request.block_count()); index++) {
-        allocated_dma_regions.append(m_dma_buffers.at(index));
+        allocated_dma_regions.append(m_dma_buffers.at(slot * dma_pages_per_command_slot + index));
     }
 
-    m_current_scatter_list = ScatterList::create(request, allocated_dma_regions, m_connected_device->block_size());
+    auto& command_slot = m_command_slots[slot];
+    command_slot.scatter_list = ScatterList::create(request, allocated_dma_regions, m_connected_device->block_size());
     if (request.request_type() == AsyncBlockDeviceRequest::Write) {
-        if (!request.read_from_buffer(request.buffer(), m_current_scatter_list->dma_region().as_ptr(), m_connected_device->block_size() * request.block_count())) {
+        if (!request.read_from_buffer(request.buffer(), command_slot.scatter_list->dma_region().as_ptr(), m_connected_device->block_size() * request.block_count())) {
             return AsyncDeviceRequest::MemoryFault;
         }
     }
@@ -476,34 +480,98 @@ void AHCIPort::start_request(AsyncBlockDeviceRequest& request)
 {
     LOCKER(m_lock);
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request start", representative_port_index());
-    VERIFY(!m_current_request);
-    VERIFY(!m_current_scatter_list);
+    m_pending_requests.append(request);
+    issue_pending_requests();
+}
 
-    m_current_request = request;
+void AHCIPort::issue_pending_requests()
+{
+    VERIFY(m_lock.is_locked());
+    while (!m_pending_requests.is_empty()) {
+        if (!is_operable()) {
+            // The port was shut down after a fatal error, so there is nothing left to issue commands to.
+            m_pending_requests.take_first()->complete(AsyncDeviceRequest::Failure);
+            continue;
+        }
+        auto unused_command_header = try_to_find_unused_command_header();
+        if (!unused_command_header.has_value())
+            return;
+        auto slot = unused_command_header.value();
+        auto& command_slot = m_command_slots[slot];
+        VERIFY(!command_slot.request);
+        VERIFY(!command_slot.scatter_list);
+
+        auto request = m_pending_requests.take_first();
+        command_slot.request = request;
+
+        auto result = prepare_and_set_scatter_list(slot, request);
+        if (result.has_value()) {
+            dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure.", representative_port_index());
+            complete_request_in_slot(slot, result.value());
+            continue;
+        }
 
-    auto result = prepare_and_set_scatter_list(request);
-    if (result.has_value()) {
-        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure.", representative_port_index());
-        m_lock.unlock();
-        complete_current_request(result.value());
-        return;
+        if (!access_device(slot, request->request_type(), request->block_index(), request->block_count())) {
+            dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure.", representative_port_index());
+            complete_request_in_slot(slot, AsyncDeviceRequest::Failure);
+            continue;
+        }
     }
+}
 
-    auto success = access_device(request.request_type(), request.block_index(), request.block_count());
-    if (!success) {
-        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure.", representative_port_index());
-        m_lock.unlock();
-        complete_current_request(AsyncDeviceRequest::Failure);
-        return;
+void AHCIPort::complete_finished_requests()
+{
+    LOCKER(m_lock);
+    // A queued command stays set in PxSACT until the device reports it as done, a
+    // non-queued one stays set in PxCI. Any slot we issued that is clear in both
+    // has finished, in whatever order the device chose to service them.
+    u32 finished_command_slots = m_issued_command_slots & ~(m_port_registers.sact | m_port_registers.ci);
+    for (u8 slot = 0; slot < m_command_slots_count; slot++) {
+        if (!(finished_command_slots & (1u << slot)))
+            continue;
+        m_issued_command_slots &= ~(1u << slot);
+
+        auto& command_slot = m_command_slots[slot];
+        VERIFY(command_slot.request);
+        VERIFY(command_slot.scatter_list);
+        auto& request = *command_slot.request;
+        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request in slot {} handled", representative_port_index(), slot);
+        if (request.request_type() == AsyncBlockDeviceRequest::Read) {
+            if (!request.write_to_buffer(request.buffer(), command_slot.scatter_list->dma_region().as_ptr(), m_connected_device->block_size() * request.block_count())) {
+                dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure, memory fault occurred when reading in data.", representative_port_index());
+                complete_request_in_slot(slot, AsyncDeviceRequest::MemoryFault);
+                continue;
+            }
+        }
+        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request success", representative_port_index());
+        complete_request_in_slot(slot, AsyncDeviceRequest::Success);
+    }
+
+    issue_pending_requests();
+}
+
+void AHCIPort::fail_all_requests()
+{
+    LOCKER(m_lock);
+    m_issued_command_slots = 0;
+    for (u8 slot = 0; slot < m_command_slots_count; slot++) {
+        if (m_command_slots[slot].request)
+            complete_request_in_slot(slot, AsyncDeviceRequest::Failure);
     }
+    while (!m_pending_requests.is_empty())
+        m_pending_requests.take_first()->complete(AsyncDeviceRequest::Failure);
 }
 
-void AHCIPort::complete_current_request(AsyncDeviceRequest::RequestResult result)
+void AHCIPort::complete_request_in_slot(u8 slot, AsyncDeviceRequest::RequestResult result)
 {
-    VERIFY(m_current_request);
-    auto current_request = m_current_request;
-    m_current_request.clear();
-    current_request->complete(result);
+    VERIFY(m_lock.is_locked());
+    auto& command_slot = m_command_slots[slot];
+    VERIFY(command_slot.request);
+    auto request = move(command_slot.request);
+    command_slot.scatter_list = nullptr;
+    // Completing the request may hand us the next one from the device queue right away,
+    // so the slot has to be free by now.
+    request->complete(result);
 }
 
 bool AHCIPort::spin_until_ready() const
@@ -522,35 +590,35 @@ bool AHCIPort::spin_until_ready() const
     return true;
 }
 
-bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64 lba, u8 block_count)
+bool AHCIPort::access_device(u8 slot, AsyncBlockDeviceRequest::RequestType direction, u64 lba, u8 block_count)
 {
     VERIFY(m_connected_device);
     VERIFY(is_operable());
     VERIFY(m_lock.is_locked());
-    VERIFY(m_current_scatter_list);
+    auto& scatter_list = m_command_slots[slot].scatter_list;
+    VERIFY(scatter_list);
     ScopedSpinLock lock(m_hard_lock);
 
-    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Do a {}, lba {}, block count {}", representative_port_index(), direction == AsyncBlockDeviceRequest::RequestType::Write ? "write" : "read", lba, block_count);
-    if (!spin_until_ready())
+    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Do a {}, lba {}, block count {}, slot {}", representative_port_index(), direction == AsyncBlockDeviceRequest::RequestType::Write ? "write" : "read", lba, block_count, slot);
+    // Queued commands may be issued while others are still being serviced, so
+    // only non-queued commands have to wait for the device to become idle.
+    if (!m_ncq_enabled && !spin_until_ready())
         return false;
-
-    auto unused_command_header = try_to_find_unused_command_header();
-    VERIFY(unused_command_header.has_value());
     auto* command_list_entries = (volatile AHCI::CommandHeader*)m_command_list_region->vaddr().as_ptr();
-    command_list_entries[unused_command_header.value()].ctba = m_command_table_pages[unused_command_header.value()].paddr().get();
-    command_list_entries[unused_command_header.value()].ctbau = 0;
-    command_list_entries[unused_command_header.value()].prdbc = 0;
-    command_list_entries[unused_command_header.value()].prdtl = m_current_scatter_list->scatters_count();
+    command_list_entries[slot].ctba = m_command_table_pages[slot].paddr().get();
+    command_list_entries[slot].ctbau = 0;
+    command_list_entries[slot].prdbc = 0;
+    command_list_entries[slot].prdtl = scatter_list->scatters_count();
 
     // Note: we must set the correct Dword count in this register. Real hardware
     // AHCI controllers do care about this field! QEMU doesn't care if we don't
     // set the correct CFL field in this register, real hardware will set an
     // handshake error bit in PxSERR register if CFL is incorrect.
-    command_list_entries[unused_command_header.value()].attributes = (size_t)FIS::DwordCount::RegisterHostToDevice | AHCI::CommandHeaderAttributes::P | AHCI::CommandHeaderAttributes::C | (is_atapi_attached() ? AHCI::CommandHeaderAttributes::A : 0) | (direction == AsyncBlockDeviceRequest::RequestType::Write ? AHCI::CommandHeaderAttributes::W : 0);
+    command_list_entries[slot].attributes = (size_t)FIS::DwordCount::RegisterHostToDevice | AHCI::CommandHeaderAttributes::P | AHCI::CommandHeaderAttributes::C | (is_atapi_attached() ? AHCI::CommandHeaderAttributes::A : 0) | (direction == AsyncBlockDeviceRequest::RequestType::Write ? AHCI::CommandHeaderAttributes::W : 0);
 
-    dbgln_if(AHCI_DEBUG, "AHCI Port {}: CLE: ctba=0x{:08x}, ctbau=0x{:08x}, prdbc=0x{:08x}, prdtl=0x{:04x}, attributes=0x{:04x}", representative_port_index(), (u32)command_list_entries[unused_command_header.value()].ctba, (u32)command_list_entries[unused_command_header.value()].ctbau, (u32)command_list_entries[unused_command_header.value()].prdbc, (u16)command_list_entries[unused_command_header.value()].prdtl, (u16)command_list_entries[unused_command_header.value()].attributes);
+    dbgln_if(AHCI_DEBUG, "AHCI Port {}: CLE: ctba=0x{:08x}, ctbau=0x{:08x}, prdbc=0x{:08x}, prdtl=0x{:04x}, attributes=0x{:04x}", representative_port_index(), (u32)command_list_entries[slot].ctba, (u32)command_list_entries[slot].ctbau, (u32)command_list_entries[slot].prdbc, (u16)command_list_entries[slot].prdtl, (u16)command_list_entries[slot].attributes);
 
-    auto command_table_region = MM.allocate_kernel_region(m_command_table_pages[unused_command_header.value()].paddr().page_base(), page_round_up(sizeof(AHCI::CommandTable)), "AHCI Command Table", Region::Access::Read | Region::Access::Write, Region::Cacheable::No);
+    auto command_table_region = MM.allocate_kernel_region(m_command_table_pages[slot].paddr().page_base(), page_round_up(sizeof(AHCI::CommandTable)), "AHCI Command Table", Region::Access::Read | Region::Access::Write, Region::Cacheable::No);
     auto& command_table = *(volatile AHCI::CommandTable*)command_table_region->vaddr().as_ptr();
 
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: Allocated command table at {}", representative_port_index(), command_table_region->vaddr());
@@ -559,7 +627,7 @@ bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64
 
     size_t scatter_entry_index = 0;
     size_t data_transfer_count = (block_count * m_connected_device->block_size());
-    for (auto scatter_page : m_current_scatter_list->vmobject().physical_pages()) {
+    for (auto scatter_page : scatter_list->vmobject().physical_pages()) {
         VERIFY(data_transfer_count != 0);
         VERIFY(scatter_page);
         dbgln_if(AHCI_DEBUG, "AHCI Port {}: Add a transfer scatter entry @ {}", representative_port_index(), scatter_page->paddr());
@@ -583,6 +651,11 @@ bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64
     if (is_atapi_attached()) {
         fis.command = ATA_CMD_PACKET;
         TODO();
+    } else if (m_ncq_enabled) {
+        if (direction == AsyncBlockDeviceRequest::RequestType::Write)
+            fis.command = ATA_CMD_WRITE_FPDMA_QUEUED;
+        else
+            fis.command = ATA_CMD_READ_FPDMA_QUEUED;
     } else {
         if (direction == AsyncBlockDeviceRequest::RequestType::Write)
             fis.command = ATA_CMD_WRITE_DMA_EXT;
@@ -601,17 +674,27 @@ bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64
     fis.lba_low[0] = lba & 0xff;
     fis.lba_low[1] = (lba >> 8) & 0xff;
     fis.lba_low[2] = (lba >> 16) & 0xff;
-    fis.count = (block_count);
+    if (m_ncq_enabled) {
+        // FPDMA QUEUED commands carry the sector count in the features field,
+        // and the tag (which we keep equal to the command slot) in bits 7:3 of the count field.
+        fis.features_low = block_count;
+        fis.features_high = 0;
+        fis.count = slot << 3;
+    } else {
+        fis.count = (block_count);
+    }
 
     // The below loop waits until the port is no longer busy before issuing a new command
-    if (!spin_until_ready())
+    if (!m_ncq_enabled && !spin_until_ready())
         return false;
 
     full_memory_barrier();
-    mark_command_header_ready_to_process(unused_command_header.value());
+    if (m_ncq_enabled)
+        m_port_registers.sact = 1u << slot;
+    mark_command_header_ready_to_process(slot);
     full_memory_barrier();
 
-    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Do a {}, lba {}, block count {} @ {}, ended", representative_port_index(), direction == AsyncBlockDeviceRequest::RequestType::Write ? "write" : "read", lba, block_count, m_dma_buffers[0].paddr());
+    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Do a {}, lba {}, block count {} @ {}, ended", representative_port_index(), direction == AsyncBlockDeviceRequest::RequestType::Write ? "write" : "read", lba, block_count, m_dma_buffers[slot * dma_pages_per_command_slot].paddr());
     return true;
 }
 
@@ -687,8 +770,10 @@ bool AHCIPort::shutdown()
 Optional<u8> AHCIPort::try_to_find_unused_command_header()
 {
     VERIFY(m_lock.is_locked());
-    u32 commands_issued = m_port_registers.ci;
-    for (size_t index = 0; index < 32; index++) {
+    // A slot is only free once we have completed its request, which may be a while
+    // after the HBA cleared its PxCI bit.
+    u32 commands_issued = m_port_registers.ci | m_issued_command_slots;
+    for (size_t index = 0; index < m_command_slots_count; index++) {
         if (!(commands_issued & 1)) {
             dbgln_if(AHCI_DEBUG, "AHCI Port {}: unused command header at index {}", representative_port_index(), index);
             return index;
@@ -707,13 +792,13 @@ void AHCIPort::start_command_list_processing() const
     m_port_registers.cmd = m_port_registers.cmd | 1;
 }
 
-void AHCIPort::mark_command_header_ready_to_process(u8 command_header_index) const
+void AHCIPort::mark_command_header_ready_to_process(u8 command_header_index)
 {
     VERIFY(m_lock.is_locked());
     VERIFY(m_hard_lock.is_locked());
     VERIFY(is_operable());
-    VERIFY(!m_wait_for_completion);
-    m_wait_for_completion = true;
+    VERIFY(!(m_issued_command_slots & (1u << command_header_index)));
+    m_issued_command_slots |= 1u << command_header_index;
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: Marking command header at index {} as ready to process.", representative_port_index(), command_header_index);
     m_port_registers.ci = 1 << command_header_index;
 }
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/OwnPtr.h>
 #include <AK/RefPtr.h>
 #include <Kernel/Devices/Device.h>
@@ -76,6 +77,8 @@ public:
     bool is_atapi_attached() const { return m_port_registers.sig == (u32)AHCI::DeviceSignature::ATAPI; };
 
     RefPtr<StorageDevice> connected_device() const { return m_connected_device; }
+    size_t command_slots_count() const { return m_command_slots_count; }
+    bool is_ncq_enabled() const { return m_ncq_enabled; }
 
     bool reset();
     UNMAP_AFTER_INIT bool initialize_without_reset();
@@ -102,10 +105,13 @@ private:
     ALWAYS_INLINE void power_on() const;
 
     void start_request(AsyncBlockDeviceRequest&);
-    void complete_current_request(AsyncDeviceRequest::RequestResult);
-    bool access_device(AsyncBlockDeviceRequest::RequestType, u64 lba, u8 block_count);
+    void issue_pending_requests();
+    void complete_finished_requests();
+    void fail_all_requests();
+    void complete_request_in_slot(u8 slot, AsyncDeviceRequest::RequestResult);
+    bool access_device(u8 slot, AsyncBlockDeviceRequest::RequestType, u64 lba, u8 block_count);
     size_t calculate_descriptors_count(size_t block_count) const;
-    [[nodiscard]] Optional<AsyncDeviceRequest::RequestResult> prepare_and_set_scatter_list(AsyncBlockDeviceRequest& request);
+    [[nodiscard]] Optional<AsyncDeviceRequest::RequestResult> prepare_and_set_scatter_list(u8 slot, AsyncBlockDeviceRequest& request);
 
     ALWAYS_INLINE bool is_interrupts_enabled() const;
 
@@ -114,7 +120,7 @@ private:
     bool identify_device(ScopedSpinLock<SpinLock<u8>>&);
 
     ALWAYS_INLINE void start_command_list_processing() const;
-    ALWAYS_INLINE void mark_command_header_ready_to_process(u8 command_header_index) const;
+    ALWAYS_INLINE void mark_command_header_ready_to_process(u8 command_header_index);
     ALWAYS_INLINE void stop_command_list_processing() const;
 
     ALWAYS_INLINE void start_fis_receiving() const;
@@ -131,14 +137,28 @@ private:
 
     // Data members
 
+    struct CommandSlot {
+        RefPtr<AsyncBlockDeviceRequest> request;
+        RefPtr<AHCIPort::ScatterList> scatter_list;
+    };
+
     EntropySource m_entropy_source;
-    RefPtr<AsyncBlockDeviceRequest> m_current_request;
+    // Requests that are waiting for a free command slot.
+    Vector<NonnullRefPtr<AsyncBlockDeviceRequest>> m_pending_requests;
+    // Indexed by command slot, which is also the NCQ tag when NCQ is enabled.
+    Array<CommandSlot, 32> m_command_slots;
+    // Bitmask of the command slots that were handed to the HBA and have not been completed yet.
+    u32 m_issued_command_slots { 0 };
+    size_t m_command_slots_count { 1 };
+    bool m_ncq_enabled { false };
     SpinLock<u8> m_hard_lock;
     Lock m_lock { "AHCIPort" };
 
     mutable bool m_wait_for_completion { false };
     bool m_wait_connect_for_completion { false };
 
+    // m_dma_buffers holds dma_pages_per_command_slot consecutive pages for each command slot.
+    static constexpr size_t dma_pages_per_command_slot = 1;
     NonnullRefPtrVector<PhysicalPage> m_dma_buffers;
     NonnullRefPtrVector<PhysicalPage> m_command_table_pages;
     RefPtr<PhysicalPage> m_command_list_page;
@@ -152,7 +172,6 @@ private:
     AHCI::PortInterruptStatusBitField m_interrupt_status;
     AHCI::PortInterruptEnableBitField m_interrupt_enable;
 
-    RefPtr<AHCIPort::ScatterList> m_current_scatter_list;
     bool m_disabled_by_firmware { false };
 };
 }
@@ -52,6 +52,8 @@ public:
     // ^BlockDevice
     virtual void start_request(AsyncBlockDeviceRequest&) override;
     virtual String device_name() const override;
+    // ^Device
+    virtual size_t max_in_flight_requests() const override { return m_port->command_slots_count(); }
 
 private:
     SATADiskDevice(const AHCIController&, const AHCIPort&, size_t sector_size, u64 max_addressable_block);
@@ -29,6 +29,7 @@
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/Process.h>
 #include <Kernel/VM/Region.h>
+#include <Kernel/VM/TLBFlushBatch.h>
 
 namespace Kernel {
 
@@ -83,6 +84,9 @@ KResultOr<pid_t> Process::sys$fork(RegisterState& regs)
     dbgln_if(FORK_DEBUG, "fork: child will begin executing at {:04x}:{:08x} with stack {:04x}:{:08x}, kstack {:04x}:{:08x}", child_tss.cs, child_tss.eip, child_tss.ss, child_tss.esp, child_tss.ss0, child_tss.esp0);
 
     {
+        // Making our regions copy-on-write needs a TLB shootdown for each of them,
+        // so send them to the other processors all at once.
+        TLBFlushBatch tlb_flush_batch(space().page_directory());
         ScopedSpinLock lock(space().get_lock());
         for (auto& region : space().regions()) {
             dbgln_if(FORK_DEBUG, "fork: cloning Region({}) '{}' @ {}", &region, region.name(), region.vaddr());
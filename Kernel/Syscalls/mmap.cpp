@@ -34,6 +34,7 @@
 #include <Kernel/VM/PrivateInodeVMObject.h>
 #include <Kernel/VM/Region.h>
 #include <Kernel/VM/SharedInodeVMObject.h>
+#include <Kernel/VM/TLBFlushBatch.h>
 #include <LibC/limits.h>
 #include <LibELF/Validation.h>
 
@@ -193,6 +194,7 @@ KResultOr<FlatPtr> Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> u
     bool map_fixed = flags & MAP_FIXED;
     bool map_noreserve = flags & MAP_NORESERVE;
     bool map_randomized = flags & MAP_RANDOMIZED;
+    bool map_huge = flags & MAP_HUGE;
 
     if (map_shared && map_private)
         return EINVAL;
@@ -209,6 +211,15 @@ KResultOr<FlatPtr> Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> u
     if (map_stack && (!map_private || !map_anonymous))
         return EINVAL;
 
+    // Huge mappings are populated up front, so that they can be backed by physically contiguous memory.
+    if (map_huge && (!map_anonymous || map_noreserve))
+        return EINVAL;
+
+    // Prefer huge page alignment for big mappings, so that contiguous memory (e.g. framebuffers)
+    // behind them can be mapped with huge pages.
+    if (!map_fixed)
+        alignment = max(alignment, preferred_alignment_for_size(page_round_up(size)));
+
     Region* region = nullptr;
     Optional<Range> range;
 
@@ -229,6 +240,8 @@ KResultOr<FlatPtr> Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> u
 
     if (map_anonymous) {
         auto strategy = map_noreserve ? AllocationStrategy::None : AllocationStrategy::Reserve;
+        if (map_huge)
+            strategy = AllocationStrategy::AllocateNow;
         auto region_or_error = space().allocate_region(range.value(), !name.is_null() ? name : "mmap", prot, strategy);
         if (region_or_error.is_error())
             return region_or_error.error().error();
@@ -504,19 +517,21 @@ KResultOr<int> Process::sys$munmap(Userspace<void*> addr, size_t size)
 
     Vector<Region*, 2> new_regions;
 
-    for (auto* old_region : regions) {
-        // if it's a full match we can delete the complete old region
-        if (old_region->range().intersect(range_to_unmap).size() == old_region->size()) {
-            bool res = space().deallocate_region(*old_region);
-            VERIFY(res);
-            continue;
+    {
+        // Unmap everything first and shoot down the TLBs on other processors with a single IPI.
+        // The old regions must stay alive until then, since other processors may still be using their pages.
+        TLBFlushBatch tlb_flush_batch(space().page_directory());
+        for (auto* old_region : regions) {
+            // if it's not a full match, split the regions and collect them for future mapping
+            if (old_region->range().intersect(range_to_unmap).size() != old_region->size())
+                new_regions.append(space().split_region_around_range(*old_region, range_to_unmap));
+
+            // We manually unmap the old region here, specifying that we *don't* want the VM deallocated.
+            old_region->unmap(Region::ShouldDeallocateVirtualMemoryRange::No);
         }
+    }
 
-        // otherwise just split the regions and collect them for future mapping
-        new_regions.append(space().split_region_around_range(*old_region, range_to_unmap));
-
-        // We manually unmap the old region here, specifying that we *don't* want the VM deallocated.
-        old_region->unmap(Region::ShouldDeallocateVirtualMemoryRange::No);
+    for (auto* old_region : regions) {
         bool res = space().deallocate_region(*old_region);
         VERIFY(res);
     }
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/NumericLimits.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/FileSystem/Inode.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+static constexpr size_t sendfile_chunk_size = 64 * KiB;
+
+KResultOr<ssize_t> Process::sys$sendfile(Userspace<const Syscall::SC_sendfile_params*> user_params)
+{
+    REQUIRE_PROMISE(stdio);
+
+    Syscall::SC_sendfile_params params;
+    if (!copy_from_user(&params, user_params))
+        return EFAULT;
+
+    auto in_description = file_description(params.in_fd);
+    if (!in_description)
+        return EBADF;
+    if (!in_description->is_readable())
+        return EBADF;
+    auto* inode = in_description->inode();
+    if (!inode || !inode->metadata().is_regular_file())
+        return EINVAL;
+
+    auto out_description = file_description(params.out_fd);
+    if (!out_description)
+        return EBADF;
+    if (!out_description->is_writable())
+        return EBADF;
+
+    off_t offset;
+    if (params.offset) {
+        if (!copy_from_user(&offset, params.offset))
+            return EFAULT;
+        if (offset < 0)
+            return EINVAL;
+    } else {
+        offset = in_description->offset();
+    }
+
+    size_t count = min(params.count, (size_t)NumericLimits<ssize_t>::max());
+    if (count == 0)
+        return 0;
+
+    // The data goes straight from the inode (and thus the file system's block cache) into the
+    // destination through a kernel buffer, without a round trip through userspace.
+    auto buffer = KBuffer::try_create_with_size(min(count, sendfile_chunk_size), Region::Access::Read | Region::Access::Write, "sendfile");
+    if (!buffer)
+        return ENOMEM;
+    auto kernel_buffer = UserOrKernelBuffer::for_kernel_buffer(buffer->data());
+
+    size_t total_sent = 0;
+    while (total_sent < count) {
+        size_t chunk_size = min(count - total_sent, buffer->size());
+        ssize_t nread = inode->read_bytes(offset, chunk_size, kernel_buffer, in_description);
+        if (nread < 0) {
+            if (total_sent)
+                break;
+            return KResult((ErrnoCode)-nread);
+        }
+        if (nread == 0)
+            break;
+
+        auto nwritten_or_error = do_write(*out_description, kernel_buffer, nread);
+        if (nwritten_or_error.is_error()) {
+            if (total_sent)
+                break;
+            return nwritten_or_error.error();
+        }
+        size_t nwritten = nwritten_or_error.value();
+        total_sent += nwritten;
+        offset += nwritten;
+        if (nwritten < (size_t)nread)
+            break;
+    }
+
+    if (params.offset) {
+        if (!copy_to_user(params.offset, &offset))
+            return EFAULT;
+    } else {
+        auto seek_result = in_description->seek(offset, SEEK_SET);
+        if (seek_result.is_error())
+            return seek_result.error();
+    }
+
+    return total_sent;
+}
+
+}
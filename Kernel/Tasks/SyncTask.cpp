@@ -28,19 +28,31 @@
 #include <Kernel/Process.h>
 #include <Kernel/Tasks/SyncTask.h>
 #include <Kernel/Time/TimeManagement.h>
+#include <Kernel/WaitQueue.h>
 
 namespace Kernel {
 
+static WaitQueue* s_writeback_wait_queue;
+
 void SyncTask::spawn()
 {
+    s_writeback_wait_queue = new WaitQueue;
+
     RefPtr<Thread> syncd_thread;
     Process::create_kernel_process(syncd_thread, "SyncTask", [] {
         dbgln("SyncTask is running");
         for (;;) {
-            VFS::the().sync();
-            (void)Thread::current()->sleep(Time::from_seconds(1));
+            FS::writeback();
+            auto timeout = Time::from_seconds(1);
+            [[maybe_unused]] auto result = s_writeback_wait_queue->wait_on(Thread::BlockTimeout(false, &timeout), "SyncTask");
         }
     });
 }
 
+void SyncTask::request_writeback()
+{
+    if (s_writeback_wait_queue)
+        s_writeback_wait_queue->wake_one();
+}
+
 }
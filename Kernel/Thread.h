@@ -89,6 +89,7 @@ class Thread
     friend class ProtectedProcessBase;
     friend class Scheduler;
     friend class ThreadReadyQueue;
+    friend struct ThreadReadyQueues;
 
     static SpinLock<u8> g_tid_map_lock;
     static HashMap<ThreadID, Thread*>* g_tid_map;
@@ -1075,6 +1076,9 @@ public:
     };
     PreviousMode previous_mode() const { return m_previous_mode; }
     void set_previous_mode(PreviousMode mode) { m_previous_mode = mode; }
+
+    TLBFlushBatch* tlb_flush_batch() { return m_tlb_flush_batch; }
+    void set_tlb_flush_batch(TLBFlushBatch* batch) { m_tlb_flush_batch = batch; }
     TrapFrame*& current_trap() { return m_current_trap; }
 
     RecursiveSpinLock& get_lock() const { return m_lock; }
@@ -1131,6 +1135,7 @@ private:
 
     IntrusiveListNode m_process_thread_list_node;
     int m_runnable_priority { -1 };
+    int m_runnable_cpu { -1 };
 
     friend class WaitQueue;
 
@@ -1201,6 +1206,7 @@ private:
     ThreadID m_tid { -1 };
     TSS m_tss {};
     TrapFrame* m_current_trap { nullptr };
+    TLBFlushBatch* m_tlb_flush_batch { nullptr };
     u32 m_saved_critical { 1 };
     IntrusiveListNode m_ready_queue_node;
     Atomic<u32> m_cpu { 0 };
@@ -105,9 +105,24 @@ AnonymousVMObject::AnonymousVMObject(size_t size, AllocationStrategy strategy)
     , m_unused_committed_pages(strategy == AllocationStrategy::Reserve ? page_count() : 0)
 {
     if (strategy == AllocationStrategy::AllocateNow) {
-        // Allocate all pages right now. We know we can get all because we committed the amount needed
-        for (size_t i = 0; i < page_count(); ++i)
-            physical_pages()[i] = MM.allocate_committed_user_physical_page(MemoryManager::ShouldZeroFill::Yes);
+        // Allocate all pages right now. We know we can get all because we committed the amount needed.
+        // Prefer whole huge pages, so that regions mapping us can use huge page mappings.
+        constexpr size_t pages_per_huge_page = HUGE_PAGE_SIZE / PAGE_SIZE;
+        bool try_huge_pages = true;
+        size_t i = 0;
+        while (i < page_count()) {
+            if (try_huge_pages && page_count() - i >= pages_per_huge_page) {
+                auto huge_page = MM.allocate_committed_user_physical_huge_page(MemoryManager::ShouldZeroFill::Yes);
+                if (!huge_page.is_empty()) {
+                    for (auto& page : huge_page)
+                        physical_pages()[i++] = page;
+                    continue;
+                }
+                // Physical memory is too fragmented, don't bother trying again for this object.
+                try_huge_pages = false;
+            }
+            physical_pages()[i++] = MM.allocate_committed_user_physical_page(MemoryManager::ShouldZeroFill::Yes);
+        }
     } else {
         auto& initial_page = (strategy == AllocationStrategy::Reserve) ? MM.lazy_committed_page() : MM.shared_zero_page();
         for (size_t i = 0; i < page_count(); ++i)
@@ -50,6 +50,21 @@ InodeVMObject::~InodeVMObject()
 {
 }
 
+size_t InodeVMObject::read_ahead_page_count_for_fault(size_t page_index) const
+{
+    VERIFY(m_paging_lock.is_locked());
+    if (m_read_ahead_page_count && page_index == m_read_ahead_next_page_index)
+        return min(m_read_ahead_page_count * 2, max_read_ahead_page_count);
+    return initial_read_ahead_page_count;
+}
+
+void InodeVMObject::did_read_ahead(size_t page_index, size_t page_count)
+{
+    VERIFY(m_paging_lock.is_locked());
+    m_read_ahead_next_page_index = page_index + page_count;
+    m_read_ahead_page_count = page_count;
+}
+
 size_t InodeVMObject::amount_clean() const
 {
     size_t count = 0;
@@ -47,6 +47,14 @@ public:
     u32 writable_mappings() const;
     u32 executable_mappings() const;
 
+    // Read-ahead bookkeeping for Region::handle_inode_fault(), which holds m_paging_lock.
+    // A fault right where the previous read-ahead window ended doubles the next window,
+    // anything else starts over with a small one.
+    static constexpr size_t initial_read_ahead_page_count = 4;
+    static constexpr size_t max_read_ahead_page_count = 32;
+    size_t read_ahead_page_count_for_fault(size_t page_index) const;
+    void did_read_ahead(size_t page_index, size_t page_count);
+
 protected:
     explicit InodeVMObject(Inode&, size_t);
     explicit InodeVMObject(const InodeVMObject&);
@@ -61,6 +69,9 @@ protected:
 
     NonnullRefPtr<Inode> m_inode;
     Bitmap m_dirty_pages;
+
+    size_t m_read_ahead_next_page_index { 0 };
+    size_t m_read_ahead_page_count { 0 };
 };
 
 }
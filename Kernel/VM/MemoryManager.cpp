@@ -34,12 +34,14 @@
 #include <Kernel/Multiboot.h>
 #include <Kernel/Process.h>
 #include <Kernel/StdLib.h>
+#include <Kernel/Tasks/PageZeroingTask.h>
 #include <Kernel/VM/AnonymousVMObject.h>
 #include <Kernel/VM/ContiguousVMObject.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/PageDirectory.h>
 #include <Kernel/VM/PhysicalRegion.h>
 #include <Kernel/VM/SharedInodeVMObject.h>
+#include <Kernel/VM/TLBFlushBatch.h>
 
 extern u8* start_of_kernel_image;
 extern u8* end_of_kernel_image;
@@ -327,7 +329,8 @@ PageTableEntry* MemoryManager::pte(PageDirectory& page_directory, VirtualAddress
 
     auto* pd = quickmap_pd(const_cast<PageDirectory&>(page_directory), page_directory_table_index);
     const PageDirectoryEntry& pde = pd[page_directory_index];
-    if (!pde.is_present())
+    // Huge pages are mapped directly by the page directory and have no PTEs.
+    if (!pde.is_present() || pde.is_huge())
         return nullptr;
 
     return &quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()))[page_table_index];
@@ -343,6 +346,12 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
     u32 page_table_index = (vaddr.get() >> 12) & 0x1ff;
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
+    if (pd[page_directory_index].is_huge()) {
+        // Someone wants to change a single page inside a huge page, so break it up into 4 KiB pages first.
+        if (!split_huge_pde(page_directory, vaddr))
+            return nullptr;
+        pd = quickmap_pd(page_directory, page_directory_table_index);
+    }
     PageDirectoryEntry& pde = pd[page_directory_index];
     if (!pde.is_present()) {
         bool did_purge = false;
@@ -374,6 +383,87 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
     return &quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()))[page_table_index];
 }
 
+PageDirectoryEntry* MemoryManager::ensure_huge_pde(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    VERIFY(s_mm_lock.own_lock());
+    VERIFY(page_directory.get_lock().own_lock());
+    VERIFY((vaddr.get() & ~HUGE_PAGE_MASK) == 0);
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x3;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+
+    auto* pd = quickmap_pd(page_directory, page_directory_table_index);
+    PageDirectoryEntry& pde = pd[page_directory_index];
+    if (!pde.is_present() || pde.is_huge())
+        return &pde;
+
+    // There's already a page table here. We can only replace it if nothing is mapped through it.
+    auto* page_table = quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()));
+    for (u32 i = 0; i <= 0x1ff; i++) {
+        if (!page_table[i].is_null())
+            return nullptr;
+    }
+    pde.clear();
+    auto result = page_directory.m_page_tables.remove(vaddr.get());
+    VERIFY(result);
+    return &pde;
+}
+
+bool MemoryManager::split_huge_pde(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    VERIFY(s_mm_lock.own_lock());
+    VERIFY(page_directory.get_lock().own_lock());
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x3;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+
+    bool did_purge = false;
+    auto page_table = allocate_user_physical_page(ShouldZeroFill::No, &did_purge);
+    if (!page_table) {
+        dbgln("MM: Unable to allocate page table to split huge page at {}", vaddr);
+        return false;
+    }
+
+    auto* pd = quickmap_pd(page_directory, page_directory_table_index);
+    PageDirectoryEntry& pde = pd[page_directory_index];
+    if (did_purge && !pde.is_huge()) {
+        // Purging remapped some pages and that already split the huge page for us.
+        return true;
+    }
+    VERIFY(pde.is_present() && pde.is_huge());
+
+    // Fill in a page table that maps exactly what the huge page did, then swap it in.
+    // Both translations are the same, so the caller only needs to flush the pages it changes afterwards.
+    FlatPtr huge_page_base = (FlatPtr)pde.huge_page_base();
+    auto* ptes = quickmap_pt(page_table->paddr());
+    for (u32 i = 0; i <= 0x1ff; i++) {
+        auto& pte = ptes[i];
+        pte.clear();
+        pte.set_physical_page_base(huge_page_base + i * PAGE_SIZE);
+        pte.set_present(true);
+        pte.set_writable(pde.is_writable());
+        pte.set_user_allowed(pde.is_user_allowed());
+        pte.set_cache_disabled(pde.is_cache_disabled());
+        pte.set_write_through(pde.is_write_through());
+        pte.set_execute_disabled(pde.is_execute_disabled());
+    }
+
+    PageDirectoryEntry new_pde;
+    new_pde.clear();
+    new_pde.set_page_table_base(page_table->paddr().get());
+    new_pde.set_user_allowed(true);
+    new_pde.set_present(true);
+    new_pde.set_writable(true);
+    new_pde.set_global(&page_directory == m_kernel_page_directory.ptr());
+    pde.copy_from(Badge<MemoryManager> {}, new_pde);
+
+    auto result = page_directory.m_page_tables.set(vaddr.get() & ~0x1fffff, move(page_table));
+    VERIFY(result == AK::HashSetResult::InsertedNewEntry);
+    --m_huge_pages_mapped;
+    ++m_huge_pages_split;
+    return true;
+}
+
 void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress vaddr, bool is_last_release)
 {
     VERIFY_INTERRUPTS_DISABLED();
@@ -385,6 +475,12 @@ void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress va
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     PageDirectoryEntry& pde = pd[page_directory_index];
+    if (pde.is_huge()) {
+        // A huge page never spans more than one region, so releasing any of its pages releases all of them.
+        pde.clear();
+        --m_huge_pages_mapped;
+        return;
+    }
     if (pde.is_present()) {
         auto* page_table = quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()));
         auto& pte = page_table[page_table_index];
@@ -419,6 +515,9 @@ UNMAP_AFTER_INIT void MemoryManager::initialize(u32 cpu)
         s_the = new MemoryManager;
         kmalloc_enable_expand();
     }
+
+    ScopedSpinLock lock(s_mm_lock);
+    MM.m_processor_data.append(mm_data);
 }
 
 Region* MemoryManager::kernel_region_from_vaddr(VirtualAddress vaddr)
@@ -485,7 +584,7 @@ OwnPtr<Region> MemoryManager::allocate_contiguous_kernel_region(size_t size, Str
 {
     VERIFY(!(size % PAGE_SIZE));
     ScopedSpinLock lock(s_mm_lock);
-    auto range = kernel_page_directory().range_allocator().allocate_anywhere(size);
+    auto range = kernel_page_directory().range_allocator().allocate_anywhere(size, preferred_alignment_for_size(size));
     if (!range.has_value())
         return {};
     auto vmobject = ContiguousVMObject::create_with_size(size, physical_alignment);
@@ -496,7 +595,7 @@ OwnPtr<Region> MemoryManager::allocate_kernel_region(size_t size, String name, R
 {
     VERIFY(!(size % PAGE_SIZE));
     ScopedSpinLock lock(s_mm_lock);
-    auto range = kernel_page_directory().range_allocator().allocate_anywhere(size);
+    auto range = kernel_page_directory().range_allocator().allocate_anywhere(size, preferred_alignment_for_size(size));
     if (!range.has_value())
         return {};
     auto vmobject = AnonymousVMObject::create_with_size(size, strategy);
@@ -509,7 +608,7 @@ OwnPtr<Region> MemoryManager::allocate_kernel_region(PhysicalAddress paddr, size
 {
     VERIFY(!(size % PAGE_SIZE));
     ScopedSpinLock lock(s_mm_lock);
-    auto range = kernel_page_directory().range_allocator().allocate_anywhere(size);
+    auto range = kernel_page_directory().range_allocator().allocate_anywhere(size, preferred_alignment_for_size(size));
     if (!range.has_value())
         return {};
     auto vmobject = AnonymousVMObject::create_for_physical_range(paddr, size);
@@ -544,20 +643,30 @@ OwnPtr<Region> MemoryManager::allocate_kernel_region_with_vmobject(VMObject& vmo
 {
     VERIFY(!(size % PAGE_SIZE));
     ScopedSpinLock lock(s_mm_lock);
-    auto range = kernel_page_directory().range_allocator().allocate_anywhere(size);
+    auto range = kernel_page_directory().range_allocator().allocate_anywhere(size, preferred_alignment_for_size(size));
     if (!range.has_value())
         return {};
     return allocate_kernel_region_with_vmobject(range.value(), vmobject, move(name), access, cacheable);
 }
 
+bool MemoryManager::try_to_take_uncommitted_user_physical_pages(size_t page_count)
+{
+    // Single page allocations update this without holding s_mm_lock.
+    unsigned uncommitted = m_user_physical_pages_uncommitted.load();
+    do {
+        if (uncommitted < page_count)
+            return false;
+    } while (!m_user_physical_pages_uncommitted.compare_exchange_strong(uncommitted, uncommitted - page_count));
+    return true;
+}
+
 bool MemoryManager::commit_user_physical_pages(size_t page_count)
 {
     VERIFY(page_count > 0);
     ScopedSpinLock lock(s_mm_lock);
-    if (m_user_physical_pages_uncommitted < page_count)
+    if (!try_to_take_uncommitted_user_physical_pages(page_count))
         return false;
 
-    m_user_physical_pages_uncommitted -= page_count;
     m_user_physical_pages_committed += page_count;
     return true;
 }
@@ -574,78 +683,253 @@ void MemoryManager::uncommit_user_physical_pages(size_t page_count)
 
 void MemoryManager::deallocate_user_physical_page(const PhysicalPage& page)
 {
+    bool did_cache_page = false;
+    {
+        auto& mm_data = get_data();
+        ScopedSpinLock magazine_lock(mm_data.m_page_magazine_lock);
+        if (mm_data.m_page_magazine_size < MemoryManagerData::page_magazine_capacity) {
+            mm_data.m_page_magazine[mm_data.m_page_magazine_size++] = page.paddr();
+            did_cache_page = true;
+        }
+    }
+
+    if (!did_cache_page) {
+        // The magazine is full, hand a batch of pages back to the physical regions.
+        // NOTE: We take s_mm_lock before the magazine lock and hold it until the batch is back in the regions,
+        //       so that find_free_user_physical_page() can't miss these pages while they're in transit.
+        ScopedSpinLock lock(s_mm_lock);
+        auto& mm_data = get_data();
+        ScopedSpinLock magazine_lock(mm_data.m_page_magazine_lock);
+        // We may have been preempted and moved to another processor in the meantime,
+        // so the magazine might not be full anymore.
+        if (mm_data.m_page_magazine_size == MemoryManagerData::page_magazine_capacity) {
+            mm_data.m_page_magazine_size -= MemoryManagerData::page_magazine_batch_size;
+            return_user_physical_pages_to_regions({ mm_data.m_page_magazine + mm_data.m_page_magazine_size, MemoryManagerData::page_magazine_batch_size });
+        }
+        mm_data.m_page_magazine[mm_data.m_page_magazine_size++] = page.paddr();
+    }
+
+    --m_user_physical_pages_used;
+
+    // Always return pages to the uncommitted pool. Pages that were
+    // committed and allocated are only freed upon request. Once
+    // returned there is no guarantee being able to get them back.
+    ++m_user_physical_pages_uncommitted;
+}
+
+void MemoryManager::return_user_physical_pages_to_regions(Span<const PhysicalAddress> pages)
+{
+    VERIFY(s_mm_lock.own_lock());
+    for (auto paddr : pages) {
+        bool returned = false;
+        for (auto& region : m_user_physical_regions) {
+            if (!region.contains(paddr))
+                continue;
+            region.return_page(paddr);
+            returned = true;
+            break;
+        }
+        if (!returned) {
+            dmesgln("MM: deallocate_user_physical_page couldn't figure out region for user page @ {}", paddr);
+            VERIFY_NOT_REACHED();
+        }
+    }
+}
+
+Optional<PhysicalAddress> MemoryManager::take_free_user_physical_page()
+{
+    {
+        auto& mm_data = get_data();
+        ScopedSpinLock magazine_lock(mm_data.m_page_magazine_lock);
+        if (mm_data.m_page_magazine_size)
+            return mm_data.m_page_magazine[--mm_data.m_page_magazine_size];
+    }
+
+    // Our magazine is empty, so refill it with a batch of pages from the physical regions.
+    // NOTE: We hold s_mm_lock until the whole batch has made it into our magazine,
+    //       so that find_free_user_physical_page() can't miss these pages while they're in transit.
     ScopedSpinLock lock(s_mm_lock);
+    PhysicalAddress pages[MemoryManagerData::page_magazine_batch_size];
+    size_t page_count = 0;
     for (auto& region : m_user_physical_regions) {
-        if (!region.contains(page))
-            continue;
-
-        region.return_page(page);
-        --m_user_physical_pages_used;
+        page_count += region.take_free_pages({ pages + page_count, MemoryManagerData::page_magazine_batch_size - page_count });
+        if (page_count == MemoryManagerData::page_magazine_batch_size)
+            break;
+    }
+    if (!page_count) {
+        // The regions are empty, but other processors may still be caching free pages.
+        return steal_page_from_page_magazines();
+    }
 
-        // Always return pages to the uncommitted pool. Pages that were
-        // committed and allocated are only freed upon request. Once
-        // returned there is no guarantee being able to get them back.
-        ++m_user_physical_pages_uncommitted;
-        return;
+    size_t overflow_count = 0;
+    {
+        auto& mm_data = get_data();
+        ScopedSpinLock magazine_lock(mm_data.m_page_magazine_lock);
+        // We may have been preempted and moved to another processor before taking s_mm_lock,
+        // so the magazine might not be empty anymore.
+        for (size_t i = 1; i < page_count; ++i) {
+            if (mm_data.m_page_magazine_size == MemoryManagerData::page_magazine_capacity)
+                pages[1 + overflow_count++] = pages[i];
+            else
+                mm_data.m_page_magazine[mm_data.m_page_magazine_size++] = pages[i];
+        }
     }
+    if (overflow_count)
+        return_user_physical_pages_to_regions({ pages + 1, overflow_count });
+    return pages[0];
+}
 
-    dmesgln("MM: deallocate_user_physical_page couldn't figure out region for user page @ {}", page.paddr());
-    VERIFY_NOT_REACHED();
+Optional<PhysicalAddress> MemoryManager::steal_page_from_page_magazines()
+{
+    VERIFY(s_mm_lock.own_lock());
+    for (auto* mm_data : m_processor_data) {
+        ScopedSpinLock magazine_lock(mm_data->m_page_magazine_lock);
+        if (mm_data->m_page_magazine_size)
+            return mm_data->m_page_magazine[--mm_data->m_page_magazine_size];
+    }
+    return {};
 }
 
-RefPtr<PhysicalPage> MemoryManager::find_free_user_physical_page(bool committed)
+RefPtr<PhysicalPage> MemoryManager::find_free_user_physical_page(bool committed, ShouldZeroFill should_zero_fill)
 {
-    VERIFY(s_mm_lock.is_locked());
-    RefPtr<PhysicalPage> page;
     if (committed) {
         // Draw from the committed pages pool. We should always have these pages available
         VERIFY(m_user_physical_pages_committed > 0);
         m_user_physical_pages_committed--;
     } else {
         // We need to make sure we don't touch pages that we have committed to
-        if (m_user_physical_pages_uncommitted == 0)
+        if (!try_to_take_uncommitted_user_physical_pages(1))
             return {};
-        m_user_physical_pages_uncommitted--;
     }
-    for (auto& region : m_user_physical_regions) {
-        page = region.take_free_page(false);
-        if (!page.is_null()) {
-            ++m_user_physical_pages_used;
-            break;
+
+    Optional<PhysicalAddress> paddr;
+    bool needs_zero_fill = should_zero_fill == ShouldZeroFill::Yes;
+    if (needs_zero_fill) {
+        paddr = take_page_from_zeroed_page_pool();
+        if (paddr.has_value()) {
+            ++m_zeroed_page_pool_hits;
+            needs_zero_fill = false;
+        } else {
+            ++m_zeroed_page_pool_misses;
         }
     }
-    VERIFY(!committed || !page.is_null());
-    return page;
+    if (!paddr.has_value())
+        paddr = take_free_user_physical_page();
+    if (!paddr.has_value()) {
+        // The zeroed page pool is the last place where free pages may be hiding.
+        paddr = take_page_from_zeroed_page_pool();
+        needs_zero_fill = false;
+    }
+    if (!paddr.has_value()) {
+        VERIFY(!committed);
+        ++m_user_physical_pages_uncommitted;
+        return {};
+    }
+    ++m_user_physical_pages_used;
+    if (needs_zero_fill)
+        zero_fill_physical_page(paddr.value());
+    return PhysicalPage::create(paddr.value(), false);
+}
+
+Optional<PhysicalAddress> MemoryManager::take_page_from_zeroed_page_pool()
+{
+    PhysicalAddress paddr;
+    bool needs_refill;
+    {
+        ScopedSpinLock lock(m_zeroed_page_pool_lock);
+        if (!m_zeroed_page_pool_size)
+            return {};
+        paddr = m_zeroed_page_pool[--m_zeroed_page_pool_size];
+        needs_refill = m_zeroed_page_pool_size == zeroed_page_pool_low_watermark - 1;
+    }
+    if (needs_refill)
+        PageZeroingTask::request_refill();
+    return paddr;
+}
+
+bool MemoryManager::add_page_to_zeroed_page_pool()
+{
+    // PageZeroingTask is the only producer, so nobody else can fill up the pool under us.
+    if (!zeroed_page_pool_needs_refill())
+        return false;
+
+    // The page is out of sight while we zero it, so take it out of the uncommitted pool until it's in the zeroed
+    // page pool. Otherwise a committed allocation could come up empty-handed in the meantime.
+    if (!try_to_take_uncommitted_user_physical_pages(1))
+        return false;
+
+    auto paddr = take_free_user_physical_page();
+    if (!paddr.has_value()) {
+        ++m_user_physical_pages_uncommitted;
+        return false;
+    }
+
+    zero_fill_physical_page(paddr.value());
+
+    {
+        ScopedSpinLock lock(m_zeroed_page_pool_lock);
+        VERIFY(m_zeroed_page_pool_size < zeroed_page_pool_high_watermark);
+        m_zeroed_page_pool[m_zeroed_page_pool_size++] = paddr.value();
+    }
+    ++m_user_physical_pages_uncommitted;
+    return true;
+}
+
+void MemoryManager::zero_fill_physical_page(PhysicalAddress paddr)
+{
+    InterruptDisabler disabler;
+    auto* ptr = quickmap_page(paddr);
+    memset(ptr, 0, PAGE_SIZE);
+    unquickmap_page();
 }
 
 NonnullRefPtr<PhysicalPage> MemoryManager::allocate_committed_user_physical_page(ShouldZeroFill should_zero_fill)
 {
-    ScopedSpinLock lock(s_mm_lock);
-    auto page = find_free_user_physical_page(true);
+    return find_free_user_physical_page(true, should_zero_fill).release_nonnull();
+}
+
+NonnullRefPtrVector<PhysicalPage> MemoryManager::allocate_committed_user_physical_huge_page(ShouldZeroFill should_zero_fill)
+{
+    // Try to draw a naturally aligned, physically contiguous block of pages from the committed pool,
+    // so that it can be mapped with a single huge page. Returns nothing if memory is too fragmented.
+    constexpr size_t page_count = HUGE_PAGE_SIZE / PAGE_SIZE;
+    NonnullRefPtrVector<PhysicalPage> physical_pages;
+    {
+        ScopedSpinLock lock(s_mm_lock);
+        VERIFY(m_user_physical_pages_committed >= page_count);
+        for (auto& region : m_user_physical_regions) {
+            physical_pages = region.take_contiguous_free_pages(page_count, false, HUGE_PAGE_SIZE);
+            if (!physical_pages.is_empty())
+                break;
+        }
+        if (physical_pages.is_empty())
+            return {};
+        m_user_physical_pages_committed -= page_count;
+        m_user_physical_pages_used += page_count;
+    }
     if (should_zero_fill == ShouldZeroFill::Yes) {
-        auto* ptr = quickmap_page(*page);
-        memset(ptr, 0, PAGE_SIZE);
-        unquickmap_page();
+        for (auto& page : physical_pages)
+            zero_fill_physical_page(page.paddr());
     }
-    return page.release_nonnull();
+    return physical_pages;
 }
 
 RefPtr<PhysicalPage> MemoryManager::allocate_user_physical_page(ShouldZeroFill should_zero_fill, bool* did_purge)
 {
-    ScopedSpinLock lock(s_mm_lock);
-    auto page = find_free_user_physical_page(false);
+    auto page = find_free_user_physical_page(false, should_zero_fill);
     bool purged_pages = false;
 
     if (!page) {
         // We didn't have a single free physical page. Let's try to free something up!
         // First, we look for a purgeable VMObject in the volatile state.
+        ScopedSpinLock lock(s_mm_lock);
         for_each_vmobject([&](auto& vmobject) {
             if (!vmobject.is_anonymous())
                 return IterationDecision::Continue;
             int purged_page_count = static_cast<AnonymousVMObject&>(vmobject).purge_with_interrupts_disabled({});
             if (purged_page_count) {
                 dbgln("MM: Purge saved the day! Purged {} pages from AnonymousVMObject", purged_page_count);
-                page = find_free_user_physical_page(false);
+                page = find_free_user_physical_page(false, should_zero_fill);
                 purged_pages = true;
                 VERIFY(page);
                 return IterationDecision::Break;
@@ -658,12 +942,6 @@ RefPtr<PhysicalPage> MemoryManager::allocate_user_physical_page(ShouldZeroFill s
         }
     }
 
-    if (should_zero_fill == ShouldZeroFill::Yes) {
-        auto* ptr = quickmap_page(*page);
-        memset(ptr, 0, PAGE_SIZE);
-        unquickmap_page();
-    }
-
     if (did_purge)
         *did_purge = purged_pages;
     return page;
@@ -697,7 +975,7 @@ NonnullRefPtrVector<PhysicalPage> MemoryManager::allocate_contiguous_supervisor_
     for (auto& region : m_super_physical_regions) {
         physical_pages = region.take_contiguous_free_pages(count, true, physical_alignment);
         if (!physical_pages.is_empty())
-            continue;
+            break;
     }
 
     if (physical_pages.is_empty()) {
@@ -764,6 +1042,12 @@ void MemoryManager::flush_tlb_local(VirtualAddress vaddr, size_t page_count)
 
 void MemoryManager::flush_tlb(const PageDirectory* page_directory, VirtualAddress vaddr, size_t page_count)
 {
+    auto* current_thread = Thread::current();
+    if (current_thread && current_thread->tlb_flush_batch() && current_thread->tlb_flush_batch()->add(page_directory, vaddr, page_count)) {
+        // Keep this processor's TLB up to date right away, the other processors get the whole batch later.
+        Processor::flush_tlb_local(vaddr, page_count);
+        return;
+    }
     Processor::flush_tlb(page_directory, vaddr, page_count);
 }
 
@@ -821,18 +1105,23 @@ PageTableEntry* MemoryManager::quickmap_pt(PhysicalAddress pt_paddr)
 }
 
 u8* MemoryManager::quickmap_page(PhysicalPage& physical_page)
+{
+    return quickmap_page(physical_page.paddr());
+}
+
+u8* MemoryManager::quickmap_page(PhysicalAddress paddr)
 {
     VERIFY_INTERRUPTS_DISABLED();
     auto& mm_data = get_data();
+    // Each processor has its own quickmap slot, so m_quickmap_in_use is all the locking we need.
     mm_data.m_quickmap_prev_flags = mm_data.m_quickmap_in_use.lock();
-    ScopedSpinLock lock(s_mm_lock);
 
     u32 pte_idx = 8 + Processor::id();
     VirtualAddress vaddr(0xffe00000 + pte_idx * PAGE_SIZE);
 
     auto& pte = boot_pd3_pt1023[pte_idx];
-    if (pte.physical_page_base() != physical_page.paddr().as_ptr()) {
-        pte.set_physical_page_base(physical_page.paddr().get());
+    if (pte.physical_page_base() != paddr.as_ptr()) {
+        pte.set_physical_page_base(paddr.get());
         pte.set_present(true);
         pte.set_writable(true);
         pte.set_user_allowed(false);
@@ -844,7 +1133,6 @@ u8* MemoryManager::quickmap_page(PhysicalPage& physical_page)
 void MemoryManager::unquickmap_page()
 {
     VERIFY_INTERRUPTS_DISABLED();
-    ScopedSpinLock lock(s_mm_lock);
     auto& mm_data = get_data();
     VERIFY(mm_data.m_quickmap_in_use.is_locked());
     u32 pte_idx = 8 + Processor::id();
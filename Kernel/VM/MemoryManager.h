@@ -57,6 +57,12 @@ constexpr FlatPtr page_round_down(FlatPtr x)
     return ((FlatPtr)(x)) & ~(PAGE_SIZE - 1);
 }
 
+// Ranges big enough to hold a huge page are aligned for one, so that they can be mapped with huge pages.
+constexpr size_t preferred_alignment_for_size(size_t size)
+{
+    return size >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : PAGE_SIZE;
+}
+
 inline FlatPtr low_physical_to_virtual(FlatPtr physical)
 {
     return physical + 0xc0000000;
@@ -113,6 +119,16 @@ struct MemoryManagerData {
 
     PhysicalAddress m_last_quickmap_pd;
     PhysicalAddress m_last_quickmap_pt;
+
+    // Free user physical pages cached by this processor, so that most single page
+    // allocations and deallocations don't have to take s_mm_lock. Other processors
+    // only look at it when they run out of pages. Never take s_mm_lock while holding
+    // m_page_magazine_lock.
+    static constexpr size_t page_magazine_capacity = 64;
+    static constexpr size_t page_magazine_batch_size = page_magazine_capacity / 2;
+    SpinLock<u8> m_page_magazine_lock;
+    size_t m_page_magazine_size { 0 };
+    PhysicalAddress m_page_magazine[page_magazine_capacity];
 };
 
 extern RecursiveSpinLock s_mm_lock;
@@ -157,6 +173,7 @@ public:
     bool commit_user_physical_pages(size_t);
     void uncommit_user_physical_pages(size_t);
     NonnullRefPtr<PhysicalPage> allocate_committed_user_physical_page(ShouldZeroFill = ShouldZeroFill::Yes);
+    NonnullRefPtrVector<PhysicalPage> allocate_committed_user_physical_huge_page(ShouldZeroFill = ShouldZeroFill::Yes);
     RefPtr<PhysicalPage> allocate_user_physical_page(ShouldZeroFill = ShouldZeroFill::Yes, bool* did_purge = nullptr);
     RefPtr<PhysicalPage> allocate_supervisor_physical_page();
     NonnullRefPtrVector<PhysicalPage> allocate_contiguous_supervisor_physical_pages(size_t size, size_t physical_alignment = PAGE_SIZE);
@@ -176,6 +193,18 @@ public:
     unsigned user_physical_pages_uncommitted() const { return m_user_physical_pages_uncommitted; }
     unsigned super_physical_pages() const { return m_super_physical_pages; }
     unsigned super_physical_pages_used() const { return m_super_physical_pages_used; }
+    unsigned zeroed_page_pool_size() const { return m_zeroed_page_pool_size; }
+    unsigned zeroed_page_pool_hits() const { return m_zeroed_page_pool_hits; }
+    unsigned zeroed_page_pool_misses() const { return m_zeroed_page_pool_misses; }
+    unsigned huge_pages_mapped() const { return m_huge_pages_mapped; }
+    unsigned huge_pages_split() const { return m_huge_pages_split; }
+
+    // The zeroed page pool is refilled by PageZeroingTask, which waits until the pool
+    // drops below the low watermark and then tops it up to the high watermark.
+    static constexpr size_t zeroed_page_pool_low_watermark = 64;
+    static constexpr size_t zeroed_page_pool_high_watermark = 256;
+    bool zeroed_page_pool_needs_refill() const { return m_zeroed_page_pool_size < zeroed_page_pool_high_watermark; }
+    bool add_page_to_zeroed_page_pool();
 
     template<typename Callback>
     static void for_each_vmobject(Callback callback)
@@ -219,8 +248,15 @@ private:
 
     static Region* find_region_from_vaddr(VirtualAddress);
 
-    RefPtr<PhysicalPage> find_free_user_physical_page(bool);
+    RefPtr<PhysicalPage> find_free_user_physical_page(bool, ShouldZeroFill);
+    bool try_to_take_uncommitted_user_physical_pages(size_t);
+    Optional<PhysicalAddress> take_free_user_physical_page();
+    Optional<PhysicalAddress> steal_page_from_page_magazines();
+    void return_user_physical_pages_to_regions(Span<const PhysicalAddress>);
+    Optional<PhysicalAddress> take_page_from_zeroed_page_pool();
+    void zero_fill_physical_page(PhysicalAddress);
     u8* quickmap_page(PhysicalPage&);
+    u8* quickmap_page(PhysicalAddress);
     void unquickmap_page();
 
     PageDirectoryEntry* quickmap_pd(PageDirectory&, size_t pdpt_index);
@@ -228,6 +264,8 @@ private:
 
     PageTableEntry* pte(PageDirectory&, VirtualAddress);
     PageTableEntry* ensure_pte(PageDirectory&, VirtualAddress);
+    PageDirectoryEntry* ensure_huge_pde(PageDirectory&, VirtualAddress);
+    bool split_huge_pde(PageDirectory&, VirtualAddress);
     void release_pte(PageDirectory&, VirtualAddress, bool);
 
     RefPtr<PageDirectory> m_kernel_page_directory;
@@ -241,9 +279,21 @@ private:
     Atomic<unsigned, AK::MemoryOrder::memory_order_relaxed> m_user_physical_pages_uncommitted { 0 };
     Atomic<unsigned, AK::MemoryOrder::memory_order_relaxed> m_super_physical_pages { 0 };
     Atomic<unsigned, AK::MemoryOrder::memory_order_relaxed> m_super_physical_pages_used { 0 };
+    Atomic<unsigned, AK::MemoryOrder::memory_order_relaxed> m_zeroed_page_pool_hits { 0 };
+    Atomic<unsigned, AK::MemoryOrder::memory_order_relaxed> m_zeroed_page_pool_misses { 0 };
+    Atomic<unsigned, AK::MemoryOrder::memory_order_relaxed> m_huge_pages_mapped { 0 };
+    Atomic<unsigned, AK::MemoryOrder::memory_order_relaxed> m_huge_pages_split { 0 };
+
+    // Free user physical pages that have already been zero-filled. These still count
+    // as uncommitted (or committed) free pages and are handed out when nothing else is left.
+    // Never take s_mm_lock while holding m_zeroed_page_pool_lock.
+    SpinLock<u8> m_zeroed_page_pool_lock;
+    Atomic<size_t, AK::MemoryOrder::memory_order_relaxed> m_zeroed_page_pool_size { 0 };
+    PhysicalAddress m_zeroed_page_pool[zeroed_page_pool_high_watermark];
 
     NonnullRefPtrVector<PhysicalRegion> m_user_physical_regions;
     NonnullRefPtrVector<PhysicalRegion> m_super_physical_regions;
+    Vector<MemoryManagerData*> m_processor_data;
 
     InlineLinkedList<Region> m_user_regions;
     InlineLinkedList<Region> m_kernel_regions;
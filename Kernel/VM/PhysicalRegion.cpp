@@ -29,12 +29,19 @@
 #include <AK/RefPtr.h>
 #include <AK/Vector.h>
 #include <Kernel/Assertions.h>
-#include <Kernel/Random.h>
 #include <Kernel/VM/PhysicalPage.h>
 #include <Kernel/VM/PhysicalRegion.h>
 
 namespace Kernel {
 
+static constexpr size_t order_for_page_count(size_t page_count)
+{
+    size_t order = 0;
+    while (((size_t)1 << order) < page_count)
+        ++order;
+    return order;
+}
+
 NonnullRefPtr<PhysicalRegion> PhysicalRegion::create(PhysicalAddress lower, PhysicalAddress upper)
 {
     return adopt(*new PhysicalRegion(lower, upper));
@@ -59,133 +66,179 @@ unsigned PhysicalRegion::finalize_capacity()
     VERIFY(!m_pages);
 
     m_pages = (m_upper.get() - m_lower.get()) / PAGE_SIZE;
-    m_bitmap.grow(m_pages, false);
+
+    m_base_page_frame = (m_lower.get() / PAGE_SIZE) & ~(((size_t)1 << max_order) - 1);
+    size_t first_index = index_of(m_lower);
+    size_t span = first_index + m_pages;
+    for (size_t order = 0; order <= max_order; ++order)
+        m_free_blocks[order].grow(max(ceil_div(span, (size_t)1 << order), (size_t)1), false);
+
+    free_range(first_index, m_pages);
 
     return size();
 }
 
-NonnullRefPtrVector<PhysicalPage> PhysicalRegion::take_contiguous_free_pages(size_t count, bool supervisor, size_t physical_alignment)
+Optional<size_t> PhysicalRegion::allocate_block(size_t order)
 {
-    VERIFY(m_pages);
-    VERIFY(m_used != m_pages);
+    VERIFY(order <= max_order);
+    size_t found_order = order;
+    while (found_order <= max_order && !m_free_block_count[found_order])
+        ++found_order;
+    if (found_order > max_order)
+        return {};
 
-    NonnullRefPtrVector<PhysicalPage> physical_pages;
-    physical_pages.ensure_capacity(count);
+    auto block = m_free_blocks[found_order].find_one_anywhere_set(m_free_block_hint[found_order]);
+    VERIFY(block.has_value());
+    m_free_blocks[found_order].set(block.value(), false);
+    m_free_block_count[found_order]--;
+    m_free_block_hint[found_order] = block.value();
+    size_t index = block.value() << found_order;
+
+    // Split the block until it has the requested size, handing the upper halves back.
+    while (found_order > order) {
+        --found_order;
+        size_t buddy = index + ((size_t)1 << found_order);
+        m_free_blocks[found_order].set(buddy >> found_order, true);
+        m_free_block_count[found_order]++;
+        m_free_block_hint[found_order] = buddy >> found_order;
+    }
+    return index;
+}
 
-    auto first_contiguous_page = find_contiguous_free_pages(count, physical_alignment);
+void PhysicalRegion::free_block(size_t index, size_t order)
+{
+    VERIFY(!(index & (((size_t)1 << order) - 1)));
+
+    // Merge with the buddy block as long as it's free as a whole.
+    while (order < max_order) {
+        size_t buddy = (index ^ ((size_t)1 << order)) >> order;
+        if (buddy >= m_free_blocks[order].size() || !m_free_blocks[order].get(buddy))
+            break;
+        m_free_blocks[order].set(buddy, false);
+        m_free_block_count[order]--;
+        index &= ~((size_t)1 << order);
+        ++order;
+    }
 
-    for (size_t index = 0; index < count; index++)
-        physical_pages.append(PhysicalPage::create(m_lower.offset(PAGE_SIZE * (index + first_contiguous_page)), supervisor));
-    return physical_pages;
+    VERIFY(!m_free_blocks[order].get(index >> order));
+    m_free_blocks[order].set(index >> order, true);
+    m_free_block_count[order]++;
+    m_free_block_hint[order] = index >> order;
 }
 
-unsigned PhysicalRegion::find_contiguous_free_pages(size_t count, size_t physical_alignment)
+void PhysicalRegion::free_range(size_t index, size_t count)
 {
-    VERIFY(count != 0);
-    VERIFY(physical_alignment % PAGE_SIZE == 0);
-    // search from the last page we allocated
-    auto range = find_and_allocate_contiguous_range(count, physical_alignment / PAGE_SIZE);
-    VERIFY(range.has_value());
-    return range.value();
+    // Carve the range into the largest naturally aligned blocks that fit.
+    size_t end = index + count;
+    while (index < end) {
+        size_t order = max_order;
+        while (order > 0 && ((index & (((size_t)1 << order) - 1)) || index + ((size_t)1 << order) > end))
+            --order;
+        free_block(index, order);
+        index += (size_t)1 << order;
+    }
 }
 
-Optional<unsigned> PhysicalRegion::find_one_free_page()
+Optional<size_t> PhysicalRegion::allocate_adjacent_max_order_blocks(size_t block_count, size_t page_alignment)
 {
-    if (m_used == m_pages) {
-        // We know we don't have any free pages, no need to check the bitmap
-        // Check if we can draw one from the return queue
-        if (m_recently_returned.size() > 0) {
-            u8 index = get_fast_random<u8>() % m_recently_returned.size();
-            Checked<FlatPtr> local_offset = m_recently_returned[index].get();
-            local_offset -= m_lower.get();
-            m_recently_returned.remove(index);
-            VERIFY(!local_offset.has_overflow());
-            VERIFY(local_offset.value() < (FlatPtr)(m_pages * PAGE_SIZE));
-            return local_offset.value() / PAGE_SIZE;
-        }
-        return {};
-    }
-    auto free_index = m_bitmap.find_one_anywhere_unset(m_free_hint);
-    if (!free_index.has_value())
+    VERIFY(block_count > 0);
+    auto& free_blocks = m_free_blocks[max_order];
+    if (m_free_block_count[max_order] < block_count)
         return {};
 
-    auto page_index = free_index.value();
-    m_bitmap.set(page_index, true);
-    m_used++;
-    m_free_hint = free_index.value() + 1; // Just a guess
-    if (m_free_hint >= m_bitmap.size())
-        m_free_hint = 0;
-    return page_index;
+    size_t run_start = 0;
+    size_t run_length = 0;
+    for (size_t block = 0; block < free_blocks.size(); ++block) {
+        if (!free_blocks.get(block)) {
+            run_length = 0;
+            continue;
+        }
+        // Only start a run on a block that satisfies the requested physical alignment.
+        if (!run_length) {
+            if ((m_base_page_frame + (block << max_order)) % page_alignment)
+                continue;
+            run_start = block;
+        }
+        if (++run_length < block_count)
+            continue;
+
+        for (size_t i = run_start; i < run_start + block_count; ++i)
+            free_blocks.set(i, false);
+        m_free_block_count[max_order] -= block_count;
+        return run_start << max_order;
+    }
+    return {};
 }
 
-Optional<unsigned> PhysicalRegion::find_and_allocate_contiguous_range(size_t count, unsigned alignment)
+NonnullRefPtrVector<PhysicalPage> PhysicalRegion::take_contiguous_free_pages(size_t count, bool supervisor, size_t physical_alignment)
 {
+    VERIFY(m_pages);
     VERIFY(count != 0);
-    size_t found_pages_count = 0;
-    // TODO: Improve how we deal with alignment != 1
-    auto first_index = m_bitmap.find_longest_range_of_unset_bits(count + alignment - 1, found_pages_count);
-    if (!first_index.has_value())
-        return {};
+    VERIFY(physical_alignment % PAGE_SIZE == 0);
 
-    auto page = first_index.value();
-    if (alignment != 1) {
-        auto lower_page = m_lower.get() / PAGE_SIZE;
-        page = ((lower_page + page + alignment - 1) & ~(alignment - 1)) - lower_page;
-    }
-    if (found_pages_count >= count) {
-        m_bitmap.set_range<true>(page, count);
-        m_used += count;
-        m_free_hint = first_index.value() + count + 1; // Just a guess
-        if (m_free_hint >= m_bitmap.size())
-            m_free_hint = 0;
-        return page;
+    // Buddy blocks are naturally aligned, so asking for a block at least as large as
+    // the alignment takes care of it.
+    size_t order = order_for_page_count(max(count, physical_alignment / PAGE_SIZE));
+    Optional<size_t> index;
+    size_t block_size;
+    if (order <= max_order) {
+        index = allocate_block(order);
+        block_size = (size_t)1 << order;
+    } else {
+        // Too large for a single block, so stitch together a run of adjacent max_order blocks.
+        size_t block_count = ceil_div(count, (size_t)1 << max_order);
+        index = allocate_adjacent_max_order_blocks(block_count, physical_alignment / PAGE_SIZE);
+        block_size = block_count << max_order;
     }
-    return {};
+    if (!index.has_value())
+        return {};
+
+    if (block_size > count)
+        free_range(index.value() + count, block_size - count);
+    m_used += count;
+
+    NonnullRefPtrVector<PhysicalPage> physical_pages;
+    physical_pages.ensure_capacity(count);
+    for (size_t i = 0; i < count; i++)
+        physical_pages.append(PhysicalPage::create(address_of(index.value() + i), supervisor));
+    return physical_pages;
 }
 
 RefPtr<PhysicalPage> PhysicalRegion::take_free_page(bool supervisor)
 {
     VERIFY(m_pages);
 
-    auto free_index = find_one_free_page();
-    if (!free_index.has_value())
+    auto index = allocate_block(0);
+    if (!index.has_value())
         return nullptr;
+    m_used++;
 
-    return PhysicalPage::create(m_lower.offset(free_index.value() * PAGE_SIZE), supervisor);
+    return PhysicalPage::create(address_of(index.value()), supervisor);
 }
 
-void PhysicalRegion::free_page_at(PhysicalAddress addr)
+size_t PhysicalRegion::take_free_pages(Span<PhysicalAddress> pages)
 {
     VERIFY(m_pages);
 
-    if (m_used == 0) {
-        VERIFY_NOT_REACHED();
+    size_t taken = 0;
+    for (; taken < pages.size(); ++taken) {
+        auto index = allocate_block(0);
+        if (!index.has_value())
+            break;
+        pages[taken] = address_of(index.value());
     }
-
-    Checked<FlatPtr> local_offset = addr.get();
-    local_offset -= m_lower.get();
-    VERIFY(!local_offset.has_overflow());
-    VERIFY(local_offset.value() < (FlatPtr)(m_pages * PAGE_SIZE));
-
-    auto page = local_offset.value() / PAGE_SIZE;
-    m_bitmap.set(page, false);
-    m_free_hint = page; // We know we can find one here for sure
-    m_used--;
+    m_used += taken;
+    return taken;
 }
 
-void PhysicalRegion::return_page(const PhysicalPage& page)
+void PhysicalRegion::return_page(PhysicalAddress paddr)
 {
-    auto returned_count = m_recently_returned.size();
-    if (returned_count >= m_recently_returned.capacity()) {
-        // Return queue is full, pick a random entry and free that page
-        // and replace the entry with this page
-        auto& entry = m_recently_returned[get_fast_random<u8>()];
-        free_page_at(entry);
-        entry = page.paddr();
-    } else {
-        // Still filling the return queue, just append it
-        m_recently_returned.append(page.paddr());
-    }
+    VERIFY(m_pages);
+    VERIFY(m_used > 0);
+    VERIFY(contains(paddr));
+
+    free_block(index_of(paddr), 0);
+    m_used--;
 }
 
 }
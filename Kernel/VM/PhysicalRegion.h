@@ -30,14 +30,22 @@
 #include <AK/NonnullRefPtrVector.h>
 #include <AK/Optional.h>
 #include <AK/RefCounted.h>
+#include <AK/Span.h>
 #include <Kernel/VM/PhysicalPage.h>
 
 namespace Kernel {
 
+// A PhysicalRegion hands out the pages of a physically contiguous range of memory using a
+// binary buddy allocator. Free memory is kept as naturally aligned blocks of 2^order pages,
+// with one bitmap per order marking which blocks of that order are free. Contiguous
+// allocations larger than a max_order block are served from runs of adjacent free
+// max_order blocks.
 class PhysicalRegion : public RefCounted<PhysicalRegion> {
     AK_MAKE_ETERNAL
 
 public:
+    static constexpr size_t max_order = 10;
+
     static NonnullRefPtr<PhysicalRegion> create(PhysicalAddress lower, PhysicalAddress upper);
     ~PhysicalRegion() = default;
 
@@ -47,19 +55,27 @@ public:
     PhysicalAddress lower() const { return m_lower; }
     PhysicalAddress upper() const { return m_upper; }
     unsigned size() const { return m_pages; }
-    unsigned used() const { return m_used - m_recently_returned.size(); }
-    unsigned free() const { return m_pages - m_used + m_recently_returned.size(); }
-    bool contains(const PhysicalPage& page) const { return page.paddr() >= m_lower && page.paddr() <= m_upper; }
+    unsigned used() const { return m_used; }
+    unsigned free() const { return m_pages - m_used; }
+    bool contains(const PhysicalPage& page) const { return contains(page.paddr()); }
+    bool contains(PhysicalAddress paddr) const { return paddr >= m_lower && paddr <= m_upper; }
 
     RefPtr<PhysicalPage> take_free_page(bool supervisor);
     NonnullRefPtrVector<PhysicalPage> take_contiguous_free_pages(size_t count, bool supervisor, size_t physical_alignment = PAGE_SIZE);
-    void return_page(const PhysicalPage& page);
+    void return_page(const PhysicalPage& page) { return_page(page.paddr()); }
+
+    // Bulk versions for the per-processor page caches in MemoryManager.
+    size_t take_free_pages(Span<PhysicalAddress>);
+    void return_page(PhysicalAddress);
 
 private:
-    unsigned find_contiguous_free_pages(size_t count, size_t physical_alignment = PAGE_SIZE);
-    Optional<unsigned> find_and_allocate_contiguous_range(size_t count, unsigned alignment = 1);
-    Optional<unsigned> find_one_free_page();
-    void free_page_at(PhysicalAddress addr);
+    Optional<size_t> allocate_block(size_t order);
+    Optional<size_t> allocate_adjacent_max_order_blocks(size_t block_count, size_t page_alignment);
+    void free_block(size_t index, size_t order);
+    void free_range(size_t index, size_t count);
+
+    size_t index_of(PhysicalAddress paddr) const { return paddr.get() / PAGE_SIZE - m_base_page_frame; }
+    PhysicalAddress address_of(size_t index) const { return PhysicalAddress((m_base_page_frame + index) * PAGE_SIZE); }
 
     PhysicalRegion(PhysicalAddress lower, PhysicalAddress upper);
 
@@ -67,9 +83,14 @@ private:
     PhysicalAddress m_upper;
     unsigned m_pages { 0 };
     unsigned m_used { 0 };
-    Bitmap m_bitmap;
-    size_t m_free_hint { 0 };
-    Vector<PhysicalAddress, 256> m_recently_returned;
+
+    // Block indices are relative to m_base_page_frame, which is m_lower rounded down to
+    // a max_order boundary, so that a block's alignment in the region is also its
+    // physical alignment.
+    size_t m_base_page_frame { 0 };
+    Bitmap m_free_blocks[max_order + 1];
+    size_t m_free_block_count[max_order + 1] {};
+    size_t m_free_block_hint[max_order + 1] {};
 };
 
 }
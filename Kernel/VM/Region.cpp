@@ -286,6 +286,61 @@ bool Region::map_individual_page_impl(size_t page_index)
     return true;
 }
 
+bool Region::can_map_as_huge_page(size_t page_index) const
+{
+    // A huge page can only be used if it lies entirely within this region and the pages behind it
+    // are physically contiguous, naturally aligned, and all mapped the same way.
+    if (!vmobject().is_anonymous() && !vmobject().is_contiguous())
+        return false;
+    if (vaddr_from_page_index(page_index).get() & ~HUGE_PAGE_MASK)
+        return false;
+    if (page_index + pages_per_huge_page > page_count())
+        return false;
+    if (!is_readable() && !is_writable())
+        return false;
+    auto* first_page = physical_page(page_index);
+    if (!first_page || (first_page->paddr().get() & ~HUGE_PAGE_MASK))
+        return false;
+    for (size_t i = 0; i < pages_per_huge_page; ++i) {
+        auto* page = physical_page(page_index + i);
+        if (!page || page->is_shared_zero_page() || page->is_lazy_committed_page())
+            return false;
+        if (page->paddr() != first_page->paddr().offset(i * PAGE_SIZE))
+            return false;
+        if (should_cow(page_index + i))
+            return false;
+    }
+    return true;
+}
+
+bool Region::map_huge_page_impl(size_t page_index)
+{
+    VERIFY(m_page_directory->get_lock().own_lock());
+    auto page_vaddr = vaddr_from_page_index(page_index);
+
+    bool user_allowed = page_vaddr.get() >= 0x00800000 && is_user_address(page_vaddr);
+    if (is_mmap() && !user_allowed) {
+        PANIC("About to map mmap'ed page at a kernel address");
+    }
+
+    auto* pde = MM.ensure_huge_pde(*m_page_directory, page_vaddr);
+    if (!pde)
+        return false;
+    bool was_huge = pde->is_huge();
+    pde->set_huge_page_base(physical_page(page_index)->paddr().get());
+    pde->set_huge(true);
+    pde->set_cache_disabled(!m_cacheable);
+    pde->set_writable(is_writable());
+    if (Processor::current().has_feature(CPUFeature::NX))
+        pde->set_execute_disabled(!is_executable());
+    pde->set_user_allowed(user_allowed);
+    pde->set_present(true);
+
+    if (!was_huge)
+        ++MM.m_huge_pages_mapped;
+    return true;
+}
+
 bool Region::do_remap_vmobject_page_range(size_t page_index, size_t page_count)
 {
     bool success = true;
@@ -398,6 +453,10 @@ bool Region::map(PageDirectory& page_directory, ShouldFlushTLB should_flush_tlb)
     set_page_directory(page_directory);
     size_t page_index = 0;
     while (page_index < page_count()) {
+        if (can_map_as_huge_page(page_index) && map_huge_page_impl(page_index)) {
+            page_index += pages_per_huge_page;
+            continue;
+        }
         if (!map_individual_page_impl(page_index))
             break;
         ++page_index;
@@ -549,6 +608,7 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region, Scoped
         dbgln_if(PAGE_FAULT_DEBUG, "MM: page_in_from_inode() but page already present. Fine with me!");
         if (!remap_vmobject_page(page_index_in_vmobject))
             return PageFaultResponse::OutOfMemory;
+        fault_around(page_index_in_region);
         return PageFaultResponse::Continue;
     }
 
@@ -556,49 +616,110 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region, Scoped
     if (current_thread)
         current_thread->did_inode_fault();
 
-    u8 page_buffer[PAGE_SIZE];
+    // Read ahead a window of pages starting at the faulting one, stopping at the end of
+    // this region or at the first page that is already present in the VMObject.
+    size_t read_ahead_page_count = inode_vmobject.read_ahead_page_count_for_fault(page_index_in_vmobject);
+    read_ahead_page_count = min(read_ahead_page_count, page_count() - page_index_in_region);
+    for (size_t i = 1; i < read_ahead_page_count; ++i) {
+        if (!inode_vmobject.physical_pages()[page_index_in_vmobject + i].is_null()) {
+            read_ahead_page_count = i;
+            break;
+        }
+    }
+
     auto& inode = inode_vmobject.inode();
 
-    // Reading the page may block, so release the MM lock temporarily
+    // Reading the pages may block, so release the MM lock temporarily
     mm_lock.unlock();
-    auto buffer = UserOrKernelBuffer::for_kernel_buffer(page_buffer);
-    auto nread = inode.read_bytes(page_index_in_vmobject * PAGE_SIZE, PAGE_SIZE, buffer, nullptr);
+    auto read_buffer = ByteBuffer::create_uninitialized(read_ahead_page_count * PAGE_SIZE);
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(read_buffer.data());
+    auto nread = inode.read_bytes(page_index_in_vmobject * PAGE_SIZE, read_buffer.size(), buffer, nullptr);
     mm_lock.lock();
 
     if (nread < 0) {
         dmesgln("MM: handle_inode_fault had error ({}) while reading!", nread);
         return PageFaultResponse::ShouldCrash;
     }
-    if (nread < PAGE_SIZE) {
-        // If we read less than a page, zero out the rest to avoid leaking uninitialized data.
-        memset(page_buffer + nread, 0, PAGE_SIZE - nread);
+    if ((size_t)nread < read_buffer.size()) {
+        // If we read less than we asked for, zero out the rest to avoid leaking uninitialized data.
+        memset(read_buffer.data() + nread, 0, read_buffer.size() - nread);
     }
 
-    vmobject_physical_page_entry = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No);
-    if (vmobject_physical_page_entry.is_null()) {
-        dmesgln("MM: handle_inode_fault was unable to allocate a physical page");
-        return PageFaultResponse::OutOfMemory;
-    }
+    // Only keep the read-ahead pages that actually contain file data, but always
+    // page in the faulting page, even if it's past the end of the file.
+    size_t pages_read = max((size_t)1, min(read_ahead_page_count, (size_t)page_round_up(nread) / PAGE_SIZE));
+    size_t pages_populated = 0;
+    for (size_t i = 0; i < pages_read; ++i) {
+        auto& page_slot = inode_vmobject.physical_pages()[page_index_in_vmobject + i];
+        if (!page_slot.is_null()) {
+            // Someone else populated this page while we were reading.
+            ++pages_populated;
+            continue;
+        }
+
+        page_slot = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No);
+        if (page_slot.is_null()) {
+            if (i == 0) {
+                dmesgln("MM: handle_inode_fault was unable to allocate a physical page");
+                return PageFaultResponse::OutOfMemory;
+            }
+            // Read-ahead is only an optimization, we can do without the remaining pages.
+            break;
+        }
 
-    u8* dest_ptr = MM.quickmap_page(*vmobject_physical_page_entry);
-    {
-        void* fault_at;
-        if (!safe_memcpy(dest_ptr, page_buffer, PAGE_SIZE, fault_at)) {
-            if ((u8*)fault_at >= dest_ptr && (u8*)fault_at <= dest_ptr + PAGE_SIZE)
-                dbgln("      >> inode fault: error copying data to {}/{}, failed at {}",
-                    vmobject_physical_page_entry->paddr(),
-                    VirtualAddress(dest_ptr),
-                    VirtualAddress(fault_at));
-            else
-                VERIFY_NOT_REACHED();
+        u8* dest_ptr = MM.quickmap_page(*page_slot);
+        {
+            void* fault_at;
+            if (!safe_memcpy(dest_ptr, read_buffer.data() + i * PAGE_SIZE, PAGE_SIZE, fault_at)) {
+                if ((u8*)fault_at >= dest_ptr && (u8*)fault_at <= dest_ptr + PAGE_SIZE)
+                    dbgln("      >> inode fault: error copying data to {}/{}, failed at {}",
+                        page_slot->paddr(),
+                        VirtualAddress(dest_ptr),
+                        VirtualAddress(fault_at));
+                else
+                    VERIFY_NOT_REACHED();
+            }
         }
+        MM.unquickmap_page();
+        ++pages_populated;
     }
-    MM.unquickmap_page();
 
-    remap_vmobject_page(page_index_in_vmobject);
+    dbgln_if(PAGE_FAULT_DEBUG, "Inode fault in {} read {} page(s) at page index {}", name(), pages_populated, page_index_in_region);
+    inode_vmobject.did_read_ahead(page_index_in_vmobject, pages_populated);
+
+    remap_vmobject_page_range(page_index_in_vmobject, pages_populated);
+    fault_around(page_index_in_region);
     return PageFaultResponse::Continue;
 }
 
+void Region::fault_around(size_t page_index_in_region)
+{
+    // Map the pages around a fault that are already present in the VMObject, so that
+    // touching them later doesn't cost another trip through the page fault handler.
+    VERIFY(s_mm_lock.own_lock());
+    if (!m_page_directory)
+        return;
+    size_t first_page = page_index_in_region & ~(fault_around_page_count - 1);
+    size_t last_page = min(first_page + fault_around_page_count, page_count());
+    ScopedSpinLock page_lock(m_page_directory->get_lock());
+    size_t mapped_pages = 0;
+    for (size_t index = first_page; index < last_page; ++index) {
+        if (index == page_index_in_region)
+            continue;
+        auto* page = physical_page(index);
+        if (!page || page->is_shared_zero_page() || page->is_lazy_committed_page())
+            continue;
+        auto* pte = MM.pte(*m_page_directory, vaddr_from_page_index(index));
+        if (pte && pte->is_present())
+            continue;
+        if (!map_individual_page_impl(index))
+            break;
+        ++mapped_pages;
+    }
+    // Pages that weren't present before can't be in any TLB, so there is nothing to flush.
+    dbgln_if(PAGE_FAULT_DEBUG, "Fault-around in {} mapped {} page(s) around page index {}", name(), mapped_pages, page_index_in_region);
+}
+
 RefPtr<Process> Region::get_owner()
 {
     return m_owner.strong_ref();
@@ -269,8 +269,14 @@ private:
     PageFaultResponse handle_cow_fault(size_t page_index);
     PageFaultResponse handle_inode_fault(size_t page_index, ScopedSpinLock<RecursiveSpinLock>&);
     PageFaultResponse handle_zero_fault(size_t page_index);
+    void fault_around(size_t page_index);
 
     bool map_individual_page_impl(size_t page_index);
+    bool can_map_as_huge_page(size_t page_index) const;
+    bool map_huge_page_impl(size_t page_index);
+
+    static constexpr size_t fault_around_page_count = 16;
+    static constexpr size_t pages_per_huge_page = HUGE_PAGE_SIZE / PAGE_SIZE;
 
     void register_purgeable_page_ranges();
     void unregister_purgeable_page_ranges();
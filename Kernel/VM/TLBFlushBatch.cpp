@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/Thread.h>
+#include <Kernel/VM/MemoryManager.h>
+#include <Kernel/VM/PageDirectory.h>
+#include <Kernel/VM/TLBFlushBatch.h>
+
+namespace Kernel {
+
+TLBFlushBatch::TLBFlushBatch(PageDirectory& page_directory)
+    : m_page_directory(page_directory)
+{
+    auto* current_thread = Thread::current();
+    VERIFY(current_thread);
+    m_previous_batch = current_thread->tlb_flush_batch();
+    current_thread->set_tlb_flush_batch(this);
+}
+
+TLBFlushBatch::~TLBFlushBatch()
+{
+    auto* current_thread = Thread::current();
+    VERIFY(current_thread->tlb_flush_batch() == this);
+    current_thread->set_tlb_flush_batch(m_previous_batch);
+    flush();
+}
+
+bool TLBFlushBatch::add(const PageDirectory* page_directory, VirtualAddress vaddr, size_t page_count)
+{
+    if (page_directory != m_page_directory.ptr() || !is_user_range(vaddr, page_count * PAGE_SIZE))
+        return false;
+    if (m_flush_entire_tlb)
+        return true;
+
+    if (m_range_count) {
+        // Merge with the previous range if they touch, which is what unmapping and remapping
+        // neighbouring regions usually looks like.
+        auto& last_range = m_ranges[m_range_count - 1];
+        if (last_range.ptr + last_range.page_count * PAGE_SIZE == vaddr.as_ptr()) {
+            last_range.page_count += page_count;
+            return true;
+        }
+    }
+    if (m_range_count == max_ranges) {
+        m_flush_entire_tlb = true;
+        return true;
+    }
+    m_ranges[m_range_count++] = { vaddr.as_ptr(), page_count };
+    return true;
+}
+
+void TLBFlushBatch::flush()
+{
+    if (!m_range_count && !m_flush_entire_tlb)
+        return;
+    // We may have moved to another processor since some of these were added,
+    // so this flushes the current processor's TLB again as well.
+    Processor::flush_tlb(m_page_directory.ptr(), m_ranges, m_flush_entire_tlb ? 0 : m_range_count);
+    m_range_count = 0;
+    m_flush_entire_tlb = false;
+}
+
+}
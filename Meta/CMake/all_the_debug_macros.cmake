@@ -80,6 +80,7 @@ set(SYSTEM_MENU_DEBUG ON)
 set(SYSTEMSERVER_DEBUG ON)
 set(SERVICE_DEBUG ON)
 set(COMPOSE_DEBUG ON)
+set(CONNECTIONCACHE_DEBUG ON)
 set(MINIMIZE_ANIMATION_DEBUG ON)
 set(OCCLUSIONS_DEBUG ON)
 set(MENUS_DEBUG ON)
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "BasicBlockCache.h"
+#include "Emulator.h"
+#include "Report.h"
+
+namespace UserspaceEmulator {
+
+static constexpr size_t max_instructions_per_block = 64;
+static constexpr u32 max_instruction_length = 15;
+
+BasicBlockCache::BasicBlockCache(Emulator& emulator)
+    : m_emulator(emulator)
+{
+}
+
+static bool ends_basic_block(const X86::Instruction& insn)
+{
+    if (insn.has_sub_op()) {
+        // Jcc rel16/32, UD2, SYSCALL and SYSENTER
+        u8 sub_op = insn.sub_op();
+        return (sub_op >= 0x80 && sub_op <= 0x8f) || sub_op == 0x0b || sub_op == 0x05 || sub_op == 0x34;
+    }
+
+    switch (insn.op()) {
+    case 0x70 ... 0x7f: // Jcc rel8
+    case 0x9a:          // CALL far
+    case 0xc2:          // RET imm16
+    case 0xc3:          // RET
+    case 0xca:          // RETF imm16
+    case 0xcb:          // RETF
+    case 0xcc:          // INT3
+    case 0xcd:          // INT imm8
+    case 0xce:          // INTO
+    case 0xcf:          // IRET
+    case 0xe0 ... 0xe3: // LOOPNZ, LOOPZ, LOOP, JCXZ
+    case 0xe8 ... 0xeb: // CALL, JMP
+    case 0xf4:          // HLT
+        return true;
+    case 0xff:
+        // Indirect CALL and JMP
+        return insn.slash() >= 2 && insn.slash() <= 5;
+    default:
+        return false;
+    }
+}
+
+NonnullRefPtr<BasicBlock> BasicBlockCache::decode_block(u32 eip)
+{
+    auto& cpu = m_emulator.cpu();
+    auto* region = m_emulator.mmu().find_region({ cpu.cs(), eip });
+
+    auto block = adopt(*new BasicBlock(eip));
+    u32 saved_eip = cpu.eip();
+    cpu.set_eip(eip);
+    for (;;) {
+        u32 instruction_base = cpu.eip();
+        auto insn = X86::Instruction::from_stream(cpu, true, true);
+        if (!insn.is_valid()) {
+            // Bytes we decoded ahead may never be executed, so only complain once we actually get there.
+            if (!block->m_instructions.is_empty())
+                break;
+            reportln("\n=={}==  \033[31;1mInvalid instruction\033[0m @ {:p}", getpid(), instruction_base);
+            m_emulator.dump_backtrace();
+            TODO();
+        }
+        block->m_instructions.append({ insn, insn.handler(), (u8)(cpu.eip() - instruction_base) });
+        block->m_end = cpu.eip();
+
+        if (ends_basic_block(insn) || block->m_instructions.size() == max_instructions_per_block)
+            break;
+        // Don't read ahead past the end of the code region.
+        if (!region || block->m_end + max_instruction_length > region->end())
+            break;
+    }
+    cpu.set_eip(saved_eip);
+
+    m_blocks.set(eip, block);
+    for (u32 page = block->base() / PAGE_SIZE; page <= (block->end() - 1) / PAGE_SIZE; ++page)
+        m_blocks_by_page.ensure(page).append(eip);
+    return block;
+}
+
+void BasicBlockCache::invalidate_page(u32 page)
+{
+    auto it = m_blocks_by_page.find(page);
+    if (it == m_blocks_by_page.end())
+        return;
+    // Drop every block on the page. Their entries on other pages go stale,
+    // which at worst makes a later invalidation throw away a re-decoded block.
+    for (auto base : it->value) {
+        auto block_it = m_blocks.find(base);
+        if (block_it == m_blocks.end())
+            continue;
+        block_it->value->m_valid = false;
+        m_blocks.remove(block_it);
+    }
+    m_blocks_by_page.remove(it);
+}
+
+void BasicBlockCache::invalidate(u32 address, size_t size)
+{
+    if (!size || m_blocks_by_page.is_empty())
+        return;
+
+    u32 first_page = address / PAGE_SIZE;
+    u32 last_page = (address + size - 1) / PAGE_SIZE;
+    if (last_page - first_page + 1 <= m_blocks_by_page.size()) {
+        for (u32 page = first_page; page <= last_page; ++page)
+            invalidate_page(page);
+        return;
+    }
+
+    // Large ranges (e.g. unmapping a whole library) are cheaper to handle from the other side.
+    Vector<u32> pages_to_invalidate;
+    for (auto& it : m_blocks_by_page) {
+        if (it.key >= first_page && it.key <= last_page)
+            pages_to_invalidate.append(it.key);
+    }
+    for (auto page : pages_to_invalidate)
+        invalidate_page(page);
+}
+
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/RefCounted.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+#include <LibX86/Instruction.h>
+
+namespace UserspaceEmulator {
+
+class Emulator;
+
+struct CachedInstruction {
+    X86::Instruction instruction;
+    X86::InstructionHandler handler { nullptr };
+    u8 length { 0 };
+};
+
+// A run of pre-decoded instructions starting at some guest EIP and ending at
+// the first instruction that may transfer control elsewhere.
+class BasicBlock : public RefCounted<BasicBlock> {
+public:
+    u32 base() const { return m_base; }
+    u32 end() const { return m_end; }
+
+    const Vector<CachedInstruction>& instructions() const { return m_instructions; }
+
+    // Cleared when the guest overwrites or unmaps the code this block was decoded from.
+    bool is_valid() const { return m_valid; }
+
+private:
+    friend class BasicBlockCache;
+
+    explicit BasicBlock(u32 base)
+        : m_base(base)
+        , m_end(base)
+    {
+    }
+
+    u32 m_base { 0 };
+    u32 m_end { 0 };
+    bool m_valid { true };
+    Vector<CachedInstruction> m_instructions;
+};
+
+class BasicBlockCache {
+public:
+    explicit BasicBlockCache(Emulator&);
+
+    ALWAYS_INLINE NonnullRefPtr<BasicBlock> block_at(u32 eip)
+    {
+        auto it = m_blocks.find(eip);
+        if (it != m_blocks.end())
+            return it->value;
+        return decode_block(eip);
+    }
+
+    void invalidate(u32 address, size_t size);
+
+private:
+    NonnullRefPtr<BasicBlock> decode_block(u32 eip);
+    void invalidate_page(u32 page);
+
+    Emulator& m_emulator;
+    HashMap<u32, NonnullRefPtr<BasicBlock>> m_blocks;
+
+    // Start addresses of the blocks decoded from each code page, so a write
+    // only has to look at the blocks that may contain the written bytes.
+    HashMap<u32, Vector<u32>> m_blocks_by_page;
+};
+
+}
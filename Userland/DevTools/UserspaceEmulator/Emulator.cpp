@@ -63,6 +63,7 @@ Emulator::Emulator(const String& executable_path, const Vector<String>& argument
     , m_environment(environment)
     , m_mmu(*this)
     , m_cpu(*this)
+    , m_basic_block_cache(*this)
 {
     m_malloc_tracer = make<MallocTracer>(*this);
 
@@ -234,18 +235,27 @@ int Emulator::exec()
     constexpr bool trace = false;
 
     while (!m_shutdown) {
-        m_cpu.save_base_eip();
+        auto block = m_basic_block_cache.block_at(m_cpu.eip());
 
-        auto insn = X86::Instruction::from_stream(m_cpu, true, true);
+        for (auto& cached : block->instructions()) {
+            m_cpu.save_base_eip();
+            u32 next_eip = m_cpu.base_eip() + cached.length;
+            m_cpu.set_eip(next_eip);
 
-        if constexpr (trace) {
-            outln("{:p}  \033[33;1m{}\033[0m", m_cpu.base_eip(), insn.to_string(m_cpu.base_eip(), symbol_provider));
-        }
+            if constexpr (trace) {
+                outln("{:p}  \033[33;1m{}\033[0m", m_cpu.base_eip(), cached.instruction.to_string(m_cpu.base_eip(), symbol_provider));
+            }
 
-        (m_cpu.*insn.handler())(insn);
+            (m_cpu.*cached.handler)(cached.instruction);
+
+            if constexpr (trace) {
+                m_cpu.dump();
+            }
 
-        if constexpr (trace) {
-            m_cpu.dump();
+            // Leave the block early if the instruction went somewhere else, ended the program,
+            // raised a signal or rewrote the code we're running.
+            if (m_cpu.eip() != next_eip || m_shutdown || m_pending_signals || !block->is_valid()) [[unlikely]]
+                break;
         }
 
         if (m_pending_signals) [[unlikely]] {
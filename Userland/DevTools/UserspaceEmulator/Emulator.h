@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include "BasicBlockCache.h"
 #include "MallocTracer.h"
 #include "RangeAllocator.h"
 #include "Report.h"
@@ -59,6 +60,8 @@ public:
     u32 virt_syscall(u32 function, u32 arg1, u32 arg2, u32 arg3);
 
     SoftMMU& mmu() { return m_mmu; }
+    SoftCPU& cpu() { return m_cpu; }
+    BasicBlockCache& basic_block_cache() { return m_basic_block_cache; }
 
     MallocTracer* malloc_tracer() { return m_malloc_tracer; }
 
@@ -78,6 +81,7 @@ private:
 
     SoftMMU m_mmu;
     SoftCPU m_cpu;
+    BasicBlockCache m_basic_block_cache;
 
     OwnPtr<MallocTracer> m_malloc_tracer;
 
@@ -134,6 +138,7 @@ private:
     int virt$gettimeofday(FlatPtr);
     int virt$clock_gettime(int, FlatPtr);
     int virt$clock_nanosleep(FlatPtr);
+    int virt$sendfile(FlatPtr);
     int virt$dbgputstr(FlatPtr characters, int length);
     int virt$dbgputch(char);
     int virt$chmod(FlatPtr, size_t, mode_t);
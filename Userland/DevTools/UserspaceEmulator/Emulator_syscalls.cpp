@@ -249,6 +249,8 @@ u32 Emulator::virt_syscall(u32 function, u32 arg1, u32 arg2, u32 arg3)
         return virt$watch_file(arg1, arg2);
     case SC_clock_nanosleep:
         return virt$clock_nanosleep(arg1);
+    case SC_sendfile:
+        return virt$sendfile(arg1);
     case SC_readlink:
         return virt$readlink(arg1);
     case SC_ptsname:
@@ -961,10 +963,13 @@ u32 Emulator::virt$mprotect(FlatPtr base, size_t size, int prot)
                 return IterationDecision::Break;
             }
             auto& mmap_region = *(MmapRegion*)region;
+            if (mmap_region.is_executable())
+                m_basic_block_cache.invalidate(mmap_region.base(), mmap_region.size());
             mmap_region.set_prot(prot);
         }
         return IterationDecision::Continue;
     });
+    mmu().flush_tlb();
     if (has_non_mmaped_region)
         return -EINVAL;
 
@@ -1442,6 +1447,25 @@ int Emulator::virt$clock_nanosleep(FlatPtr params_addr)
     return rc;
 }
 
+int Emulator::virt$sendfile(FlatPtr params_addr)
+{
+    Syscall::SC_sendfile_params params;
+    mmu().copy_from_vm(&params, params_addr, sizeof(params));
+
+    auto offset_vm_addr = params.offset;
+    off_t offset = 0;
+    if (offset_vm_addr) {
+        mmu().copy_from_vm(&offset, (FlatPtr)offset_vm_addr, sizeof(offset));
+        params.offset = &offset;
+    }
+
+    int rc = syscall(SC_sendfile, &params);
+    if (offset_vm_addr)
+        mmu().copy_to_vm((FlatPtr)offset_vm_addr, &offset, sizeof(offset));
+
+    return rc;
+}
+
 int Emulator::virt$readlink(FlatPtr params_addr)
 {
     Syscall::SC_readlink_params params;
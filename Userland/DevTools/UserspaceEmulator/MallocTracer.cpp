@@ -95,6 +95,8 @@ void MallocTracer::target_did_malloc(Badge<Emulator>, FlatPtr address, size_t si
 
         // Mark the containing mmap region as a malloc block!
         mmap_region.set_malloc(true);
+        // Accesses to this region need to be audited from now on.
+        m_emulator.mmu().flush_tlb();
     }
     auto* mallocation = mmap_region.malloc_metadata()->mallocation_for_address(address);
     VERIFY(mallocation);
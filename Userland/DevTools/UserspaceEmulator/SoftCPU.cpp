@@ -2479,6 +2479,17 @@ template<typename T>
 ALWAYS_INLINE static void do_movs(SoftCPU& cpu, const X86::Instruction& insn)
 {
     auto src_segment = cpu.segment(insn.segment_prefix().value_or(X86::SegmentRegister::DS));
+    if (insn.has_rep_prefix() && insn.a32() && !cpu.df()) {
+        // Fast path for forward memory copy, moving data and shadow in bulk.
+        u32 count = cpu.ecx().value();
+        if (cpu.emulator().mmu().fast_copy_memory({ cpu.es(), cpu.edi().value() }, { src_segment, cpu.esi().value() }, count, sizeof(T))) {
+            // FIXME: Should an uninitialized ECX taint ESI and EDI here?
+            cpu.set_esi({ (u32)(cpu.esi().value() + count * sizeof(T)), cpu.esi().shadow() });
+            cpu.set_edi({ (u32)(cpu.edi().value() + count * sizeof(T)), cpu.edi().shadow() });
+            cpu.set_ecx(shadow_wrap_as_initialized<u32>(0));
+            return;
+        }
+    }
     cpu.do_once_or_repeat<false>(insn, [&] {
         auto src = cpu.read_memory<T>({ src_segment, cpu.source_index(insn.a32()).value() });
         cpu.write_memory<T>({ cpu.es(), cpu.destination_index(insn.a32()).value() }, src);
@@ -3143,7 +3154,7 @@ void SoftCPU::STOSB(const X86::Instruction& insn)
 {
     if (insn.has_rep_prefix() && !df()) {
         // Fast path for 8-bit forward memory fill.
-        if (m_emulator.mmu().fast_fill_memory8({ es(), destination_index(insn.a32()).value() }, ecx().value(), al())) {
+        if (m_emulator.mmu().fast_fill_memory8({ es(), destination_index(insn.a32()).value() }, loop_index(insn.a32()).value(), al())) {
             if (insn.a32()) {
                 // FIXME: Should an uninitialized ECX taint EDI here?
                 set_edi({ (u32)(edi().value() + ecx().value()), edi().shadow() });
@@ -3167,7 +3178,7 @@ void SoftCPU::STOSD(const X86::Instruction& insn)
 {
     if (insn.has_rep_prefix() && !df()) {
         // Fast path for 32-bit forward memory fill.
-        if (m_emulator.mmu().fast_fill_memory32({ es(), destination_index(insn.a32()).value() }, ecx().value(), eax())) {
+        if (m_emulator.mmu().fast_fill_memory32({ es(), destination_index(insn.a32()).value() }, loop_index(insn.a32()).value(), eax())) {
             if (insn.a32()) {
                 // FIXME: Should an uninitialized ECX taint EDI here?
                 set_edi({ (u32)(edi().value() + (ecx().value() * sizeof(u32))), edi().shadow() });
@@ -3189,6 +3200,22 @@ void SoftCPU::STOSD(const X86::Instruction& insn)
 
 void SoftCPU::STOSW(const X86::Instruction& insn)
 {
+    if (insn.has_rep_prefix() && !df()) {
+        // Fast path for 16-bit forward memory fill.
+        if (m_emulator.mmu().fast_fill_memory16({ es(), destination_index(insn.a32()).value() }, loop_index(insn.a32()).value(), ax())) {
+            if (insn.a32()) {
+                // FIXME: Should an uninitialized ECX taint EDI here?
+                set_edi({ (u32)(edi().value() + (ecx().value() * sizeof(u16))), edi().shadow() });
+                set_ecx(shadow_wrap_as_initialized<u32>(0));
+            } else {
+                // FIXME: Should an uninitialized CX taint DI here?
+                set_di({ (u16)(di().value() + (cx().value() * sizeof(u16))), di().shadow() });
+                set_cx(shadow_wrap_as_initialized<u16>(0));
+            }
+            return;
+        }
+    }
+
     do_once_or_repeat<false>(insn, [&] {
         write_memory16({ es(), destination_index(insn.a32()).value() }, ax());
         step_destination_index(insn.a32(), 2);
@@ -63,6 +63,8 @@ public:
     explicit SoftCPU(Emulator&);
     void dump() const;
 
+    Emulator& emulator() { return m_emulator; }
+
     u32 base_eip() const { return m_base_eip; }
     void save_base_eip() { m_base_eip = m_eip; }
 
@@ -51,16 +51,21 @@ void SoftMMU::add_region(NonnullOwnPtr<Region> region)
 
     m_regions.append(move(region));
     quick_sort((Vector<OwnPtr<Region>>&)m_regions, [](auto& a, auto& b) { return a->base() < b->base(); });
+    flush_tlb();
 }
 
 void SoftMMU::remove_region(Region& region)
 {
+    if (region.is_executable())
+        m_emulator.basic_block_cache().invalidate(region.base(), region.size());
+
     size_t first_page_in_region = region.base() / PAGE_SIZE;
     for (size_t i = 0; i < ceil_div(region.size(), PAGE_SIZE); ++i) {
         m_page_to_region_map[first_page_in_region + i] = nullptr;
     }
 
     m_regions.remove_first_matching([&](auto& entry) { return entry.ptr() == &region; });
+    flush_tlb();
 }
 
 void SoftMMU::ensure_split_at(X86::LogicalAddress address)
@@ -103,6 +108,7 @@ void SoftMMU::ensure_split_at(X86::LogicalAddress address)
 
     m_regions.append(move(new_region));
     quick_sort((Vector<OwnPtr<Region>>&)m_regions, [](auto& a, auto& b) { return a->base() < b->base(); });
+    flush_tlb();
 }
 
 void SoftMMU::set_tls_region(NonnullOwnPtr<Region> region)
@@ -111,161 +117,155 @@ void SoftMMU::set_tls_region(NonnullOwnPtr<Region> region)
     m_tls_region = move(region);
 }
 
-ValueWithShadow<u8> SoftMMU::read8(X86::LogicalAddress address)
+bool SoftMMU::needs_access_auditing(const Region& region)
 {
-    auto* region = find_region(address);
-    if (!region) {
-        reportln("SoftMMU::read8: No region for @ {:p}", address.offset());
-        m_emulator.dump_backtrace();
-        TODO();
-    }
-
-    if (!region->is_readable()) {
-        reportln("SoftMMU::read8: Non-readable region @ {:p}", address.offset());
-        m_emulator.dump_backtrace();
-        TODO();
-    }
-
-    return region->read8(address.offset() - region->base());
+    if (!is<MmapRegion>(region) || !static_cast<const MmapRegion&>(region).is_malloc_block())
+        return false;
+    return m_emulator.malloc_tracer();
 }
 
-ValueWithShadow<u16> SoftMMU::read16(X86::LogicalAddress address)
+void SoftMMU::fill_tlb(u32 page, Region& region)
 {
-    auto* region = find_region(address);
-    if (!region) {
-        reportln("SoftMMU::read16: No region for @ {:p}", address.offset());
-        m_emulator.dump_backtrace();
-        TODO();
-    }
+    u32 page_base = page * PAGE_SIZE;
+    if (page_base < region.base() || page_base + PAGE_SIZE > region.end())
+        return;
+    if (needs_access_auditing(region))
+        return;
 
-    if (!region->is_readable()) {
-        reportln("SoftMMU::read16: Non-readable region @ {:p}", address.offset());
-        m_emulator.dump_backtrace();
-        TODO();
-    }
+    bool readable = region.is_readable();
+    bool writable = region.is_writable() && !region.is_executable();
+    if (!readable && !writable)
+        return;
 
-    return region->read16(address.offset() - region->base());
+    auto& entry = m_tlb[page % tlb_size];
+    entry.page = page;
+    entry.readable = readable;
+    entry.writable = writable;
+    entry.data = region.data() + (page_base - region.base());
+    entry.shadow_data = region.shadow_data() + (page_base - region.base());
 }
 
-ValueWithShadow<u32> SoftMMU::read32(X86::LogicalAddress address)
+void SoftMMU::flush_tlb()
 {
-    auto* region = find_region(address);
-    if (!region) {
-        reportln("SoftMMU::read32: No region for @ {:04x}:{:p}", address.selector(), address.offset());
-        m_emulator.dump_backtrace();
-        TODO();
-    }
-
-    if (!region->is_readable()) {
-        reportln("SoftMMU::read32: Non-readable region @ {:p}", address.offset());
-        m_emulator.dump_backtrace();
-        TODO();
-    }
-
-    return region->read32(address.offset() - region->base());
+    for (auto& entry : m_tlb)
+        entry = {};
 }
 
-ValueWithShadow<u64> SoftMMU::read64(X86::LogicalAddress address)
+template<typename T>
+ValueWithShadow<T> SoftMMU::slow_read(X86::LogicalAddress address)
 {
     auto* region = find_region(address);
     if (!region) {
-        reportln("SoftMMU::read64: No region for @ {:p}", address.offset());
+        reportln("SoftMMU::read{}: No region for @ {:04x}:{:p}", sizeof(T) * 8, address.selector(), address.offset());
         m_emulator.dump_backtrace();
         TODO();
     }
 
     if (!region->is_readable()) {
-        reportln("SoftMMU::read64: Non-readable region @ {:p}", address.offset());
-        m_emulator.dump_backtrace();
-        TODO();
-    }
-
-    return region->read64(address.offset() - region->base());
-}
-
-void SoftMMU::write8(X86::LogicalAddress address, ValueWithShadow<u8> value)
-{
-    auto* region = find_region(address);
-    if (!region) {
-        reportln("SoftMMU::write8: No region for @ {:p}", address.offset());
-        m_emulator.dump_backtrace();
-        TODO();
-    }
-
-    if (!region->is_writable()) {
-        reportln("SoftMMU::write8: Non-writable region @ {:p}", address.offset());
-        m_emulator.dump_backtrace();
-        TODO();
-    }
-    region->write8(address.offset() - region->base(), value);
-}
-
-void SoftMMU::write16(X86::LogicalAddress address, ValueWithShadow<u16> value)
-{
-    auto* region = find_region(address);
-    if (!region) {
-        reportln("SoftMMU::write16: No region for @ {:p}", address.offset());
-        m_emulator.dump_backtrace();
-        TODO();
-    }
-
-    if (!region->is_writable()) {
-        reportln("SoftMMU::write16: Non-writable region @ {:p}", address.offset());
+        reportln("SoftMMU::read{}: Non-readable region @ {:p}", sizeof(T) * 8, address.offset());
         m_emulator.dump_backtrace();
         TODO();
     }
 
-    region->write16(address.offset() - region->base(), value);
+    if (address.selector() != 0x2b)
+        fill_tlb(address.offset() / PAGE_SIZE, *region);
+
+    u32 offset_in_region = address.offset() - region->base();
+    if constexpr (sizeof(T) == 1)
+        return region->read8(offset_in_region);
+    if constexpr (sizeof(T) == 2)
+        return region->read16(offset_in_region);
+    if constexpr (sizeof(T) == 4)
+        return region->read32(offset_in_region);
+    if constexpr (sizeof(T) == 8)
+        return region->read64(offset_in_region);
 }
 
-void SoftMMU::write32(X86::LogicalAddress address, ValueWithShadow<u32> value)
+template<typename T>
+void SoftMMU::slow_write(X86::LogicalAddress address, ValueWithShadow<T> value)
 {
     auto* region = find_region(address);
     if (!region) {
-        reportln("SoftMMU::write32: No region for @ {:p}", address.offset());
+        reportln("SoftMMU::write{}: No region for @ {:04x}:{:p}", sizeof(T) * 8, address.selector(), address.offset());
         m_emulator.dump_backtrace();
         TODO();
     }
 
     if (!region->is_writable()) {
-        reportln("SoftMMU::write32: Non-writable region @ {:p}", address.offset());
+        reportln("SoftMMU::write{}: Non-writable region @ {:p}", sizeof(T) * 8, address.offset());
         m_emulator.dump_backtrace();
         TODO();
     }
 
-    region->write32(address.offset() - region->base(), value);
+    if (region->is_executable()) [[unlikely]]
+        m_emulator.basic_block_cache().invalidate(address.offset(), sizeof(T));
+    else if (address.selector() != 0x2b)
+        fill_tlb(address.offset() / PAGE_SIZE, *region);
+
+    u32 offset_in_region = address.offset() - region->base();
+    if constexpr (sizeof(T) == 1)
+        region->write8(offset_in_region, value);
+    if constexpr (sizeof(T) == 2)
+        region->write16(offset_in_region, value);
+    if constexpr (sizeof(T) == 4)
+        region->write32(offset_in_region, value);
+    if constexpr (sizeof(T) == 8)
+        region->write64(offset_in_region, value);
 }
 
-void SoftMMU::write64(X86::LogicalAddress address, ValueWithShadow<u64> value)
-{
-    auto* region = find_region(address);
-    if (!region) {
-        reportln("SoftMMU::write64: No region for @ {:p}", address.offset());
-        m_emulator.dump_backtrace();
-        TODO();
-    }
+template ValueWithShadow<u8> SoftMMU::slow_read<u8>(X86::LogicalAddress);
+template ValueWithShadow<u16> SoftMMU::slow_read<u16>(X86::LogicalAddress);
+template ValueWithShadow<u32> SoftMMU::slow_read<u32>(X86::LogicalAddress);
+template ValueWithShadow<u64> SoftMMU::slow_read<u64>(X86::LogicalAddress);
 
-    if (!region->is_writable()) {
-        reportln("SoftMMU::write64: Non-writable region @ {:p}", address.offset());
-        m_emulator.dump_backtrace();
-        TODO();
-    }
-
-    region->write64(address.offset() - region->base(), value);
-}
+template void SoftMMU::slow_write<u8>(X86::LogicalAddress, ValueWithShadow<u8>);
+template void SoftMMU::slow_write<u16>(X86::LogicalAddress, ValueWithShadow<u16>);
+template void SoftMMU::slow_write<u32>(X86::LogicalAddress, ValueWithShadow<u32>);
+template void SoftMMU::slow_write<u64>(X86::LogicalAddress, ValueWithShadow<u64>);
 
 void SoftMMU::copy_to_vm(FlatPtr destination, const void* source, size_t size)
 {
     // FIXME: We should have a way to preserve the shadow data here as well.
-    for (size_t i = 0; i < size; ++i)
-        write8({ 0x23, destination + i }, shadow_wrap_as_initialized(((const u8*)source)[i]));
+    while (size) {
+        auto* region = find_region({ 0x23, destination });
+        if (!region || !region->is_writable() || region->is_executable() || needs_access_auditing(*region)) {
+            // Let the regular path report bad accesses and do the bookkeeping.
+            write8({ 0x23, destination }, shadow_wrap_as_initialized(*(const u8*)source));
+            ++destination;
+            source = (const u8*)source + 1;
+            --size;
+            continue;
+        }
+        size_t offset_in_region = destination - region->base();
+        size_t chunk_size = min(size, (size_t)region->size() - offset_in_region);
+        memcpy(region->data() + offset_in_region, source, chunk_size);
+        memset(region->shadow_data() + offset_in_region, initialized_shadow<u8>(), chunk_size);
+        destination += chunk_size;
+        source = (const u8*)source + chunk_size;
+        size -= chunk_size;
+    }
 }
 
 void SoftMMU::copy_from_vm(void* destination, const FlatPtr source, size_t size)
 {
     // FIXME: We should have a way to preserve the shadow data here as well.
-    for (size_t i = 0; i < size; ++i)
-        ((u8*)destination)[i] = read8({ 0x23, source + i }).value();
+    FlatPtr address = source;
+    while (size) {
+        auto* region = find_region({ 0x23, address });
+        if (!region || !region->is_readable() || needs_access_auditing(*region)) {
+            *(u8*)destination = read8({ 0x23, address }).value();
+            ++address;
+            destination = (u8*)destination + 1;
+            --size;
+            continue;
+        }
+        size_t offset_in_region = address - region->base();
+        size_t chunk_size = min(size, (size_t)region->size() - offset_in_region);
+        memcpy(destination, region->data() + offset_in_region, chunk_size);
+        address += chunk_size;
+        destination = (u8*)destination + chunk_size;
+        size -= chunk_size;
+    }
 }
 
 ByteBuffer SoftMMU::copy_buffer_from_vm(const FlatPtr source, size_t size)
@@ -294,12 +294,52 @@ bool SoftMMU::fast_fill_memory8(X86::LogicalAddress address, size_t size, ValueW
         }
     }
 
+    if (region->is_executable()) [[unlikely]]
+        m_emulator.basic_block_cache().invalidate(address.offset(), size);
+
     size_t offset_in_region = address.offset() - region->base();
     memset(region->data() + offset_in_region, value.value(), size);
     memset(region->shadow_data() + offset_in_region, value.shadow(), size);
     return true;
 }
 
+bool SoftMMU::fast_fill_memory16(X86::LogicalAddress address, size_t count, ValueWithShadow<u16> value)
+{
+    if (!count)
+        return true;
+    auto* region = find_region(address);
+    if (!region)
+        return false;
+    if (!region->contains(address.offset() + (count * sizeof(u16)) - 1))
+        return false;
+
+    if (is<MmapRegion>(*region) && static_cast<const MmapRegion&>(*region).is_malloc_block()) {
+        if (auto* tracer = m_emulator.malloc_tracer()) {
+            // FIXME: Add a way to audit an entire range of memory instead of looping here!
+            for (size_t i = 0; i < count; ++i) {
+                tracer->audit_write(*region, address.offset() + (i * sizeof(u16)), sizeof(u16));
+            }
+        }
+    }
+
+    if (region->is_executable()) [[unlikely]]
+        m_emulator.basic_block_cache().invalidate(address.offset(), count * sizeof(u16));
+
+    size_t offset_in_region = address.offset() - region->base();
+    u32 value32 = (u32)value.value() | ((u32)value.value() << 16);
+    u32 shadow32 = (u32)value.shadow() | ((u32)value.shadow() << 16);
+    u16* data = (u16*)(region->data() + offset_in_region);
+    u16* shadow_data = (u16*)(region->shadow_data() + offset_in_region);
+    if (count & 1) {
+        data[count - 1] = value.value();
+        shadow_data[count - 1] = value.shadow();
+    }
+    // The host is fine with unaligned 32-bit stores, so fill pairs of elements at a time.
+    fast_u32_fill((u32*)data, value32, count / 2);
+    fast_u32_fill((u32*)shadow_data, shadow32, count / 2);
+    return true;
+}
+
 bool SoftMMU::fast_fill_memory32(X86::LogicalAddress address, size_t count, ValueWithShadow<u32> value)
 {
     if (!count)
@@ -319,10 +359,55 @@ bool SoftMMU::fast_fill_memory32(X86::LogicalAddress address, size_t count, Valu
         }
     }
 
+    if (region->is_executable()) [[unlikely]]
+        m_emulator.basic_block_cache().invalidate(address.offset(), count * sizeof(u32));
+
     size_t offset_in_region = address.offset() - region->base();
     fast_u32_fill((u32*)(region->data() + offset_in_region), value.value(), count);
     fast_u32_fill((u32*)(region->shadow_data() + offset_in_region), value.shadow(), count);
     return true;
 }
 
+bool SoftMMU::fast_copy_memory(X86::LogicalAddress destination, X86::LogicalAddress source, size_t count, size_t element_size)
+{
+    if (!count)
+        return true;
+    size_t size = count * element_size;
+    auto* source_region = find_region(source);
+    auto* destination_region = find_region(destination);
+    if (!source_region || !destination_region)
+        return false;
+    if (!source_region->contains(source.offset() + size - 1) || !destination_region->contains(destination.offset() + size - 1))
+        return false;
+    if (!source_region->is_readable() || !destination_region->is_writable())
+        return false;
+
+    const u8* source_data = source_region->data() + (source.offset() - source_region->base());
+    u8* destination_data = destination_region->data() + (destination.offset() - destination_region->base());
+
+    // A forward element-by-element copy into an overlapping destination above the
+    // source replicates the leading elements, which memmove() would not do.
+    if (destination_data > source_data && destination_data < source_data + size)
+        return false;
+
+    if (needs_access_auditing(*source_region)) {
+        // FIXME: Add a way to audit an entire range of memory instead of looping here!
+        for (size_t i = 0; i < count; ++i)
+            m_emulator.malloc_tracer()->audit_read(*source_region, source.offset() + (i * element_size), element_size);
+    }
+    if (needs_access_auditing(*destination_region)) {
+        for (size_t i = 0; i < count; ++i)
+            m_emulator.malloc_tracer()->audit_write(*destination_region, destination.offset() + (i * element_size), element_size);
+    }
+
+    if (destination_region->is_executable()) [[unlikely]]
+        m_emulator.basic_block_cache().invalidate(destination.offset(), size);
+
+    const u8* source_shadow = source_region->shadow_data() + (source.offset() - source_region->base());
+    u8* destination_shadow = destination_region->shadow_data() + (destination.offset() - destination_region->base());
+    memmove(destination_data, source_data, size);
+    memmove(destination_shadow, source_shadow, size);
+    return true;
+}
+
 }
@@ -42,15 +42,15 @@ class SoftMMU {
 public:
     explicit SoftMMU(Emulator&);
 
-    ValueWithShadow<u8> read8(X86::LogicalAddress);
-    ValueWithShadow<u16> read16(X86::LogicalAddress);
-    ValueWithShadow<u32> read32(X86::LogicalAddress);
-    ValueWithShadow<u64> read64(X86::LogicalAddress);
+    ALWAYS_INLINE ValueWithShadow<u8> read8(X86::LogicalAddress address) { return read<u8>(address); }
+    ALWAYS_INLINE ValueWithShadow<u16> read16(X86::LogicalAddress address) { return read<u16>(address); }
+    ALWAYS_INLINE ValueWithShadow<u32> read32(X86::LogicalAddress address) { return read<u32>(address); }
+    ALWAYS_INLINE ValueWithShadow<u64> read64(X86::LogicalAddress address) { return read<u64>(address); }
 
-    void write8(X86::LogicalAddress, ValueWithShadow<u8>);
-    void write16(X86::LogicalAddress, ValueWithShadow<u16>);
-    void write32(X86::LogicalAddress, ValueWithShadow<u32>);
-    void write64(X86::LogicalAddress, ValueWithShadow<u64>);
+    ALWAYS_INLINE void write8(X86::LogicalAddress address, ValueWithShadow<u8> value) { write<u8>(address, value); }
+    ALWAYS_INLINE void write16(X86::LogicalAddress address, ValueWithShadow<u16> value) { write<u16>(address, value); }
+    ALWAYS_INLINE void write32(X86::LogicalAddress address, ValueWithShadow<u32> value) { write<u32>(address, value); }
+    ALWAYS_INLINE void write64(X86::LogicalAddress address, ValueWithShadow<u64> value) { write<u64>(address, value); }
 
     ALWAYS_INLINE Region* find_region(X86::LogicalAddress address)
     {
@@ -68,7 +68,12 @@ public:
     void set_tls_region(NonnullOwnPtr<Region>);
 
     bool fast_fill_memory8(X86::LogicalAddress, size_t size, ValueWithShadow<u8>);
-    bool fast_fill_memory32(X86::LogicalAddress, size_t size, ValueWithShadow<u32>);
+    bool fast_fill_memory16(X86::LogicalAddress, size_t count, ValueWithShadow<u16>);
+    bool fast_fill_memory32(X86::LogicalAddress, size_t count, ValueWithShadow<u32>);
+    bool fast_copy_memory(X86::LogicalAddress destination, X86::LogicalAddress source, size_t count, size_t element_size);
+
+    // Must be called whenever the mapping, protection or malloc state of a region changes.
+    void flush_tlb();
 
     void copy_to_vm(FlatPtr destination, const void* source, size_t);
     void copy_from_vm(void* destination, const FlatPtr source, size_t);
@@ -110,8 +115,75 @@ public:
     }
 
 private:
+    // A small direct-mapped cache of recently accessed pages, so that plain loads
+    // and stores can go straight to the backing (and shadow) memory without the
+    // region lookup and virtual dispatch. Only pages that need no per-access
+    // bookkeeping (malloc auditing, code cache invalidation) are ever entered.
+    struct TLBEntry {
+        static constexpr u32 invalid_page = 0xffffffff;
+
+        u32 page { invalid_page };
+        bool readable { false };
+        bool writable { false };
+        u8* data { nullptr };
+        u8* shadow_data { nullptr };
+    };
+
+    static constexpr size_t tlb_size = 64;
+
+    template<typename T>
+    ALWAYS_INLINE TLBEntry* tlb_entry_for(X86::LogicalAddress address)
+    {
+        // TLS accesses go through a different selector and always take the slow path.
+        if (address.selector() == 0x2b)
+            return nullptr;
+        u32 offset = address.offset();
+        // Accesses that straddle a page boundary take the slow path as well.
+        if ((offset & (PAGE_SIZE - 1)) > PAGE_SIZE - sizeof(T))
+            return nullptr;
+        u32 page = offset / PAGE_SIZE;
+        auto& entry = m_tlb[page % tlb_size];
+        if (entry.page != page)
+            return nullptr;
+        return &entry;
+    }
+
+    template<typename T>
+    ALWAYS_INLINE ValueWithShadow<T> read(X86::LogicalAddress address)
+    {
+        auto* entry = tlb_entry_for<T>(address);
+        if (entry && entry->readable) [[likely]] {
+            u32 offset_in_page = address.offset() & (PAGE_SIZE - 1);
+            return { *reinterpret_cast<const T*>(entry->data + offset_in_page), *reinterpret_cast<const T*>(entry->shadow_data + offset_in_page) };
+        }
+        return slow_read<T>(address);
+    }
+
+    template<typename T>
+    ALWAYS_INLINE void write(X86::LogicalAddress address, ValueWithShadow<T> value)
+    {
+        auto* entry = tlb_entry_for<T>(address);
+        if (entry && entry->writable) [[likely]] {
+            u32 offset_in_page = address.offset() & (PAGE_SIZE - 1);
+            *reinterpret_cast<T*>(entry->data + offset_in_page) = value.value();
+            *reinterpret_cast<T*>(entry->shadow_data + offset_in_page) = value.shadow();
+            return;
+        }
+        slow_write<T>(address, value);
+    }
+
+    template<typename T>
+    ValueWithShadow<T> slow_read(X86::LogicalAddress);
+    template<typename T>
+    void slow_write(X86::LogicalAddress, ValueWithShadow<T>);
+
+    void fill_tlb(u32 page, Region&);
+    bool needs_access_auditing(const Region&);
+
     Emulator& m_emulator;
 
+    TLBEntry m_tlb[tlb_size];
+
     Region* m_page_to_region_map[786432];
 
     OwnPtr<Region> m_tls_region;
@@ -34,6 +34,16 @@ namespace UserspaceEmulator {
 template<typename T>
 class ValueAndShadowReference;
 
+// Every byte of a value carries one shadow byte, and bit 0 of a shadow byte
+// is set when the corresponding value byte is initialized. Keeping the shadow
+// the same width as the value lets us check and propagate all bytes at once.
+template<typename T>
+constexpr T initialized_shadow()
+{
+    static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+    return static_cast<T>(0x01010101'01010101LLU);
+}
+
 template<typename T>
 class ValueWithShadow {
 public:
@@ -52,22 +62,12 @@ public:
 
     bool is_uninitialized() const
     {
-        if constexpr (sizeof(T) == 4)
-            return (m_shadow & 0x01010101) != 0x01010101;
-        if constexpr (sizeof(T) == 2)
-            return (m_shadow & 0x0101) != 0x0101;
-        if constexpr (sizeof(T) == 1)
-            return (m_shadow & 0x01) != 0x01;
+        return (m_shadow & initialized_shadow<T>()) != initialized_shadow<T>();
     }
 
     void set_initialized()
     {
-        if constexpr (sizeof(T) == 4)
-            m_shadow = 0x01010101;
-        if constexpr (sizeof(T) == 2)
-            m_shadow = 0x0101;
-        if constexpr (sizeof(T) == 1)
-            m_shadow = 0x01;
+        m_shadow = initialized_shadow<T>();
     }
 
 private:
@@ -88,12 +88,7 @@ public:
 
     bool is_uninitialized() const
     {
-        if constexpr (sizeof(T) == 4)
-            return (m_shadow & 0x01010101) != 0x01010101;
-        if constexpr (sizeof(T) == 2)
-            return (m_shadow & 0x0101) != 0x0101;
-        if constexpr (sizeof(T) == 1)
-            return (m_shadow & 0x01) != 0x01;
+        return (m_shadow & initialized_shadow<T>()) != initialized_shadow<T>();
     }
 
     void operator=(const ValueWithShadow<T>&);
@@ -112,38 +107,30 @@ private:
 template<typename T>
 ALWAYS_INLINE ValueWithShadow<T> shadow_wrap_as_initialized(T value)
 {
-    if constexpr (sizeof(T) == 8)
-        return { value, 0x01010101'01010101LLU };
-    if constexpr (sizeof(T) == 4)
-        return { value, 0x01010101 };
-    if constexpr (sizeof(T) == 2)
-        return { value, 0x0101 };
-    if constexpr (sizeof(T) == 1)
-        return { value, 0x01 };
+    return { value, initialized_shadow<T>() };
 }
 
-template<typename T, typename U>
-ALWAYS_INLINE ValueWithShadow<T> shadow_wrap_with_taint_from(T value, const U& taint_a)
+// The taint helpers below are branchless: the shadows of all inputs are
+// folded together, and the result is either fully initialized or fully
+// uninitialized depending on whether any input byte was uninitialized.
+template<typename U>
+ALWAYS_INLINE bool is_any_uninitialized(const U& taint)
 {
-    if (taint_a.is_uninitialized())
-        return { value, 0 };
-    return shadow_wrap_as_initialized(value);
+    return taint.is_uninitialized();
 }
 
-template<typename T, typename U, typename V>
-ALWAYS_INLINE ValueWithShadow<T> shadow_wrap_with_taint_from(T value, const U& taint_a, const V& taint_b)
+template<typename U, typename... Rest>
+ALWAYS_INLINE bool is_any_uninitialized(const U& taint, const Rest&... rest)
 {
-    if (taint_a.is_uninitialized() || taint_b.is_uninitialized())
-        return { value, 0 };
-    return shadow_wrap_as_initialized(value);
+    return taint.is_uninitialized() | is_any_uninitialized(rest...);
 }
 
-template<typename T, typename U, typename V, typename X>
-ALWAYS_INLINE ValueWithShadow<T> shadow_wrap_with_taint_from(T value, const U& taint_a, const V& taint_b, const X& taint_c)
+template<typename T, typename... Taints>
+ALWAYS_INLINE ValueWithShadow<T> shadow_wrap_with_taint_from(T value, const Taints&... taints)
 {
-    if (taint_a.is_uninitialized() || taint_b.is_uninitialized() || taint_c.is_uninitialized())
-        return { value, 0 };
-    return shadow_wrap_as_initialized(value);
+    static_assert(sizeof...(Taints) > 0);
+    T mask = static_cast<T>(is_any_uninitialized(taints...)) - 1;
+    return { value, static_cast<T>(initialized_shadow<T>() & mask) };
 }
 
 template<typename T>
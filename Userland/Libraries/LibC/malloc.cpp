@@ -24,8 +24,10 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Atomic.h>
 #include <AK/Debug.h>
 #include <AK/InlineLinkedList.h>
+#include <AK/NumericLimits.h>
 #include <AK/ScopedValueRollback.h>
 #include <AK/Vector.h>
 #include <LibELF/AuxiliaryVector.h>
@@ -40,21 +42,25 @@
 #include <sys/mman.h>
 #include <syscall.h>
 
-// FIXME: Thread safety.
-
 #define RECYCLE_BIG_ALLOCATIONS
 
-#define PAGE_ROUND_UP(x) ((((size_t)(x)) + PAGE_SIZE - 1) & (~(PAGE_SIZE - 1)))
+// The dynamic loader is built without TLS, and it is single threaded anyway.
+#ifndef NO_TLS
+#    define USE_THREAD_CACHE
+#endif
 
-static LibThread::Lock& malloc_lock()
-{
-    static u32 lock_storage[sizeof(LibThread::Lock) / sizeof(u32)];
-    return *reinterpret_cast<LibThread::Lock*>(&lock_storage);
-}
+#define PAGE_ROUND_UP(x) ((((size_t)(x)) + PAGE_SIZE - 1) & (~(PAGE_SIZE - 1)))
 
 constexpr size_t number_of_chunked_blocks_to_keep_around_per_size_class = 4;
 constexpr size_t number_of_big_blocks_to_keep_around_per_size_class = 8;
 
+// Each thread keeps a few free chunks of the smaller size classes around, so
+// that most allocations don't need to take the size class lock at all.
+// Chunks move between a thread cache and its size class in batches.
+constexpr size_t largest_thread_cached_chunk_size = 1016;
+constexpr size_t max_thread_cached_chunks_per_size_class = 32;
+constexpr size_t thread_cache_batch_size = max_thread_cached_chunks_per_size_class / 2;
+
 static bool s_log_malloc = false;
 static bool s_scrub_malloc = true;
 static bool s_scrub_free = true;
@@ -79,28 +85,38 @@ ALWAYS_INLINE static void ue_notify_realloc(const void* ptr, size_t size)
         syscall(SC_emuctl, 3, size, (FlatPtr)ptr);
 }
 
+using MallocCounter = Atomic<size_t, AK::memory_order_relaxed>;
+
 struct MallocStats {
-    size_t number_of_malloc_calls;
+    MallocCounter number_of_malloc_calls;
+
+    MallocCounter number_of_big_allocator_hits;
+    MallocCounter number_of_big_allocator_purge_hits;
+    MallocCounter number_of_big_allocs;
 
-    size_t number_of_big_allocator_hits;
-    size_t number_of_big_allocator_purge_hits;
-    size_t number_of_big_allocs;
+    MallocCounter number_of_empty_block_hits;
+    MallocCounter number_of_empty_block_purge_hits;
+    MallocCounter number_of_block_allocs;
+    MallocCounter number_of_blocks_full;
 
-    size_t number_of_empty_block_hits;
-    size_t number_of_empty_block_purge_hits;
-    size_t number_of_block_allocs;
-    size_t number_of_blocks_full;
+    MallocCounter number_of_free_calls;
 
-    size_t number_of_free_calls;
+    MallocCounter number_of_big_allocator_keeps;
+    MallocCounter number_of_big_allocator_frees;
 
-    size_t number_of_big_allocator_keeps;
-    size_t number_of_big_allocator_frees;
+    MallocCounter number_of_freed_full_blocks;
+    MallocCounter number_of_keeps;
+    MallocCounter number_of_frees;
 
-    size_t number_of_freed_full_blocks;
-    size_t number_of_keeps;
-    size_t number_of_frees;
+    MallocCounter number_of_thread_cache_hits;
+    MallocCounter number_of_thread_cache_refills;
+    MallocCounter number_of_thread_cache_keeps;
+    MallocCounter number_of_thread_cache_flushes;
+
+    MallocCounter number_of_lock_acquisitions;
+    MallocCounter number_of_contended_lock_acquisitions;
 };
-static MallocStats g_malloc_stats = {};
+static MallocStats g_malloc_stats;
 
 struct Allocator {
     size_t size { 0 };
@@ -109,12 +125,47 @@ struct Allocator {
     ChunkedBlock* empty_blocks[number_of_chunked_blocks_to_keep_around_per_size_class] { nullptr };
     InlineLinkedList<ChunkedBlock> usable_blocks;
     InlineLinkedList<ChunkedBlock> full_blocks;
+    LibThread::Lock lock;
 };
 
 struct BigAllocator {
     Vector<BigAllocationBlock*, number_of_big_blocks_to_keep_around_per_size_class> blocks;
+    LibThread::Lock lock;
+};
+
+class MallocLocker {
+public:
+    explicit MallocLocker(LibThread::Lock& lock)
+        : m_lock(lock)
+    {
+        g_malloc_stats.number_of_lock_acquisitions++;
+        if (!m_lock.try_lock()) {
+            g_malloc_stats.number_of_contended_lock_acquisitions++;
+            m_lock.lock();
+        }
+    }
+    ~MallocLocker() { m_lock.unlock(); }
+
+private:
+    LibThread::Lock& m_lock;
 };
 
+#ifdef USE_THREAD_CACHE
+struct ThreadCache {
+    FreelistEntry* chunks[num_size_classes];
+    u8 chunk_count[num_size_classes];
+
+    // Calls served by the cache are only added to the global statistics
+    // whenever we have to touch a size class anyway.
+    size_t pending_hits;
+    size_t pending_keeps;
+};
+static_assert(max_thread_cached_chunks_per_size_class <= NumericLimits<u8>::max());
+
+static __thread ThreadCache t_thread_cache;
+static bool s_use_thread_cache = true;
+#endif
+
 // Allocators will be initialized in __malloc_init.
 // We can not rely on global constructors to initialize them,
 // because they must be initialized before other global constructors
@@ -134,6 +185,11 @@ static inline BigAllocator (&big_allocators())[1]
     return reinterpret_cast<BigAllocator(&)[1]>(g_big_allocators_storage);
 }
 
+static inline size_t size_class_index(const Allocator& allocator)
+{
+    return &allocator - allocators();
+}
+
 static Allocator* allocator_for_size(size_t size, size_t& good_size)
 {
     for (size_t i = 0; size_classes[i]; ++i) {
@@ -175,25 +231,181 @@ enum class CallerWillInitializeMemory {
     Yes,
 };
 
-static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_initialize_memory)
+static void* allocate_chunk(Allocator& allocator)
 {
-    LOCKER(malloc_lock());
+    size_t good_size = allocator.size;
+
+    ChunkedBlock* block = nullptr;
 
+    for (block = allocator.usable_blocks.head(); block; block = block->next()) {
+        if (block->free_chunks())
+            break;
+    }
+
+    if (!block && allocator.empty_block_count) {
+        g_malloc_stats.number_of_empty_block_hits++;
+        block = allocator.empty_blocks[--allocator.empty_block_count];
+        int rc = madvise(block, ChunkedBlock::block_size, MADV_SET_NONVOLATILE);
+        bool this_block_was_purged = rc == 1;
+        if (rc < 0) {
+            perror("madvise");
+            VERIFY_NOT_REACHED();
+        }
+        rc = mprotect(block, ChunkedBlock::block_size, PROT_READ | PROT_WRITE);
+        if (rc < 0) {
+            perror("mprotect");
+            VERIFY_NOT_REACHED();
+        }
+        if (this_block_was_purged) {
+            g_malloc_stats.number_of_empty_block_purge_hits++;
+            new (block) ChunkedBlock(good_size);
+        }
+        allocator.usable_blocks.append(block);
+    }
+
+    if (!block) {
+        g_malloc_stats.number_of_block_allocs++;
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
+        block = (ChunkedBlock*)os_alloc(ChunkedBlock::block_size, buffer);
+        new (block) ChunkedBlock(good_size);
+        allocator.usable_blocks.append(block);
+        ++allocator.block_count;
+    }
+
+    --block->m_free_chunks;
+    void* ptr = block->m_freelist;
+    VERIFY(ptr);
+    block->m_freelist = block->m_freelist->next;
+    if (block->is_full()) {
+        g_malloc_stats.number_of_blocks_full++;
+        dbgln_if(MALLOC_DEBUG, "Block {:p} is now full in size class {}", block, good_size);
+        allocator.usable_blocks.remove(block);
+        allocator.full_blocks.append(block);
+    }
+    dbgln_if(MALLOC_DEBUG, "LibC: allocated {:p} (chunk in block {:p}, size {})", ptr, block, block->bytes_per_chunk());
+    return ptr;
+}
+
+static void free_chunk(Allocator& allocator, ChunkedBlock& block, void* ptr)
+{
+    auto* entry = (FreelistEntry*)ptr;
+    entry->next = block.m_freelist;
+    block.m_freelist = entry;
+
+    if (block.is_full()) {
+        dbgln_if(MALLOC_DEBUG, "Block {:p} no longer full in size class {}", &block, allocator.size);
+        g_malloc_stats.number_of_freed_full_blocks++;
+        allocator.full_blocks.remove(&block);
+        allocator.usable_blocks.prepend(&block);
+    }
+
+    ++block.m_free_chunks;
+
+    if (!block.used_chunks()) {
+        if (allocator.block_count < number_of_chunked_blocks_to_keep_around_per_size_class) {
+            dbgln_if(MALLOC_DEBUG, "Keeping block {:p} around for size class {}", &block, allocator.size);
+            g_malloc_stats.number_of_keeps++;
+            allocator.usable_blocks.remove(&block);
+            allocator.empty_blocks[allocator.empty_block_count++] = &block;
+            mprotect(&block, ChunkedBlock::block_size, PROT_NONE);
+            madvise(&block, ChunkedBlock::block_size, MADV_SET_VOLATILE);
+            return;
+        }
+        dbgln_if(MALLOC_DEBUG, "Releasing block {:p} for size class {}", &block, allocator.size);
+        g_malloc_stats.number_of_frees++;
+        allocator.usable_blocks.remove(&block);
+        --allocator.block_count;
+        os_free(&block, ChunkedBlock::block_size);
+    }
+}
+
+#ifdef USE_THREAD_CACHE
+static void flush_pending_thread_cache_stats(ThreadCache& cache)
+{
+    g_malloc_stats.number_of_malloc_calls += cache.pending_hits;
+    g_malloc_stats.number_of_thread_cache_hits += cache.pending_hits;
+    g_malloc_stats.number_of_free_calls += cache.pending_keeps;
+    g_malloc_stats.number_of_thread_cache_keeps += cache.pending_keeps;
+    cache.pending_hits = 0;
+    cache.pending_keeps = 0;
+}
+
+static void* thread_cache_allocate(Allocator& allocator)
+{
+    auto& cache = t_thread_cache;
+    auto index = size_class_index(allocator);
+
+    if (!cache.chunks[index]) {
+        g_malloc_stats.number_of_thread_cache_refills++;
+        flush_pending_thread_cache_stats(cache);
+        MallocLocker locker(allocator.lock);
+        for (size_t i = 0; i < thread_cache_batch_size; ++i) {
+            auto* entry = (FreelistEntry*)allocate_chunk(allocator);
+            entry->next = cache.chunks[index];
+            cache.chunks[index] = entry;
+        }
+        cache.chunk_count[index] = thread_cache_batch_size;
+    }
+
+    auto* entry = cache.chunks[index];
+    cache.chunks[index] = entry->next;
+    --cache.chunk_count[index];
+    ++cache.pending_hits;
+    return entry;
+}
+
+static void thread_cache_flush(Allocator& allocator, size_t count)
+{
+    auto& cache = t_thread_cache;
+    auto index = size_class_index(allocator);
+    if (!count)
+        return;
+
+    g_malloc_stats.number_of_thread_cache_flushes++;
+    flush_pending_thread_cache_stats(cache);
+    MallocLocker locker(allocator.lock);
+    for (size_t i = 0; i < count && cache.chunks[index]; ++i) {
+        auto* entry = cache.chunks[index];
+        cache.chunks[index] = entry->next;
+        --cache.chunk_count[index];
+        auto* block = (ChunkedBlock*)((FlatPtr)entry & ChunkedBlock::block_mask);
+        free_chunk(allocator, *block, entry);
+    }
+}
+
+static void thread_cache_free(Allocator& allocator, void* ptr)
+{
+    auto& cache = t_thread_cache;
+    auto index = size_class_index(allocator);
+
+    auto* entry = (FreelistEntry*)ptr;
+    entry->next = cache.chunks[index];
+    cache.chunks[index] = entry;
+    ++cache.pending_keeps;
+
+    if (++cache.chunk_count[index] > max_thread_cached_chunks_per_size_class)
+        thread_cache_flush(allocator, thread_cache_batch_size);
+}
+#endif
+
+static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_initialize_memory)
+{
     if (s_log_malloc)
         dbgln("LibC: malloc({})", size);
 
     if (!size)
         return nullptr;
 
-    g_malloc_stats.number_of_malloc_calls++;
-
     size_t good_size;
     auto* allocator = allocator_for_size(size, good_size);
 
     if (!allocator) {
+        g_malloc_stats.number_of_malloc_calls++;
         size_t real_size = round_up_to_power_of_two(sizeof(BigAllocationBlock) + size, ChunkedBlock::block_size);
 #ifdef RECYCLE_BIG_ALLOCATIONS
         if (auto* allocator = big_allocator_for_size(real_size)) {
+            MallocLocker locker(allocator->lock);
             if (!allocator->blocks.is_empty()) {
                 g_malloc_stats.number_of_big_allocator_hits++;
                 auto* block = allocator->blocks.take_last();
@@ -224,58 +436,19 @@ static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_ini
         return &block->m_slot[0];
     }
 
-    ChunkedBlock* block = nullptr;
-
-    for (block = allocator->usable_blocks.head(); block; block = block->next()) {
-        if (block->free_chunks())
-            break;
-    }
-
-    if (!block && allocator->empty_block_count) {
-        g_malloc_stats.number_of_empty_block_hits++;
-        block = allocator->empty_blocks[--allocator->empty_block_count];
-        int rc = madvise(block, ChunkedBlock::block_size, MADV_SET_NONVOLATILE);
-        bool this_block_was_purged = rc == 1;
-        if (rc < 0) {
-            perror("madvise");
-            VERIFY_NOT_REACHED();
-        }
-        rc = mprotect(block, ChunkedBlock::block_size, PROT_READ | PROT_WRITE);
-        if (rc < 0) {
-            perror("mprotect");
-            VERIFY_NOT_REACHED();
-        }
-        if (this_block_was_purged) {
-            g_malloc_stats.number_of_empty_block_purge_hits++;
-            new (block) ChunkedBlock(good_size);
-        }
-        allocator->usable_blocks.append(block);
-    }
-
-    if (!block) {
-        g_malloc_stats.number_of_block_allocs++;
-        char buffer[64];
-        snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
-        block = (ChunkedBlock*)os_alloc(ChunkedBlock::block_size, buffer);
-        new (block) ChunkedBlock(good_size);
-        allocator->usable_blocks.append(block);
-        ++allocator->block_count;
-    }
-
-    --block->m_free_chunks;
-    void* ptr = block->m_freelist;
-    VERIFY(ptr);
-    block->m_freelist = block->m_freelist->next;
-    if (block->is_full()) {
-        g_malloc_stats.number_of_blocks_full++;
-        dbgln_if(MALLOC_DEBUG, "Block {:p} is now full in size class {}", block, good_size);
-        allocator->usable_blocks.remove(block);
-        allocator->full_blocks.append(block);
+    void* ptr = nullptr;
+#ifdef USE_THREAD_CACHE
+    if (s_use_thread_cache && good_size <= largest_thread_cached_chunk_size)
+        ptr = thread_cache_allocate(*allocator);
+#endif
+    if (!ptr) {
+        g_malloc_stats.number_of_malloc_calls++;
+        MallocLocker locker(allocator->lock);
+        ptr = allocate_chunk(*allocator);
     }
-    dbgln_if(MALLOC_DEBUG, "LibC: allocated {:p} (chunk in block {:p}, size {})", ptr, block, block->bytes_per_chunk());
 
     if (s_scrub_malloc && caller_will_initialize_memory == CallerWillInitializeMemory::No)
-        memset(ptr, MALLOC_SCRUB_BYTE, block->m_size);
+        memset(ptr, MALLOC_SCRUB_BYTE, good_size);
 
     ue_notify_malloc(ptr, size);
     return ptr;
@@ -288,17 +461,15 @@ static void free_impl(void* ptr)
     if (!ptr)
         return;
 
-    g_malloc_stats.number_of_free_calls++;
-
-    LOCKER(malloc_lock());
-
     void* block_base = (void*)((FlatPtr)ptr & ChunkedBlock::ChunkedBlock::block_mask);
     size_t magic = *(size_t*)block_base;
 
     if (magic == MAGIC_BIGALLOC_HEADER) {
+        g_malloc_stats.number_of_free_calls++;
         auto* block = (BigAllocationBlock*)block_base;
 #ifdef RECYCLE_BIG_ALLOCATIONS
         if (auto* allocator = big_allocator_for_size(block->m_size)) {
+            MallocLocker locker(allocator->lock);
             if (allocator->blocks.size() < number_of_big_blocks_to_keep_around_per_size_class) {
                 g_malloc_stats.number_of_big_allocator_keeps++;
                 allocator->blocks.append(block);
@@ -328,39 +499,20 @@ static void free_impl(void* ptr)
     if (s_scrub_free)
         memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
 
-    auto* entry = (FreelistEntry*)ptr;
-    entry->next = block->m_freelist;
-    block->m_freelist = entry;
+    size_t good_size;
+    auto* allocator = allocator_for_size(block->m_size, good_size);
+    VERIFY(allocator);
 
-    if (block->is_full()) {
-        size_t good_size;
-        auto* allocator = allocator_for_size(block->m_size, good_size);
-        dbgln_if(MALLOC_DEBUG, "Block {:p} no longer full in size class {}", block, good_size);
-        g_malloc_stats.number_of_freed_full_blocks++;
-        allocator->full_blocks.remove(block);
-        allocator->usable_blocks.prepend(block);
+#ifdef USE_THREAD_CACHE
+    if (s_use_thread_cache && good_size <= largest_thread_cached_chunk_size) {
+        thread_cache_free(*allocator, ptr);
+        return;
     }
+#endif
 
-    ++block->m_free_chunks;
-
-    if (!block->used_chunks()) {
-        size_t good_size;
-        auto* allocator = allocator_for_size(block->m_size, good_size);
-        if (allocator->block_count < number_of_chunked_blocks_to_keep_around_per_size_class) {
-            dbgln_if(MALLOC_DEBUG, "Keeping block {:p} around for size class {}", block, good_size);
-            g_malloc_stats.number_of_keeps++;
-            allocator->usable_blocks.remove(block);
-            allocator->empty_blocks[allocator->empty_block_count++] = block;
-            mprotect(block, ChunkedBlock::block_size, PROT_NONE);
-            madvise(block, ChunkedBlock::block_size, MADV_SET_VOLATILE);
-            return;
-        }
-        dbgln_if(MALLOC_DEBUG, "Releasing block {:p} for size class {}", block, good_size);
-        g_malloc_stats.number_of_frees++;
-        allocator->usable_blocks.remove(block);
-        --allocator->block_count;
-        os_free(block, ChunkedBlock::block_size);
-    }
+    g_malloc_stats.number_of_free_calls++;
+    MallocLocker locker(allocator->lock);
+    free_chunk(*allocator, *block, ptr);
 }
 
 [[gnu::flatten]] void* malloc(size_t size)
@@ -392,7 +544,6 @@ size_t malloc_size(void* ptr)
 {
     if (!ptr)
         return 0;
-    LOCKER(malloc_lock());
     void* page_base = (void*)((FlatPtr)ptr & ChunkedBlock::block_mask);
     auto* header = (const CommonHeader*)page_base;
     auto size = header->m_size;
@@ -410,7 +561,6 @@ void* realloc(void* ptr, size_t size)
     if (!size)
         return nullptr;
 
-    LOCKER(malloc_lock());
     auto existing_allocation_size = malloc_size(ptr);
 
     if (size <= existing_allocation_size) {
@@ -427,14 +577,16 @@ void* realloc(void* ptr, size_t size)
 
 void __malloc_init()
 {
-    new (&malloc_lock()) LibThread::Lock();
-
     s_in_userspace_emulator = (int)syscall(SC_emuctl, 0) != -ENOSYS;
     if (s_in_userspace_emulator) {
         // Don't bother scrubbing memory if we're running in UE since it
         // keeps track of heap memory anyway.
         s_scrub_malloc = false;
         s_scrub_free = false;
+#ifdef USE_THREAD_CACHE
+        // UE's MallocTracer expects freed chunks to be on their block's freelist.
+        s_use_thread_cache = false;
+#endif
     }
 
     if (secure_getenv("LIBC_NOSCRUB_MALLOC"))
@@ -445,6 +597,10 @@ void __malloc_init()
         s_log_malloc = true;
     if (secure_getenv("LIBC_PROFILE_MALLOC"))
         s_profiling = true;
+#ifdef USE_THREAD_CACHE
+    if (secure_getenv("LIBC_NO_MALLOC_THREAD_CACHE"))
+        s_use_thread_cache = false;
+#endif
 
     for (size_t i = 0; i < num_size_classes; ++i) {
         new (&allocators()[i]) Allocator();
@@ -454,26 +610,44 @@ void __malloc_init()
     new (&big_allocators()[0])(BigAllocator);
 }
 
+void __malloc_thread_exit()
+{
+#ifdef USE_THREAD_CACHE
+    // Give the chunks this thread was holding on to back to their size classes.
+    for (size_t i = 0; i < num_size_classes; ++i)
+        thread_cache_flush(allocators()[i], t_thread_cache.chunk_count[i]);
+    flush_pending_thread_cache_stats(t_thread_cache);
+#endif
+}
+
 void serenity_dump_malloc_stats()
 {
-    dbgln("# malloc() calls: {}", g_malloc_stats.number_of_malloc_calls);
+    dbgln("# malloc() calls: {}", g_malloc_stats.number_of_malloc_calls.load());
+    dbgln();
+    dbgln("big alloc hits: {}", g_malloc_stats.number_of_big_allocator_hits.load());
+    dbgln("big alloc hits that were purged: {}", g_malloc_stats.number_of_big_allocator_purge_hits.load());
+    dbgln("big allocs: {}", g_malloc_stats.number_of_big_allocs.load());
+    dbgln();
+    dbgln("empty block hits: {}", g_malloc_stats.number_of_empty_block_hits.load());
+    dbgln("empty block hits that were purged: {}", g_malloc_stats.number_of_empty_block_purge_hits.load());
+    dbgln("block allocs: {}", g_malloc_stats.number_of_block_allocs.load());
+    dbgln("filled blocks: {}", g_malloc_stats.number_of_blocks_full.load());
     dbgln();
-    dbgln("big alloc hits: {}", g_malloc_stats.number_of_big_allocator_hits);
-    dbgln("big alloc hits that were purged: {}", g_malloc_stats.number_of_big_allocator_purge_hits);
-    dbgln("big allocs: {}", g_malloc_stats.number_of_big_allocs);
+    dbgln("# free() calls: {}", g_malloc_stats.number_of_free_calls.load());
     dbgln();
-    dbgln("empty block hits: {}", g_malloc_stats.number_of_empty_block_hits);
-    dbgln("empty block hits that were purged: {}", g_malloc_stats.number_of_empty_block_purge_hits);
-    dbgln("block allocs: {}", g_malloc_stats.number_of_block_allocs);
-    dbgln("filled blocks: {}", g_malloc_stats.number_of_blocks_full);
+    dbgln("big alloc keeps: {}", g_malloc_stats.number_of_big_allocator_keeps.load());
+    dbgln("big alloc frees: {}", g_malloc_stats.number_of_big_allocator_frees.load());
     dbgln();
-    dbgln("# free() calls: {}", g_malloc_stats.number_of_free_calls);
+    dbgln("full block frees: {}", g_malloc_stats.number_of_freed_full_blocks.load());
+    dbgln("number of keeps: {}", g_malloc_stats.number_of_keeps.load());
+    dbgln("number of frees: {}", g_malloc_stats.number_of_frees.load());
     dbgln();
-    dbgln("big alloc keeps: {}", g_malloc_stats.number_of_big_allocator_keeps);
-    dbgln("big alloc frees: {}", g_malloc_stats.number_of_big_allocator_frees);
+    dbgln("thread cache hits: {}", g_malloc_stats.number_of_thread_cache_hits.load());
+    dbgln("thread cache refills: {}", g_malloc_stats.number_of_thread_cache_refills.load());
+    dbgln("thread cache keeps: {}", g_malloc_stats.number_of_thread_cache_keeps.load());
+    dbgln("thread cache flushes: {}", g_malloc_stats.number_of_thread_cache_flushes.load());
     dbgln();
-    dbgln("full block frees: {}", g_malloc_stats.number_of_freed_full_blocks);
-    dbgln("number of keeps: {}", g_malloc_stats.number_of_keeps);
-    dbgln("number of frees: {}", g_malloc_stats.number_of_frees);
+    dbgln("lock acquisitions: {}", g_malloc_stats.number_of_lock_acquisitions.load());
+    dbgln("contended lock acquisitions: {}", g_malloc_stats.number_of_contended_lock_acquisitions.load());
 }
 }
@@ -28,7 +28,7 @@
 #include <AK/Array.h>
 #include <AK/Assertions.h>
 #include <AK/BinaryHeap.h>
-#include <AK/BinarySearch.h>
+#include <AK/Function.h>
 #include <AK/MemoryStream.h>
 #include <string.h>
 
@@ -36,6 +36,114 @@
 
 namespace Compress {
 
+// Bit reader for inputs that are entirely in memory, which lets us refill a whole 64-bit word at a time
+// (possibly reading ahead past the end of the deflate stream, which is harmless here).
+class WordBitReader {
+public:
+    explicit WordBitReader(ReadonlyBytes bytes)
+        : m_bytes(bytes)
+    {
+    }
+
+    ALWAYS_INLINE void refill()
+    {
+        if (m_bit_count >= 56)
+            return;
+
+        if (m_offset + sizeof(u64) <= m_bytes.size()) {
+            LittleEndian<u64> word;
+            memcpy(&word, m_bytes.offset_pointer(m_offset), sizeof(word));
+            m_bit_buffer |= static_cast<u64>(word) << m_bit_count;
+            // Only whole bytes are accounted for, the bits of the next byte that did fit into the buffer are
+            // simply or-ed in again by the next refill.
+            const auto nread = (63 - m_bit_count) / 8;
+            m_offset += nread;
+            m_bit_count += nread * 8;
+            return;
+        }
+
+        while (m_bit_count < 56 && m_offset < m_bytes.size()) {
+            m_bit_buffer |= static_cast<u64>(m_bytes[m_offset++]) << m_bit_count;
+            m_bit_count += 8;
+        }
+    }
+
+    ALWAYS_INLINE bool try_fill_bits(size_t count)
+    {
+        if (m_bit_count < count)
+            refill();
+        return m_bit_count >= count;
+    }
+
+    ALWAYS_INLINE u32 peek_bits(size_t count) const { return static_cast<u32>(m_bit_buffer & ((1ull << count) - 1)); }
+
+    ALWAYS_INLINE void discard_bits(size_t count)
+    {
+        m_bit_buffer >>= count;
+        m_bit_count -= count;
+    }
+
+    ALWAYS_INLINE u32 read_bits(size_t count)
+    {
+        if (!try_fill_bits(count)) {
+            m_has_error = true;
+            return 0;
+        }
+
+        const auto result = peek_bits(count);
+        discard_bits(count);
+        return result;
+    }
+
+    bool read_bit() { return static_cast<bool>(read_bits(1)); }
+
+    size_t buffered_bit_count() const { return m_bit_count; }
+
+    // Hands the whole bytes that were buffered back to the input, so that the following bytes can be read directly.
+    ReadonlyBytes align_and_read_bytes(size_t count)
+    {
+        discard_bits(m_bit_count % 8);
+        m_offset -= m_bit_count / 8;
+        m_bit_buffer = 0;
+        m_bit_count = 0;
+
+        if (m_offset + count > m_bytes.size()) {
+            m_has_error = true;
+            return {};
+        }
+
+        auto bytes = m_bytes.slice(m_offset, count);
+        m_offset += count;
+        return bytes;
+    }
+
+    bool has_error() const { return m_has_error; }
+
+private:
+    ReadonlyBytes m_bytes;
+    size_t m_offset { 0 };
+    u64 m_bit_buffer { 0 };
+    size_t m_bit_count { 0 };
+    bool m_has_error { false };
+};
+
+template<typename BitReader>
+ALWAYS_INLINE static u32 read_symbol_from(const CanonicalCode& code, BitReader& reader)
+{
+    for (;;) {
+        size_t code_length;
+        const auto symbol = code.lookup_symbol(reader.peek_bits(CanonicalCode::max_code_length), code_length);
+        if (code_length != 0 && code_length <= reader.buffered_bit_count()) {
+            reader.discard_bits(code_length);
+            return symbol;
+        }
+
+        // Either the code is longer than what we have buffered, or the missing bits made it look invalid.
+        if (reader.buffered_bit_count() >= CanonicalCode::max_code_length || !reader.try_fill_bits(reader.buffered_bit_count() + 1))
+            return UINT32_MAX; // the maximum symbol in deflate is 288, so we use UINT32_MAX (an impossible value) to indicate an error
+    }
+}
+
 const CanonicalCode& CanonicalCode::fixed_literal_codes()
 {
     static CanonicalCode code;
@@ -79,10 +187,9 @@ Optional<CanonicalCode> CanonicalCode::from_bytes(ReadonlyBytes bytes)
         }
     }
     if (non_zero_symbols == 1) { // special case - only 1 symbol
-        code.m_symbol_codes.append(0b10);
-        code.m_symbol_values.append(last_non_zero);
         code.m_bit_codes[last_non_zero] = 0;
         code.m_bit_code_lengths[last_non_zero] = 1;
+        code.build_lookup_tables(bytes.size());
         return code;
     }
 
@@ -98,8 +205,6 @@ Optional<CanonicalCode> CanonicalCode::from_bytes(ReadonlyBytes bytes)
             if (next_code > start_bit)
                 return {};
 
-            code.m_symbol_codes.append(start_bit | next_code);
-            code.m_symbol_values.append(symbol);
             code.m_bit_codes[symbol] = fast_reverse16(start_bit | next_code, code_length); // DEFLATE writes huffman encoded symbols as lsb-first
             code.m_bit_code_lengths[symbol] = code_length;
 
@@ -111,26 +216,62 @@ Optional<CanonicalCode> CanonicalCode::from_bytes(ReadonlyBytes bytes)
         return {};
     }
 
+    code.build_lookup_tables(bytes.size());
     return code;
 }
 
-u32 CanonicalCode::read_symbol(InputBitStream& stream) const
+void CanonicalCode::build_lookup_tables(size_t symbol_count)
 {
-    u32 code_bits = 1;
+    // Codes that do not fit into the primary table share a secondary table per primary_table_bits prefix,
+    // which has to be large enough for the longest code with that prefix.
+    Array<u8, 1 << primary_table_bits> secondary_bits {};
+    for (size_t symbol = 0; symbol < symbol_count; ++symbol) {
+        const auto code_length = m_bit_code_lengths[symbol];
+        if (code_length <= primary_table_bits)
+            continue;
+        auto& bits = secondary_bits[m_bit_codes[symbol] & ((1 << primary_table_bits) - 1)];
+        bits = max<u8>(bits, code_length - primary_table_bits);
+    }
 
-    for (;;) {
-        code_bits = code_bits << 1 | stream.read_bits(1);
-        if (code_bits >= (1 << 16))
-            return UINT32_MAX; // the maximum symbol in deflate is 288, so we use UINT32_MAX (an impossible value) to indicate an error
+    size_t secondary_table_size = 0;
+    for (size_t prefix = 0; prefix < secondary_bits.size(); ++prefix) {
+        if (secondary_bits[prefix] == 0)
+            continue;
+        m_primary_table[prefix] = secondary_table_link | secondary_bits[prefix] << 16 | secondary_table_size;
+        secondary_table_size += 1 << secondary_bits[prefix];
+    }
+    m_secondary_table.resize(secondary_table_size);
+    m_secondary_table.span().fill(0);
+
+    // Every code is replicated into all the slots whose low bits match it, so that a lookup can use whatever
+    // bits follow the code as part of the index.
+    for (size_t symbol = 0; symbol < symbol_count; ++symbol) {
+        const u32 code_length = m_bit_code_lengths[symbol];
+        if (code_length == 0)
+            continue;
+
+        const u32 code = m_bit_codes[symbol];
+        const u32 entry = code_length << 16 | symbol;
 
-        // FIXME: This is very inefficient and could greatly be improved by implementing this
-        //        algorithm: https://www.hanshq.net/zip.html#huffdec
-        size_t index;
-        if (binary_search(m_symbol_codes.span(), code_bits, &index))
-            return m_symbol_values[index];
+        if (code_length <= primary_table_bits) {
+            for (size_t index = code; index < m_primary_table.size(); index += 1 << code_length)
+                m_primary_table[index] = entry;
+            continue;
+        }
+
+        const auto link = m_primary_table[code & ((1 << primary_table_bits) - 1)];
+        const auto offset = link & 0xffff;
+        const auto table_bits = (link >> 16) & 0xff;
+        for (size_t index = code >> primary_table_bits; index < (1u << table_bits); index += 1 << (code_length - primary_table_bits))
+            m_secondary_table[offset + index] = entry;
     }
 }
 
+u32 CanonicalCode::read_symbol(InputBitStream& stream) const
+{
+    return read_symbol_from(*this, stream);
+}
+
 void CanonicalCode::write_symbol(OutputBitStream& stream, u32 symbol) const
 {
     stream.write_bits(m_bit_codes[symbol], m_bit_code_lengths[symbol]);
@@ -148,45 +289,51 @@ bool DeflateDecompressor::CompressedBlock::try_read_more()
     if (m_eof == true)
         return false;
 
-    const auto symbol = m_literal_codes.read_symbol(m_decompressor.m_input_stream);
+    // Decode as many symbols as we can while there is room for the longest possible back reference, so
+    // that the caller does not have to come back for every single symbol.
+    auto& output_stream = m_decompressor.m_output_stream;
+    bool produced_output = false;
+    while (output_stream.remaining_space() >= DeflateCompressor::max_match_length) {
+        const auto symbol = read_symbol_from(m_literal_codes, m_decompressor.m_input_stream);
 
-    if (symbol >= 286) { // invalid deflate literal/length symbol
-        m_decompressor.set_fatal_error();
-        return false;
-    }
+        if (symbol >= 286) { // invalid deflate literal/length symbol
+            m_decompressor.set_fatal_error();
+            return false;
+        }
+
+        if (symbol < 256) {
+            output_stream << static_cast<u8>(symbol);
+            produced_output = true;
+            continue;
+        }
+
+        if (symbol == 256) {
+            m_eof = true;
+            return produced_output;
+        }
 
-    if (symbol < 256) {
-        m_decompressor.m_output_stream << static_cast<u8>(symbol);
-        return true;
-    } else if (symbol == 256) {
-        m_eof = true;
-        return false;
-    } else {
         if (!m_distance_codes.has_value()) {
             m_decompressor.set_fatal_error();
             return false;
         }
 
         const auto length = m_decompressor.decode_length(symbol);
-        const auto distance_symbol = m_distance_codes.value().read_symbol(m_decompressor.m_input_stream);
+        const auto distance_symbol = read_symbol_from(m_distance_codes.value(), m_decompressor.m_input_stream);
         if (distance_symbol >= 30) { // invalid deflate distance symbol
             m_decompressor.set_fatal_error();
             return false;
         }
         const auto distance = m_decompressor.decode_distance(distance_symbol);
 
-        for (size_t idx = 0; idx < length; ++idx) {
-            u8 byte = 0;
-            m_decompressor.m_output_stream.read({ &byte, sizeof(byte) }, distance);
-            if (m_decompressor.m_output_stream.handle_any_error()) {
-                m_decompressor.set_fatal_error();
-                return false; // a back reference was requested that was too far back (outside our current sliding window)
-            }
-            m_decompressor.m_output_stream << byte;
+        if (!output_stream.copy_from_seekback(distance, length)) {
+            output_stream.handle_any_error();
+            m_decompressor.set_fatal_error();
+            return false; // a back reference was requested that was too far back (outside our current sliding window)
         }
-
-        return true;
+        produced_output = true;
     }
+
+    return produced_output;
 }
 
 DeflateDecompressor::UncompressedBlock::UncompressedBlock(DeflateDecompressor& decompressor, size_t length)
@@ -274,9 +421,7 @@ size_t DeflateDecompressor::read(Bytes bytes)
             if (block_type == 0b10) {
                 CanonicalCode literal_codes;
                 Optional<CanonicalCode> distance_codes;
-                decode_codes(literal_codes, distance_codes);
-
-                if (m_input_stream.has_any_error()) {
+                if (!decode_codes(m_input_stream, literal_codes, distance_codes) || m_input_stream.has_any_error()) {
                     set_fatal_error();
                     break;
                 }
@@ -375,69 +520,239 @@ bool DeflateDecompressor::handle_any_error()
     return Stream::handle_any_error() || handled_errors;
 }
 
-Optional<ByteBuffer> DeflateDecompressor::decompress_all(ReadonlyBytes bytes)
+// Back references are copied a word at a time, so the output always keeps this much slack after the longest match.
+static constexpr size_t output_copy_slack = sizeof(u64);
+
+// How much output is collected before it is handed out, when the caller wants it in pieces.
+static constexpr size_t output_chunk_size = 64 * KiB;
+
+// Where the in-memory inflater puts its output. Without a callback everything is collected in one growing buffer;
+// with one, the buffer is handed out whenever it fills up and only the window that back references can reach is kept.
+class InflateOutput {
+public:
+    explicit InflateOutput(size_t capacity, Function<IterationDecision(ReadonlyBytes)> callback = {})
+        : m_buffer(ByteBuffer::create_uninitialized(capacity))
+        , m_callback(move(callback))
+    {
+    }
+
+    // Makes sure that count bytes (plus the copy slack) can be written at end(), returns false if the callback asked us to stop.
+    ALWAYS_INLINE bool ensure_space(size_t count)
+    {
+        if (m_size + count + output_copy_slack <= m_buffer.size())
+            return true;
+        return make_room(count);
+    }
+
+    ALWAYS_INLINE void append(u8 byte) { m_buffer.data()[m_size++] = byte; }
+    ALWAYS_INLINE u8* end() { return m_buffer.offset_pointer(m_size); }
+    ALWAYS_INLINE void commit(size_t count) { m_size += count; }
+
+    // The amount of output that back references can currently reach.
+    ALWAYS_INLINE size_t size() const { return m_size; }
+
+    bool has_stopped() const { return m_stopped; }
+
+    void flush()
+    {
+        if (!m_callback || m_stopped || m_flushed == m_size)
+            return;
+        m_stopped = m_callback(m_buffer.bytes().slice(m_flushed, m_size - m_flushed)) == IterationDecision::Break;
+        m_flushed = m_size;
+    }
+
+    ByteBuffer release_buffer()
+    {
+        m_buffer.trim(m_size);
+        return move(m_buffer);
+    }
+
+private:
+    bool make_room(size_t count)
+    {
+        if (m_callback) {
+            flush();
+            if (m_stopped)
+                return false;
+
+            const auto history_size = min(m_size, DeflateCompressor::max_distance);
+            memmove(m_buffer.data(), m_buffer.offset_pointer(m_size - history_size), history_size);
+            m_size = history_size;
+            m_flushed = history_size;
+        }
+
+        if (m_size + count + output_copy_slack > m_buffer.size())
+            m_buffer.grow(max(m_buffer.size() * 2, m_size + count + output_copy_slack));
+        return true;
+    }
+
+    ByteBuffer m_buffer;
+    size_t m_size { 0 };
+    size_t m_flushed { 0 };
+    bool m_stopped { false };
+    Function<IterationDecision(ReadonlyBytes)> m_callback;
+};
+
+ALWAYS_INLINE static void copy_back_reference(u8* destination, size_t distance, size_t length)
 {
-    InputMemoryStream memory_stream { bytes };
-    DeflateDecompressor deflate_stream { memory_stream };
-    DuplexMemoryStream output_stream;
+    const u8* source = destination - distance;
 
-    u8 buffer[4096];
-    while (!deflate_stream.has_any_error() && !deflate_stream.unreliable_eof()) {
-        const auto nread = deflate_stream.read({ buffer, sizeof(buffer) });
-        output_stream.write_or_error({ buffer, nread });
+    if (distance >= sizeof(u64)) {
+        // The source and destination may still overlap, but never within a single word.
+        for (size_t offset = 0; offset < length; offset += sizeof(u64))
+            memcpy(destination + offset, source + offset, sizeof(u64));
+        return;
     }
 
-    if (deflate_stream.handle_any_error())
-        return {};
+    if (distance == 1) {
+        memset(destination, *source, length);
+        return;
+    }
 
-    return output_stream.copy_into_contiguous_buffer();
+    for (size_t offset = 0; offset < length; ++offset)
+        destination[offset] = source[offset];
 }
 
-u32 DeflateDecompressor::decode_length(u32 symbol)
+static bool inflate_compressed_block(WordBitReader& reader, const CanonicalCode& literal_codes, const Optional<CanonicalCode>& distance_codes, InflateOutput& output)
 {
-    // FIXME: I can't quite follow the algorithm here, but it seems to work.
+    for (;;) {
+        if (!output.ensure_space(DeflateCompressor::max_match_length))
+            return false;
 
-    if (symbol <= 264)
-        return symbol - 254;
+        // A single refill holds the longest length code, distance code and their extra bits (15 + 5 + 15 + 13 bits).
+        reader.refill();
 
-    if (symbol <= 284) {
-        auto extra_bits = (symbol - 261) / 4;
-        return (((symbol - 265) % 4 + 4) << extra_bits) + 3 + m_input_stream.read_bits(extra_bits);
-    }
+        const auto symbol = read_symbol_from(literal_codes, reader);
+        if (symbol < 256) {
+            output.append(static_cast<u8>(symbol));
+            continue;
+        }
+
+        if (symbol == 256)
+            return true;
 
-    if (symbol == 285)
-        return 258;
+        if (symbol >= 286 || !distance_codes.has_value())
+            return false;
+
+        const auto& length_symbol = packed_length_symbols[symbol - 257];
+        const size_t length = length_symbol.base_length + reader.read_bits(length_symbol.extra_bits);
+
+        const auto distance_symbol = read_symbol_from(distance_codes.value(), reader);
+        if (distance_symbol >= 30)
+            return false;
+
+        const auto& distance_entry = packed_distances[distance_symbol];
+        const size_t distance = distance_entry.base_distance + reader.read_bits(distance_entry.extra_bits);
+
+        if (reader.has_error() || distance > output.size())
+            return false;
 
-    VERIFY_NOT_REACHED();
+        copy_back_reference(output.end(), distance, length);
+        output.commit(length);
+    }
 }
 
-u32 DeflateDecompressor::decode_distance(u32 symbol)
+// With the whole input at hand we can skip the streaming machinery (and its sliding window) entirely and
+// decode straight into the output buffer, which is where back references are resolved from as well.
+bool DeflateDecompressor::inflate(ReadonlyBytes bytes, InflateOutput& output)
 {
-    // FIXME: I can't quite follow the algorithm here, but it seems to work.
+    WordBitReader reader { bytes };
+
+    bool read_final_block = false;
+    while (!read_final_block) {
+        read_final_block = reader.read_bit();
+        const auto block_type = reader.read_bits(2);
+
+        if (reader.has_error())
+            return false;
+
+        if (block_type == 0b00) {
+            auto header = reader.align_and_read_bytes(2 * sizeof(u16));
+            if (header.is_empty())
+                return false;
+
+            const u16 length = header[0] | header[1] << 8;
+            const u16 negated_length = header[2] | header[3] << 8;
+            if ((length ^ 0xffff) != negated_length)
+                return false;
+
+            auto block = reader.align_and_read_bytes(length);
+            if (reader.has_error() || !output.ensure_space(length))
+                return false;
+
+            block.copy_to(Bytes { output.end(), length });
+            output.commit(length);
+            continue;
+        }
+
+        if (block_type == 0b01) {
+            if (!inflate_compressed_block(reader, CanonicalCode::fixed_literal_codes(), CanonicalCode::fixed_distance_codes(), output))
+                return false;
+            continue;
+        }
 
-    if (symbol <= 3)
-        return symbol + 1;
+        if (block_type == 0b10) {
+            CanonicalCode literal_codes;
+            Optional<CanonicalCode> distance_codes;
+            if (!decode_codes(reader, literal_codes, distance_codes) || reader.has_error())
+                return false;
 
-    if (symbol <= 29) {
-        auto extra_bits = (symbol / 2) - 1;
-        return ((symbol % 2 + 2) << extra_bits) + 1 + m_input_stream.read_bits(extra_bits);
+            if (!inflate_compressed_block(reader, literal_codes, distance_codes, output))
+                return false;
+            continue;
+        }
+
+        return false;
     }
 
-    VERIFY_NOT_REACHED();
+    return !reader.has_error();
+}
+
+Optional<ByteBuffer> DeflateDecompressor::decompress_all(ReadonlyBytes bytes)
+{
+    InflateOutput output { max<size_t>(bytes.size() * 4, 4 * KiB) };
+    if (!inflate(bytes, output))
+        return {};
+    return output.release_buffer();
+}
+
+bool DeflateDecompressor::decompress_all(ReadonlyBytes bytes, Function<IterationDecision(ReadonlyBytes)> callback)
+{
+    InflateOutput output { DeflateCompressor::max_distance + output_chunk_size, move(callback) };
+    const auto success = inflate(bytes, output);
+    if (output.has_stopped())
+        return true;
+
+    // Whatever was decoded before running into an error is handed out as well, so that truncated data stays usable.
+    output.flush();
+    return success;
 }
 
-void DeflateDecompressor::decode_codes(CanonicalCode& literal_code, Optional<CanonicalCode>& distance_code)
+u32 DeflateDecompressor::decode_length(u32 symbol)
 {
-    auto literal_code_count = m_input_stream.read_bits(5) + 257;
-    auto distance_code_count = m_input_stream.read_bits(5) + 1;
-    auto code_length_count = m_input_stream.read_bits(4) + 4;
+    const auto& length = packed_length_symbols[symbol - 257];
+    return length.base_length + m_input_stream.read_bits(length.extra_bits);
+}
+
+u32 DeflateDecompressor::decode_distance(u32 symbol)
+{
+    const auto& distance = packed_distances[symbol];
+    return distance.base_distance + m_input_stream.read_bits(distance.extra_bits);
+}
+
+template<typename BitReader>
+bool DeflateDecompressor::decode_codes(BitReader& stream, CanonicalCode& literal_code, Optional<CanonicalCode>& distance_code)
+{
+    auto literal_code_count = stream.read_bits(5) + 257;
+    auto distance_code_count = stream.read_bits(5) + 1;
+    auto code_length_count = stream.read_bits(4) + 4;
 
     // First we have to extract the code lengths of the code that was used to encode the code lengths of
     // the code that was used to encode the block.
 
     u8 code_lengths_code_lengths[19] = { 0 };
     for (size_t i = 0; i < code_length_count; ++i) {
-        code_lengths_code_lengths[code_lengths_code_lengths_order[i]] = m_input_stream.read_bits(3);
+        code_lengths_code_lengths[code_lengths_code_lengths_order[i]] = stream.read_bits(3);
     }
 
     // Now we can extract the code that was used to encode the code lengths of the code that was used to
@@ -445,8 +760,7 @@ void DeflateDecompressor::decode_codes(CanonicalCode& literal_code, Optional<Can
 
     auto code_length_code_result = CanonicalCode::from_bytes({ code_lengths_code_lengths, sizeof(code_lengths_code_lengths) });
     if (!code_length_code_result.has_value()) {
-        set_fatal_error();
-        return;
+        return false;
     }
     const auto code_length_code = code_length_code_result.value();
 
@@ -454,23 +768,22 @@ void DeflateDecompressor::decode_codes(CanonicalCode& literal_code, Optional<Can
 
     Vector<u8> code_lengths;
     while (code_lengths.size() < literal_code_count + distance_code_count) {
-        auto symbol = code_length_code.read_symbol(m_input_stream);
+        auto symbol = read_symbol_from(code_length_code, stream);
 
         if (symbol == UINT32_MAX) {
-            set_fatal_error();
-            return;
+            return false;
         }
 
         if (symbol < DeflateSpecialCodeLengths::COPY) {
             code_lengths.append(static_cast<u8>(symbol));
             continue;
         } else if (symbol == DeflateSpecialCodeLengths::ZEROS) {
-            auto nrepeat = 3 + m_input_stream.read_bits(3);
+            auto nrepeat = 3 + stream.read_bits(3);
             for (size_t j = 0; j < nrepeat; ++j)
                 code_lengths.append(0);
             continue;
         } else if (symbol == DeflateSpecialCodeLengths::LONG_ZEROS) {
-            auto nrepeat = 11 + m_input_stream.read_bits(7);
+            auto nrepeat = 11 + stream.read_bits(7);
             for (size_t j = 0; j < nrepeat; ++j)
                 code_lengths.append(0);
             continue;
@@ -478,27 +791,24 @@ void DeflateDecompressor::decode_codes(CanonicalCode& literal_code, Optional<Can
             VERIFY(symbol == DeflateSpecialCodeLengths::COPY);
 
             if (code_lengths.is_empty()) {
-                set_fatal_error();
-                return;
+                return false;
             }
 
-            auto nrepeat = 3 + m_input_stream.read_bits(2);
+            auto nrepeat = 3 + stream.read_bits(2);
             for (size_t j = 0; j < nrepeat; ++j)
                 code_lengths.append(code_lengths.last());
         }
     }
 
     if (code_lengths.size() != literal_code_count + distance_code_count) {
-        set_fatal_error();
-        return;
+        return false;
     }
 
     // Now we extract the code that was used to encode literals and lengths in the block.
 
     auto literal_code_result = CanonicalCode::from_bytes(code_lengths.span().trim(literal_code_count));
     if (!literal_code_result.has_value()) {
-        set_fatal_error();
-        return;
+        return false;
     }
     literal_code = literal_code_result.value();
 
@@ -508,19 +818,18 @@ void DeflateDecompressor::decode_codes(CanonicalCode& literal_code, Optional<Can
         auto length = code_lengths[literal_code_count];
 
         if (length == 0) {
-            return;
+            return true;
         } else if (length != 1) {
-            set_fatal_error();
-            return;
+            return false;
         }
     }
 
     auto distance_code_result = CanonicalCode::from_bytes(code_lengths.span().slice(literal_code_count));
     if (!distance_code_result.has_value()) {
-        set_fatal_error();
-        return;
+        return false;
     }
     distance_code = distance_code_result.value();
+    return true;
 }
 
 DeflateCompressor::DeflateCompressor(OutputStream& stream, CompressionLevel compression_level)
@@ -530,11 +839,14 @@ DeflateCompressor::DeflateCompressor(OutputStream& stream, CompressionLevel comp
 {
     m_symbol_frequencies.fill(0);
     m_distance_frequencies.fill(0);
+
+    for (auto& slot : m_hash_head) // initialize chained hash table
+        slot = empty_slot;
 }
 
 DeflateCompressor::~DeflateCompressor()
 {
-    VERIFY(m_finished);
+    VERIFY(m_finished || m_sync_flushed || m_abandoned);
 }
 
 size_t DeflateCompressor::write(ReadonlyBytes bytes)
@@ -544,6 +856,8 @@ size_t DeflateCompressor::write(ReadonlyBytes bytes)
     if (bytes.size() == 0)
         return 0; // recursion base case
 
+    m_sync_flushed = false;
+
     auto n_written = bytes.copy_trimmed_to(pending_block().slice(m_pending_block_size));
     m_pending_block_size += n_written;
 
@@ -570,6 +884,30 @@ u16 DeflateCompressor::hash_sequence(const u8* bytes)
     return ((bytes[0] | bytes[1] << 8 | bytes[2] << 16 | bytes[3] << 24) * knuth_constant) >> (32 - hash_bits);
 }
 
+ALWAYS_INLINE void DeflateCompressor::insert_hash(size_t position, u16 hash)
+{
+    auto window_position = position % window_size;
+    m_hash_prev[window_position] = m_hash_head[hash];
+    m_hash_head[hash] = window_position;
+}
+
+void DeflateCompressor::slide_window(size_t amount)
+{
+    VERIFY(amount <= block_size);
+
+    // The last block_size bytes we have seen become the history of the next block
+    memmove(m_rolling_window, m_rolling_window + amount, block_size);
+    m_history_size = min(block_size, m_history_size + amount);
+
+    auto slide = [amount](u16 position) -> u16 {
+        return (position == empty_slot || position < amount) ? empty_slot : position - amount;
+    };
+    for (auto& slot : m_hash_head)
+        slot = slide(slot);
+    for (size_t position = 0; position < block_size; ++position)
+        m_hash_prev[position] = slide(m_hash_prev[position + amount]);
+}
+
 size_t DeflateCompressor::compare_match_candidate(size_t start, size_t candidate, size_t previous_match_length, size_t maximum_match_length)
 {
     VERIFY(previous_match_length < maximum_match_length);
@@ -580,8 +918,17 @@ size_t DeflateCompressor::compare_match_candidate(size_t start, size_t candidate
             return 0;
     }
 
-    // Find the actual length
+    // Find the actual length, a word at a time while possible (the first differing byte is the lowest differing one in little endian)
     auto match_length = previous_match_length + 1;
+    while (match_length + sizeof(u64) <= maximum_match_length) {
+        LittleEndian<u64> start_word, candidate_word;
+        memcpy(&start_word, &m_rolling_window[start + match_length], sizeof(u64));
+        memcpy(&candidate_word, &m_rolling_window[candidate + match_length], sizeof(u64));
+        auto difference = static_cast<u64>(start_word) ^ static_cast<u64>(candidate_word);
+        if (difference != 0)
+            return match_length + __builtin_ctzll(difference) / 8;
+        match_length += sizeof(u64);
+    }
     while (match_length < maximum_match_length && m_rolling_window[start + match_length] == m_rolling_window[candidate + match_length]) {
         match_length++;
     }
@@ -610,8 +957,8 @@ size_t DeflateCompressor::find_back_match(size_t start, u16 hash, size_t previou
             break; // no remaining candidates
 
         VERIFY(candidate < start);
-        if (start - candidate > window_size)
-            break; // outside the window
+        if (start - candidate > max_distance)
+            break; // outside the window (the chain only gets older from here)
 
         auto match_length = compare_match_candidate(start, candidate, previous_match_length, maximum_match_length);
 
@@ -710,15 +1057,9 @@ void DeflateCompressor::generate_huffman_lengths(Array<u8, Size>& lengths, const
 
 void DeflateCompressor::lz77_compress_block()
 {
-    for (auto& slot : m_hash_head) { // initialize chained hash table
-        slot = empty_slot;
-    }
-
-    auto insert_hash = [&](auto pos, auto hash) {
-        auto window_pos = pos % window_size;
-        m_hash_prev[window_pos] = m_hash_head[hash];
-        m_hash_head[hash] = window_pos;
-    };
+    // The last few sequences of the previous block could only be hashed now that the bytes following them are here
+    for (auto position = block_size - min(m_history_size, min_match_length - 1); position < block_size; position++)
+        insert_hash(position, hash_sequence(&m_rolling_window[position]));
 
     auto emit_literal = [&](auto literal) {
         VERIFY(m_pending_symbol_size <= block_size + 1);
@@ -1057,12 +1398,46 @@ void DeflateCompressor::flush()
         m_output_stream.align_to_byte_boundary();
 
     // reset all block specific members
+    slide_window(m_pending_block_size);
     m_pending_block_size = 0;
     m_pending_symbol_size = 0;
     m_symbol_frequencies.fill(0);
     m_distance_frequencies.fill(0);
-    // On the final block this copy will potentially produce an invalid search window, but since its the final block we dont care
-    pending_block().copy_trimmed_to({ m_rolling_window, block_size });
+}
+
+void DeflateCompressor::sync_flush()
+{
+    VERIFY(!m_finished);
+
+    if (m_pending_block_size != 0)
+        flush();
+
+    m_output_stream.write_bit(false);
+    m_output_stream.write_bits(0b00, 2); // no compression
+    m_output_stream.align_to_byte_boundary();
+    LittleEndian<u16> len = 0;
+    LittleEndian<u16> nlen = 0xffff;
+    m_output_stream << len << nlen;
+
+    m_sync_flushed = true;
+}
+
+void DeflateCompressor::abandon()
+{
+    m_abandoned = true;
+    handle_any_error();
+}
+
+void DeflateCompressor::preset_dictionary(ReadonlyBytes dictionary)
+{
+    VERIFY(m_pending_block_size == 0 && m_history_size == 0);
+
+    m_history_size = min(dictionary.size(), block_size);
+    dictionary.slice(dictionary.size() - m_history_size).copy_to({ m_rolling_window + block_size - m_history_size, m_history_size });
+
+    // The sequences that reach into the first block are hashed along with it
+    for (auto position = block_size - m_history_size; position + min_match_length <= block_size; position++)
+        insert_hash(position, hash_sequence(&m_rolling_window[position]));
 }
 
 void DeflateCompressor::final_flush()
@@ -31,6 +31,8 @@
 #include <AK/ByteBuffer.h>
 #include <AK/CircularDuplexStream.h>
 #include <AK/Endian.h>
+#include <AK/Function.h>
+#include <AK/IterationDecision.h>
 #include <AK/Vector.h>
 #include <LibCompress/DeflateTables.h>
 
@@ -38,25 +40,49 @@ namespace Compress {
 
 class CanonicalCode {
 public:
+    static constexpr size_t max_code_length = 15;
+
     CanonicalCode() = default;
     u32 read_symbol(InputBitStream&) const;
     void write_symbol(OutputBitStream&, u32) const;
 
+    // Resolves the code at the start of the lsb-first bits in a single table walk. A code_length of 0 means
+    // that the bits do not start with a valid code (or that not enough of them were available to tell).
+    ALWAYS_INLINE u32 lookup_symbol(u32 bits, size_t& code_length) const
+    {
+        auto entry = m_primary_table[bits & ((1 << primary_table_bits) - 1)];
+        if (entry & secondary_table_link) {
+            const auto secondary_bits = (entry >> 16) & 0xff;
+            entry = m_secondary_table[(entry & 0xffff) + ((bits >> primary_table_bits) & ((1 << secondary_bits) - 1))];
+        }
+        code_length = (entry >> 16) & 0xff;
+        return entry & 0xffff;
+    }
+
     static const CanonicalCode& fixed_literal_codes();
     static const CanonicalCode& fixed_distance_codes();
 
     static Optional<CanonicalCode> from_bytes(ReadonlyBytes);
 
 private:
-    // Decompression - indexed by code
-    Vector<u16> m_symbol_codes;
-    Vector<u16> m_symbol_values;
+    static constexpr size_t primary_table_bits = 9;
+    static constexpr u32 secondary_table_link = 1u << 31;
+
+    void build_lookup_tables(size_t symbol_count);
+
+    // Decompression - indexed by the next primary_table_bits input bits, every entry is either
+    // (code_length << 16 | symbol) or, for longer codes, (secondary_table_link | secondary_bits << 16 | offset)
+    // pointing at a secondary table indexed by the secondary_bits that follow.
+    Array<u32, 1 << primary_table_bits> m_primary_table {};
+    Vector<u32> m_secondary_table;
 
     // Compression - indexed by symbol
     Array<u16, 288> m_bit_codes {}; // deflate uses a maximum of 288 symbols (maximum of 32 for distances)
     Array<u16, 288> m_bit_code_lengths {};
 };
 
+class InflateOutput;
+
 class DeflateDecompressor final : public InputStream {
 private:
     class CompressedBlock {
@@ -106,10 +132,16 @@ public:
 
     static Optional<ByteBuffer> decompress_all(ReadonlyBytes);
 
+    // Like the above, but hands the output to the callback piece by piece instead of collecting all of it.
+    // Returns false if the data is invalid, in which case everything that could be decoded has still been handed out.
+    static bool decompress_all(ReadonlyBytes, Function<IterationDecision(ReadonlyBytes)>);
+
 private:
     u32 decode_length(u32);
     u32 decode_distance(u32);
-    void decode_codes(CanonicalCode& literal_code, Optional<CanonicalCode>& distance_code);
+    template<typename BitReader>
+    static bool decode_codes(BitReader&, CanonicalCode& literal_code, Optional<CanonicalCode>& distance_code);
+    static bool inflate(ReadonlyBytes, InflateOutput&);
 
     bool m_read_final_bock { false };
 
@@ -138,6 +170,7 @@ public:
     static constexpr size_t max_huffman_distances = 32;
     static constexpr size_t min_match_length = 4;   // matches smaller than these are not worth the size of the back reference
     static constexpr size_t max_match_length = 258; // matches longer than these cannot be encoded using huffman codes
+    static constexpr size_t max_distance = 32 * KiB; // back references cannot reach further back than this
     static constexpr u16 empty_slot = UINT16_MAX;
 
     struct CompressionConstants {
@@ -171,6 +204,21 @@ public:
     bool write_or_error(ReadonlyBytes) override;
     void final_flush();
 
+    // Ends the output written so far on a byte boundary (with an empty stored block), without ending the deflate
+    // stream. Independently compressed pieces of data can be concatenated this way, see preset_dictionary().
+    // The compressor may be destroyed after this without a final_flush() (if the stream is ended elsewhere).
+    void sync_flush();
+
+    // Gives up on the output (e.g. after an error), so the compressor may be destroyed without ending the stream.
+    void abandon();
+
+    // Makes the data preceding the input available for back references, this must be called before anything is written.
+    // Only the last max_distance bytes of the dictionary can be referenced.
+    void preset_dictionary(ReadonlyBytes);
+
+    // The number of hash chain entries that are compared per position (the main speed/ratio trade-off of a level).
+    void set_max_chain(size_t max_chain) { m_compression_constants.max_chain = max_chain; }
+
     static Optional<ByteBuffer> compress_all(const ReadonlyBytes& bytes, CompressionLevel = CompressionLevel::GOOD);
 
 private:
@@ -178,6 +226,8 @@ private:
 
     // LZ77 Compression
     static u16 hash_sequence(const u8* bytes);
+    void insert_hash(size_t position, u16 hash);
+    void slide_window(size_t amount);
     size_t compare_match_candidate(size_t start, size_t candidate, size_t prev_match_length, size_t max_match_length);
     size_t find_back_match(size_t start, u16 hash, size_t previous_match_length, size_t max_match_length, size_t& match_position);
     void lz77_compress_block();
@@ -202,12 +252,15 @@ private:
     void flush();
 
     bool m_finished { false };
+    bool m_sync_flushed { false };
+    bool m_abandoned { false };
     CompressionLevel m_compression_level;
     CompressionConstants m_compression_constants;
     OutputBitStream m_output_stream;
 
     u8 m_rolling_window[window_size];
     size_t m_pending_block_size { 0 };
+    size_t m_history_size { 0 }; // the amount of data preceding the pending block in the rolling window
 
     struct [[gnu::packed]] {
         u16 distance; // back reference length
@@ -220,7 +273,7 @@ private:
     Array<u16, max_huffman_literals> m_symbol_frequencies;    // there are 286 valid symbol values (symbols 286-287 never occur)
     Array<u16, max_huffman_distances> m_distance_frequencies; // there are 30 valid distance values (distances 30-31 never occur)
 
-    // LZ77 Chained hash table
+    // LZ77 Chained hash table, which is kept across blocks (and slid along with the rolling window)
     u16 m_hash_head[1 << hash_bits];
     u16 m_hash_prev[window_size];
 };
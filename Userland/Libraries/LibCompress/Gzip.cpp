@@ -213,16 +213,18 @@ bool GzipDecompressor::handle_any_error()
     return Stream::handle_any_error() || handled_errors;
 }
 
-GzipCompressor::GzipCompressor(OutputStream& stream)
+GzipCompressor::GzipCompressor(OutputStream& stream, DeflateCompressor::CompressionLevel compression_level)
     : m_output_stream(stream)
+    , m_compression_level(compression_level)
 {
 }
 
 GzipCompressor::~GzipCompressor()
 {
+    VERIFY(!m_compressed_stream || m_finished || m_abandoned);
 }
 
-size_t GzipCompressor::write(ReadonlyBytes bytes)
+void GzipCompressor::write_header()
 {
     BlockHeader header;
     header.identification_1 = 0x1f;
@@ -233,15 +235,22 @@ size_t GzipCompressor::write(ReadonlyBytes bytes)
     header.extra_flags = 3;      // DEFLATE sets 2 for maximum compression and 4 for minimum compression
     header.operating_system = 3; // unix
     m_output_stream << Bytes { &header, sizeof(header) };
-    DeflateCompressor compressed_stream { m_output_stream };
-    VERIFY(compressed_stream.write_or_error(bytes));
-    compressed_stream.final_flush();
-    Crypto::Checksum::CRC32 crc32;
-    crc32.update(bytes);
-    LittleEndian<u32> digest = crc32.digest();
-    LittleEndian<u32> size = bytes.size();
-    m_output_stream << digest << size;
-    return bytes.size();
+
+    // The deflate compressor is rather large, so we keep it off the stack
+    m_compressed_stream = make<DeflateCompressor>(m_output_stream, m_compression_level);
+}
+
+size_t GzipCompressor::write(ReadonlyBytes bytes)
+{
+    VERIFY(!m_finished && !m_wrote_precompressed);
+
+    if (!m_compressed_stream)
+        write_header();
+
+    auto nwritten = m_compressed_stream->write(bytes);
+    m_checksum.update(bytes.trim(nwritten));
+    m_total_size += nwritten;
+    return nwritten;
 }
 
 bool GzipCompressor::write_or_error(ReadonlyBytes bytes)
@@ -254,12 +263,60 @@ bool GzipCompressor::write_or_error(ReadonlyBytes bytes)
     return true;
 }
 
-Optional<ByteBuffer> GzipCompressor::compress_all(const ReadonlyBytes& bytes)
+bool GzipCompressor::write_precompressed(ReadonlyBytes uncompressed, ReadonlyBytes compressed)
+{
+    VERIFY(!m_finished);
+
+    if (!m_compressed_stream)
+        write_header();
+    else
+        VERIFY(m_wrote_precompressed);
+    m_wrote_precompressed = true;
+
+    m_checksum.update(uncompressed);
+    m_total_size += uncompressed.size();
+    if (!m_output_stream.write_or_error(compressed)) {
+        set_fatal_error();
+        return false;
+    }
+
+    return true;
+}
+
+void GzipCompressor::final_flush()
+{
+    VERIFY(!m_finished);
+
+    if (!m_compressed_stream)
+        write_header();
+
+    // After precompressed data this only writes an empty final block
+    m_compressed_stream->final_flush();
+    m_finished = true;
+
+    LittleEndian<u32> digest = m_checksum.digest();
+    LittleEndian<u32> size = m_total_size;
+    m_output_stream << digest << size;
+
+    if (m_compressed_stream->handle_any_error() || m_output_stream.has_any_error())
+        set_fatal_error();
+}
+
+void GzipCompressor::abandon()
+{
+    m_abandoned = true;
+    if (m_compressed_stream)
+        m_compressed_stream->abandon();
+    handle_any_error();
+}
+
+Optional<ByteBuffer> GzipCompressor::compress_all(const ReadonlyBytes& bytes, DeflateCompressor::CompressionLevel compression_level)
 {
     DuplexMemoryStream output_stream;
-    GzipCompressor gzip_stream { output_stream };
+    GzipCompressor gzip_stream { output_stream, compression_level };
 
     gzip_stream.write_or_error(bytes);
+    gzip_stream.final_flush();
 
     if (gzip_stream.handle_any_error())
         return {};
@@ -27,6 +27,7 @@
 
 #pragma once
 
+#include <AK/OwnPtr.h>
 #include <LibCompress/Deflate.h>
 #include <LibCrypto/Checksum/CRC32.h>
 
@@ -100,16 +101,34 @@ private:
 
 class GzipCompressor final : public OutputStream {
 public:
-    GzipCompressor(OutputStream&);
+    GzipCompressor(OutputStream&, DeflateCompressor::CompressionLevel = DeflateCompressor::CompressionLevel::GOOD);
     ~GzipCompressor();
 
     size_t write(ReadonlyBytes) override;
     bool write_or_error(ReadonlyBytes) override;
 
-    static Optional<ByteBuffer> compress_all(const ReadonlyBytes& bytes);
+    // Appends deflate data that was compressed elsewhere (e.g. on another thread) and ends on a byte boundary,
+    // see DeflateCompressor::sync_flush(). This can not be mixed with write().
+    bool write_precompressed(ReadonlyBytes uncompressed, ReadonlyBytes compressed);
+
+    void final_flush();
+
+    // Gives up on the output (e.g. after an error), so the compressor may be destroyed without a final_flush().
+    void abandon();
+
+    static Optional<ByteBuffer> compress_all(const ReadonlyBytes& bytes, DeflateCompressor::CompressionLevel = DeflateCompressor::CompressionLevel::GOOD);
 
 private:
+    void write_header();
+
     OutputStream& m_output_stream;
+    DeflateCompressor::CompressionLevel m_compression_level;
+    OwnPtr<DeflateCompressor> m_compressed_stream;
+    Crypto::Checksum::CRC32 m_checksum;
+    u32 m_total_size { 0 };
+    bool m_wrote_precompressed { false };
+    bool m_finished { false };
+    bool m_abandoned { false };
 };
 
 }
@@ -71,6 +71,11 @@ Optional<ByteBuffer> Zlib::decompress()
     return DeflateDecompressor::decompress_all(m_data_bytes);
 }
 
+bool Zlib::decompress(Function<IterationDecision(ReadonlyBytes)> callback)
+{
+    return DeflateDecompressor::decompress_all(m_data_bytes, move(callback));
+}
+
 Optional<ByteBuffer> Zlib::decompress_all(ReadonlyBytes bytes)
 {
     auto zlib = try_create(bytes);
@@ -79,6 +84,14 @@ Optional<ByteBuffer> Zlib::decompress_all(ReadonlyBytes bytes)
     return zlib->decompress();
 }
 
+bool Zlib::decompress_all(ReadonlyBytes bytes, Function<IterationDecision(ReadonlyBytes)> callback)
+{
+    auto zlib = try_create(bytes);
+    if (!zlib.has_value())
+        return false;
+    return zlib->decompress(move(callback));
+}
+
 u32 Zlib::checksum()
 {
     if (!m_checksum) {
@@ -27,6 +27,8 @@
 #pragma once
 
 #include <AK/ByteBuffer.h>
+#include <AK/Function.h>
+#include <AK/IterationDecision.h>
 #include <AK/Span.h>
 #include <AK/Types.h>
 
@@ -35,10 +37,12 @@ namespace Compress {
 class Zlib {
 public:
     Optional<ByteBuffer> decompress();
+    bool decompress(Function<IterationDecision(ReadonlyBytes)>);
     u32 checksum();
 
     static Optional<Zlib> try_create(ReadonlyBytes data);
     static Optional<ByteBuffer> decompress_all(ReadonlyBytes);
+    static bool decompress_all(ReadonlyBytes, Function<IterationDecision(ReadonlyBytes)>);
 
 private:
     Zlib(const ReadonlyBytes& data);
@@ -231,12 +231,9 @@ FLATTEN UnsignedBigInteger UnsignedBigInteger::shift_left(size_t num_bits) const
 FLATTEN UnsignedBigInteger UnsignedBigInteger::multiplied_by(const UnsignedBigInteger& other) const
 {
     UnsignedBigInteger result;
-    UnsignedBigInteger temp_shift_result;
-    UnsignedBigInteger temp_shift_plus;
-    UnsignedBigInteger temp_shift;
-    UnsignedBigInteger temp_plus;
+    UnsignedBigInteger temp;
 
-    multiply_without_allocation(*this, other, temp_shift_result, temp_shift_plus, temp_shift, temp_plus, result);
+    multiply_without_allocation(*this, other, temp, result);
 
     return result;
 }
@@ -253,12 +250,9 @@ FLATTEN UnsignedDivisionResult UnsignedBigInteger::divided_by(const UnsignedBigI
         return UnsignedDivisionResult { quotient, remainder };
     }
 
-    UnsignedBigInteger temp_shift_result;
-    UnsignedBigInteger temp_shift_plus;
-    UnsignedBigInteger temp_shift;
-    UnsignedBigInteger temp_minus;
+    UnsignedBigInteger temp;
 
-    divide_without_allocation(*this, divisor, temp_shift_result, temp_shift_plus, temp_shift, temp_minus, quotient, remainder);
+    divide_without_allocation(*this, divisor, temp, quotient, remainder);
 
     return UnsignedDivisionResult { quotient, remainder };
 }
@@ -594,76 +588,305 @@ FLATTEN void UnsignedBigInteger::shift_left_without_allocation(
     }
 }
 
+// Below this many words, Karatsuba's extra additions cost more than the word multiplications they save.
+static constexpr size_t karatsuba_threshold = 32;
+
+// target[0, target_size) += source[0, source_size), returns the carry out of the topmost word.
+static u32 add_words(u32* target, size_t target_size, const u32* source, size_t source_size)
+{
+    u64 carry = 0;
+    size_t i = 0;
+    for (; i < source_size; ++i) {
+        carry += static_cast<u64>(target[i]) + source[i];
+        target[i] = static_cast<u32>(carry);
+        carry >>= 32;
+    }
+    for (; carry && i < target_size; ++i) {
+        carry += target[i];
+        target[i] = static_cast<u32>(carry);
+        carry >>= 32;
+    }
+    return static_cast<u32>(carry);
+}
+
+// target[0, target_size) -= source[0, source_size), returns the borrow out of the topmost word.
+static u32 subtract_words(u32* target, size_t target_size, const u32* source, size_t source_size)
+{
+    u64 borrow = 0;
+    size_t i = 0;
+    for (; i < source_size; ++i) {
+        u64 difference = static_cast<u64>(target[i]) - source[i] - borrow;
+        target[i] = static_cast<u32>(difference);
+        borrow = difference >> 63;
+    }
+    for (; borrow && i < target_size; ++i) {
+        u64 difference = static_cast<u64>(target[i]) - borrow;
+        target[i] = static_cast<u32>(difference);
+        borrow = difference >> 63;
+    }
+    return static_cast<u32>(borrow);
+}
+
+// Every Karatsuba level needs room for the two half sums and their product, plus whatever the
+// recursive multiplication of those sums needs.
+static size_t karatsuba_scratch_size(size_t size)
+{
+    if (size < karatsuba_threshold)
+        return 0;
+    auto half = size / 2;
+    return 4 * (half + 2) + karatsuba_scratch_size(half + 2);
+}
+
+// output[0, left_size + right_size) = left * right
+static void multiply_words(const u32* left, size_t left_size, const u32* right, size_t right_size, u32* output, u32* scratch)
+{
+    auto half = max(left_size, right_size) / 2;
+    if (min(left_size, right_size) < karatsuba_threshold || min(left_size, right_size) <= half) {
+        __builtin_memset(output, 0, (left_size + right_size) * sizeof(u32));
+        for (size_t i = 0; i < left_size; ++i) {
+            u64 carry = 0;
+            u64 word = left[i];
+            for (size_t j = 0; j < right_size; ++j) {
+                carry += word * right[j] + output[i + j];
+                output[i + j] = static_cast<u32>(carry);
+                carry >>= 32;
+            }
+            output[i + right_size] = static_cast<u32>(carry);
+        }
+        return;
+    }
+
+    // With x = x1 * B^half + x0 and y = y1 * B^half + y0:
+    // x * y = x1y1 * B^(2 * half) + ((x0 + x1)(y0 + y1) - x0y0 - x1y1) * B^half + x0y0
+    auto total_size = left_size + right_size;
+    multiply_words(left, half, right, half, output, scratch);
+    multiply_words(left + half, left_size - half, right + half, right_size - half, output + 2 * half, scratch);
+
+    u32* left_sum = scratch;
+    auto left_sum_size = max(half, left_size - half) + 1;
+    __builtin_memset(left_sum, 0, left_sum_size * sizeof(u32));
+    __builtin_memcpy(left_sum, left, half * sizeof(u32));
+    add_words(left_sum, left_sum_size, left + half, left_size - half);
+
+    u32* right_sum = left_sum + half + 2;
+    auto right_sum_size = max(half, right_size - half) + 1;
+    __builtin_memset(right_sum, 0, right_sum_size * sizeof(u32));
+    __builtin_memcpy(right_sum, right, half * sizeof(u32));
+    add_words(right_sum, right_sum_size, right + half, right_size - half);
+
+    u32* middle = right_sum + half + 2;
+    auto middle_size = left_sum_size + right_sum_size;
+    multiply_words(left_sum, left_sum_size, right_sum, right_sum_size, middle, middle + 2 * half + 4);
+    subtract_words(middle, middle_size, output, 2 * half);
+    subtract_words(middle, middle_size, output + 2 * half, total_size - 2 * half);
+
+    // The middle term is smaller than B^(total_size - half), only its trailing zero words stick out.
+    while (middle_size > 0 && middle[middle_size - 1] == 0)
+        --middle_size;
+    add_words(output + half, total_size - half, middle, middle_size);
+}
+
 /**
- * Complexity: O(N^2) where N is the number of words in the larger number
+ * Complexity: O(N^2) where N is the number of words in the larger number, O(N^1.58) once both numbers
+ * are longer than karatsuba_threshold words.
  * Multiplication method:
- * An integer is equal to the sum of the powers of two
- * according to the indexes of its 'on' bits.
- * So to multiple x*y, we go over each '1' bit in x (say the i'th bit),
- * and add y<<i to the result.
+ * Schoolbook multiplication one word at a time, accumulating every row into the output with a 64-bit carry.
+ * Large operands of similar size are split in halves and multiplied with Karatsuba's method, which replaces
+ * one of the four half-sized multiplications with a few additions.
+ * The temp number is used as scratch space for the Karatsuba intermediates.
  */
 FLATTEN void UnsignedBigInteger::multiply_without_allocation(
     const UnsignedBigInteger& left,
     const UnsignedBigInteger& right,
-    UnsignedBigInteger& temp_shift_result,
-    UnsignedBigInteger& temp_shift_plus,
-    UnsignedBigInteger& temp_shift,
-    UnsignedBigInteger& temp_plus,
+    UnsignedBigInteger& temp,
     UnsignedBigInteger& output)
 {
+    auto left_length = left.trimmed_length();
+    auto right_length = right.trimmed_length();
+
     output.set_to_0();
+    if (left_length == 0 || right_length == 0)
+        return;
 
-    // iterate all bits
-    for (size_t word_index = 0; word_index < left.length(); ++word_index) {
-        for (size_t bit_index = 0; bit_index < UnsignedBigInteger::BITS_IN_WORD; ++bit_index) {
-            // If the bit is off - skip over it
-            if (!(left.m_words[word_index] & (1 << bit_index)))
-                continue;
+    output.m_words.resize_and_keep_capacity(left_length + right_length);
+    temp.set_to_0();
+    temp.m_words.resize_and_keep_capacity(karatsuba_scratch_size(max(left_length, right_length)));
 
-            const size_t shift_amount = word_index * UnsignedBigInteger::BITS_IN_WORD + bit_index;
+    multiply_words(left.m_words.data(), left_length, right.m_words.data(), right_length, output.m_words.data(), temp.m_words.data());
 
-            // output += (right << shift_amount);
-            shift_left_without_allocation(right, shift_amount, temp_shift_result, temp_shift_plus, temp_shift);
-            add_without_allocation(output, temp_shift, temp_plus);
-            output.set_to(temp_plus);
-        }
-    }
+    output.clamp_to_trimmed_length();
 }
 
 /**
- * Complexity: O(N^2) where N is the number of words in the larger number
+ * Complexity: O(N*M) where N and M are the number of words in the numerator and the denominator
  * Division method:
- * We loop over the bits of the divisor, attempting to subtract divisor<<i from the dividend.
- * If the result is non-negative, it means that divisor*2^i "fits" in the dividend,
- * so we set the ith bit in the quotient and reduce divisor<<i from the dividend.
- * When we're done, what's left from the dividend is the remainder.
+ * Knuth's Algorithm D (TAOCP vol. 2, 4.3.1): after shifting both numbers so that the topmost bit of
+ * the denominator is set, every quotient word is estimated from the top two words of the remainder and
+ * the top word of the denominator. The estimate is at most two too large; it is corrected against the
+ * second denominator word, and in the rare case it's still one too large, the denominator is added back.
+ * The temp number holds the shifted denominator, the shifted numerator is reduced in place in the remainder.
  */
 FLATTEN void UnsignedBigInteger::divide_without_allocation(
     const UnsignedBigInteger& numerator,
     const UnsignedBigInteger& denominator,
-    UnsignedBigInteger& temp_shift_result,
-    UnsignedBigInteger& temp_shift_plus,
-    UnsignedBigInteger& temp_shift,
-    UnsignedBigInteger& temp_minus,
+    UnsignedBigInteger& temp,
     UnsignedBigInteger& quotient,
     UnsignedBigInteger& remainder)
 {
+    auto numerator_length = numerator.trimmed_length();
+    auto denominator_length = denominator.trimmed_length();
+
+    if (denominator_length == 0) {
+        quotient.invalidate();
+        remainder.invalidate();
+        return;
+    }
+
+    if (numerator < denominator) {
+        quotient.set_to_0();
+        remainder.set_to(numerator);
+        remainder.clamp_to_trimmed_length();
+        return;
+    }
+
     quotient.set_to_0();
-    remainder.set_to(numerator);
-
-    // iterate all bits
-    for (int word_index = numerator.trimmed_length() - 1; word_index >= 0; --word_index) {
-        for (int bit_index = UnsignedBigInteger::BITS_IN_WORD - 1; bit_index >= 0; --bit_index) {
-            const size_t shift_amount = word_index * UnsignedBigInteger::BITS_IN_WORD + bit_index;
-            shift_left_without_allocation(denominator, shift_amount, temp_shift_result, temp_shift_plus, temp_shift);
-
-            subtract_without_allocation(remainder, temp_shift, temp_minus);
-            if (!temp_minus.is_invalid()) {
-                remainder.set_to(temp_minus);
-                quotient.set_bit_inplace(shift_amount);
+    quotient.m_words.resize_and_keep_capacity(numerator_length - denominator_length + 1);
+    auto* quotient_words = quotient.m_words.data();
+
+    if (denominator_length == 1) {
+        u64 divisor = denominator.m_words[0];
+        u64 remainder_word = 0;
+        for (int word_index = numerator_length - 1; word_index >= 0; --word_index) {
+            u64 number_to_divide = (remainder_word << 32) | numerator.m_words[word_index];
+            quotient_words[word_index] = static_cast<u32>(number_to_divide / divisor);
+            remainder_word = number_to_divide % divisor;
+        }
+        quotient.clamp_to_trimmed_length();
+        remainder.set_to(static_cast<u32>(remainder_word));
+        return;
+    }
+
+    auto shift = __builtin_clz(denominator.m_words[denominator_length - 1]);
+    auto shift_word = [shift](const u32* words, size_t index) -> u32 {
+        if (shift == 0)
+            return words[index];
+        return (words[index] << shift) | (index > 0 ? words[index - 1] >> (BITS_IN_WORD - shift) : 0);
+    };
+
+    temp.set_to_0();
+    temp.m_words.resize_and_keep_capacity(denominator_length);
+    auto* divisor = temp.m_words.data();
+    for (size_t i = 0; i < denominator_length; ++i)
+        divisor[i] = shift_word(denominator.m_words.data(), i);
+
+    remainder.set_to_0();
+    remainder.m_words.resize_and_keep_capacity(numerator_length + 1);
+    auto* dividend = remainder.m_words.data();
+    for (size_t i = 0; i < numerator_length; ++i)
+        dividend[i] = shift_word(numerator.m_words.data(), i);
+    dividend[numerator_length] = shift == 0 ? 0 : numerator.m_words[numerator_length - 1] >> (BITS_IN_WORD - shift);
+
+    const u64 base = 1ull << 32;
+    u64 divisor_high = divisor[denominator_length - 1];
+    u64 divisor_next = divisor[denominator_length - 2];
+
+    for (int j = numerator_length - denominator_length; j >= 0; --j) {
+        u64 number_to_divide = (static_cast<u64>(dividend[j + denominator_length]) << 32) | dividend[j + denominator_length - 1];
+        u64 quotient_estimate = number_to_divide / divisor_high;
+        u64 remainder_estimate = number_to_divide % divisor_high;
+        while (quotient_estimate >= base || quotient_estimate * divisor_next > ((remainder_estimate << 32) | dividend[j + denominator_length - 2])) {
+            --quotient_estimate;
+            remainder_estimate += divisor_high;
+            if (remainder_estimate >= base)
+                break;
+        }
+
+        // dividend[j, j + denominator_length] -= quotient_estimate * divisor
+        i64 borrow = 0;
+        i64 difference;
+        for (size_t i = 0; i < denominator_length; ++i) {
+            u64 product = quotient_estimate * divisor[i];
+            difference = static_cast<i64>(dividend[i + j]) - borrow - static_cast<i64>(product & 0xffffffff);
+            dividend[i + j] = static_cast<u32>(difference);
+            borrow = static_cast<i64>(product >> 32) - (difference >> 32);
+        }
+        difference = static_cast<i64>(dividend[j + denominator_length]) - borrow;
+        dividend[j + denominator_length] = static_cast<u32>(difference);
+
+        quotient_words[j] = static_cast<u32>(quotient_estimate);
+        if (difference < 0) {
+            --quotient_words[j];
+            auto carry = add_words(dividend + j, denominator_length, divisor, denominator_length);
+            dividend[j + denominator_length] += carry;
+        }
+    }
+
+    // Undo the normalization shift on what's left of the dividend.
+    if (shift != 0) {
+        for (size_t i = 0; i < denominator_length; ++i)
+            dividend[i] = (dividend[i] >> shift) | (dividend[i + 1] << (BITS_IN_WORD - shift));
+    }
+    remainder.m_words.resize_and_keep_capacity(denominator_length);
+    remainder.clamp_to_trimmed_length();
+    quotient.clamp_to_trimmed_length();
+}
+
+/**
+ * Complexity: O(N^2) where N is the number of words in the modulus
+ * Reduction method:
+ * Montgomery's REDC: for every word of the modulus, add the multiple of the modulus that clears the lowest
+ * remaining word of the number, then drop all the cleared words. What's left is smaller than twice the
+ * modulus, a final conditional subtraction brings it into range.
+ */
+FLATTEN void UnsignedBigInteger::montgomery_reduce_without_allocation(
+    const UnsignedBigInteger& number,
+    const UnsignedBigInteger& modulus,
+    u32 modulus_inverse,
+    UnsignedBigInteger& output)
+{
+    auto modulus_length = modulus.trimmed_length();
+    auto number_length = min(number.trimmed_length(), 2 * modulus_length);
+    VERIFY(modulus_length > 0 && (modulus.m_words[0] & 1));
+
+    output.set_to_0();
+    output.m_words.resize_and_keep_capacity(2 * modulus_length + 1);
+    auto* words = output.m_words.data();
+    __builtin_memset(words, 0, (2 * modulus_length + 1) * sizeof(u32));
+    __builtin_memcpy(words, number.m_words.data(), number_length * sizeof(u32));
+
+    auto* modulus_words = modulus.m_words.data();
+    for (size_t i = 0; i < modulus_length; ++i) {
+        u64 factor = static_cast<u32>(words[i] * modulus_inverse);
+        u64 carry = 0;
+        for (size_t j = 0; j < modulus_length; ++j) {
+            carry += factor * modulus_words[j] + words[i + j];
+            words[i + j] = static_cast<u32>(carry);
+            carry >>= 32;
+        }
+        for (size_t k = i + modulus_length; carry; ++k) {
+            carry += words[k];
+            words[k] = static_cast<u32>(carry);
+            carry >>= 32;
+        }
+    }
+
+    auto* result = words + modulus_length;
+    bool needs_subtraction = result[modulus_length] != 0;
+    if (!needs_subtraction) {
+        needs_subtraction = true;
+        for (int i = modulus_length - 1; i >= 0; --i) {
+            if (result[i] != modulus_words[i]) {
+                needs_subtraction = result[i] > modulus_words[i];
+                break;
             }
         }
     }
+    if (needs_subtraction)
+        subtract_words(result, modulus_length + 1, modulus_words, modulus_length);
+
+    __builtin_memmove(words, result, modulus_length * sizeof(u32));
+    output.m_words.resize_and_keep_capacity(modulus_length);
+    output.clamp_to_trimmed_length();
 }
 
 /**
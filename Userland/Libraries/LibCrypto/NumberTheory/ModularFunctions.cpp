@@ -37,9 +37,6 @@ UnsignedBigInteger ModularInverse(const UnsignedBigInteger& a_, const UnsignedBi
 
     UnsignedBigInteger one { 1 };
     UnsignedBigInteger temp_1;
-    UnsignedBigInteger temp_2;
-    UnsignedBigInteger temp_3;
-    UnsignedBigInteger temp_4;
     UnsignedBigInteger temp_plus;
     UnsignedBigInteger temp_minus;
     UnsignedBigInteger temp_quotient;
@@ -113,23 +110,130 @@ UnsignedBigInteger ModularInverse(const UnsignedBigInteger& a_, const UnsignedBi
     }
 
     // x % b
-    UnsignedBigInteger::divide_without_allocation(x, b, temp_1, temp_2, temp_3, temp_4, temp_quotient, temp_remainder);
+    UnsignedBigInteger::divide_without_allocation(x, b, temp_1, temp_quotient, temp_remainder);
     return temp_remainder;
 }
 
+// Returns -value^-1 mod 2^32 for an odd value.
+static u32 negated_inverse_modulo_word(u32 value)
+{
+    VERIFY(value & 1);
+    // Every odd number is its own inverse modulo 8, and every Newton step (x = x * (2 - value * x))
+    // doubles the number of correct low bits: 3 -> 6 -> 12 -> 24 -> 48.
+    u32 inverse = value;
+    for (size_t i = 0; i < 4; ++i)
+        inverse *= 2 - value * inverse;
+    return -inverse;
+}
+
+// Larger windows need fewer multiplications per exponent bit, but more precomputed powers.
+static size_t window_size_for_exponent(size_t exponent_bits)
+{
+    if (exponent_bits > 671)
+        return 6;
+    if (exponent_bits > 239)
+        return 5;
+    if (exponent_bits > 79)
+        return 4;
+    if (exponent_bits > 23)
+        return 3;
+    return 1;
+}
+
+// Sliding window exponentiation in the Montgomery domain: every modular multiplication is a plain
+// multiplication followed by a Montgomery reduction, no division is needed besides the setup.
+static UnsignedBigInteger montgomery_modular_power(const UnsignedBigInteger& b, const UnsignedBigInteger& e, const UnsignedBigInteger& m)
+{
+    auto modulus_length = m.trimmed_length();
+    auto modulus_inverse = negated_inverse_modulo_word(m.words()[0]);
+
+    UnsignedBigInteger temp;
+    UnsignedBigInteger temp_multiply;
+    UnsignedBigInteger temp_quotient;
+    UnsignedBigInteger temp_remainder;
+
+    auto multiply = [&](const UnsignedBigInteger& left, const UnsignedBigInteger& right, UnsignedBigInteger& output) {
+        UnsignedBigInteger::multiply_without_allocation(left, right, temp, temp_multiply);
+        UnsignedBigInteger::montgomery_reduce_without_allocation(temp_multiply, m, modulus_inverse, output);
+    };
+
+    // R^2 mod m, with R = 2^(32 * modulus_length); multiplying by it and reducing converts into Montgomery form.
+    UnsignedBigInteger r_squared;
+    r_squared.set_bit_inplace(2 * modulus_length * 32);
+    UnsignedBigInteger::divide_without_allocation(r_squared, m, temp, temp_quotient, temp_remainder);
+    r_squared.set_to(temp_remainder);
+
+    UnsignedBigInteger::divide_without_allocation(b, m, temp, temp_quotient, temp_remainder);
+    UnsignedBigInteger base;
+    multiply(temp_remainder, r_squared, base);
+
+    auto exponent_length = e.trimmed_length();
+    size_t exponent_bits = 0;
+    if (exponent_length > 0)
+        exponent_bits = exponent_length * 32 - __builtin_clz(e.words()[exponent_length - 1]);
+    auto bit = [&](size_t index) { return (e.words()[index / 32] >> (index % 32)) & 1; };
+    auto window_size = window_size_for_exponent(exponent_bits);
+
+    // odd_powers[i] = base^(2i + 1)
+    Vector<UnsignedBigInteger> odd_powers;
+    odd_powers.append(base);
+    if (window_size > 1) {
+        UnsignedBigInteger base_squared;
+        multiply(base, base, base_squared);
+        for (size_t i = 1; i < (1u << (window_size - 1)); ++i) {
+            UnsignedBigInteger power;
+            multiply(odd_powers.last(), base_squared, power);
+            odd_powers.append(move(power));
+        }
+    }
+
+    // 1 in Montgomery form, R mod m.
+    UnsignedBigInteger result;
+    UnsignedBigInteger::montgomery_reduce_without_allocation(r_squared, m, modulus_inverse, result);
+    UnsignedBigInteger temp_result;
+
+    for (int i = exponent_bits - 1; i >= 0;) {
+        if (!bit(i)) {
+            multiply(result, result, temp_result);
+            result.set_to(temp_result);
+            --i;
+            continue;
+        }
+
+        // Take the longest run of at most window_size bits that starts at bit i and ends with a set bit.
+        int window_end = max(i - static_cast<int>(window_size) + 1, 0);
+        while (!bit(window_end))
+            ++window_end;
+
+        size_t window_value = 0;
+        for (int j = i; j >= window_end; --j) {
+            window_value = (window_value << 1) | bit(j);
+            multiply(result, result, temp_result);
+            result.set_to(temp_result);
+        }
+        multiply(result, odd_powers[window_value >> 1], temp_result);
+        result.set_to(temp_result);
+        i = window_end - 1;
+    }
+
+    // Leave the Montgomery domain.
+    UnsignedBigInteger::montgomery_reduce_without_allocation(result, m, modulus_inverse, temp_result);
+    return temp_result;
+}
+
 UnsignedBigInteger ModularPower(const UnsignedBigInteger& b, const UnsignedBigInteger& e, const UnsignedBigInteger& m)
 {
     if (m == 1)
         return 0;
 
+    if (m.trimmed_length() > 0 && (m.words()[0] & 1))
+        return montgomery_modular_power(b, e, m);
+
     UnsignedBigInteger ep { e };
     UnsignedBigInteger base { b };
     UnsignedBigInteger exp { 1 };
 
     UnsignedBigInteger temp_1;
-    UnsignedBigInteger temp_2;
-    UnsignedBigInteger temp_3;
-    UnsignedBigInteger temp_4;
     UnsignedBigInteger temp_multiply;
     UnsignedBigInteger temp_quotient;
     UnsignedBigInteger temp_remainder;
@@ -137,8 +241,8 @@ UnsignedBigInteger ModularPower(const UnsignedBigInteger& b, const UnsignedBigIn
     while (!(ep < 1)) {
         if (ep.words()[0] % 2 == 1) {
             // exp = (exp * base) % m;
-            UnsignedBigInteger::multiply_without_allocation(exp, base, temp_1, temp_2, temp_3, temp_4, temp_multiply);
-            UnsignedBigInteger::divide_without_allocation(temp_multiply, m, temp_1, temp_2, temp_3, temp_4, temp_quotient, temp_remainder);
+            UnsignedBigInteger::multiply_without_allocation(exp, base, temp_1, temp_multiply);
+            UnsignedBigInteger::divide_without_allocation(temp_multiply, m, temp_1, temp_quotient, temp_remainder);
             exp.set_to(temp_remainder);
         }
 
@@ -147,8 +251,8 @@ UnsignedBigInteger ModularPower(const UnsignedBigInteger& b, const UnsignedBigIn
         ep.set_to(temp_quotient);
 
         // base = (base * base) % m;
-        UnsignedBigInteger::multiply_without_allocation(base, base, temp_1, temp_2, temp_3, temp_4, temp_multiply);
-        UnsignedBigInteger::divide_without_allocation(temp_multiply, m, temp_1, temp_2, temp_3, temp_4, temp_quotient, temp_remainder);
+        UnsignedBigInteger::multiply_without_allocation(base, base, temp_1, temp_multiply);
+        UnsignedBigInteger::divide_without_allocation(temp_multiply, m, temp_1, temp_quotient, temp_remainder);
         base.set_to(temp_remainder);
 
         // Note that not clamping here would cause future calculations (multiply, specifically) to allocate even more unused space
@@ -167,9 +271,6 @@ static void GCD_without_allocation(
     UnsignedBigInteger& temp_a,
     UnsignedBigInteger& temp_b,
     UnsignedBigInteger& temp_1,
-    UnsignedBigInteger& temp_2,
-    UnsignedBigInteger& temp_3,
-    UnsignedBigInteger& temp_4,
     UnsignedBigInteger& temp_quotient,
     UnsignedBigInteger& temp_remainder,
     UnsignedBigInteger& output)
@@ -183,7 +284,7 @@ static void GCD_without_allocation(
         }
 
         // temp_b %= temp_a
-        UnsignedBigInteger::divide_without_allocation(temp_b, temp_a, temp_1, temp_2, temp_3, temp_4, temp_quotient, temp_remainder);
+        UnsignedBigInteger::divide_without_allocation(temp_b, temp_a, temp_1, temp_quotient, temp_remainder);
         temp_b.set_to(temp_remainder);
         if (temp_b == 0) {
             output.set_to(temp_a);
@@ -191,7 +292,7 @@ static void GCD_without_allocation(
         }
 
         // temp_a %= temp_b
-        UnsignedBigInteger::divide_without_allocation(temp_a, temp_b, temp_1, temp_2, temp_3, temp_4, temp_quotient, temp_remainder);
+        UnsignedBigInteger::divide_without_allocation(temp_a, temp_b, temp_1, temp_quotient, temp_remainder);
         temp_a.set_to(temp_remainder);
     }
 }
@@ -201,14 +302,11 @@ UnsignedBigInteger GCD(const UnsignedBigInteger& a, const UnsignedBigInteger& b)
     UnsignedBigInteger temp_a;
     UnsignedBigInteger temp_b;
     UnsignedBigInteger temp_1;
-    UnsignedBigInteger temp_2;
-    UnsignedBigInteger temp_3;
-    UnsignedBigInteger temp_4;
     UnsignedBigInteger temp_quotient;
     UnsignedBigInteger temp_remainder;
     UnsignedBigInteger output;
 
-    GCD_without_allocation(a, b, temp_a, temp_b, temp_1, temp_2, temp_3, temp_4, temp_quotient, temp_remainder, output);
+    GCD_without_allocation(a, b, temp_a, temp_b, temp_1, temp_quotient, temp_remainder, output);
 
     return output;
 }
@@ -218,15 +316,12 @@ UnsignedBigInteger LCM(const UnsignedBigInteger& a, const UnsignedBigInteger& b)
     UnsignedBigInteger temp_a;
     UnsignedBigInteger temp_b;
     UnsignedBigInteger temp_1;
-    UnsignedBigInteger temp_2;
-    UnsignedBigInteger temp_3;
-    UnsignedBigInteger temp_4;
     UnsignedBigInteger temp_quotient;
     UnsignedBigInteger temp_remainder;
     UnsignedBigInteger gcd_output;
     UnsignedBigInteger output { 0 };
 
-    GCD_without_allocation(a, b, temp_a, temp_b, temp_1, temp_2, temp_3, temp_4, temp_quotient, temp_remainder, gcd_output);
+    GCD_without_allocation(a, b, temp_a, temp_b, temp_1, temp_quotient, temp_remainder, gcd_output);
     if (gcd_output == 0) {
 #if NT_DEBUG
         dbgln("GCD is zero");
@@ -235,8 +330,8 @@ UnsignedBigInteger LCM(const UnsignedBigInteger& a, const UnsignedBigInteger& b)
     }
 
     // output = (a / gcd_output) * b
-    UnsignedBigInteger::divide_without_allocation(a, gcd_output, temp_1, temp_2, temp_3, temp_4, temp_quotient, temp_remainder);
-    UnsignedBigInteger::multiply_without_allocation(temp_quotient, b, temp_1, temp_2, temp_3, temp_4, output);
+    UnsignedBigInteger::divide_without_allocation(a, gcd_output, temp_1, temp_quotient, temp_remainder);
+    UnsignedBigInteger::multiply_without_allocation(temp_quotient, b, temp_1, output);
 
     dbgln_if(NT_DEBUG, "quot: {} rem: {} out: {}", temp_quotient, temp_remainder, output);
 
@@ -173,9 +173,27 @@ RSA::KeyPairType RSA::parse_rsa_key(ReadonlyBytes der)
             }
             auto private_exponent = private_exponent_result.release_value();
 
-            // Drop the rest of the fields on the floor, we don't use them.
-            // FIXME: Actually use them...
-            keypair.private_key = { modulus, move(private_exponent), public_exponent };
+            // The CRT parameters let us do private key operations modulo the two primes instead of the modulus.
+            // They're not strictly needed though, so just fall back to using the private exponent if they're broken.
+            Vector<UnsignedBigInteger, 5> crt_parameters;
+            for (size_t i = 0; i < 5; ++i) {
+                auto parameter_result = decoder.read<UnsignedBigInteger>();
+                if (parameter_result.is_error()) {
+                    dbgln_if(RSA_PARSE_DEBUG, "RSA PKCS#1 private key CRT parameters parse failed: {}", parameter_result.error());
+                    break;
+                }
+                crt_parameters.append(parameter_result.release_value());
+            }
+
+            if (crt_parameters.size() == 5) {
+                keypair.private_key = {
+                    modulus, move(private_exponent), public_exponent,
+                    move(crt_parameters[0]), move(crt_parameters[1]),
+                    move(crt_parameters[2]), move(crt_parameters[3]), move(crt_parameters[4])
+                };
+            } else {
+                keypair.private_key = { modulus, move(private_exponent), public_exponent };
+            }
             keypair.public_key = { move(modulus), move(public_exponent) };
 
             return keypair;
@@ -225,6 +243,25 @@ RSA::KeyPairType RSA::parse_rsa_key(ReadonlyBytes der)
     }
 }
 
+// in^d mod n. With the CRT parameters, this is done as two exponentiations modulo the primes, each with half-sized
+// numbers and exponents, which is about four times cheaper. The two results are then recombined with Garner's formula.
+static UnsignedBigInteger private_key_operation(const UnsignedBigInteger& in, const RSA::PrivateKeyType& key)
+{
+    if (!key.has_crt_parameters())
+        return NumberTheory::ModularPower(in, key.private_exponent(), key.modulus());
+
+    auto m1 = NumberTheory::ModularPower(in, key.exponent1(), key.prime1());
+    auto m2 = NumberTheory::ModularPower(in, key.exponent2(), key.prime2());
+
+    // h = qinv * (m1 - m2) mod p
+    auto m2_mod_p = m2.divided_by(key.prime1()).remainder;
+    auto difference = m1 < m2_mod_p ? m1.plus(key.prime1()).minus(m2_mod_p) : m1.minus(m2_mod_p);
+    auto h = key.coefficient().multiplied_by(difference).divided_by(key.prime1()).remainder;
+
+    // m = m2 + h * q
+    return m2.plus(h.multiplied_by(key.prime2()));
+}
+
 void RSA::encrypt(ReadonlyBytes in, Bytes& out)
 {
     dbgln_if(CRYPTO_DEBUG, "in size: {}", in.size());
@@ -245,10 +282,8 @@ void RSA::encrypt(ReadonlyBytes in, Bytes& out)
 
 void RSA::decrypt(ReadonlyBytes in, Bytes& out)
 {
-    // FIXME: Actually use the private key properly
-
     auto in_integer = UnsignedBigInteger::import_data(in.data(), in.size());
-    auto exp = NumberTheory::ModularPower(in_integer, m_private_key.private_exponent(), m_private_key.modulus());
+    auto exp = private_key_operation(in_integer, m_private_key);
     auto size = exp.export_data(out);
 
     auto align = m_private_key.length();
@@ -262,7 +297,7 @@ void RSA::decrypt(ReadonlyBytes in, Bytes& out)
 void RSA::sign(ReadonlyBytes in, Bytes& out)
 {
     auto in_integer = UnsignedBigInteger::import_data(in.data(), in.size());
-    auto exp = NumberTheory::ModularPower(in_integer, m_private_key.private_exponent(), m_private_key.modulus());
+    auto exp = private_key_operation(in_integer, m_private_key);
     auto size = exp.export_data(out);
     out = out.slice(out.size() - size, size);
 }
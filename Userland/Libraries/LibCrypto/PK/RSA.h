@@ -82,6 +82,19 @@ public:
     {
     }
 
+    RSAPrivateKey(Integer n, Integer d, Integer e, Integer p, Integer q, Integer dp, Integer dq, Integer qinv)
+        : m_modulus(move(n))
+        , m_private_exponent(move(d))
+        , m_public_exponent(move(e))
+        , m_prime_1(move(p))
+        , m_prime_2(move(q))
+        , m_exponent_1(move(dp))
+        , m_exponent_2(move(dq))
+        , m_coefficient(move(qinv))
+        , m_length(m_modulus.trimmed_length() * sizeof(u32))
+    {
+    }
+
     RSAPrivateKey()
     {
     }
@@ -90,6 +103,13 @@ public:
     const Integer& modulus() const { return m_modulus; }
     const Integer& private_exponent() const { return m_private_exponent; }
     const Integer& public_exponent() const { return m_public_exponent; }
+    // The CRT parameters from PKCS#1, these are zero if the key didn't come with them.
+    const Integer& prime1() const { return m_prime_1; }
+    const Integer& prime2() const { return m_prime_2; }
+    const Integer& exponent1() const { return m_exponent_1; }
+    const Integer& exponent2() const { return m_exponent_2; }
+    const Integer& coefficient() const { return m_coefficient; }
+    bool has_crt_parameters() const { return !(m_prime_1 == 0) && !(m_prime_2 == 0); }
     size_t length() const { return m_length; }
     void set_length(size_t length) { m_length = length; }
 
@@ -98,6 +118,11 @@ public:
         m_modulus = move(n);
         m_private_exponent = move(d);
         m_public_exponent = move(e);
+        m_prime_1 = 0;
+        m_prime_2 = 0;
+        m_exponent_1 = 0;
+        m_exponent_2 = 0;
+        m_coefficient = 0;
         m_length = m_modulus.trimmed_length() * sizeof(u32);
     }
 
@@ -105,6 +130,11 @@ private:
     Integer m_modulus;
     Integer m_private_exponent;
     Integer m_public_exponent;
+    Integer m_prime_1;
+    Integer m_prime_2;
+    Integer m_exponent_1;
+    Integer m_exponent_2;
+    Integer m_coefficient;
     size_t m_length { 0 };
 };
 
@@ -139,10 +169,13 @@ public:
         auto n = p.multiplied_by(q);
 
         auto d = NumberTheory::ModularInverse(e, lambda);
+        auto dp = d.divided_by(p.minus(1)).remainder;
+        auto dq = d.divided_by(q.minus(1)).remainder;
+        auto qinv = NumberTheory::ModularInverse(q.divided_by(p).remainder, p);
         dbgln("Your keys are Pub(n={}, e={}) and Priv(n={}, d={})", n, e, n, d);
         RSAKeyPair<PublicKeyType, PrivateKeyType> keys {
             { n, e },
-            { n, d, e }
+            { n, d, e, p, q, dp, dq, qinv }
         };
         keys.public_key.set_length(bits / 2 / 8);
         keys.private_key.set_length(bits / 2 / 8);
@@ -511,6 +511,10 @@ Optional<BackingStore> Bitmap::allocate_backing_store(BitmapFormat format, const
     if (purgeable == Purgeable::Yes)
         map_flags |= MAP_NORESERVE;
 #ifdef __serenity__
+    // Large bitmaps (e.g. WindowServer's back buffers) get backed by huge pages when possible,
+    // which saves a lot of TLB misses when blitting them.
+    if (purgeable == Purgeable::No && data_size_in_bytes >= 2 * MiB)
+        map_flags |= MAP_HUGE;
     void* data = mmap_with_name(nullptr, data_size_in_bytes, PROT_READ | PROT_WRITE, map_flags, 0, 0, String::format("GraphicsBitmap [%dx%d]", size.width(), size.height()).characters());
 #else
     void* data = mmap(nullptr, data_size_in_bytes, PROT_READ | PROT_WRITE, map_flags, 0, 0);
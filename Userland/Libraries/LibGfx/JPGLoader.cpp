@@ -31,6 +31,7 @@
 #include <AK/LexicalPath.h>
 #include <AK/MappedFile.h>
 #include <AK/MemoryStream.h>
+#include <AK/SIMD.h>
 #include <AK/String.h>
 #include <AK/Vector.h>
 #include <LibGfx/Bitmap.h>
@@ -105,6 +106,8 @@ constexpr static u8 zigzag_map[64] {
     53, 60, 61, 54, 47, 55, 62, 63
 };
 
+using AK::SIMD::i32x4;
+
 using Marker = u16;
 
 /**
@@ -177,17 +180,62 @@ struct StartOfFrame {
 };
 
 struct HuffmanTableSpec {
+    static constexpr u8 lookahead_bits = 9;
+
     u8 type { 0 };
     u8 destination_id { 0 };
     u8 code_counts[16] = { 0 };
     Vector<u8> symbols;
-    Vector<u16> codes;
+
+    // Codes of up to lookahead_bits bits are decoded with a single lookup into this table, indexed
+    // by the next lookahead_bits bits of the stream. Entries hold (code length << 8 | symbol), or 0
+    // if those bits are the prefix of a longer code.
+    u16 lookahead[1 << lookahead_bits] = { 0 };
+
+    // Longer codes are decoded one length at a time: max_code holds the largest code of each length
+    // (or -1 if there is none), and value_offset maps a code of that length to its index in symbols.
+    i32 max_code[17] = { 0 };
+    i32 value_offset[17] = { 0 };
 };
 
 struct HuffmanStreamState {
     Vector<u8> stream;
-    u8 bit_offset { 0 };
     size_t byte_offset { 0 };
+
+    // Bits are consumed MSB-first from the low bit_count bits of bit_buffer, which is refilled a
+    // byte at a time. Past the end of the stream, it is padded with zeroes; is_exhausted() tells
+    // whether any of those have been consumed.
+    u64 bit_buffer { 0 };
+    u8 bit_count { 0 };
+
+    ALWAYS_INLINE void refill()
+    {
+        while (bit_count <= 48) {
+            u8 byte = byte_offset < stream.size() ? stream.data()[byte_offset] : 0;
+            byte_offset++;
+            bit_buffer = (bit_buffer << 8) | byte;
+            bit_count += 8;
+        }
+    }
+
+    ALWAYS_INLINE u32 peek_bits(u8 count)
+    {
+        if (bit_count < count)
+            refill();
+        return (bit_buffer >> (bit_count - count)) & ((1u << count) - 1);
+    }
+
+    ALWAYS_INLINE void discard_bits(u8 count) { bit_count -= count; }
+
+    bool is_exhausted() const { return byte_offset * 8 - bit_count > stream.size() * 8; }
+
+    // Drops the remaining bits of a partially consumed byte, and hands the buffered bytes back to the stream.
+    void align_to_byte_boundary()
+    {
+        byte_offset -= bit_count / 8;
+        bit_buffer = 0;
+        bit_count = 0;
+    }
 };
 
 struct JPGLoadingContext {
@@ -203,6 +251,9 @@ struct JPGLoadingContext {
     size_t data_size { 0 };
     u32 luma_table[64] = { 0 };
     u32 chroma_table[64] = { 0 };
+    // The quantization tables with the scale factors of the inverse DCT folded in, in fixed point.
+    i32 idct_luma_table[64] = { 0 };
+    i32 idct_chroma_table[64] = { 0 };
     StartOfFrame frame;
     u8 hsample_factor { 0 };
     u8 vsample_factor { 0 };
@@ -217,53 +268,63 @@ struct JPGLoadingContext {
     MacroblockMeta mblock_meta;
 };
 
-static void generate_huffman_codes(HuffmanTableSpec& table)
+static bool generate_huffman_codes(HuffmanTableSpec& table)
 {
     unsigned code = 0;
-    for (auto number_of_codes : table.code_counts) {
-        for (int i = 0; i < number_of_codes; i++)
-            table.codes.append(code++);
+    size_t code_cursor = 0;
+    for (u8 length = 1; length <= 16; length++) {
+        auto number_of_codes = table.code_counts[length - 1];
+        table.value_offset[length] = (i32)code_cursor - (i32)code;
+        for (int i = 0; i < number_of_codes; i++) {
+            if (code >= (1u << length)) {
+                dbgln_if(JPG_DEBUG, "Huffman table has too many codes of length {}!", length);
+                return false;
+            }
+
+            if (length <= HuffmanTableSpec::lookahead_bits) {
+                // Every lookahead index that starts with this code decodes to its symbol.
+                u8 unused_bits = HuffmanTableSpec::lookahead_bits - length;
+                u16 entry = (length << 8) | table.symbols[code_cursor];
+                for (unsigned suffix = 0; suffix < (1u << unused_bits); suffix++)
+                    table.lookahead[(code << unused_bits) | suffix] = entry;
+            }
+
+            code++;
+            code_cursor++;
+        }
+        table.max_code[length] = number_of_codes > 0 ? (i32)code - 1 : -1;
         code <<= 1;
     }
+    return true;
 }
 
 static Optional<size_t> read_huffman_bits(HuffmanStreamState& hstream, size_t count = 1)
 {
-    if (count > (8 * sizeof(size_t))) {
+    if (count > 16) {
         dbgln_if(JPG_DEBUG, "Can't read {} bits at once!", count);
         return {};
     }
-    size_t value = 0;
-    while (count--) {
-        if (hstream.byte_offset >= hstream.stream.size()) {
-            dbgln_if(JPG_DEBUG, "Huffman stream exhausted. This could be an error!");
-            return {};
-        }
-        u8 current_byte = hstream.stream[hstream.byte_offset];
-        u8 current_bit = 1u & (u32)(current_byte >> (7 - hstream.bit_offset)); // MSB first.
-        hstream.bit_offset++;
-        value = (value << 1) | (size_t)current_bit;
-        if (hstream.bit_offset == 8) {
-            hstream.byte_offset++;
-            hstream.bit_offset = 0;
-        }
-    }
+    size_t value = hstream.peek_bits(count);
+    hstream.discard_bits(count);
     return value;
 }
 
 static Optional<u8> get_next_symbol(HuffmanStreamState& hstream, const HuffmanTableSpec& table)
 {
-    unsigned code = 0;
-    size_t code_cursor = 0;
-    for (int i = 0; i < 16; i++) { // Codes can't be longer than 16 bits.
-        auto result = read_huffman_bits(hstream);
-        if (!result.has_value())
-            return {};
-        code = (code << 1) | (i32)result.release_value();
-        for (int j = 0; j < table.code_counts[i]; j++) {
-            if (code == table.codes[code_cursor])
-                return table.symbols[code_cursor];
-            code_cursor++;
+    // Codes can't be longer than 16 bits.
+    u32 bits = hstream.peek_bits(16);
+
+    u16 entry = table.lookahead[bits >> (16 - HuffmanTableSpec::lookahead_bits)];
+    if (entry != 0) {
+        hstream.discard_bits(entry >> 8);
+        return entry & 0xFF;
+    }
+
+    for (u8 length = HuffmanTableSpec::lookahead_bits + 1; length <= 16; length++) {
+        i32 code = bits >> (16 - length);
+        if (code <= table.max_code[length]) {
+            hstream.discard_bits(length);
+            return table.symbols[code + table.value_offset[length]];
         }
     }
 
@@ -280,7 +341,7 @@ static Optional<u8> get_next_symbol(HuffmanStreamState& hstream, const HuffmanTa
  * coefficients before we get to read a cb-cr block.
 
  * In the function below, `hcursor` and `vcursor` denote the location of the block
- * we're building in the macroblock matrix. `vfactor_i` and `hfactor_i` are cursors
+ * we're building in the current row of macroblocks. `vfactor_i` and `hfactor_i` are cursors
  * that iterate over the vertical and horizontal subsampling factors, respectively.
  * When we finish one iteration of the innermost loop, we'll have the coefficients
  * of one of the components of block at position `mb_index`. When the outermost loop
@@ -298,14 +359,14 @@ static bool build_macroblocks(JPGLoadingContext& context, Vector<Macroblock>& ma
         if (component.ac_destination_id >= context.ac_tables.size())
             return false;
 
+        auto& dc_table = context.dc_tables.find(component.dc_destination_id)->value;
+        auto& ac_table = context.ac_tables.find(component.ac_destination_id)->value;
+
         for (u8 vfactor_i = 0; vfactor_i < component.vsample_factor; vfactor_i++) {
             for (u8 hfactor_i = 0; hfactor_i < component.hsample_factor; hfactor_i++) {
                 u32 mb_index = (vcursor + vfactor_i) * context.mblock_meta.hpadded_count + (hfactor_i + hcursor);
                 Macroblock& block = macroblocks[mb_index];
 
-                auto& dc_table = context.dc_tables.find(component.dc_destination_id)->value;
-                auto& ac_table = context.ac_tables.find(component.ac_destination_id)->value;
-
                 auto symbol_or_error = get_next_symbol(context.huffman_stream, dc_table);
                 if (!symbol_or_error.has_value())
                     return false;
@@ -371,6 +432,12 @@ static bool build_macroblocks(JPGLoadingContext& context, Vector<Macroblock>& ma
                         select_component[zigzag_map[j++]] = ac_coefficient;
                     }
                 }
+
+                // Reading past the end only yields zeroes, so it's enough to check once per block.
+                if (context.huffman_stream.is_exhausted()) {
+                    dbgln_if(JPG_DEBUG, "Huffman stream exhausted. This could be an error!");
+                    return false;
+                }
             }
         }
     }
@@ -378,61 +445,38 @@ static bool build_macroblocks(JPGLoadingContext& context, Vector<Macroblock>& ma
     return true;
 }
 
-static Optional<Vector<Macroblock>> decode_huffman_stream(JPGLoadingContext& context)
+static bool decode_huffman_stream(JPGLoadingContext& context, Vector<Macroblock>& macroblocks, u32 vcursor)
 {
-    Vector<Macroblock> macroblocks;
-    macroblocks.resize(context.mblock_meta.padded_total);
-
-    if constexpr (JPG_DEBUG) {
-        dbgln("Image width: {}", context.frame.width);
-        dbgln("Image height: {}", context.frame.height);
-        dbgln("Macroblocks in a row: {}", context.mblock_meta.hpadded_count);
-        dbgln("Macroblocks in a column: {}", context.mblock_meta.vpadded_count);
-        dbgln("Macroblock meta padded total: {}", context.mblock_meta.padded_total);
-    }
-
-    // Compute huffman codes for DC and AC tables.
-    for (auto it = context.dc_tables.begin(); it != context.dc_tables.end(); ++it)
-        generate_huffman_codes(it->value);
-
-    for (auto it = context.ac_tables.begin(); it != context.ac_tables.end(); ++it)
-        generate_huffman_codes(it->value);
-
-    for (u32 vcursor = 0; vcursor < context.mblock_meta.vcount; vcursor += context.vsample_factor) {
-        for (u32 hcursor = 0; hcursor < context.mblock_meta.hcount; hcursor += context.hsample_factor) {
-            u32 i = vcursor * context.mblock_meta.hpadded_count + hcursor;
-            if (context.dc_reset_interval > 0) {
-                if (i % context.dc_reset_interval == 0) {
-                    context.previous_dc_values[0] = 0;
-                    context.previous_dc_values[1] = 0;
-                    context.previous_dc_values[2] = 0;
-
-                    // Restart markers are stored in byte boundaries. Advance the huffman stream cursor to
-                    //  the 0th bit of the next byte.
-                    if (context.huffman_stream.byte_offset < context.huffman_stream.stream.size()) {
-                        if (context.huffman_stream.bit_offset > 0) {
-                            context.huffman_stream.bit_offset = 0;
-                            context.huffman_stream.byte_offset++;
-                        }
+    // Restart intervals are counted in MCUs, each of which covers hsample_factor * vsample_factor macroblocks.
+    const u32 mcus_per_row = context.mblock_meta.hpadded_count / context.hsample_factor;
+
+    for (u32 hcursor = 0; hcursor < context.mblock_meta.hcount; hcursor += context.hsample_factor) {
+        u32 mcu_index = (vcursor / context.vsample_factor) * mcus_per_row + hcursor / context.hsample_factor;
+        if (context.dc_reset_interval > 0 && mcu_index > 0 && mcu_index % context.dc_reset_interval == 0) {
+            context.previous_dc_values[0] = 0;
+            context.previous_dc_values[1] = 0;
+            context.previous_dc_values[2] = 0;
+
+            // Restart markers are stored in byte boundaries. Advance the huffman stream cursor to
+            //  the 0th bit of the next byte.
+            context.huffman_stream.align_to_byte_boundary();
+
+            // Skip the restart marker (RSTn).
+            if (context.huffman_stream.byte_offset < context.huffman_stream.stream.size())
+                context.huffman_stream.byte_offset++;
+        }
 
-                        // Skip the restart marker (RSTn).
-                        context.huffman_stream.byte_offset++;
-                    }
-                }
-            }
-
-            if (!build_macroblocks(context, macroblocks, hcursor, vcursor)) {
-                if constexpr (JPG_DEBUG) {
-                    dbgln("Failed to build Macroblock {}", i);
-                    dbgln("Huffman stream byte offset {}", context.huffman_stream.byte_offset);
-                    dbgln("Huffman stream bit offset {}", context.huffman_stream.bit_offset);
-                }
-                return {};
+        if (!build_macroblocks(context, macroblocks, hcursor, 0)) {
+            if constexpr (JPG_DEBUG) {
+                dbgln("Failed to build Macroblock {}", vcursor * context.mblock_meta.hpadded_count + hcursor);
+                dbgln("Huffman stream byte offset {}", context.huffman_stream.byte_offset);
+                dbgln("Huffman stream buffered bits {}", context.huffman_stream.bit_count);
             }
+            return false;
         }
     }
 
-    return macroblocks;
+    return true;
 }
 
 static inline bool bounds_okay(const size_t cursor, const size_t delta, const size_t bound)
@@ -645,7 +689,7 @@ static bool read_huffman_table(InputMemoryStream& stream, JPGLoadingContext& con
             table.code_counts[i] = count;
         }
 
-        table.codes.ensure_capacity(total_codes);
+        table.symbols.ensure_capacity(total_codes);
 
         // Read symbols. Read X bytes, where X is the sum of the counts of codes read in the previous step.
         for (u32 i = 0; i < total_codes; i++) {
@@ -860,247 +904,233 @@ static bool skip_marker_with_length(InputMemoryStream& stream)
     return !stream.handle_any_error();
 }
 
-static void dequantize(JPGLoadingContext& context, Vector<Macroblock>& macroblocks)
+// The inverse DCT is a fixed-point version of the AAN algorithm. Samples carry idct_fraction_bits
+// fractional bits through both passes, and its multipliers are scaled by 2^idct_constant_bits.
+// The quantization tables keep idct_quantization_bits, so that small quantizers stay accurate.
+static constexpr int idct_fraction_bits = 6;
+static constexpr int idct_constant_bits = 10;
+static constexpr int idct_quantization_bits = 12;
+
+static constexpr i32 idct_fixed_point(double value)
 {
-    for (u32 vcursor = 0; vcursor < context.mblock_meta.vcount; vcursor += context.vsample_factor) {
-        for (u32 hcursor = 0; hcursor < context.mblock_meta.hcount; hcursor += context.hsample_factor) {
-            for (auto it = context.components.begin(); it != context.components.end(); ++it) {
-                auto& component = it->value;
-                const u32* table = component.qtable_id == 0 ? context.luma_table : context.chroma_table;
-                for (u32 vfactor_i = 0; vfactor_i < component.vsample_factor; vfactor_i++) {
-                    for (u32 hfactor_i = 0; hfactor_i < component.hsample_factor; hfactor_i++) {
-                        u32 mb_index = (vcursor + vfactor_i) * context.mblock_meta.hpadded_count + (hfactor_i + hcursor);
-                        Macroblock& block = macroblocks[mb_index];
-                        int* block_component = component.serial_id == 0 ? block.y : (component.serial_id == 1 ? block.cb : block.cr);
-                        for (u32 k = 0; k < 64; k++)
-                            block_component[k] *= table[k];
-                    }
-                }
-            }
+    return static_cast<i32>(value * (1 << idct_constant_bits) + 0.5);
+}
+
+static constexpr i32 idct_m1 = idct_fixed_point(1.414213562); // 2 * cos(2 / 16 * 2pi)
+static constexpr i32 idct_m2 = idct_fixed_point(1.082392200); // m0 - m5
+static constexpr i32 idct_m3 = idct_m1;
+static constexpr i32 idct_m4 = idct_fixed_point(2.613125930); // m0 + m5
+static constexpr i32 idct_m5 = idct_fixed_point(0.765366865); // 2 * cos(3 / 16 * 2pi)
+
+static void generate_idct_tables(JPGLoadingContext& context)
+{
+    // Each coefficient is scaled by s(row) * s(column) before the butterflies, which we do while dequantizing.
+    double scale_factors[8];
+    scale_factors[0] = 1.0 / sqrt(8);
+    for (int k = 1; k < 8; k++)
+        scale_factors[k] = cos(k / 16.0 * M_PI) / 2.0;
+
+    for (int row = 0; row < 8; row++) {
+        for (int column = 0; column < 8; column++) {
+            const double scale = scale_factors[row] * scale_factors[column] * (1 << idct_quantization_bits);
+            const int i = row * 8 + column;
+            context.idct_luma_table[i] = static_cast<i32>(context.luma_table[i] * scale + 0.5);
+            context.idct_chroma_table[i] = static_cast<i32>(context.chroma_table[i] * scale + 0.5);
         }
     }
 }
 
-static void inverse_dct(const JPGLoadingContext& context, Vector<Macroblock>& macroblocks)
+ALWAYS_INLINE static i32x4 load_i32x4(const i32* data)
 {
-    static const float m0 = 2.0 * cos(1.0 / 16.0 * 2.0 * M_PI);
-    static const float m1 = 2.0 * cos(2.0 / 16.0 * 2.0 * M_PI);
-    static const float m3 = 2.0 * cos(2.0 / 16.0 * 2.0 * M_PI);
-    static const float m5 = 2.0 * cos(3.0 / 16.0 * 2.0 * M_PI);
-    static const float m2 = m0 - m5;
-    static const float m4 = m0 + m5;
-    static const float s0 = cos(0.0 / 16.0 * M_PI) / sqrt(8);
-    static const float s1 = cos(1.0 / 16.0 * M_PI) / 2.0;
-    static const float s2 = cos(2.0 / 16.0 * M_PI) / 2.0;
-    static const float s3 = cos(3.0 / 16.0 * M_PI) / 2.0;
-    static const float s4 = cos(4.0 / 16.0 * M_PI) / 2.0;
-    static const float s5 = cos(5.0 / 16.0 * M_PI) / 2.0;
-    static const float s6 = cos(6.0 / 16.0 * M_PI) / 2.0;
-    static const float s7 = cos(7.0 / 16.0 * M_PI) / 2.0;
+    i32x4 value;
+    __builtin_memcpy(&value, data, sizeof(value));
+    return value;
+}
 
-    for (u32 vcursor = 0; vcursor < context.mblock_meta.vcount; vcursor += context.vsample_factor) {
-        for (u32 hcursor = 0; hcursor < context.mblock_meta.hcount; hcursor += context.hsample_factor) {
-            for (auto it = context.components.begin(); it != context.components.end(); ++it) {
-                auto& component = it->value;
-                for (u8 vfactor_i = 0; vfactor_i < component.vsample_factor; vfactor_i++) {
-                    for (u8 hfactor_i = 0; hfactor_i < component.hsample_factor; hfactor_i++) {
-                        u32 mb_index = (vcursor + vfactor_i) * context.mblock_meta.hpadded_count + (hfactor_i + hcursor);
-                        Macroblock& block = macroblocks[mb_index];
-                        i32* block_component = component.serial_id == 0 ? block.y : (component.serial_id == 1 ? block.cb : block.cr);
-                        for (u32 k = 0; k < 8; ++k) {
-                            const float g0 = block_component[0 * 8 + k] * s0;
-                            const float g1 = block_component[4 * 8 + k] * s4;
-                            const float g2 = block_component[2 * 8 + k] * s2;
-                            const float g3 = block_component[6 * 8 + k] * s6;
-                            const float g4 = block_component[5 * 8 + k] * s5;
-                            const float g5 = block_component[1 * 8 + k] * s1;
-                            const float g6 = block_component[7 * 8 + k] * s7;
-                            const float g7 = block_component[3 * 8 + k] * s3;
-
-                            const float f0 = g0;
-                            const float f1 = g1;
-                            const float f2 = g2;
-                            const float f3 = g3;
-                            const float f4 = g4 - g7;
-                            const float f5 = g5 + g6;
-                            const float f6 = g5 - g6;
-                            const float f7 = g4 + g7;
-
-                            const float e0 = f0;
-                            const float e1 = f1;
-                            const float e2 = f2 - f3;
-                            const float e3 = f2 + f3;
-                            const float e4 = f4;
-                            const float e5 = f5 - f7;
-                            const float e6 = f6;
-                            const float e7 = f5 + f7;
-                            const float e8 = f4 + f6;
-
-                            const float d0 = e0;
-                            const float d1 = e1;
-                            const float d2 = e2 * m1;
-                            const float d3 = e3;
-                            const float d4 = e4 * m2;
-                            const float d5 = e5 * m3;
-                            const float d6 = e6 * m4;
-                            const float d7 = e7;
-                            const float d8 = e8 * m5;
-
-                            const float c0 = d0 + d1;
-                            const float c1 = d0 - d1;
-                            const float c2 = d2 - d3;
-                            const float c3 = d3;
-                            const float c4 = d4 + d8;
-                            const float c5 = d5 + d7;
-                            const float c6 = d6 - d8;
-                            const float c7 = d7;
-                            const float c8 = c5 - c6;
-
-                            const float b0 = c0 + c3;
-                            const float b1 = c1 + c2;
-                            const float b2 = c1 - c2;
-                            const float b3 = c0 - c3;
-                            const float b4 = c4 - c8;
-                            const float b5 = c8;
-                            const float b6 = c6 - c7;
-                            const float b7 = c7;
-
-                            block_component[0 * 8 + k] = b0 + b7;
-                            block_component[1 * 8 + k] = b1 + b6;
-                            block_component[2 * 8 + k] = b2 + b5;
-                            block_component[3 * 8 + k] = b3 + b4;
-                            block_component[4 * 8 + k] = b3 - b4;
-                            block_component[5 * 8 + k] = b2 - b5;
-                            block_component[6 * 8 + k] = b1 - b6;
-                            block_component[7 * 8 + k] = b0 - b7;
-                        }
-                        for (u32 l = 0; l < 8; ++l) {
-                            const float g0 = block_component[l * 8 + 0] * s0;
-                            const float g1 = block_component[l * 8 + 4] * s4;
-                            const float g2 = block_component[l * 8 + 2] * s2;
-                            const float g3 = block_component[l * 8 + 6] * s6;
-                            const float g4 = block_component[l * 8 + 5] * s5;
-                            const float g5 = block_component[l * 8 + 1] * s1;
-                            const float g6 = block_component[l * 8 + 7] * s7;
-                            const float g7 = block_component[l * 8 + 3] * s3;
-
-                            const float f0 = g0;
-                            const float f1 = g1;
-                            const float f2 = g2;
-                            const float f3 = g3;
-                            const float f4 = g4 - g7;
-                            const float f5 = g5 + g6;
-                            const float f6 = g5 - g6;
-                            const float f7 = g4 + g7;
-
-                            const float e0 = f0;
-                            const float e1 = f1;
-                            const float e2 = f2 - f3;
-                            const float e3 = f2 + f3;
-                            const float e4 = f4;
-                            const float e5 = f5 - f7;
-                            const float e6 = f6;
-                            const float e7 = f5 + f7;
-                            const float e8 = f4 + f6;
-
-                            const float d0 = e0;
-                            const float d1 = e1;
-                            const float d2 = e2 * m1;
-                            const float d3 = e3;
-                            const float d4 = e4 * m2;
-                            const float d5 = e5 * m3;
-                            const float d6 = e6 * m4;
-                            const float d7 = e7;
-                            const float d8 = e8 * m5;
-
-                            const float c0 = d0 + d1;
-                            const float c1 = d0 - d1;
-                            const float c2 = d2 - d3;
-                            const float c3 = d3;
-                            const float c4 = d4 + d8;
-                            const float c5 = d5 + d7;
-                            const float c6 = d6 - d8;
-                            const float c7 = d7;
-                            const float c8 = c5 - c6;
-
-                            const float b0 = c0 + c3;
-                            const float b1 = c1 + c2;
-                            const float b2 = c1 - c2;
-                            const float b3 = c0 - c3;
-                            const float b4 = c4 - c8;
-                            const float b5 = c8;
-                            const float b6 = c6 - c7;
-                            const float b7 = c7;
-
-                            block_component[l * 8 + 0] = b0 + b7;
-                            block_component[l * 8 + 1] = b1 + b6;
-                            block_component[l * 8 + 2] = b2 + b5;
-                            block_component[l * 8 + 3] = b3 + b4;
-                            block_component[l * 8 + 4] = b3 - b4;
-                            block_component[l * 8 + 5] = b2 - b5;
-                            block_component[l * 8 + 6] = b1 - b6;
-                            block_component[l * 8 + 7] = b0 - b7;
-                        }
-                    }
-                }
-            }
+ALWAYS_INLINE static void store_i32x4(i32* data, i32x4 value)
+{
+    __builtin_memcpy(data, &value, sizeof(value));
+}
+
+ALWAYS_INLINE static i32x4 idct_multiply(i32x4 value, i32 constant)
+{
+    return (value * constant) >> idct_constant_bits;
+}
+
+// Transforms four rows or columns at once, each lane holding one of them.
+ALWAYS_INLINE static void inverse_dct_1d(i32x4 (&values)[8])
+{
+    const i32x4 g0 = values[0];
+    const i32x4 g1 = values[4];
+    const i32x4 g2 = values[2];
+    const i32x4 g3 = values[6];
+    const i32x4 g4 = values[5];
+    const i32x4 g5 = values[1];
+    const i32x4 g6 = values[7];
+    const i32x4 g7 = values[3];
+
+    const i32x4 f4 = g4 - g7;
+    const i32x4 f5 = g5 + g6;
+    const i32x4 f6 = g5 - g6;
+    const i32x4 f7 = g4 + g7;
+
+    const i32x4 e2 = g2 - g3;
+    const i32x4 e3 = g2 + g3;
+    const i32x4 e5 = f5 - f7;
+    const i32x4 e7 = f5 + f7;
+    const i32x4 e8 = f4 + f6;
+
+    const i32x4 d2 = idct_multiply(e2, idct_m1);
+    const i32x4 d4 = idct_multiply(f4, idct_m2);
+    const i32x4 d5 = idct_multiply(e5, idct_m3);
+    const i32x4 d6 = idct_multiply(f6, idct_m4);
+    const i32x4 d8 = idct_multiply(e8, idct_m5);
+
+    const i32x4 c0 = g0 + g1;
+    const i32x4 c1 = g0 - g1;
+    const i32x4 c2 = d2 - e3;
+    const i32x4 c4 = d4 + d8;
+    const i32x4 c5 = d5 + e7;
+    const i32x4 c6 = d6 - d8;
+    const i32x4 c8 = c5 - c6;
+
+    const i32x4 b0 = c0 + e3;
+    const i32x4 b1 = c1 + c2;
+    const i32x4 b2 = c1 - c2;
+    const i32x4 b3 = c0 - e3;
+    const i32x4 b4 = c4 - c8;
+    const i32x4 b6 = c6 - e7;
+
+    values[0] = b0 + e7;
+    values[1] = b1 + b6;
+    values[2] = b2 + c8;
+    values[3] = b3 + b4;
+    values[4] = b3 - b4;
+    values[5] = b2 - c8;
+    values[6] = b1 - b6;
+    values[7] = b0 - e7;
+}
+
+// Dequantizes and transforms the coefficients of one block in place, leaving samples centered around zero.
+static void inverse_dct_block(i32* block, const i32* table)
+{
+    // Smooth areas often leave nothing but the DC coefficient, which makes for a flat block.
+    i32x4 ac_coefficients = load_i32x4(block + 4);
+    for (int i = 8; i < 64; i += 4)
+        ac_coefficients |= load_i32x4(block + i);
+    if ((ac_coefficients[0] | ac_coefficients[1] | ac_coefficients[2] | ac_coefficients[3] | block[1] | block[2] | block[3]) == 0) {
+        const i32 dc = (block[0] * table[0]) >> (idct_quantization_bits - idct_fraction_bits);
+        const i32 sample = (dc + (1 << (idct_fraction_bits - 1))) >> idct_fraction_bits;
+        for (int i = 0; i < 64; i++)
+            block[i] = sample;
+        return;
+    }
+
+    i32 workspace[64];
+
+    // Columns first: every row of the block holds one coefficient of eight columns.
+    for (int half = 0; half < 8; half += 4) {
+        i32x4 values[8];
+        for (int row = 0; row < 8; row++) {
+            const i32x4 coefficients = load_i32x4(block + row * 8 + half) * load_i32x4(table + row * 8 + half);
+            values[row] = coefficients >> (idct_quantization_bits - idct_fraction_bits);
+        }
+        inverse_dct_1d(values);
+        for (int row = 0; row < 8; row++)
+            store_i32x4(workspace + row * 8 + half, values[row]);
+    }
+
+    // Then rows, four at a time, gathering their columns into lanes.
+    for (int half = 0; half < 8; half += 4) {
+        i32x4 values[8];
+        for (int column = 0; column < 8; column++) {
+            const i32* samples = workspace + half * 8 + column;
+            values[column] = i32x4 { samples[0], samples[8], samples[16], samples[24] };
+        }
+        inverse_dct_1d(values);
+        for (int column = 0; column < 8; column++) {
+            const i32x4 samples = (values[column] + (1 << (idct_fraction_bits - 1))) >> idct_fraction_bits;
+            for (int lane = 0; lane < 4; lane++)
+                block[(half + lane) * 8 + column] = samples[lane];
         }
     }
 }
 
-static void ycbcr_to_rgb(const JPGLoadingContext& context, Vector<Macroblock>& macroblocks)
+static void dequantize_and_inverse_dct(const JPGLoadingContext& context, Vector<Macroblock>& macroblocks)
 {
-    for (u32 vcursor = 0; vcursor < context.mblock_meta.vcount; vcursor += context.vsample_factor) {
-        for (u32 hcursor = 0; hcursor < context.mblock_meta.hcount; hcursor += context.hsample_factor) {
-            const u32 chroma_block_index = vcursor * context.mblock_meta.hpadded_count + hcursor;
-            const Macroblock& chroma = macroblocks[chroma_block_index];
-            // Overflows are intentional.
-            for (u8 vfactor_i = context.vsample_factor - 1; vfactor_i < context.vsample_factor; --vfactor_i) {
-                for (u8 hfactor_i = context.hsample_factor - 1; hfactor_i < context.hsample_factor; --hfactor_i) {
-                    u32 mb_index = (vcursor + vfactor_i) * context.mblock_meta.hpadded_count + (hcursor + hfactor_i);
-                    i32* y = macroblocks[mb_index].y;
-                    i32* cb = macroblocks[mb_index].cb;
-                    i32* cr = macroblocks[mb_index].cr;
-                    for (u8 i = 7; i < 8; --i) {
-                        for (u8 j = 7; j < 8; --j) {
-                            const u8 pixel = i * 8 + j;
-                            const u32 chroma_pxrow = (i / context.vsample_factor) + 4 * vfactor_i;
-                            const u32 chroma_pxcol = (j / context.hsample_factor) + 4 * hfactor_i;
-                            const u32 chroma_pixel = chroma_pxrow * 8 + chroma_pxcol;
-                            int r = y[pixel] + 1.402f * chroma.cr[chroma_pixel] + 128;
-                            int g = y[pixel] - 0.344f * chroma.cb[chroma_pixel] - 0.714f * chroma.cr[chroma_pixel] + 128;
-                            int b = y[pixel] + 1.772f * chroma.cb[chroma_pixel] + 128;
-                            y[pixel] = r < 0 ? 0 : (r > 255 ? 255 : r);
-                            cb[pixel] = g < 0 ? 0 : (g > 255 ? 255 : g);
-                            cr[pixel] = b < 0 ? 0 : (b > 255 ? 255 : b);
-                        }
-                    }
+    for (u32 hcursor = 0; hcursor < context.mblock_meta.hcount; hcursor += context.hsample_factor) {
+        for (auto it = context.components.begin(); it != context.components.end(); ++it) {
+            auto& component = it->value;
+            const i32* table = component.qtable_id == 0 ? context.idct_luma_table : context.idct_chroma_table;
+            for (u32 vfactor_i = 0; vfactor_i < component.vsample_factor; vfactor_i++) {
+                for (u32 hfactor_i = 0; hfactor_i < component.hsample_factor; hfactor_i++) {
+                    u32 mb_index = vfactor_i * context.mblock_meta.hpadded_count + (hfactor_i + hcursor);
+                    Macroblock& block = macroblocks[mb_index];
+                    i32* block_component = component.serial_id == 0 ? block.y : (component.serial_id == 1 ? block.cb : block.cr);
+                    inverse_dct_block(block_component, table);
                 }
             }
         }
     }
 }
 
-static bool compose_bitmap(JPGLoadingContext& context, const Vector<Macroblock>& macroblocks)
+ALWAYS_INLINE static i32x4 clamp_to_u8(i32x4 value)
 {
-    context.bitmap = Bitmap::create_purgeable(BitmapFormat::BGRx8888, { context.frame.width, context.frame.height });
-    if (!context.bitmap)
-        return false;
+    // Comparisons yield all ones in the lanes where they hold.
+    value &= ~(value < 0);
+    return (value | (value > 255)) & 255;
+}
+
+// Converts a row of macroblocks to RGB, and writes it straight into the rows of the bitmap it covers.
+static void ycbcr_to_rgb(JPGLoadingContext& context, const Vector<Macroblock>& macroblocks, u32 vcursor)
+{
+    auto& bitmap = *context.bitmap;
+    const u32 width = context.frame.width;
+    const u32 height = context.frame.height;
+
+    for (u32 hcursor = 0; hcursor < context.mblock_meta.hcount; hcursor += context.hsample_factor) {
+        const Macroblock& chroma = macroblocks[hcursor];
+        for (u32 vfactor_i = 0; vfactor_i < context.vsample_factor; vfactor_i++) {
+            for (u32 hfactor_i = 0; hfactor_i < context.hsample_factor; hfactor_i++) {
+                const u32 block_x = (hcursor + hfactor_i) * 8;
+                const u32 block_y = (vcursor + vfactor_i) * 8;
+                if (block_x >= width || block_y >= height)
+                    continue;
+
+                const i32* y = macroblocks[vfactor_i * context.mblock_meta.hpadded_count + (hcursor + hfactor_i)].y;
+                for (u32 i = 0; i < 8 && block_y + i < height; i++) {
+                    RGBA32* scanline = bitmap.scanline(block_y + i);
+                    const u32 chroma_row = ((i / context.vsample_factor) + 4 * vfactor_i) * 8 + 4 * hfactor_i;
+                    for (u32 j = 0; j < 8 && block_x + j < width; j += 4) {
+                        const i32x4 luma = load_i32x4(y + i * 8 + j) + 128;
+                        i32x4 cb;
+                        i32x4 cr;
+                        if (context.hsample_factor == 1) {
+                            cb = load_i32x4(chroma.cb + chroma_row + j);
+                            cr = load_i32x4(chroma.cr + chroma_row + j);
+                        } else {
+                            const u32 chroma_pixel = chroma_row + j / 2;
+                            cb = i32x4 { chroma.cb[chroma_pixel], chroma.cb[chroma_pixel], chroma.cb[chroma_pixel + 1], chroma.cb[chroma_pixel + 1] };
+                            cr = i32x4 { chroma.cr[chroma_pixel], chroma.cr[chroma_pixel], chroma.cr[chroma_pixel + 1], chroma.cr[chroma_pixel + 1] };
+                        }
 
-    for (u32 y = context.frame.height - 1; y < context.frame.height; y--) {
-        const u32 block_row = y / 8;
-        const u32 pixel_row = y % 8;
-        for (u32 x = 0; x < context.frame.width; x++) {
-            const u32 block_column = x / 8;
-            auto& block = macroblocks[block_row * context.mblock_meta.hpadded_count + block_column];
-            const u32 pixel_column = x % 8;
-            const u32 pixel_index = pixel_row * 8 + pixel_column;
-            const Color color { (u8)block.y[pixel_index], (u8)block.cb[pixel_index], (u8)block.cr[pixel_index] };
-            context.bitmap->set_pixel(x, y, color);
+                        // JFIF conversion factors in 16.16 fixed point.
+                        const i32x4 r = luma + ((cr * 91881 + 32768) >> 16);
+                        const i32x4 g = luma + ((32768 - cb * 22554 - cr * 46802) >> 16);
+                        const i32x4 b = luma + ((cb * 116130 + 32768) >> 16);
+
+                        const i32x4 pixels = static_cast<i32>(0xff000000) | (clamp_to_u8(r) << 16) | (clamp_to_u8(g) << 8) | clamp_to_u8(b);
+                        if (block_x + j + 4 <= width) {
+                            __builtin_memcpy(scanline + block_x + j, &pixels, sizeof(pixels));
+                        } else {
+                            for (u32 k = 0; block_x + j + k < width; k++)
+                                scanline[block_x + j + k] = pixels[k];
+                        }
+                    }
+                }
+            }
         }
     }
-
-    return true;
 }
 
 static bool parse_header(InputMemoryStream& stream, JPGLoadingContext& context)
@@ -1225,18 +1255,50 @@ static bool decode_jpg(JPGLoadingContext& context)
     if (!scan_huffman_stream(stream, context))
         return false;
 
-    auto result = decode_huffman_stream(context);
-    if (!result.has_value()) {
-        dbgln_if(JPG_DEBUG, "{}: Failed to decode Macroblocks!", stream.offset());
-        return false;
+    if constexpr (JPG_DEBUG) {
+        dbgln("Image width: {}", context.frame.width);
+        dbgln("Image height: {}", context.frame.height);
+        dbgln("Macroblocks in a row: {}", context.mblock_meta.hpadded_count);
+        dbgln("Macroblocks in a column: {}", context.mblock_meta.vpadded_count);
+        dbgln("Macroblock meta padded total: {}", context.mblock_meta.padded_total);
+    }
+
+    // Compute huffman codes for DC and AC tables.
+    for (auto it = context.dc_tables.begin(); it != context.dc_tables.end(); ++it) {
+        if (!generate_huffman_codes(it->value))
+            return false;
     }
 
-    auto macroblocks = result.release_value();
-    dequantize(context, macroblocks);
-    inverse_dct(context, macroblocks);
-    ycbcr_to_rgb(context, macroblocks);
-    if (!compose_bitmap(context, macroblocks))
+    for (auto it = context.ac_tables.begin(); it != context.ac_tables.end(); ++it) {
+        if (!generate_huffman_codes(it->value))
+            return false;
+    }
+
+    generate_idct_tables(context);
+
+    context.bitmap = Bitmap::create_purgeable(BitmapFormat::BGRx8888, { context.frame.width, context.frame.height });
+    if (!context.bitmap)
         return false;
+
+    // Only one row of MCUs is held at a time: it's turned into pixels as soon as it's been decoded.
+    Vector<Macroblock> macroblocks;
+    macroblocks.resize(context.mblock_meta.hpadded_count * context.vsample_factor);
+
+    for (u32 vcursor = 0; vcursor < context.mblock_meta.vcount; vcursor += context.vsample_factor) {
+        if (!decode_huffman_stream(context, macroblocks, vcursor)) {
+            dbgln_if(JPG_DEBUG, "{}: Failed to decode Macroblocks!", stream.offset());
+            context.bitmap = nullptr;
+            return false;
+        }
+
+        dequantize_and_inverse_dct(context, macroblocks);
+        ycbcr_to_rgb(context, macroblocks, vcursor);
+
+        // Only non-zero coefficients are stored while decoding the next row.
+        for (auto& block : macroblocks)
+            block = {};
+    }
+
     return true;
 }
 
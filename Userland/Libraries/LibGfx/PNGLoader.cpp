@@ -28,6 +28,7 @@
 #include <AK/Endian.h>
 #include <AK/LexicalPath.h>
 #include <AK/MappedFile.h>
+#include <AK/SIMD.h>
 #include <LibCompress/Zlib.h>
 #include <LibGfx/PNGLoader.h>
 #include <fcntl.h>
@@ -45,6 +46,9 @@
 
 namespace Gfx {
 
+using AK::SIMD::i16x4;
+using AK::SIMD::u8x16;
+
 static const u8 png_header[8] = { 0x89, 'P', 'N', 'G', 13, 10, 26, 10 };
 
 struct PNG_IHDR {
@@ -59,11 +63,6 @@ struct PNG_IHDR {
 
 static_assert(sizeof(PNG_IHDR) == 13);
 
-struct Scanline {
-    u8 filter { 0 };
-    ReadonlyBytes data {};
-};
-
 struct [[gnu::packed]] PaletteEntry {
     u8 r;
     u8 g;
@@ -71,27 +70,6 @@ struct [[gnu::packed]] PaletteEntry {
     //u8 a;
 };
 
-template<typename T>
-struct [[gnu::packed]] Tuple {
-    T gray;
-    T a;
-};
-
-template<typename T>
-struct [[gnu::packed]] Triplet {
-    T r;
-    T g;
-    T b;
-};
-
-template<typename T>
-struct [[gnu::packed]] Quad {
-    T r;
-    T g;
-    T b;
-    T a;
-};
-
 enum PngInterlaceMethod {
     Null = 0,
     Adam7 = 1
@@ -119,9 +97,7 @@ struct PNGLoadingContext {
     u8 channels { 0 };
     bool has_seen_zlib_header { false };
     bool has_alpha() const { return color_type & 4 || palette_transparency_data.size() > 0; }
-    Vector<Scanline> scanlines;
     RefPtr<Gfx::Bitmap> bitmap;
-    ByteBuffer decompression_buffer;
     Vector<u8> compressed_data;
     Vector<PaletteEntry> palette_data;
     Vector<u8> palette_transparency_data;
@@ -181,6 +157,7 @@ public:
     }
 
     bool at_end() const { return !m_size_remaining; }
+    size_t remaining_size() const { return m_size_remaining; }
 
 private:
     const u8* m_data_ptr { nullptr };
@@ -222,301 +199,203 @@ ALWAYS_INLINE static u8 paeth_predictor(int a, int b, int c)
     return c;
 }
 
-union [[gnu::packed]] Pixel {
-    RGBA32 rgba { 0 };
-    u8 v[4];
-    struct {
-        u8 r;
-        u8 g;
-        u8 b;
-        u8 a;
-    };
-};
-static_assert(sizeof(Pixel) == 4);
+// The unfilter functions work on the raw bytes of a scanline, and rely on the bytes_per_pixel bytes in front of
+// both the scanline and the previous one being zero, so that the left edge of the image needs no special casing.
 
-template<bool has_alpha, u8 filter_type>
-ALWAYS_INLINE static void unfilter_impl(Gfx::Bitmap& bitmap, int y, const void* dummy_scanline_data)
+static void unfilter_sub(u8* scanline, size_t size, size_t bytes_per_pixel)
 {
-    auto* dummy_scanline = (const Pixel*)dummy_scanline_data;
-    if constexpr (filter_type == 0) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-        }
-    }
+    const u8* left = scanline - bytes_per_pixel;
+    for (size_t i = 0; i < size; ++i)
+        scanline[i] += left[i];
+}
 
-    if constexpr (filter_type == 1) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        swap(pixels[0].r, pixels[0].b);
-        for (int i = 1; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            auto& a = (const Pixel&)pixels[i - 1];
-            x.v[0] += a.v[0];
-            x.v[1] += a.v[1];
-            x.v[2] += a.v[2];
-            if constexpr (has_alpha)
-                x.v[3] += a.v[3];
-        }
-        return;
-    }
-    if constexpr (filter_type == 2) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (const Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            const Pixel& b = pixels_y_minus_1[i];
-            x.v[0] += b.v[0];
-            x.v[1] += b.v[1];
-            x.v[2] += b.v[2];
-            if constexpr (has_alpha)
-                x.v[3] += b.v[3];
-        }
-        return;
-    }
-    if constexpr (filter_type == 3) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (const Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            Pixel a;
-            if (i != 0)
-                a = pixels[i - 1];
-            const Pixel& b = pixels_y_minus_1[i];
-            x.v[0] = x.v[0] + ((a.v[0] + b.v[0]) / 2);
-            x.v[1] = x.v[1] + ((a.v[1] + b.v[1]) / 2);
-            x.v[2] = x.v[2] + ((a.v[2] + b.v[2]) / 2);
-            if constexpr (has_alpha)
-                x.v[3] = x.v[3] + ((a.v[3] + b.v[3]) / 2);
-        }
-        return;
-    }
-    if constexpr (filter_type == 4) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            Pixel a;
-            const Pixel& b = pixels_y_minus_1[i];
-            Pixel c;
-            if (i != 0) {
-                a = pixels[i - 1];
-                c = pixels_y_minus_1[i - 1];
-            }
-            x.v[0] += paeth_predictor(a.v[0], b.v[0], c.v[0]);
-            x.v[1] += paeth_predictor(a.v[1], b.v[1], c.v[1]);
-            x.v[2] += paeth_predictor(a.v[2], b.v[2], c.v[2]);
-            if constexpr (has_alpha)
-                x.v[3] += paeth_predictor(a.v[3], b.v[3], c.v[3]);
-        }
+static void unfilter_up(u8* scanline, const u8* previous_scanline, size_t size)
+{
+    size_t i = 0;
+    for (; i + sizeof(u8x16) <= size; i += sizeof(u8x16)) {
+        u8x16 x, b;
+        memcpy(&x, scanline + i, sizeof(x));
+        memcpy(&b, previous_scanline + i, sizeof(b));
+        x += b;
+        memcpy(scanline + i, &x, sizeof(x));
     }
+    for (; i < size; ++i)
+        scanline[i] += previous_scanline[i];
 }
 
-template<typename T>
-ALWAYS_INLINE static void unpack_grayscale_without_alpha(PNGLoadingContext& context)
+static void unfilter_average(u8* scanline, const u8* previous_scanline, size_t size, size_t bytes_per_pixel)
 {
-    for (int y = 0; y < context.height; ++y) {
-        auto* gray_values = reinterpret_cast<const T*>(context.scanlines[y].data.data());
-        for (int i = 0; i < context.width; ++i) {
-            auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-            pixel.r = gray_values[i];
-            pixel.g = gray_values[i];
-            pixel.b = gray_values[i];
-            pixel.a = 0xff;
-        }
-    }
+    const u8* left = scanline - bytes_per_pixel;
+    for (size_t i = 0; i < size; ++i)
+        scanline[i] += (left[i] + previous_scanline[i]) / 2;
 }
 
-template<typename T>
-ALWAYS_INLINE static void unpack_grayscale_with_alpha(PNGLoadingContext& context)
+static void unfilter_paeth(u8* scanline, const u8* previous_scanline, size_t size, size_t bytes_per_pixel)
 {
-    for (int y = 0; y < context.height; ++y) {
-        auto* tuples = reinterpret_cast<const Tuple<T>*>(context.scanlines[y].data.data());
-        for (int i = 0; i < context.width; ++i) {
-            auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-            pixel.r = tuples[i].gray;
-            pixel.g = tuples[i].gray;
-            pixel.b = tuples[i].gray;
-            pixel.a = tuples[i].a;
-        }
+    const u8* left = scanline - bytes_per_pixel;
+    const u8* upper_left = previous_scanline - bytes_per_pixel;
+    for (size_t i = 0; i < size; ++i)
+        scanline[i] += paeth_predictor(left[i], previous_scanline[i], upper_left[i]);
+}
+
+// For 8-bit RGB and RGBA images, the average and Paeth filters are applied a whole pixel at a time instead:
+// each byte only depends on the same channel of the neighboring pixels, so the channels can go into separate lanes.
+
+template<size_t bytes_per_pixel>
+ALWAYS_INLINE static i16x4 load_pixel(const u8* data)
+{
+    static_assert(bytes_per_pixel == 3 || bytes_per_pixel == 4);
+    if constexpr (bytes_per_pixel == 4)
+        return i16x4 { data[0], data[1], data[2], data[3] };
+    else
+        return i16x4 { data[0], data[1], data[2], 0 };
+}
+
+template<size_t bytes_per_pixel>
+ALWAYS_INLINE static void store_pixel(u8* data, i16x4 pixel)
+{
+    for (size_t i = 0; i < bytes_per_pixel; ++i)
+        data[i] = pixel[i];
+}
+
+ALWAYS_INLINE static i16x4 absolute_value(i16x4 value)
+{
+    i16x4 negative = value < i16x4 {};
+    return (value ^ negative) - negative;
+}
+
+template<size_t bytes_per_pixel>
+static void unfilter_average(u8* scanline, const u8* previous_scanline, size_t size)
+{
+    i16x4 a {};
+    for (size_t i = 0; i < size; i += bytes_per_pixel) {
+        auto b = load_pixel<bytes_per_pixel>(previous_scanline + i);
+        a = (load_pixel<bytes_per_pixel>(scanline + i) + ((a + b) >> 1)) & 0xff;
+        store_pixel<bytes_per_pixel>(scanline + i, a);
     }
 }
 
-template<typename T>
-ALWAYS_INLINE static void unpack_triplets_without_alpha(PNGLoadingContext& context)
+template<size_t bytes_per_pixel>
+static void unfilter_paeth(u8* scanline, const u8* previous_scanline, size_t size)
 {
-    for (int y = 0; y < context.height; ++y) {
-        auto* triplets = reinterpret_cast<const Triplet<T>*>(context.scanlines[y].data.data());
-        for (int i = 0; i < context.width; ++i) {
-            auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-            pixel.r = triplets[i].r;
-            pixel.g = triplets[i].g;
-            pixel.b = triplets[i].b;
-            pixel.a = 0xff;
-        }
+    i16x4 a {};
+    i16x4 c {};
+    for (size_t i = 0; i < size; i += bytes_per_pixel) {
+        auto b = load_pixel<bytes_per_pixel>(previous_scanline + i);
+
+        // With p = a + b - c, these are the distances of p to a, b and c respectively.
+        auto pa = absolute_value(b - c);
+        auto pb = absolute_value(a - c);
+        auto pc = absolute_value(a + b - c - c);
+        i16x4 use_a = (pa <= pb) & (pa <= pc);
+        i16x4 use_b = ~use_a & (pb <= pc);
+        auto predictor = (a & use_a) | (b & use_b) | (c & ~(use_a | use_b));
+
+        a = (load_pixel<bytes_per_pixel>(scanline + i) + predictor) & 0xff;
+        c = b;
+        store_pixel<bytes_per_pixel>(scanline + i, a);
     }
 }
 
-NEVER_INLINE FLATTEN static bool unfilter(PNGLoadingContext& context)
+static void unfilter_scanline(u8 filter, u8* scanline, const u8* previous_scanline, size_t size, size_t bytes_per_pixel)
 {
-    // First unpack the scanlines to RGBA:
-    switch (context.color_type) {
+    switch (filter) {
     case 0:
-        if (context.bit_depth == 8) {
-            unpack_grayscale_without_alpha<u8>(context);
-        } else if (context.bit_depth == 16) {
-            unpack_grayscale_without_alpha<u16>(context);
-        } else if (context.bit_depth == 1 || context.bit_depth == 2 || context.bit_depth == 4) {
-            auto bit_depth_squared = context.bit_depth * context.bit_depth;
-            auto pixels_per_byte = 8 / context.bit_depth;
-            auto mask = (1 << context.bit_depth) - 1;
-            for (int y = 0; y < context.height; ++y) {
-                auto* gray_values = context.scanlines[y].data.data();
-                for (int x = 0; x < context.width; ++x) {
-                    auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (x % pixels_per_byte));
-                    auto value = (gray_values[x / pixels_per_byte] >> bit_offset) & mask;
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[x];
-                    pixel.r = value * (0xff / bit_depth_squared);
-                    pixel.g = value * (0xff / bit_depth_squared);
-                    pixel.b = value * (0xff / bit_depth_squared);
-                    pixel.a = 0xff;
-                }
-            }
-        } else {
-            VERIFY_NOT_REACHED();
-        }
         break;
-    case 4:
-        if (context.bit_depth == 8) {
-            unpack_grayscale_with_alpha<u8>(context);
-        } else if (context.bit_depth == 16) {
-            unpack_grayscale_with_alpha<u16>(context);
-        } else {
-            VERIFY_NOT_REACHED();
-        }
+    case 1:
+        unfilter_sub(scanline, size, bytes_per_pixel);
         break;
     case 2:
-        if (context.bit_depth == 8) {
-            unpack_triplets_without_alpha<u8>(context);
-        } else if (context.bit_depth == 16) {
-            unpack_triplets_without_alpha<u16>(context);
-        } else {
-            VERIFY_NOT_REACHED();
-        }
-        break;
-    case 6:
-        if (context.bit_depth == 8) {
-            for (int y = 0; y < context.height; ++y) {
-                memcpy(context.bitmap->scanline(y), context.scanlines[y].data.data(), context.scanlines[y].data.size());
-            }
-        } else if (context.bit_depth == 16) {
-            for (int y = 0; y < context.height; ++y) {
-                auto* triplets = reinterpret_cast<const Quad<u16>*>(context.scanlines[y].data.data());
-                for (int i = 0; i < context.width; ++i) {
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    pixel.r = triplets[i].r & 0xFF;
-                    pixel.g = triplets[i].g & 0xFF;
-                    pixel.b = triplets[i].b & 0xFF;
-                    pixel.a = triplets[i].a & 0xFF;
-                }
-            }
-        } else {
-            VERIFY_NOT_REACHED();
-        }
+        unfilter_up(scanline, previous_scanline, size);
         break;
     case 3:
-        if (context.bit_depth == 8) {
-            for (int y = 0; y < context.height; ++y) {
-                auto* palette_index = context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    if (palette_index[i] >= context.palette_data.size())
-                        return false;
-                    auto& color = context.palette_data.at((int)palette_index[i]);
-                    auto transparency = context.palette_transparency_data.size() >= palette_index[i] + 1u
-                        ? context.palette_transparency_data.data()[palette_index[i]]
-                        : 0xff;
-                    pixel.r = color.r;
-                    pixel.g = color.g;
-                    pixel.b = color.b;
-                    pixel.a = transparency;
-                }
-            }
-        } else if (context.bit_depth == 1 || context.bit_depth == 2 || context.bit_depth == 4) {
-            auto pixels_per_byte = 8 / context.bit_depth;
-            auto mask = (1 << context.bit_depth) - 1;
-            for (int y = 0; y < context.height; ++y) {
-                auto* palette_indexes = context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (i % pixels_per_byte));
-                    auto palette_index = (palette_indexes[i / pixels_per_byte] >> bit_offset) & mask;
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    if ((size_t)palette_index >= context.palette_data.size())
-                        return false;
-                    auto& color = context.palette_data.at(palette_index);
-                    auto transparency = context.palette_transparency_data.size() >= palette_index + 1u
-                        ? context.palette_transparency_data.data()[palette_index]
-                        : 0xff;
-                    pixel.r = color.r;
-                    pixel.g = color.g;
-                    pixel.b = color.b;
-                    pixel.a = transparency;
-                }
-            }
-        } else {
-            VERIFY_NOT_REACHED();
-        }
+        if (bytes_per_pixel == 4)
+            unfilter_average<4>(scanline, previous_scanline, size);
+        else if (bytes_per_pixel == 3)
+            unfilter_average<3>(scanline, previous_scanline, size);
+        else
+            unfilter_average(scanline, previous_scanline, size, bytes_per_pixel);
+        break;
+    case 4:
+        if (bytes_per_pixel == 4)
+            unfilter_paeth<4>(scanline, previous_scanline, size);
+        else if (bytes_per_pixel == 3)
+            unfilter_paeth<3>(scanline, previous_scanline, size);
+        else
+            unfilter_paeth(scanline, previous_scanline, size, bytes_per_pixel);
         break;
     default:
         VERIFY_NOT_REACHED();
-        break;
     }
+}
 
-    u8 dummy_scanline[context.width * sizeof(RGBA32)];
+ALWAYS_INLINE static RGBA32 make_pixel(u32 r, u32 g, u32 b, u32 a)
+{
+    return a << 24 | r << 16 | g << 8 | b;
+}
 
-    for (int y = 0; y < context.height; ++y) {
-        auto filter = context.scanlines[y].filter;
-        if (filter == 0) {
-            if (context.has_alpha())
-                unfilter_impl<true, 0>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 0>(*context.bitmap, y, dummy_scanline);
-            continue;
-        }
-        if (filter == 1) {
-            if (context.has_alpha())
-                unfilter_impl<true, 1>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 1>(*context.bitmap, y, dummy_scanline);
-            continue;
-        }
-        if (filter == 2) {
-            if (context.has_alpha())
-                unfilter_impl<true, 2>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 2>(*context.bitmap, y, dummy_scanline);
-            continue;
-        }
-        if (filter == 3) {
-            if (context.has_alpha())
-                unfilter_impl<true, 3>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 3>(*context.bitmap, y, dummy_scanline);
-            continue;
+// Converts an unfiltered scanline into pixels, storing them step pixels apart. Samples of 16-bit images are
+// reduced to their most significant byte, which is the first one.
+template<size_t sample_size>
+ALWAYS_INLINE static void unpack_samples(u8 color_type, const u8* data, int width, RGBA32* pixels, int step)
+{
+    auto sample = [&](int index) -> u32 { return data[index * sample_size]; };
+
+    switch (color_type) {
+    case 0:
+        for (int x = 0; x < width; ++x)
+            pixels[x * step] = make_pixel(sample(x), sample(x), sample(x), 0xff);
+        break;
+    case 2:
+        for (int x = 0; x < width; ++x)
+            pixels[x * step] = make_pixel(sample(3 * x), sample(3 * x + 1), sample(3 * x + 2), 0xff);
+        break;
+    case 4:
+        for (int x = 0; x < width; ++x)
+            pixels[x * step] = make_pixel(sample(2 * x), sample(2 * x), sample(2 * x), sample(2 * x + 1));
+        break;
+    case 6:
+        for (int x = 0; x < width; ++x)
+            pixels[x * step] = make_pixel(sample(4 * x), sample(4 * x + 1), sample(4 * x + 2), sample(4 * x + 3));
+        break;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+}
+
+static bool unpack_scanline(const PNGLoadingContext& context, const Vector<RGBA32>& palette, const u8* data, int width, RGBA32* pixels, int step)
+{
+    if (context.bit_depth < 8) {
+        auto pixels_per_byte = 8 / context.bit_depth;
+        auto mask = (1 << context.bit_depth) - 1;
+        for (int x = 0; x < width; ++x) {
+            auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (x % pixels_per_byte));
+            u32 value = (data[x / pixels_per_byte] >> bit_offset) & mask;
+            if (context.color_type == 3) {
+                if (value >= palette.size())
+                    return false;
+                pixels[x * step] = palette[value];
+            } else {
+                auto gray = value * (0xff / mask);
+                pixels[x * step] = make_pixel(gray, gray, gray, 0xff);
+            }
         }
-        if (filter == 4) {
-            if (context.has_alpha())
-                unfilter_impl<true, 4>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 4>(*context.bitmap, y, dummy_scanline);
-            continue;
+        return true;
+    }
+
+    if (context.color_type == 3) {
+        for (int x = 0; x < width; ++x) {
+            if (data[x] >= palette.size())
+                return false;
+            pixels[x * step] = palette[data[x]];
         }
+        return true;
     }
 
+    if (context.bit_depth == 16)
+        unpack_samples<2>(context.color_type, data, width, pixels, step);
+    else
+        unpack_samples<1>(context.color_type, data, width, pixels, step);
     return true;
 }
 
@@ -601,45 +480,6 @@ static bool decode_png_chunks(PNGLoadingContext& context)
     return true;
 }
 
-static bool decode_png_bitmap_simple(PNGLoadingContext& context)
-{
-    Streamer streamer(context.decompression_buffer.data(), context.decompression_buffer.size());
-
-    for (int y = 0; y < context.height; ++y) {
-        u8 filter;
-        if (!streamer.read(filter)) {
-            context.state = PNGLoadingContext::State::Error;
-            return false;
-        }
-
-        if (filter > 4) {
-            dbgln_if(PNG_DEBUG, "Invalid PNG filter: {}", filter);
-            context.state = PNGLoadingContext::State::Error;
-            return false;
-        }
-
-        context.scanlines.append({ filter });
-        auto& scanline_buffer = context.scanlines.last().data;
-        auto row_size = context.compute_row_size_for_width(context.width);
-        if (row_size.has_overflow())
-            return false;
-
-        if (!streamer.wrap_bytes(scanline_buffer, row_size.value())) {
-            context.state = PNGLoadingContext::State::Error;
-            return false;
-        }
-    }
-
-    context.bitmap = Bitmap::create_purgeable(context.has_alpha() ? BitmapFormat::BGRA8888 : BitmapFormat::BGRx8888, { context.width, context.height });
-
-    if (!context.bitmap) {
-        context.state = PNGLoadingContext::State::Error;
-        return false;
-    }
-
-    return unfilter(context);
-}
-
 static int adam7_height(PNGLoadingContext& context, int pass)
 {
     switch (pass) {
@@ -690,75 +530,122 @@ static int adam7_startx[8] = { 0, 0, 4, 0, 2, 0, 1, 0 };
 static int adam7_stepy[8] = { 1, 8, 8, 8, 4, 4, 2, 2 };
 static int adam7_stepx[8] = { 1, 8, 8, 4, 4, 2, 2, 1 };
 
-static bool decode_adam7_pass(PNGLoadingContext& context, Streamer& streamer, int pass)
+// Takes the inflated image data piece by piece, and unfilters every scanline as soon as all of its bytes have arrived,
+// storing its pixels straight into the bitmap. Only the current and the previous scanline are kept around.
+class ScanlineDecoder {
+public:
+    explicit ScanlineDecoder(PNGLoadingContext&);
+
+    IterationDecision append(ReadonlyBytes);
+
+    bool is_complete() const { return m_pass > m_last_pass; }
+    bool has_decoded_any_scanlines() const { return m_decoded_scanlines > 0; }
+
+private:
+    void start_pass(int pass);
+    bool decode_scanline();
+
+    PNGLoadingContext& m_context;
+    Vector<RGBA32> m_palette;
+    size_t m_bytes_per_pixel { 0 };
+
+    // Pass 0 stands for the whole of a non-interlaced image, passes 1 to 7 are the Adam7 ones.
+    int m_pass { 0 };
+    int m_last_pass { 0 };
+    int m_pass_width { 0 };
+    int m_pass_height { 0 };
+    int m_y { 0 };
+    int m_decoded_scanlines { 0 };
+
+    ByteBuffer m_scanline_buffer;
+    u8* m_scanline { nullptr };
+    u8* m_previous_scanline { nullptr };
+    size_t m_scanline_size { 0 };
+    size_t m_received_size { 0 };
+    u8 m_filter { 0 };
+};
+
+ScanlineDecoder::ScanlineDecoder(PNGLoadingContext& context)
+    : m_context(context)
+    , m_bytes_per_pixel(max(1, context.channels * context.bit_depth / 8))
+    , m_last_pass(context.interlace_method == PngInterlaceMethod::Adam7 ? 7 : 0)
 {
-    PNGLoadingContext subimage_context;
-    subimage_context.width = adam7_width(context, pass);
-    subimage_context.height = adam7_height(context, pass);
-    subimage_context.channels = context.channels;
-    subimage_context.color_type = context.color_type;
-    subimage_context.palette_data = context.palette_data;
-    subimage_context.palette_transparency_data = context.palette_transparency_data;
-    subimage_context.bit_depth = context.bit_depth;
-    subimage_context.filter_method = context.filter_method;
-
-    // For small images, some passes might be empty
-    if (!subimage_context.width || !subimage_context.height)
-        return true;
+    for (size_t i = 0; i < context.palette_data.size(); ++i) {
+        auto& color = context.palette_data[i];
+        auto alpha = i < context.palette_transparency_data.size() ? context.palette_transparency_data[i] : 0xff;
+        m_palette.append(make_pixel(color.r, color.g, color.b, alpha));
+    }
 
-    subimage_context.scanlines.clear_with_capacity();
-    for (int y = 0; y < subimage_context.height; ++y) {
-        u8 filter;
-        if (!streamer.read(filter)) {
-            context.state = PNGLoadingContext::State::Error;
-            return false;
-        }
+    // Room for two scanlines of the full width, each preceded by a pixel's worth of zeros.
+    auto maximum_scanline_size = context.compute_row_size_for_width(context.width).value();
+    m_scanline_buffer = ByteBuffer::create_zeroed(2 * (m_bytes_per_pixel + maximum_scanline_size));
+    m_scanline = m_scanline_buffer.offset_pointer(m_bytes_per_pixel);
+    m_previous_scanline = m_scanline + maximum_scanline_size + m_bytes_per_pixel;
 
-        if (filter > 4) {
-            dbgln_if(PNG_DEBUG, "Invalid PNG filter: {}", filter);
-            context.state = PNGLoadingContext::State::Error;
-            return false;
-        }
+    start_pass(context.interlace_method == PngInterlaceMethod::Adam7 ? 1 : 0);
+}
 
-        subimage_context.scanlines.append({ filter });
-        auto& scanline_buffer = subimage_context.scanlines.last().data;
+void ScanlineDecoder::start_pass(int pass)
+{
+    for (m_pass = pass; m_pass <= m_last_pass; ++m_pass) {
+        m_pass_width = m_pass ? adam7_width(m_context, m_pass) : m_context.width;
+        m_pass_height = m_pass ? adam7_height(m_context, m_pass) : m_context.height;
 
-        auto row_size = context.compute_row_size_for_width(subimage_context.width);
-        if (row_size.has_overflow())
-            return false;
-        if (!streamer.wrap_bytes(scanline_buffer, row_size.value())) {
-            context.state = PNGLoadingContext::State::Error;
-            return false;
-        }
+        // For small images, some passes might be empty, in which case they don't even have filter bytes.
+        if (m_pass_width && m_pass_height)
+            break;
     }
 
-    subimage_context.bitmap = Bitmap::create(context.bitmap->format(), { subimage_context.width, subimage_context.height });
-    if (!unfilter(subimage_context)) {
-        subimage_context.bitmap = nullptr;
+    m_y = 0;
+    m_scanline_size = m_context.compute_row_size_for_width(m_pass_width).value();
+    memset(m_previous_scanline, 0, m_scanline_size);
+}
+
+bool ScanlineDecoder::decode_scanline()
+{
+    if (m_filter > 4) {
+        dbgln_if(PNG_DEBUG, "Invalid PNG filter: {}", m_filter);
         return false;
     }
 
-    // Copy the subimage data into the main image according to the pass pattern
-    for (int y = 0, dy = adam7_starty[pass]; y < subimage_context.height && dy < context.height; ++y, dy += adam7_stepy[pass]) {
-        for (int x = 0, dx = adam7_startx[pass]; x < subimage_context.width && dy < context.width; ++x, dx += adam7_stepx[pass]) {
-            context.bitmap->set_pixel(dx, dy, subimage_context.bitmap->get_pixel(x, y));
-        }
-    }
+    unfilter_scanline(m_filter, m_scanline, m_previous_scanline, m_scanline_size, m_bytes_per_pixel);
+
+    auto y = adam7_starty[m_pass] + m_y * adam7_stepy[m_pass];
+    auto* pixels = m_context.bitmap->scanline(y) + adam7_startx[m_pass];
+    if (!unpack_scanline(m_context, m_palette, m_scanline, m_pass_width, pixels, adam7_stepx[m_pass]))
+        return false;
+
+    ++m_decoded_scanlines;
+    swap(m_scanline, m_previous_scanline);
+    if (++m_y == m_pass_height)
+        start_pass(m_pass + 1);
     return true;
 }
 
-static bool decode_png_adam7(PNGLoadingContext& context)
+IterationDecision ScanlineDecoder::append(ReadonlyBytes bytes)
 {
-    Streamer streamer(context.decompression_buffer.data(), context.decompression_buffer.size());
-    context.bitmap = Bitmap::create_purgeable(context.has_alpha() ? BitmapFormat::BGRA8888 : BitmapFormat::BGRx8888, { context.width, context.height });
-    if (!context.bitmap)
-        return false;
+    while (!bytes.is_empty() && !is_complete()) {
+        if (m_received_size == 0) {
+            m_filter = bytes[0];
+            bytes = bytes.slice(1);
+            m_received_size = 1;
+            continue;
+        }
 
-    for (int pass = 1; pass <= 7; ++pass) {
-        if (!decode_adam7_pass(context, streamer, pass))
-            return false;
+        auto count = min(bytes.size(), m_scanline_size + 1 - m_received_size);
+        memcpy(m_scanline + m_received_size - 1, bytes.data(), count);
+        bytes = bytes.slice(count);
+        m_received_size += count;
+
+        if (m_received_size == m_scanline_size + 1) {
+            m_received_size = 0;
+            if (!decode_scanline())
+                return IterationDecision::Break;
+        }
     }
-    return true;
+
+    // Anything after the last scanline is of no interest to us.
+    return is_complete() ? IterationDecision::Break : IterationDecision::Continue;
 }
 
 static bool decode_png_bitmap(PNGLoadingContext& context)
@@ -777,31 +664,32 @@ static bool decode_png_bitmap(PNGLoadingContext& context)
     if (context.color_type == 3 && context.palette_data.is_empty())
         return false; // Didn't see a PLTE chunk for a palettized image, or it was empty.
 
-    auto result = Compress::Zlib::decompress_all(context.compressed_data.span());
-    if (!result.has_value()) {
+    if (context.compute_row_size_for_width(context.width).has_overflow())
+        return false;
+
+    context.bitmap = Bitmap::create_purgeable(context.has_alpha() ? BitmapFormat::BGRA8888 : BitmapFormat::BGRx8888, { context.width, context.height });
+    if (!context.bitmap) {
         context.state = PNGLoadingContext::State::Error;
         return false;
     }
-    context.decompression_buffer = result.value();
+
+    // The image data is unfiltered as it is being inflated, so it never has to be held in memory as a whole.
+    ScanlineDecoder decoder { context };
+    Compress::Zlib::decompress_all(context.compressed_data.span(), [&](ReadonlyBytes bytes) {
+        return decoder.append(bytes);
+    });
     context.compressed_data.clear();
 
-    context.scanlines.ensure_capacity(context.height);
-    switch (context.interlace_method) {
-    case PngInterlaceMethod::Null:
-        if (!decode_png_bitmap_simple(context))
-            return false;
-        break;
-    case PngInterlaceMethod::Adam7:
-        if (!decode_png_adam7(context))
+    if (!decoder.is_complete()) {
+        // Truncated (or partially corrupted) images keep the scanlines that could be decoded, the rest stays transparent.
+        if (!decoder.has_decoded_any_scanlines()) {
+            context.bitmap = nullptr;
+            context.state = PNGLoadingContext::State::Error;
             return false;
-        break;
-    default:
-        context.state = PNGLoadingContext::State::Error;
-        return false;
+        }
+        dbgln_if(PNG_DEBUG, "PNG image data ended early, only part of the image could be decoded");
     }
 
-    context.decompression_buffer.clear();
-
     context.state = PNGLoadingContext::State::BitmapDecoded;
     return true;
 }
@@ -951,6 +839,9 @@ static bool process_chunk(Streamer& streamer, PNGLoadingContext& context)
 #if PNG_DEBUG
         printf("Bail at chunk_data\n");
 #endif
+        // Whatever there is of the image data in a truncated file still makes for a partial image.
+        if (!strcmp((const char*)chunk_type, "IDAT") && streamer.wrap_bytes(chunk_data, streamer.remaining_size()))
+            process_IDAT(chunk_data, context);
         return false;
     }
     u32 chunk_crc;
@@ -958,6 +849,8 @@ static bool process_chunk(Streamer& streamer, PNGLoadingContext& context)
 #if PNG_DEBUG
         printf("Bail at chunk_crc\n");
 #endif
+        if (!strcmp((const char*)chunk_type, "IDAT"))
+            process_IDAT(chunk_data, context);
         return false;
     }
 #if PNG_DEBUG
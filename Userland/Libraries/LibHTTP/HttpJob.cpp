@@ -33,9 +33,23 @@
 
 namespace HTTP {
 void HttpJob::start()
+{
+    start(Core::TCPSocket::construct(this));
+}
+
+void HttpJob::start(NonnullRefPtr<Core::TCPSocket> socket)
 {
     VERIFY(!m_socket);
-    m_socket = Core::TCPSocket::construct(this);
+    m_socket = move(socket);
+    if (m_socket->is_connected()) {
+        dbgln_if(CHTTPJOB_DEBUG, "HttpJob: Reusing existing connection");
+        m_is_reusing_connection = true;
+        deferred_invoke([this](auto&) {
+            if (m_socket)
+                on_socket_connected();
+        });
+        return;
+    }
     m_socket->on_connected = [this] {
 #if CHTTPJOB_DEBUG
         dbgln("HttpJob: on_connected callback");
@@ -56,8 +70,22 @@ void HttpJob::shutdown()
         return;
     m_socket->on_ready_to_read = nullptr;
     m_socket->on_connected = nullptr;
-    remove_child(*m_socket);
+    if (m_socket->parent() == this)
+        remove_child(*m_socket);
+    bool reusable = can_reuse_connection();
     m_socket = nullptr;
+    if (on_socket_released)
+        on_socket_released(reusable);
+}
+
+void HttpJob::restart_on_fresh_connection()
+{
+    if (!m_socket)
+        return;
+    // Handing back the socket tells whoever gave it to us that it's dead. The fresh socket is our own.
+    shutdown();
+    on_socket_released = nullptr;
+    start();
 }
 
 void HttpJob::register_on_ready_to_read(Function<void()> callback)
@@ -38,6 +38,8 @@ namespace HTTP {
 class HttpJob final : public Job {
     C_OBJECT(HttpJob)
 public:
+    using SocketType = Core::TCPSocket;
+
     explicit HttpJob(const HttpRequest& request, OutputStream& output_stream)
         : Job(request, output_stream)
     {
@@ -50,6 +52,9 @@ public:
     virtual void start() override;
     virtual void shutdown() override;
 
+    // Runs the job over the given socket, which may already be connected from a previous request.
+    void start(NonnullRefPtr<Core::TCPSocket>);
+
 protected:
     virtual bool should_fail_on_empty_payload() const override { return false; }
     virtual void register_on_ready_to_read(Function<void()>) override;
@@ -61,6 +66,7 @@ protected:
     virtual bool eof() const override;
     virtual bool write(ReadonlyBytes) override;
     virtual bool is_established() const override { return true; }
+    virtual void restart_on_fresh_connection() override;
 
 private:
     RefPtr<Core::Socket> m_socket;
@@ -35,16 +35,14 @@
 namespace HTTP {
 
 void HttpsJob::start()
+{
+    start(TLS::TLSv12::construct(this));
+}
+
+void HttpsJob::start(NonnullRefPtr<TLS::TLSv12> socket)
 {
     VERIFY(!m_socket);
-    m_socket = TLS::TLSv12::construct(this);
-    m_socket->set_root_certificates(m_override_ca_certificates ? *m_override_ca_certificates : DefaultRootCACertificates::the().certificates());
-    m_socket->on_tls_connected = [this] {
-#if HTTPSJOB_DEBUG
-        dbgln("HttpsJob: on_connected callback");
-#endif
-        on_socket_connected();
-    };
+    m_socket = move(socket);
     m_socket->on_tls_error = [&](TLS::AlertDescription error) {
         if (error == TLS::AlertDescription::HandshakeFailure) {
             deferred_invoke([this](auto&) {
@@ -52,18 +50,42 @@ void HttpsJob::start()
             });
         } else if (error == TLS::AlertDescription::DecryptError) {
             deferred_invoke([this](auto&) {
-                return did_fail(Core::NetworkJob::Error::ConnectionFailed);
+                return fail_or_retry_on_fresh_connection(Core::NetworkJob::Error::ConnectionFailed);
             });
         } else {
             deferred_invoke([this](auto&) {
-                return did_fail(Core::NetworkJob::Error::TransmissionFailed);
+                return fail_or_retry_on_fresh_connection(Core::NetworkJob::Error::TransmissionFailed);
             });
         }
     };
     m_socket->on_tls_finished = [&] {
+        if (can_retry_on_fresh_connection()) {
+            deferred_invoke([this](auto&) {
+                return fail_or_retry_on_fresh_connection(Core::NetworkJob::Error::ConnectionFailed);
+            });
+            return;
+        }
         finish_up();
     };
+    if (m_socket->is_established()) {
+        dbgln_if(HTTPSJOB_DEBUG, "HttpsJob: Reusing existing connection");
+        m_is_reusing_connection = true;
+        deferred_invoke([this](auto&) {
+            if (m_socket)
+                on_socket_connected();
+        });
+        return;
+    }
+    m_socket->set_root_certificates(m_override_ca_certificates ? *m_override_ca_certificates : DefaultRootCACertificates::the().certificates());
+    m_socket->on_tls_connected = [this] {
+#if HTTPSJOB_DEBUG
+        dbgln("HttpsJob: on_connected callback");
+#endif
+        on_socket_connected();
+    };
     m_socket->on_tls_certificate_request = [this](auto&) {
+        // Whatever identity we answer with stays attached to the connection, so it must not be handed to other jobs.
+        m_client_certificate_requested = true;
         if (on_certificate_requested)
             on_certificate_requested(*this);
     };
@@ -80,9 +102,27 @@ void HttpsJob::shutdown()
     if (!m_socket)
         return;
     m_socket->on_tls_ready_to_read = nullptr;
+    m_socket->on_tls_ready_to_write = nullptr;
     m_socket->on_tls_connected = nullptr;
-    remove_child(*m_socket);
+    m_socket->on_tls_error = nullptr;
+    m_socket->on_tls_finished = nullptr;
+    m_socket->on_tls_certificate_request = nullptr;
+    if (m_socket->parent() == this)
+        remove_child(*m_socket);
+    bool reusable = can_reuse_connection() && !m_client_certificate_requested;
     m_socket = nullptr;
+    if (on_socket_released)
+        on_socket_released(reusable);
+}
+
+void HttpsJob::restart_on_fresh_connection()
+{
+    if (!m_socket)
+        return;
+    // Handing back the socket tells whoever gave it to us that it's dead. The fresh socket is our own.
+    shutdown();
+    on_socket_released = nullptr;
+    start();
 }
 
 void HttpsJob::set_certificate(String certificate, String private_key)
@@ -114,6 +154,13 @@ void HttpsJob::register_on_ready_to_write(Function<void()> callback)
     m_socket->on_tls_ready_to_write = [callback = move(callback)](auto&) {
         callback();
     };
+    if (m_socket->is_established()) {
+        // A reused connection won't go through the handshake again, so nothing else would tell us it's writable.
+        deferred_invoke([this](auto&) {
+            if (m_socket && m_socket->on_tls_ready_to_write)
+                m_socket->on_tls_ready_to_write(*m_socket);
+        });
+    }
 }
 
 bool HttpsJob::can_read_line() const
@@ -38,6 +38,8 @@ namespace HTTP {
 class HttpsJob final : public Job {
     C_OBJECT(HttpsJob)
 public:
+    using SocketType = TLS::TLSv12;
+
     explicit HttpsJob(const HttpRequest& request, OutputStream& output_stream, const Vector<Certificate>* override_certs = nullptr)
         : Job(request, output_stream)
         , m_override_ca_certificates(override_certs)
@@ -50,8 +52,14 @@ public:
 
     virtual void start() override;
     virtual void shutdown() override;
+
+    // Runs the job over the given socket, which may already be established from a previous request.
+    void start(NonnullRefPtr<TLS::TLSv12>);
     void set_certificate(String certificate, String key);
 
+    // Connections made with other root certificates can't be shared with jobs that use the default ones.
+    bool overrides_ca_certificates() const { return m_override_ca_certificates; }
+
     Function<void(HttpsJob&)> on_certificate_requested;
 
 protected:
@@ -66,10 +74,12 @@ protected:
     virtual bool is_established() const override { return m_socket->is_established(); }
     virtual bool should_fail_on_empty_payload() const override { return false; }
     virtual void read_while_data_available(Function<IterationDecision()>) override;
+    virtual void restart_on_fresh_connection() override;
 
 private:
     RefPtr<TLS::TLSv12> m_socket;
     const Vector<Certificate>* m_override_ca_certificates { nullptr };
+    bool m_client_certificate_requested { false };
 };
 
 }
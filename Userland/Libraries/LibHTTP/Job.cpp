@@ -137,25 +137,29 @@ void Job::on_socket_connected()
 
         bool success = write(raw_request);
         if (!success)
-            deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::TransmissionFailed); });
+            deferred_invoke([this](auto&) { fail_or_retry_on_fresh_connection(Core::NetworkJob::Error::TransmissionFailed); });
     });
     register_on_ready_to_read([&] {
         if (is_cancelled())
             return;
 
         if (m_state == State::Finished) {
-            // This is probably just a EOF notification, which means we should receive nothing
-            // and then get eof() == true.
-            [[maybe_unused]] auto payload = receive(64);
-            // These assertions are only correct if "Connection: close".
-            VERIFY(payload.is_empty());
-            VERIFY(eof());
+            // This is either an EOF notification, or the server sending something we never asked for.
+            // Either way, the connection can't be used for another request after this.
+            auto payload = receive(64);
+            if (!payload.is_empty())
+                dbgln_if(JOB_DEBUG, "Job: Discarding {} unexpected bytes after the response", payload.size());
+            m_should_keep_alive = false;
             return;
         }
 
         if (m_state == State::InStatus) {
-            if (!can_read_line())
+            if (!can_read_line()) {
+                // A reused connection may have been closed by the server before it saw our request.
+                if (eof())
+                    return deferred_invoke([this](auto&) { fail_or_retry_on_fresh_connection(Core::NetworkJob::Error::ConnectionFailed); });
                 return;
+            }
             auto line = read_line(PAGE_SIZE);
             if (line.is_null()) {
                 fprintf(stderr, "Job: Expected HTTP status\n");
@@ -172,6 +176,8 @@ void Job::on_socket_connected()
                 return deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::ProtocolFailed); });
             }
             m_code = code.value();
+            // HTTP/1.1 connections are persistent unless either side says otherwise.
+            m_should_keep_alive = parts[0] == "HTTP/1.1";
             m_state = State::InHeaders;
             return;
         }
@@ -196,6 +202,18 @@ void Job::on_socket_connected()
                     if (on_headers_received)
                         on_headers_received(m_headers, m_code > 0 ? m_code : Optional<u32> {});
                     m_state = State::InBody;
+
+                    auto content_length = m_headers.get("Content-Length");
+                    auto transfer_encoding = m_headers.get("Transfer-Encoding");
+                    bool is_chunked = transfer_encoding.has_value() && transfer_encoding.value().equals_ignoring_case("chunked");
+                    if (m_code == 204 || m_code == 304 || (!is_chunked && content_length.has_value() && content_length.value().to_uint().value_or(1) == 0)) {
+                        // There is no body to wait for, and nothing to tell us that unless we look.
+                        return finish_up();
+                    }
+                    if (!is_chunked && !content_length.has_value()) {
+                        // The body only ends when the server closes the connection.
+                        m_should_keep_alive = false;
+                    }
                 }
                 return;
             }
@@ -223,6 +241,12 @@ void Job::on_socket_connected()
             }
             auto value = line.substring(name.length() + 2, line.length() - name.length() - 2);
             m_headers.set(name, value);
+            if (name.equals_ignoring_case("Connection")) {
+                if (value.equals_ignoring_case("close"))
+                    m_should_keep_alive = false;
+                else if (value.equals_ignoring_case("keep-alive"))
+                    m_should_keep_alive = true;
+            }
             if (name.equals_ignoring_case("Content-Encoding")) {
                 // Assume that any content-encoding means that we can't decode it as a stream :(
                 dbgln_if(JOB_DEBUG, "Content-Encoding {} detected, cannot stream output :(", value);
@@ -366,6 +390,22 @@ void Job::on_socket_connected()
     });
 }
 
+void Job::fail_or_retry_on_fresh_connection(Core::NetworkJob::Error error)
+{
+    if (!can_retry_on_fresh_connection())
+        return did_fail(error);
+
+    dbgln_if(JOB_DEBUG, "Job: Reused connection failed before the response started, retrying on a fresh one");
+    m_is_reusing_connection = false;
+    m_sent_data = false;
+    restart_on_fresh_connection();
+}
+
+bool Job::can_reuse_connection() const
+{
+    return m_state == State::Finished && m_should_keep_alive && m_buffered_size == 0 && !eof() && is_established();
+}
+
 void Job::finish_up()
 {
     m_state = State::Finished;
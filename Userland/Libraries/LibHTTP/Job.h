@@ -47,9 +47,20 @@ public:
     HttpResponse* response() { return static_cast<HttpResponse*>(Core::NetworkJob::response()); }
     const HttpResponse* response() const { return static_cast<const HttpResponse*>(Core::NetworkJob::response()); }
 
+    // Whether the connection this job used can carry another request once the job is done with it.
+    bool can_reuse_connection() const;
+
+    // Called when the job lets go of its socket, which is then free to be handed to another job.
+    Function<void(bool can_reuse_connection)> on_socket_released;
+
 protected:
     void finish_up();
     void on_socket_connected();
+    // A server may close an idle connection just as we reuse it, so until the response starts,
+    // a failure on a reused connection gets one more try on a fresh one.
+    bool can_retry_on_fresh_connection() const { return m_is_reusing_connection && m_state == State::InStatus; }
+    void fail_or_retry_on_fresh_connection(Core::NetworkJob::Error);
+    virtual void restart_on_fresh_connection() = 0;
     void flush_received_buffers();
     virtual void register_on_ready_to_read(Function<void()>) = 0;
     virtual void register_on_ready_to_write(Function<void()>) = 0;
@@ -82,6 +93,8 @@ protected:
     Optional<ssize_t> m_current_chunk_remaining_size;
     Optional<size_t> m_current_chunk_total_size;
     bool m_can_stream_response { true };
+    bool m_should_keep_alive { false };
+    bool m_is_reusing_connection { false };
 };
 
 }
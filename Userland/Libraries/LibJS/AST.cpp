@@ -33,6 +33,7 @@
 #include <AK/TemporaryChange.h>
 #include <LibCrypto/BigInt/SignedBigInteger.h>
 #include <LibJS/AST.h>
+#include <LibJS/Bytecode/Executable.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Runtime/Accessor.h>
 #include <LibJS/Runtime/Array.h>
@@ -99,6 +100,21 @@ static String get_function_name(GlobalObject& global_object, Value value)
     return value.to_string(global_object);
 }
 
+ScopeNode::ScopeNode(SourceRange source_range)
+    : Statement(move(source_range))
+{
+}
+
+ScopeNode::~ScopeNode()
+{
+}
+
+void ScopeNode::set_function_executable(NonnullOwnPtr<Bytecode::Executable> executable) const
+{
+    VERIFY(!m_function_executable);
+    m_function_executable = move(executable);
+}
+
 Value ScopeNode::execute(Interpreter& interpreter, GlobalObject& global_object) const
 {
     InterpreterNodeScope node_scope { interpreter, *this };
@@ -162,12 +178,34 @@ CallExpression::ThisAndCallee CallExpression::compute_this_and_callee(Interprete
         auto property_name = member_expression.computed_property_name(interpreter, global_object);
         if (!property_name.is_valid())
             return {};
-        auto callee = lookup_target.to_object(global_object)->get(property_name).value_or(js_undefined());
+        auto* lookup_object = lookup_target.to_object(global_object);
+        Value callee;
+        if (member_expression.is_computed())
+            callee = lookup_object->get(property_name).value_or(js_undefined());
+        else
+            callee = lookup_object->get_with_cache(property_name, member_expression.lookup_cache()).value_or(js_undefined());
         return { this_value, callee };
     }
     return { &global_object, m_callee->execute(interpreter, global_object) };
 }
 
+void CallExpression::throw_type_error_for_callee(GlobalObject& global_object, Value callee) const
+{
+    auto& vm = global_object.vm();
+    auto call_type = is<NewExpression>(*this) ? "constructor" : "function";
+    if (is<Identifier>(*m_callee) || is<MemberExpression>(*m_callee)) {
+        String expression_string;
+        if (is<Identifier>(*m_callee)) {
+            expression_string = static_cast<const Identifier&>(*m_callee).string();
+        } else {
+            expression_string = static_cast<const MemberExpression&>(*m_callee).to_string_approximation();
+        }
+        vm.throw_exception<TypeError>(global_object, ErrorType::IsNotAEvaluatedFrom, callee.to_string_without_side_effects(), call_type, expression_string);
+    } else {
+        vm.throw_exception<TypeError>(global_object, ErrorType::IsNotA, callee.to_string_without_side_effects(), call_type);
+    }
+}
+
 Value CallExpression::execute(Interpreter& interpreter, GlobalObject& global_object) const
 {
     InterpreterNodeScope node_scope { interpreter, *this };
@@ -180,19 +218,7 @@ Value CallExpression::execute(Interpreter& interpreter, GlobalObject& global_obj
 
     if (!callee.is_function()
         || (is<NewExpression>(*this) && (is<NativeFunction>(callee.as_object()) && !static_cast<NativeFunction&>(callee.as_object()).has_constructor()))) {
-        String error_message;
-        auto call_type = is<NewExpression>(*this) ? "constructor" : "function";
-        if (is<Identifier>(*m_callee) || is<MemberExpression>(*m_callee)) {
-            String expression_string;
-            if (is<Identifier>(*m_callee)) {
-                expression_string = static_cast<const Identifier&>(*m_callee).string();
-            } else {
-                expression_string = static_cast<const MemberExpression&>(*m_callee).to_string_approximation();
-            }
-            vm.throw_exception<TypeError>(global_object, ErrorType::IsNotAEvaluatedFrom, callee.to_string_without_side_effects(), call_type, expression_string);
-        } else {
-            vm.throw_exception<TypeError>(global_object, ErrorType::IsNotA, callee.to_string_without_side_effects(), call_type);
-        }
+        throw_type_error_for_callee(global_object, callee);
         return {};
     }
 
@@ -666,7 +692,10 @@ Reference MemberExpression::to_reference(Interpreter& interpreter, GlobalObject&
     auto property_name = computed_property_name(interpreter, global_object);
     if (!property_name.is_valid())
         return {};
-    return { object_value, property_name };
+    Reference reference { object_value, property_name };
+    if (!m_computed)
+        reference.set_put_cache(&put_cache());
+    return reference;
 }
 
 Value UnaryExpression::execute(Interpreter& interpreter, GlobalObject& global_object) const
@@ -1734,9 +1763,25 @@ Value MemberExpression::execute(Interpreter& interpreter, GlobalObject& global_o
     auto property_name = computed_property_name(interpreter, global_object);
     if (!property_name.is_valid())
         return {};
+    if (!m_computed)
+        return object_result->get_with_cache(property_name, lookup_cache()).value_or(js_undefined());
     return object_result->get(property_name).value_or(js_undefined());
 }
 
+PropertyLookupCache& MemberExpression::lookup_cache() const
+{
+    if (!m_lookup_cache)
+        m_lookup_cache = make<PropertyLookupCache>();
+    return *m_lookup_cache;
+}
+
+PropertyLookupCache& MemberExpression::put_cache() const
+{
+    if (!m_put_cache)
+        m_put_cache = make<PropertyLookupCache>();
+    return *m_put_cache;
+}
+
 void MetaProperty::dump(int indent) const
 {
     String name;
@@ -0,0 +1,706 @@
+/*
+ * Copyright (c) 2021, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibJS/AST.h>
+#include <LibJS/Bytecode/Generator.h>
+#include <LibJS/Bytecode/Op.h>
+#include <LibJS/Bytecode/Register.h>
+
+namespace JS {
+
+Optional<Bytecode::Register> ASTNode::generate_bytecode(Bytecode::Generator& generator) const
+{
+    // Nodes we don't know how to compile yet are run by the AST interpreter, which shares all of its state with the bytecode.
+    auto dst = generator.allocate_register();
+    if (is<Expression>(*this)) {
+        generator.emit<Bytecode::Op::EvaluateExpression>(dst, static_cast<const Expression&>(*this));
+        return dst;
+    }
+    VERIFY(is<Statement>(*this));
+    generator.emit<Bytecode::Op::ExecuteStatement>(dst, static_cast<const Statement&>(*this), generator.current_unwind_table());
+    return dst;
+}
+
+Optional<Bytecode::Register> ScopeNode::generate_bytecode(Bytecode::Generator& generator) const
+{
+    if (label().is_null()) {
+        generator.generate_scope(*this, ScopeType::Block);
+        return {};
+    }
+
+    auto& end_block = generator.make_block("labelled.end");
+    generator.begin_jump_scope(label(), Bytecode::Label { end_block }, {});
+    generator.generate_scope(*this, ScopeType::Block);
+    generator.end_jump_scope();
+    if (!generator.is_current_block_terminated())
+        generator.emit<Bytecode::Op::Jump>(Bytecode::Label { end_block });
+    generator.switch_to_basic_block(end_block);
+    return {};
+}
+
+Optional<Bytecode::Register> EmptyStatement::generate_bytecode(Bytecode::Generator&) const
+{
+    return {};
+}
+
+Optional<Bytecode::Register> ExpressionStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    return generator.generate_expression(m_expression);
+}
+
+Optional<Bytecode::Register> FunctionDeclaration::generate_bytecode(Bytecode::Generator&) const
+{
+    // Function declarations are hoisted when their scope is entered.
+    return {};
+}
+
+Optional<Bytecode::Register> ReturnStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    Optional<Bytecode::Register> value;
+    if (m_argument) {
+        value = generator.generate_expression(*m_argument);
+    } else {
+        value = generator.allocate_register();
+        generator.emit<Bytecode::Op::LoadImmediate>(*value, js_undefined());
+    }
+    generator.emit<Bytecode::Op::Return>(*value);
+    return {};
+}
+
+Optional<Bytecode::Register> IfStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto predicate = generator.generate_expression(m_predicate);
+    auto& consequent_block = generator.make_block("if.then");
+    auto& end_block = generator.make_block("if.end");
+    auto& alternate_block = m_alternate ? generator.make_block("if.else") : end_block;
+    generator.emit<Bytecode::Op::JumpConditional>(predicate, Bytecode::Label { consequent_block }, Bytecode::Label { alternate_block });
+
+    generator.switch_to_basic_block(consequent_block);
+    generator.generate_statement(m_consequent);
+    if (!generator.is_current_block_terminated())
+        generator.emit<Bytecode::Op::Jump>(Bytecode::Label { end_block });
+
+    if (m_alternate) {
+        generator.switch_to_basic_block(alternate_block);
+        generator.generate_statement(*m_alternate);
+        if (!generator.is_current_block_terminated())
+            generator.emit<Bytecode::Op::Jump>(Bytecode::Label { end_block });
+    }
+
+    generator.switch_to_basic_block(end_block);
+    return {};
+}
+
+Optional<Bytecode::Register> WhileStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto& test_block = generator.make_block("while.test");
+    auto& body_block = generator.make_block("while.body");
+    auto& end_block = generator.make_block("while.end");
+    generator.emit<Bytecode::Op::Jump>(Bytecode::Label { test_block });
+
+    generator.switch_to_basic_block(test_block);
+    auto test = generator.generate_expression(m_test);
+    generator.emit<Bytecode::Op::JumpConditional>(test, Bytecode::Label { body_block }, Bytecode::Label { end_block });
+
+    generator.switch_to_basic_block(body_block);
+    generator.begin_jump_scope(label(), Bytecode::Label { end_block }, Bytecode::Label { test_block });
+    generator.generate_statement(m_body);
+    generator.end_jump_scope();
+    if (!generator.is_current_block_terminated())
+        generator.emit<Bytecode::Op::Jump>(Bytecode::Label { test_block });
+
+    generator.switch_to_basic_block(end_block);
+    return {};
+}
+
+Optional<Bytecode::Register> DoWhileStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto& body_block = generator.make_block("do.body");
+    auto& test_block = generator.make_block("do.test");
+    auto& end_block = generator.make_block("do.end");
+    generator.emit<Bytecode::Op::Jump>(Bytecode::Label { body_block });
+
+    generator.switch_to_basic_block(body_block);
+    generator.begin_jump_scope(label(), Bytecode::Label { end_block }, Bytecode::Label { test_block });
+    generator.generate_statement(m_body);
+    generator.end_jump_scope();
+    if (!generator.is_current_block_terminated())
+        generator.emit<Bytecode::Op::Jump>(Bytecode::Label { test_block });
+
+    generator.switch_to_basic_block(test_block);
+    auto test = generator.generate_expression(m_test);
+    generator.emit<Bytecode::Op::JumpConditional>(test, Bytecode::Label { body_block }, Bytecode::Label { end_block });
+
+    generator.switch_to_basic_block(end_block);
+    return {};
+}
+
+Optional<Bytecode::Register> ForStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    // Like the AST interpreter, give let and const declarations in the head a scope of their own.
+    bool has_wrapper_scope = false;
+    if (m_init && is<VariableDeclaration>(*m_init) && static_cast<const VariableDeclaration&>(*m_init).declaration_kind() != DeclarationKind::Var) {
+        auto wrapper = create_ast_node<BlockStatement>(source_range());
+        NonnullRefPtrVector<VariableDeclaration> decls;
+        decls.append(*static_cast<const VariableDeclaration*>(m_init.ptr()));
+        wrapper->add_variables(decls);
+        generator.retain_node(*wrapper);
+        generator.begin_lexical_scope(*wrapper, ScopeType::Block);
+        has_wrapper_scope = true;
+    }
+
+    if (m_init) {
+        if (is<Expression>(*m_init))
+            generator.generate_expression(static_cast<const Expression&>(*m_init));
+        else
+            generator.generate_statement(static_cast<const Statement&>(*m_init));
+    }
+
+    auto& body_block = generator.make_block("for.body");
+    auto& update_block = generator.make_block("for.update");
+    auto& end_block = generator.make_block("for.end");
+    auto& test_block = m_test ? generator.make_block("for.test") : body_block;
+    generator.emit<Bytecode::Op::Jump>(Bytecode::Label { test_block });
+
+    if (m_test) {
+        generator.switch_to_basic_block(test_block);
+        auto test = generator.generate_expression(*m_test);
+        generator.emit<Bytecode::Op::JumpConditional>(test, Bytecode::Label { body_block }, Bytecode::Label { end_block });
+    }
+
+    generator.switch_to_basic_block(body_block);
+    generator.begin_jump_scope(label(), Bytecode::Label { end_block }, Bytecode::Label { update_block });
+    generator.generate_statement(m_body);
+    generator.end_jump_scope();
+    if (!generator.is_current_block_terminated())
+        generator.emit<Bytecode::Op::Jump>(Bytecode::Label { update_block });
+
+    generator.switch_to_basic_block(update_block);
+    if (m_update)
+        generator.generate_expression(*m_update);
+    generator.emit<Bytecode::Op::Jump>(Bytecode::Label { test_block });
+
+    generator.switch_to_basic_block(end_block);
+    if (has_wrapper_scope)
+        generator.end_lexical_scope();
+    return {};
+}
+
+Optional<Bytecode::Register> BreakStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    if (!generator.generate_break(m_target_label))
+        return ASTNode::generate_bytecode(generator);
+    return {};
+}
+
+Optional<Bytecode::Register> ContinueStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    if (!generator.generate_continue(m_target_label))
+        return ASTNode::generate_bytecode(generator);
+    return {};
+}
+
+Optional<Bytecode::Register> BinaryExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto lhs = generator.generate_expression(m_lhs);
+    auto rhs = generator.generate_expression(m_rhs);
+    auto dst = generator.allocate_register();
+
+    switch (m_op) {
+    case BinaryOp::Addition:
+        generator.emit<Bytecode::Op::Add>(dst, lhs, rhs);
+        break;
+    case BinaryOp::Subtraction:
+        generator.emit<Bytecode::Op::Sub>(dst, lhs, rhs);
+        break;
+    case BinaryOp::Multiplication:
+        generator.emit<Bytecode::Op::Mul>(dst, lhs, rhs);
+        break;
+    case BinaryOp::Division:
+        generator.emit<Bytecode::Op::Div>(dst, lhs, rhs);
+        break;
+    case BinaryOp::Modulo:
+        generator.emit<Bytecode::Op::Mod>(dst, lhs, rhs);
+        break;
+    case BinaryOp::Exponentiation:
+        generator.emit<Bytecode::Op::Exp>(dst, lhs, rhs);
+        break;
+    case BinaryOp::TypedEquals:
+        generator.emit<Bytecode::Op::TypedEquals>(dst, lhs, rhs);
+        break;
+    case BinaryOp::TypedInequals:
+        generator.emit<Bytecode::Op::TypedInequals>(dst, lhs, rhs);
+        break;
+    case BinaryOp::AbstractEquals:
+        generator.emit<Bytecode::Op::AbstractEquals>(dst, lhs, rhs);
+        break;
+    case BinaryOp::AbstractInequals:
+        generator.emit<Bytecode::Op::AbstractInequals>(dst, lhs, rhs);
+        break;
+    case BinaryOp::GreaterThan:
+        generator.emit<Bytecode::Op::GreaterThan>(dst, lhs, rhs);
+        break;
+    case BinaryOp::GreaterThanEquals:
+        generator.emit<Bytecode::Op::GreaterThanEquals>(dst, lhs, rhs);
+        break;
+    case BinaryOp::LessThan:
+        generator.emit<Bytecode::Op::LessThan>(dst, lhs, rhs);
+        break;
+    case BinaryOp::LessThanEquals:
+        generator.emit<Bytecode::Op::LessThanEquals>(dst, lhs, rhs);
+        break;
+    case BinaryOp::BitwiseAnd:
+        generator.emit<Bytecode::Op::BitwiseAnd>(dst, lhs, rhs);
+        break;
+    case BinaryOp::BitwiseOr:
+        generator.emit<Bytecode::Op::BitwiseOr>(dst, lhs, rhs);
+        break;
+    case BinaryOp::BitwiseXor:
+        generator.emit<Bytecode::Op::BitwiseXor>(dst, lhs, rhs);
+        break;
+    case BinaryOp::LeftShift:
+        generator.emit<Bytecode::Op::LeftShift>(dst, lhs, rhs);
+        break;
+    case BinaryOp::RightShift:
+        generator.emit<Bytecode::Op::RightShift>(dst, lhs, rhs);
+        break;
+    case BinaryOp::UnsignedRightShift:
+        generator.emit<Bytecode::Op::UnsignedRightShift>(dst, lhs, rhs);
+        break;
+    case BinaryOp::In:
+        generator.emit<Bytecode::Op::In>(dst, lhs, rhs);
+        break;
+    case BinaryOp::InstanceOf:
+        generator.emit<Bytecode::Op::InstanceOf>(dst, lhs, rhs);
+        break;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+    return dst;
+}
+
+// Leaves the result in dst: the lhs if it short-circuits, the rhs otherwise.
+static void generate_short_circuit(Bytecode::Generator& generator, LogicalOp op, Bytecode::Register dst, const Expression& rhs, AK::Function<void(Bytecode::Register)> store_result = {})
+{
+    auto& rhs_block = generator.make_block("logical.rhs");
+    auto& end_block = generator.make_block("logical.end");
+
+    switch (op) {
+    case LogicalOp::And:
+        generator.emit<Bytecode::Op::JumpConditional>(dst, Bytecode::Label { rhs_block }, Bytecode::Label { end_block });
+        break;
+    case LogicalOp::Or:
+        generator.emit<Bytecode::Op::JumpConditional>(dst, Bytecode::Label { end_block }, Bytecode::Label { rhs_block });
+        break;
+    case LogicalOp::NullishCoalescing:
+        generator.emit<Bytecode::Op::JumpNullish>(dst, Bytecode::Label { rhs_block }, Bytecode::Label { end_block });
+        break;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+
+    generator.switch_to_basic_block(rhs_block);
+    auto rhs_value = generator.generate_expression(rhs);
+    generator.emit<Bytecode::Op::Load>(dst, rhs_value);
+    if (store_result)
+        store_result(dst);
+    generator.emit<Bytecode::Op::Jump>(Bytecode::Label { end_block });
+
+    generator.switch_to_basic_block(end_block);
+}
+
+Optional<Bytecode::Register> LogicalExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto lhs = generator.generate_expression(m_lhs);
+    auto dst = generator.allocate_register();
+    generator.emit<Bytecode::Op::Load>(dst, lhs);
+    generate_short_circuit(generator, m_op, dst, m_rhs);
+    return dst;
+}
+
+Optional<Bytecode::Register> UnaryExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    // delete needs a reference, and typeof must not throw for undeclared identifiers.
+    if (m_op == UnaryOp::Delete || (m_op == UnaryOp::Typeof && is<Identifier>(*m_lhs)))
+        return ASTNode::generate_bytecode(generator);
+
+    auto src = generator.generate_expression(m_lhs);
+    auto dst = generator.allocate_register();
+
+    switch (m_op) {
+    case UnaryOp::BitwiseNot:
+        generator.emit<Bytecode::Op::BitwiseNot>(dst, src);
+        break;
+    case UnaryOp::Not:
+        generator.emit<Bytecode::Op::Not>(dst, src);
+        break;
+    case UnaryOp::Plus:
+        generator.emit<Bytecode::Op::UnaryPlus>(dst, src);
+        break;
+    case UnaryOp::Minus:
+        generator.emit<Bytecode::Op::UnaryMinus>(dst, src);
+        break;
+    case UnaryOp::Typeof:
+        generator.emit<Bytecode::Op::Typeof>(dst, src);
+        break;
+    case UnaryOp::Void:
+        generator.emit<Bytecode::Op::LoadImmediate>(dst, js_undefined());
+        break;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+    return dst;
+}
+
+Optional<Bytecode::Register> SequenceExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    Optional<Bytecode::Register> result;
+    for (auto& expression : m_expressions)
+        result = generator.generate_expression(expression);
+    return result;
+}
+
+Optional<Bytecode::Register> BooleanLiteral::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto dst = generator.allocate_register();
+    generator.emit<Bytecode::Op::LoadImmediate>(dst, Value(m_value));
+    return dst;
+}
+
+Optional<Bytecode::Register> NumericLiteral::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto dst = generator.allocate_register();
+    generator.emit<Bytecode::Op::LoadImmediate>(dst, m_value);
+    return dst;
+}
+
+Optional<Bytecode::Register> StringLiteral::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto dst = generator.allocate_register();
+    generator.emit<Bytecode::Op::NewString>(dst, generator.intern_string(m_value));
+    return dst;
+}
+
+Optional<Bytecode::Register> NullLiteral::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto dst = generator.allocate_register();
+    generator.emit<Bytecode::Op::LoadImmediate>(dst, js_null());
+    return dst;
+}
+
+Optional<Bytecode::Register> Identifier::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto dst = generator.allocate_register();
+    generator.emit<Bytecode::Op::GetVariable>(dst, generator.intern_identifier(m_string));
+    return dst;
+}
+
+Optional<Bytecode::Register> ThisExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto dst = generator.allocate_register();
+    generator.emit<Bytecode::Op::ResolveThisBinding>(dst);
+    return dst;
+}
+
+static void generate_get_member(Bytecode::Generator& generator, const MemberExpression& expression, Bytecode::Register dst, Bytecode::Register base, Optional<Bytecode::Register> property)
+{
+    if (property.has_value())
+        generator.emit<Bytecode::Op::GetByValue>(dst, base, *property);
+    else
+        generator.emit<Bytecode::Op::GetById>(dst, base, generator.intern_identifier(static_cast<const Identifier&>(expression.property()).string()), generator.make_property_lookup_cache());
+}
+
+static void generate_put_member(Bytecode::Generator& generator, const MemberExpression& expression, Bytecode::Register base, Optional<Bytecode::Register> property, Bytecode::Register src)
+{
+    if (property.has_value())
+        generator.emit<Bytecode::Op::PutByValue>(base, *property, src);
+    else
+        generator.emit<Bytecode::Op::PutById>(base, generator.intern_identifier(static_cast<const Identifier&>(expression.property()).string()), src, generator.make_property_lookup_cache());
+}
+
+// Evaluates the property key of a computed member expression. Non-computed ones are looked up by name.
+static Optional<Bytecode::Register> generate_member_property(Bytecode::Generator& generator, const MemberExpression& expression)
+{
+    if (!expression.is_computed())
+        return {};
+    return generator.generate_expression(expression.property());
+}
+
+Optional<Bytecode::Register> MemberExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    if (is<SuperExpression>(*m_object))
+        return ASTNode::generate_bytecode(generator);
+
+    auto base = generator.generate_expression(m_object);
+    auto property = generate_member_property(generator, *this);
+    auto dst = generator.allocate_register();
+    generate_get_member(generator, *this, dst, base, property);
+    return dst;
+}
+
+static void generate_binary_op_for_assignment(Bytecode::Generator& generator, AssignmentOp op, Bytecode::Register dst, Bytecode::Register lhs, Bytecode::Register rhs)
+{
+    switch (op) {
+    case AssignmentOp::AdditionAssignment:
+        generator.emit<Bytecode::Op::Add>(dst, lhs, rhs);
+        break;
+    case AssignmentOp::SubtractionAssignment:
+        generator.emit<Bytecode::Op::Sub>(dst, lhs, rhs);
+        break;
+    case AssignmentOp::MultiplicationAssignment:
+        generator.emit<Bytecode::Op::Mul>(dst, lhs, rhs);
+        break;
+    case AssignmentOp::DivisionAssignment:
+        generator.emit<Bytecode::Op::Div>(dst, lhs, rhs);
+        break;
+    case AssignmentOp::ModuloAssignment:
+        generator.emit<Bytecode::Op::Mod>(dst, lhs, rhs);
+        break;
+    case AssignmentOp::ExponentiationAssignment:
+        generator.emit<Bytecode::Op::Exp>(dst, lhs, rhs);
+        break;
+    case AssignmentOp::BitwiseAndAssignment:
+        generator.emit<Bytecode::Op::BitwiseAnd>(dst, lhs, rhs);
+        break;
+    case AssignmentOp::BitwiseOrAssignment:
+        generator.emit<Bytecode::Op::BitwiseOr>(dst, lhs, rhs);
+        break;
+    case AssignmentOp::BitwiseXorAssignment:
+        generator.emit<Bytecode::Op::BitwiseXor>(dst, lhs, rhs);
+        break;
+    case AssignmentOp::LeftShiftAssignment:
+        generator.emit<Bytecode::Op::LeftShift>(dst, lhs, rhs);
+        break;
+    case AssignmentOp::RightShiftAssignment:
+        generator.emit<Bytecode::Op::RightShift>(dst, lhs, rhs);
+        break;
+    case AssignmentOp::UnsignedRightShiftAssignment:
+        generator.emit<Bytecode::Op::UnsignedRightShift>(dst, lhs, rhs);
+        break;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+}
+
+Optional<Bytecode::Register> AssignmentExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    bool is_logical_assignment = m_op == AssignmentOp::AndAssignment || m_op == AssignmentOp::OrAssignment || m_op == AssignmentOp::NullishAssignment;
+
+    if (is<Identifier>(*m_lhs)) {
+        auto identifier = generator.intern_identifier(static_cast<const Identifier&>(*m_lhs).string());
+
+        if (m_op == AssignmentOp::Assignment) {
+            auto value = generator.generate_expression(m_rhs);
+            generator.emit<Bytecode::Op::SetVariable>(identifier, value, false);
+            return value;
+        }
+
+        auto dst = generator.allocate_register();
+        generator.emit<Bytecode::Op::GetVariable>(dst, identifier);
+
+        if (is_logical_assignment) {
+            auto op = m_op == AssignmentOp::AndAssignment ? LogicalOp::And : (m_op == AssignmentOp::OrAssignment ? LogicalOp::Or : LogicalOp::NullishCoalescing);
+            generate_short_circuit(generator, op, dst, m_rhs, [&](Bytecode::Register value) {
+                generator.emit<Bytecode::Op::SetVariable>(identifier, value, false);
+            });
+            return dst;
+        }
+
+        auto rhs = generator.generate_expression(m_rhs);
+        auto result = generator.allocate_register();
+        generate_binary_op_for_assignment(generator, m_op, result, dst, rhs);
+        generator.emit<Bytecode::Op::SetVariable>(identifier, result, false);
+        return result;
+    }
+
+    if (is<MemberExpression>(*m_lhs) && !is_logical_assignment) {
+        auto& member = static_cast<const MemberExpression&>(*m_lhs);
+        if (is<SuperExpression>(member.object()))
+            return ASTNode::generate_bytecode(generator);
+
+        auto base = generator.generate_expression(member.object());
+        auto property = generate_member_property(generator, member);
+
+        if (m_op == AssignmentOp::Assignment) {
+            auto value = generator.generate_expression(m_rhs);
+            generate_put_member(generator, member, base, property, value);
+            return value;
+        }
+
+        auto old_value = generator.allocate_register();
+        generate_get_member(generator, member, old_value, base, property);
+        auto rhs = generator.generate_expression(m_rhs);
+        auto result = generator.allocate_register();
+        generate_binary_op_for_assignment(generator, m_op, result, old_value, rhs);
+        generate_put_member(generator, member, base, property, result);
+        return result;
+    }
+
+    return ASTNode::generate_bytecode(generator);
+}
+
+struct UpdateResult {
+    Bytecode::Register old_value;
+    Bytecode::Register new_value;
+};
+
+static UpdateResult generate_update(Bytecode::Generator& generator, UpdateOp op, Bytecode::Register value)
+{
+    auto old_value = generator.allocate_register();
+    generator.emit<Bytecode::Op::ToNumeric>(old_value, value);
+    auto new_value = generator.allocate_register();
+    if (op == UpdateOp::Increment)
+        generator.emit<Bytecode::Op::Increment>(new_value, old_value);
+    else
+        generator.emit<Bytecode::Op::Decrement>(new_value, old_value);
+    return { old_value, new_value };
+}
+
+Optional<Bytecode::Register> UpdateExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    if (is<Identifier>(*m_argument)) {
+        auto identifier = generator.intern_identifier(static_cast<const Identifier&>(*m_argument).string());
+        auto value = generator.allocate_register();
+        generator.emit<Bytecode::Op::GetVariable>(value, identifier);
+        auto result = generate_update(generator, m_op, value);
+        generator.emit<Bytecode::Op::SetVariable>(identifier, result.new_value, false);
+        return m_prefixed ? result.new_value : result.old_value;
+    }
+
+    if (is<MemberExpression>(*m_argument)) {
+        auto& member = static_cast<const MemberExpression&>(*m_argument);
+        if (is<SuperExpression>(member.object()))
+            return ASTNode::generate_bytecode(generator);
+
+        auto base = generator.generate_expression(member.object());
+        auto property = generate_member_property(generator, member);
+        auto value = generator.allocate_register();
+        generate_get_member(generator, member, value, base, property);
+        auto result = generate_update(generator, m_op, value);
+        generate_put_member(generator, member, base, property, result.new_value);
+        return m_prefixed ? result.new_value : result.old_value;
+    }
+
+    return ASTNode::generate_bytecode(generator);
+}
+
+Optional<Bytecode::Register> VariableDeclaration::generate_bytecode(Bytecode::Generator& generator) const
+{
+    // Class expressions get the name of the binding they initialize when run by the AST interpreter.
+    for (auto& declarator : m_declarations) {
+        if (declarator.init() && is<ClassExpression>(*declarator.init()))
+            return ASTNode::generate_bytecode(generator);
+    }
+
+    for (auto& declarator : m_declarations) {
+        if (!declarator.init())
+            continue;
+        auto value = generator.generate_expression(*declarator.init());
+        generator.emit<Bytecode::Op::SetVariable>(generator.intern_identifier(declarator.id().string()), value, true);
+    }
+    return {};
+}
+
+Optional<Bytecode::Register> CallExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    if (is<SuperExpression>(*m_callee))
+        return ASTNode::generate_bytecode(generator);
+    for (auto& argument : m_arguments) {
+        if (argument.is_spread)
+            return ASTNode::generate_bytecode(generator);
+    }
+
+    bool is_construct = is<NewExpression>(*this);
+    Optional<Bytecode::Register> this_value;
+    Optional<Bytecode::Register> callee;
+
+    if (!is_construct && is<MemberExpression>(*m_callee)) {
+        auto& member = static_cast<const MemberExpression&>(*m_callee);
+        if (is<SuperExpression>(member.object()))
+            return ASTNode::generate_bytecode(generator);
+
+        auto base = generator.generate_expression(member.object());
+        this_value = generator.allocate_register();
+        generator.emit<Bytecode::Op::ToObject>(*this_value, base);
+        auto property = generate_member_property(generator, member);
+        callee = generator.allocate_register();
+        generate_get_member(generator, member, *callee, *this_value, property);
+    } else {
+        callee = generator.generate_expression(m_callee);
+    }
+
+    Vector<Bytecode::Register> arguments;
+    arguments.ensure_capacity(m_arguments.size());
+    for (auto& argument : m_arguments)
+        arguments.append(generator.generate_expression(argument.value));
+
+    auto dst = generator.allocate_register();
+    auto call_type = is_construct ? Bytecode::Op::Call::CallType::Construct : Bytecode::Op::Call::CallType::Call;
+    generator.emit_with_extra_register_slots<Bytecode::Op::Call>(arguments.size(), call_type, dst, *callee, this_value, *this, arguments);
+    return dst;
+}
+
+Optional<Bytecode::Register> ArrayExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    for (auto& element : m_elements) {
+        if (!element || is<SpreadExpression>(*element))
+            return ASTNode::generate_bytecode(generator);
+    }
+
+    Vector<Bytecode::Register> elements;
+    elements.ensure_capacity(m_elements.size());
+    for (auto& element : m_elements)
+        elements.append(generator.generate_expression(*element));
+
+    auto dst = generator.allocate_register();
+    generator.emit_with_extra_register_slots<Bytecode::Op::NewArray>(elements.size(), dst, elements);
+    return dst;
+}
+
+Optional<Bytecode::Register> ConditionalExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto test = generator.generate_expression(m_test);
+    auto& consequent_block = generator.make_block("conditional.then");
+    auto& alternate_block = generator.make_block("conditional.else");
+    auto& end_block = generator.make_block("conditional.end");
+    auto dst = generator.allocate_register();
+    generator.emit<Bytecode::Op::JumpConditional>(test, Bytecode::Label { consequent_block }, Bytecode::Label { alternate_block });
+
+    generator.switch_to_basic_block(consequent_block);
+    auto consequent = generator.generate_expression(m_consequent);
+    generator.emit<Bytecode::Op::Load>(dst, consequent);
+    generator.emit<Bytecode::Op::Jump>(Bytecode::Label { end_block });
+
+    generator.switch_to_basic_block(alternate_block);
+    auto alternate = generator.generate_expression(m_alternate);
+    generator.emit<Bytecode::Op::Load>(dst, alternate);
+    generator.emit<Bytecode::Op::Jump>(Bytecode::Label { end_block });
+
+    generator.switch_to_basic_block(end_block);
+    return dst;
+}
+
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2021, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibJS/Bytecode/BasicBlock.h>
+#include <LibJS/Bytecode/Instruction.h>
+
+namespace JS::Bytecode {
+
+NonnullOwnPtr<BasicBlock> BasicBlock::create(String name)
+{
+    return adopt_own(*new BasicBlock(move(name)));
+}
+
+BasicBlock::BasicBlock(String name)
+    : m_name(move(name))
+{
+}
+
+void* BasicBlock::append_instruction_slot(Badge<Generator>, size_t size)
+{
+    VERIFY(!m_is_terminated);
+    auto offset = m_buffer.size();
+    m_buffer.resize(offset + size);
+    return m_buffer.data() + offset;
+}
+
+void BasicBlock::dump(const Executable& executable) const
+{
+    outln("{}:", m_name);
+    size_t offset = 0;
+    while (offset < m_buffer.size()) {
+        auto& instruction = *reinterpret_cast<const Instruction*>(m_buffer.data() + offset);
+        outln("    [{:4x}] {}", offset, instruction.to_string(executable));
+        offset += instruction.aligned_length();
+    }
+}
+
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2021, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Badge.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Span.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <LibJS/Forward.h>
+
+namespace JS::Bytecode {
+
+// A straight run of instructions ending in a jump or a return. The instructions are stored back to back
+// in a single buffer, which is why they must be trivially copyable: the buffer may move as it grows.
+class BasicBlock {
+    AK_MAKE_NONCOPYABLE(BasicBlock);
+    AK_MAKE_NONMOVABLE(BasicBlock);
+
+public:
+    static NonnullOwnPtr<BasicBlock> create(String name);
+
+    const String& name() const { return m_name; }
+    ReadonlyBytes instruction_stream() const { return m_buffer.span(); }
+
+    void* append_instruction_slot(Badge<Generator>, size_t size);
+
+    bool is_terminated() const { return m_is_terminated; }
+    void terminate(Badge<Generator>) { m_is_terminated = true; }
+
+    void dump(const Executable&) const;
+
+private:
+    explicit BasicBlock(String name);
+
+    String m_name;
+    Vector<u8> m_buffer;
+    bool m_is_terminated { false };
+};
+
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2021, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/FlyString.h>
+#include <AK/NonnullOwnPtrVector.h>
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <LibJS/AST.h>
+#include <LibJS/Bytecode/BasicBlock.h>
+#include <LibJS/Runtime/PropertyLookupCache.h>
+
+namespace JS::Bytecode {
+
+struct StringTableIndex {
+    size_t value { 0 };
+};
+
+struct IdentifierTableIndex {
+    size_t value { 0 };
+};
+
+struct PropertyLookupCacheIndex {
+    size_t value { 0 };
+};
+
+// Where a break or continue coming out of code run by the AST interpreter should land in the bytecode.
+struct UnwindTarget {
+    FlyString label;
+    const BasicBlock* break_target { nullptr };
+    const BasicBlock* continue_target { nullptr };
+    size_t scope_depth { 0 };
+};
+
+struct Executable {
+    NonnullOwnPtrVector<BasicBlock> basic_blocks;
+    Vector<String> strings;
+    Vector<FlyString> identifiers;
+    // One for each GetById and PutById, filled in as they execute.
+    mutable Vector<PropertyLookupCache> property_lookup_caches;
+    // Innermost target last.
+    Vector<Vector<UnwindTarget>> unwind_tables;
+    // Instructions refer to AST nodes by pointer, so keep alive the ones nothing else owns.
+    NonnullRefPtrVector<ASTNode> retained_nodes;
+    size_t number_of_registers { 0 };
+
+    const String& string(StringTableIndex index) const { return strings[index.value]; }
+    const FlyString& identifier(IdentifierTableIndex index) const { return identifiers[index.value]; }
+    PropertyLookupCache& property_lookup_cache(PropertyLookupCacheIndex index) const { return property_lookup_caches[index.value]; }
+
+    void dump() const;
+};
+
+}
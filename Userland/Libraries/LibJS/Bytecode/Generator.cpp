@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2021, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibJS/AST.h>
+#include <LibJS/Bytecode/Generator.h>
+#include <LibJS/Bytecode/Op.h>
+
+namespace JS::Bytecode {
+
+Generator::Generator()
+    : m_executable(make<Executable>())
+{
+}
+
+NonnullOwnPtr<Executable> Generator::generate(const Program& program)
+{
+    Generator generator;
+    generator.retain_node(program);
+    generator.switch_to_basic_block(generator.make_block("entry"));
+
+    // A program evaluates to the value of the last statement that produced one.
+    auto completion = generator.allocate_register();
+    generator.m_completion_register = completion;
+    generator.emit<Op::LoadImmediate>(completion, js_undefined());
+
+    generator.begin_lexical_scope(program, ScopeType::Block);
+    for (auto& child : program.children())
+        generator.generate_statement(child);
+    generator.end_lexical_scope();
+
+    if (!generator.is_current_block_terminated())
+        generator.emit<Op::Return>(completion);
+    generator.finish();
+    return move(generator.m_executable);
+}
+
+NonnullOwnPtr<Executable> Generator::generate_function_body(const Statement& body)
+{
+    // NOTE: We don't retain the body here, since it holds on to the executable. Whoever runs it keeps the body alive.
+    Generator generator;
+    generator.switch_to_basic_block(generator.make_block("entry"));
+
+    if (is<ScopeNode>(body)) {
+        auto& scope_node = static_cast<const ScopeNode&>(body);
+        generator.begin_lexical_scope(scope_node, ScopeType::Function);
+        for (auto& child : scope_node.children())
+            generator.generate_statement(child);
+        generator.end_lexical_scope();
+    } else {
+        generator.generate_statement(body);
+    }
+
+    generator.finish();
+    return move(generator.m_executable);
+}
+
+void Generator::finish()
+{
+    // Falling off the end of a function returns undefined. Blocks that are never reached after
+    // a return, break or continue get the same treatment, so that every block is terminated.
+    for (auto& block : m_executable->basic_blocks) {
+        if (block.is_terminated())
+            continue;
+        switch_to_basic_block(block);
+        auto undefined = allocate_register();
+        emit<Op::LoadImmediate>(undefined, js_undefined());
+        emit<Op::Return>(undefined);
+    }
+    m_executable->number_of_registers = m_next_register;
+}
+
+Register Generator::allocate_register()
+{
+    return Register { m_next_register++ };
+}
+
+Register Generator::generate_expression(const Expression& expression)
+{
+    auto result = expression.generate_bytecode(*this);
+    VERIFY(result.has_value());
+    return result.value();
+}
+
+void Generator::generate_statement(const Statement& statement)
+{
+    if (is_current_block_terminated())
+        switch_to_basic_block(make_block("unreachable"));
+
+    auto result = statement.generate_bytecode(*this);
+    if (result.has_value() && m_completion_register.has_value() && !is_current_block_terminated())
+        emit<Op::Load>(*m_completion_register, *result);
+}
+
+void Generator::generate_scope(const ScopeNode& scope_node, ScopeType scope_type)
+{
+    // There's always an enclosing function or program scope, so blocks without declarations
+    // don't need one of their own.
+    bool needs_scope = !scope_node.functions().is_empty() || !scope_node.variables().is_empty();
+    if (needs_scope)
+        begin_lexical_scope(scope_node, scope_type);
+    for (auto& child : scope_node.children())
+        generate_statement(child);
+    if (needs_scope)
+        end_lexical_scope();
+}
+
+BasicBlock& Generator::make_block(const StringView& name)
+{
+    m_executable->basic_blocks.append(BasicBlock::create(String::formatted("{}.{}", name, m_executable->basic_blocks.size())));
+    return m_executable->basic_blocks.last();
+}
+
+void Generator::switch_to_basic_block(BasicBlock& block)
+{
+    m_current_block = &block;
+}
+
+StringTableIndex Generator::intern_string(const String& string)
+{
+    if (auto it = m_string_indices.find(string); it != m_string_indices.end())
+        return { it->value };
+    m_executable->strings.append(string);
+    auto index = m_executable->strings.size() - 1;
+    m_string_indices.set(string, index);
+    return { index };
+}
+
+IdentifierTableIndex Generator::intern_identifier(const FlyString& identifier)
+{
+    if (auto it = m_identifier_indices.find(identifier); it != m_identifier_indices.end())
+        return { it->value };
+    m_executable->identifiers.append(identifier);
+    auto index = m_executable->identifiers.size() - 1;
+    m_identifier_indices.set(identifier, index);
+    return { index };
+}
+
+PropertyLookupCacheIndex Generator::make_property_lookup_cache()
+{
+    m_executable->property_lookup_caches.append(PropertyLookupCache {});
+    return { m_executable->property_lookup_caches.size() - 1 };
+}
+
+void Generator::retain_node(const ASTNode& node)
+{
+    m_executable->retained_nodes.append(node);
+}
+
+void Generator::begin_lexical_scope(const ScopeNode& scope_node, ScopeType scope_type)
+{
+    emit<Op::EnterScope>(scope_node, scope_type);
+    m_lexical_scopes.append(&scope_node);
+}
+
+void Generator::end_lexical_scope()
+{
+    auto* scope_node = m_lexical_scopes.take_last();
+    if (!is_current_block_terminated())
+        emit<Op::ExitScope>(*scope_node);
+}
+
+void Generator::begin_jump_scope(const FlyString& label, Label break_target, Optional<Label> continue_target)
+{
+    m_jump_scopes.append({ label, break_target, continue_target, m_lexical_scopes.size() });
+}
+
+void Generator::end_jump_scope()
+{
+    m_jump_scopes.take_last();
+}
+
+bool Generator::generate_break(const FlyString& label)
+{
+    for (size_t i = m_jump_scopes.size(); i > 0; --i) {
+        auto& jump_scope = m_jump_scopes[i - 1];
+        if (!label.is_null() && jump_scope.label != label)
+            continue;
+        if (m_lexical_scopes.size() > jump_scope.lexical_scope_depth)
+            emit<Op::ExitScope>(*m_lexical_scopes[jump_scope.lexical_scope_depth]);
+        emit<Op::Jump>(jump_scope.break_target);
+        return true;
+    }
+    return false;
+}
+
+bool Generator::generate_continue(const FlyString& label)
+{
+    for (size_t i = m_jump_scopes.size(); i > 0; --i) {
+        auto& jump_scope = m_jump_scopes[i - 1];
+        if (!jump_scope.continue_target.has_value())
+            continue;
+        if (!label.is_null() && jump_scope.label != label)
+            continue;
+        if (m_lexical_scopes.size() > jump_scope.lexical_scope_depth)
+            emit<Op::ExitScope>(*m_lexical_scopes[jump_scope.lexical_scope_depth]);
+        emit<Op::Jump>(*jump_scope.continue_target);
+        return true;
+    }
+    return false;
+}
+
+size_t Generator::current_unwind_table()
+{
+    if (m_jump_scopes.is_empty())
+        return Op::ExecuteStatement::no_unwind_table;
+
+    Vector<UnwindTarget> targets;
+    targets.ensure_capacity(m_jump_scopes.size());
+    for (auto& jump_scope : m_jump_scopes) {
+        targets.append({
+            jump_scope.label,
+            &jump_scope.break_target.block(),
+            jump_scope.continue_target.has_value() ? &jump_scope.continue_target->block() : nullptr,
+            jump_scope.lexical_scope_depth,
+        });
+    }
+    m_executable->unwind_tables.append(move(targets));
+    return m_executable->unwind_tables.size() - 1;
+}
+
+}
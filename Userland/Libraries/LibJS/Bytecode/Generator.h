@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2021, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/FlyString.h>
+#include <AK/HashMap.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Optional.h>
+#include <AK/String.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Vector.h>
+#include <LibJS/Bytecode/BasicBlock.h>
+#include <LibJS/Bytecode/Executable.h>
+#include <LibJS/Bytecode/Instruction.h>
+#include <LibJS/Bytecode/Label.h>
+#include <LibJS/Bytecode/Register.h>
+#include <LibJS/Forward.h>
+#include <LibJS/Runtime/VM.h>
+
+namespace JS::Bytecode {
+
+class Generator {
+public:
+    static NonnullOwnPtr<Executable> generate(const Program&);
+    static NonnullOwnPtr<Executable> generate_function_body(const Statement&);
+
+    Register allocate_register();
+
+    Register generate_expression(const Expression&);
+    void generate_statement(const Statement&);
+    void generate_scope(const ScopeNode&, ScopeType);
+
+    template<typename OpType, typename... Args>
+    void emit(Args&&... args)
+    {
+        static_assert(is_trivially_copyable<OpType>());
+        void* slot = m_current_block->append_instruction_slot({}, Instruction::align_length(sizeof(OpType)));
+        new (slot) OpType(forward<Args>(args)...);
+        if constexpr (OpType::IsTerminator)
+            m_current_block->terminate({});
+    }
+
+    // For ops that keep a variable number of registers after their fixed-size part.
+    template<typename OpType, typename... Args>
+    void emit_with_extra_register_slots(size_t extra_register_slots, Args&&... args)
+    {
+        static_assert(is_trivially_copyable<OpType>());
+        void* slot = m_current_block->append_instruction_slot({}, Instruction::align_length(sizeof(OpType) + extra_register_slots * sizeof(Register)));
+        new (slot) OpType(forward<Args>(args)...);
+        if constexpr (OpType::IsTerminator)
+            m_current_block->terminate({});
+    }
+
+    BasicBlock& make_block(const StringView& name);
+    void switch_to_basic_block(BasicBlock&);
+    bool is_current_block_terminated() const { return m_current_block->is_terminated(); }
+
+    StringTableIndex intern_string(const String&);
+    IdentifierTableIndex intern_identifier(const FlyString&);
+    PropertyLookupCacheIndex make_property_lookup_cache();
+    void retain_node(const ASTNode&);
+
+    void begin_lexical_scope(const ScopeNode&, ScopeType);
+    void end_lexical_scope();
+
+    // Loops and labelled statements register where break and continue should take them.
+    void begin_jump_scope(const FlyString& label, Label break_target, Optional<Label> continue_target);
+    void end_jump_scope();
+    bool generate_break(const FlyString& label);
+    bool generate_continue(const FlyString& label);
+
+    // Describes the jump scopes we're in, for statements that are left to the AST interpreter.
+    size_t current_unwind_table();
+
+private:
+    Generator();
+
+    void finish();
+
+    struct JumpScope {
+        FlyString label;
+        Label break_target;
+        Optional<Label> continue_target;
+        size_t lexical_scope_depth { 0 };
+    };
+
+    NonnullOwnPtr<Executable> m_executable;
+    BasicBlock* m_current_block { nullptr };
+    u32 m_next_register { 0 };
+    Optional<Register> m_completion_register;
+    Vector<JumpScope> m_jump_scopes;
+    Vector<const ScopeNode*> m_lexical_scopes;
+    HashMap<String, size_t> m_string_indices;
+    HashMap<FlyString, size_t> m_identifier_indices;
+};
+
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2021, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Forward.h>
+#include <AK/Types.h>
+#include <LibJS/Forward.h>
+
+#define ENUMERATE_BYTECODE_OPS(O) \
+    O(Load)                       \
+    O(LoadImmediate)              \
+    O(NewString)                  \
+    O(NewArray)                   \
+    O(GetVariable)                \
+    O(SetVariable)                \
+    O(GetById)                    \
+    O(PutById)                    \
+    O(GetByValue)                 \
+    O(PutByValue)                 \
+    O(ToObject)                   \
+    O(ToNumeric)                  \
+    O(Increment)                  \
+    O(Decrement)                  \
+    O(ResolveThisBinding)         \
+    O(Call)                       \
+    O(Jump)                       \
+    O(JumpConditional)            \
+    O(JumpNullish)                \
+    O(Return)                     \
+    O(EnterScope)                 \
+    O(ExitScope)                  \
+    O(EvaluateExpression)         \
+    O(ExecuteStatement)           \
+    O(Add)                        \
+    O(Sub)                        \
+    O(Mul)                        \
+    O(Div)                        \
+    O(Mod)                        \
+    O(Exp)                        \
+    O(GreaterThan)                \
+    O(GreaterThanEquals)          \
+    O(LessThan)                   \
+    O(LessThanEquals)             \
+    O(AbstractInequals)           \
+    O(AbstractEquals)             \
+    O(TypedInequals)              \
+    O(TypedEquals)                \
+    O(BitwiseAnd)                 \
+    O(BitwiseOr)                  \
+    O(BitwiseXor)                 \
+    O(LeftShift)                  \
+    O(RightShift)                 \
+    O(UnsignedRightShift)         \
+    O(In)                         \
+    O(InstanceOf)                 \
+    O(BitwiseNot)                 \
+    O(Not)                        \
+    O(UnaryPlus)                  \
+    O(UnaryMinus)                 \
+    O(Typeof)
+
+namespace JS::Bytecode {
+
+class Instruction {
+public:
+    static constexpr bool IsTerminator = false;
+
+    enum class Type {
+#define __BYTECODE_OP(op) op,
+        ENUMERATE_BYTECODE_OPS(__BYTECODE_OP)
+#undef __BYTECODE_OP
+    };
+
+    Type type() const { return m_type; }
+    size_t length() const;
+    size_t aligned_length() const { return align_length(length()); }
+    String to_string(const Executable&) const;
+    void execute(Interpreter&) const;
+
+    // Every instruction starts on a pointer-aligned offset, so that Values and pointers inside it are aligned too.
+    static constexpr size_t align_length(size_t length) { return (length + alignof(void*) - 1) & ~(alignof(void*) - 1); }
+
+protected:
+    explicit Instruction(Type type)
+        : m_type(type)
+    {
+    }
+
+private:
+    Type m_type {};
+};
+
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2021, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibJS/Bytecode/Instruction.h>
+#include <LibJS/Bytecode/Interpreter.h>
+#include <LibJS/Interpreter.h>
+
+namespace JS::Bytecode {
+
+Interpreter::Interpreter(JS::Interpreter& ast_interpreter)
+    : m_ast_interpreter(ast_interpreter)
+{
+}
+
+Interpreter::~Interpreter()
+{
+}
+
+GlobalObject& Interpreter::global_object()
+{
+    return m_ast_interpreter.global_object();
+}
+
+VM& Interpreter::vm()
+{
+    return m_ast_interpreter.vm();
+}
+
+Value Interpreter::run(const Executable& executable)
+{
+    auto& vm = this->vm();
+
+    Frame frame;
+    frame.executable = &executable;
+    frame.registers.resize(executable.number_of_registers);
+    m_frames.append(move(frame));
+    m_registers = m_frames.last().registers.data();
+
+    Value return_value;
+    const BasicBlock* block = &executable.basic_blocks.first();
+    for (;;) {
+        auto stream = block->instruction_stream();
+        const BasicBlock* next_block = nullptr;
+        bool done = false;
+        for (size_t offset = 0; offset < stream.size();) {
+            auto& instruction = *reinterpret_cast<const Instruction*>(stream.data() + offset);
+            instruction.execute(*this);
+            if (vm.exception()) {
+                done = true;
+                break;
+            }
+            if (m_pending_jump) {
+                next_block = exchange(m_pending_jump, nullptr);
+                break;
+            }
+            if (m_return_value.has_value()) {
+                return_value = m_return_value.release_value();
+                done = true;
+                break;
+            }
+            offset += instruction.aligned_length();
+        }
+        if (done)
+            break;
+        // Every block ends in a jump or a return, so falling off the end means the generator messed up.
+        VERIFY(next_block);
+        block = next_block;
+    }
+
+    m_pending_jump = nullptr;
+    m_return_value.clear();
+
+    if (!m_frames.last().scopes.is_empty())
+        exit_scope(*m_frames.last().scopes.first());
+    m_frames.take_last();
+    m_registers = m_frames.is_empty() ? nullptr : m_frames.last().registers.data();
+
+    if (vm.exception())
+        return {};
+    return return_value;
+}
+
+void Interpreter::enter_scope(const ScopeNode& scope_node, ScopeType scope_type)
+{
+    m_ast_interpreter.enter_scope(scope_node, scope_type, global_object());
+    // The AST interpreter doesn't push a scope if it fails half way.
+    if (vm().exception())
+        return;
+    m_frames.last().scopes.append(&scope_node);
+}
+
+void Interpreter::exit_scope(const ScopeNode& scope_node)
+{
+    auto& scopes = m_frames.last().scopes;
+    while (!scopes.is_empty()) {
+        if (scopes.take_last() == &scope_node)
+            break;
+    }
+    m_ast_interpreter.exit_scope(scope_node);
+}
+
+void Interpreter::exit_scopes_until_depth(size_t depth)
+{
+    auto& scopes = m_frames.last().scopes;
+    if (scopes.size() > depth)
+        exit_scope(*scopes[depth]);
+}
+
+void Interpreter::gather_roots(HashTable<Cell*>& roots)
+{
+    for (auto& frame : m_frames) {
+        for (auto& value : frame.registers) {
+            if (value.is_cell())
+                roots.set(value.as_cell());
+        }
+    }
+    if (m_return_value.has_value() && m_return_value->is_cell())
+        roots.set(m_return_value->as_cell());
+}
+
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2021, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashTable.h>
+#include <AK/Optional.h>
+#include <AK/Vector.h>
+#include <LibJS/Bytecode/Executable.h>
+#include <LibJS/Bytecode/Label.h>
+#include <LibJS/Bytecode/Register.h>
+#include <LibJS/Forward.h>
+#include <LibJS/Runtime/VM.h>
+#include <LibJS/Runtime/Value.h>
+
+namespace JS::Bytecode {
+
+// Runs executables produced by Bytecode::Generator. Scopes, variables and everything the generator
+// can't compile yet are handled by the AST interpreter that owns us, so both can be mixed freely.
+class Interpreter {
+    AK_MAKE_NONCOPYABLE(Interpreter);
+    AK_MAKE_NONMOVABLE(Interpreter);
+
+public:
+    explicit Interpreter(JS::Interpreter&);
+    ~Interpreter();
+
+    JS::Interpreter& ast_interpreter() { return m_ast_interpreter; }
+    GlobalObject& global_object();
+    VM& vm();
+
+    Value run(const Executable&);
+
+    ALWAYS_INLINE Value& reg(Register reg) { return m_registers[reg.index()]; }
+    const Executable& current_executable() const { return *m_frames.last().executable; }
+
+    void jump(Label label) { m_pending_jump = &label.block(); }
+    void do_return(Value return_value) { m_return_value = return_value; }
+
+    void enter_scope(const ScopeNode&, ScopeType);
+    void exit_scope(const ScopeNode&);
+    void exit_scopes_until_depth(size_t depth);
+
+    void gather_roots(HashTable<Cell*>&);
+
+private:
+    struct Frame {
+        const Executable* executable { nullptr };
+        Vector<Value> registers;
+        Vector<const ScopeNode*> scopes;
+    };
+
+    JS::Interpreter& m_ast_interpreter;
+    Vector<Frame> m_frames;
+    Value* m_registers { nullptr };
+    const BasicBlock* m_pending_jump { nullptr };
+    Optional<Value> m_return_value;
+};
+
+}
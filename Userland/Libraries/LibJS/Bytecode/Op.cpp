@@ -0,0 +1,506 @@
+/*
+ * Copyright (c) 2021, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/StringBuilder.h>
+#include <LibCrypto/BigInt/SignedBigInteger.h>
+#include <LibJS/AST.h>
+#include <LibJS/Bytecode/Interpreter.h>
+#include <LibJS/Bytecode/Op.h>
+#include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/Array.h>
+#include <LibJS/Runtime/BigInt.h>
+#include <LibJS/Runtime/Error.h>
+#include <LibJS/Runtime/GlobalObject.h>
+#include <LibJS/Runtime/MarkedValueList.h>
+#include <LibJS/Runtime/NativeFunction.h>
+#include <LibJS/Runtime/PrimitiveString.h>
+#include <LibJS/Runtime/Reference.h>
+
+namespace JS::Bytecode {
+
+size_t Instruction::length() const
+{
+    switch (type()) {
+#define __BYTECODE_OP(op)                                  \
+    case Type::op:                                         \
+        return static_cast<const Op::op&>(*this).length();
+        ENUMERATE_BYTECODE_OPS(__BYTECODE_OP)
+#undef __BYTECODE_OP
+    }
+    VERIFY_NOT_REACHED();
+}
+
+String Instruction::to_string(const Executable& executable) const
+{
+    switch (type()) {
+#define __BYTECODE_OP(op)                                               \
+    case Type::op:                                                      \
+        return static_cast<const Op::op&>(*this).to_string(executable);
+        ENUMERATE_BYTECODE_OPS(__BYTECODE_OP)
+#undef __BYTECODE_OP
+    }
+    VERIFY_NOT_REACHED();
+}
+
+void Instruction::execute(Interpreter& interpreter) const
+{
+    switch (type()) {
+#define __BYTECODE_OP(op)                                       \
+    case Type::op:                                              \
+        static_cast<const Op::op&>(*this).execute(interpreter); \
+        return;
+        ENUMERATE_BYTECODE_OPS(__BYTECODE_OP)
+#undef __BYTECODE_OP
+    }
+    VERIFY_NOT_REACHED();
+}
+
+}
+
+namespace JS::Bytecode::Op {
+
+static String format_register_list(const Register* registers, size_t count)
+{
+    StringBuilder builder;
+    for (size_t i = 0; i < count; ++i) {
+        if (i != 0)
+            builder.append(", ");
+        builder.appendff("{}", registers[i]);
+    }
+    return builder.to_string();
+}
+
+void Load::execute(Bytecode::Interpreter& interpreter) const
+{
+    interpreter.reg(m_dst) = interpreter.reg(m_src);
+}
+
+String Load::to_string(const Bytecode::Executable&) const
+{
+    return String::formatted("Load {}, {}", m_dst, m_src);
+}
+
+void LoadImmediate::execute(Bytecode::Interpreter& interpreter) const
+{
+    interpreter.reg(m_dst) = m_value;
+}
+
+String LoadImmediate::to_string(const Bytecode::Executable&) const
+{
+    return String::formatted("LoadImmediate {}, {}", m_dst, m_value.to_string_without_side_effects());
+}
+
+void NewString::execute(Bytecode::Interpreter& interpreter) const
+{
+    interpreter.reg(m_dst) = js_string(interpreter.vm(), interpreter.current_executable().string(m_string));
+}
+
+String NewString::to_string(const Bytecode::Executable& executable) const
+{
+    return String::formatted("NewString {}, \"{}\"", m_dst, executable.string(m_string));
+}
+
+void NewArray::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto* array = Array::create(interpreter.global_object());
+    for (size_t i = 0; i < m_element_count; ++i)
+        array->indexed_properties().append(interpreter.reg(m_elements[i]));
+    interpreter.reg(m_dst) = array;
+}
+
+String NewArray::to_string(const Bytecode::Executable&) const
+{
+    return String::formatted("NewArray {}, [{}]", m_dst, format_register_list(m_elements, m_element_count));
+}
+
+void GetVariable::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto& vm = interpreter.vm();
+    auto& name = interpreter.current_executable().identifier(m_identifier);
+    auto value = vm.get_variable(name, interpreter.global_object());
+    if (value.is_empty()) {
+        if (!vm.exception())
+            vm.throw_exception<ReferenceError>(interpreter.global_object(), ErrorType::UnknownIdentifier, name);
+        return;
+    }
+    interpreter.reg(m_dst) = value;
+}
+
+String GetVariable::to_string(const Bytecode::Executable& executable) const
+{
+    return String::formatted("GetVariable {}, {}", m_dst, executable.identifier(m_identifier));
+}
+
+void SetVariable::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto& name = interpreter.current_executable().identifier(m_identifier);
+    interpreter.vm().set_variable(name, interpreter.reg(m_src), interpreter.global_object(), m_is_initialization);
+}
+
+String SetVariable::to_string(const Bytecode::Executable& executable) const
+{
+    return String::formatted("SetVariable {}, {}{}", executable.identifier(m_identifier), m_src, m_is_initialization ? " (initialization)" : "");
+}
+
+void GetById::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto* object = interpreter.reg(m_base).to_object(interpreter.global_object());
+    if (!object)
+        return;
+    auto& executable = interpreter.current_executable();
+    auto value = object->get_with_cache(executable.identifier(m_property), executable.property_lookup_cache(m_cache));
+    interpreter.reg(m_dst) = value.value_or(js_undefined());
+}
+
+String GetById::to_string(const Bytecode::Executable& executable) const
+{
+    return String::formatted("GetById {}, {}, {}", m_dst, m_base, executable.identifier(m_property));
+}
+
+void PutById::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto& executable = interpreter.current_executable();
+    Reference reference { interpreter.reg(m_base), executable.identifier(m_property) };
+    reference.set_put_cache(&executable.property_lookup_cache(m_cache));
+    reference.put(interpreter.global_object(), interpreter.reg(m_src));
+}
+
+String PutById::to_string(const Bytecode::Executable& executable) const
+{
+    return String::formatted("PutById {}, {}, {}", m_base, executable.identifier(m_property), m_src);
+}
+
+void GetByValue::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto& global_object = interpreter.global_object();
+    auto* object = interpreter.reg(m_base).to_object(global_object);
+    if (!object)
+        return;
+    auto property_name = PropertyName::from_value(global_object, interpreter.reg(m_property));
+    if (interpreter.vm().exception())
+        return;
+    auto value = object->get(property_name);
+    interpreter.reg(m_dst) = value.value_or(js_undefined());
+}
+
+String GetByValue::to_string(const Bytecode::Executable&) const
+{
+    return String::formatted("GetByValue {}, {}, {}", m_dst, m_base, m_property);
+}
+
+void PutByValue::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto& global_object = interpreter.global_object();
+    auto property_name = PropertyName::from_value(global_object, interpreter.reg(m_property));
+    if (interpreter.vm().exception())
+        return;
+    Reference reference { interpreter.reg(m_base), property_name };
+    reference.put(global_object, interpreter.reg(m_src));
+}
+
+String PutByValue::to_string(const Bytecode::Executable&) const
+{
+    return String::formatted("PutByValue {}, {}, {}", m_base, m_property, m_src);
+}
+
+void ToObject::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto* object = interpreter.reg(m_src).to_object(interpreter.global_object());
+    if (!object)
+        return;
+    interpreter.reg(m_dst) = object;
+}
+
+String ToObject::to_string(const Bytecode::Executable&) const
+{
+    return String::formatted("ToObject {}, {}", m_dst, m_src);
+}
+
+void ToNumeric::execute(Bytecode::Interpreter& interpreter) const
+{
+    interpreter.reg(m_dst) = interpreter.reg(m_src).to_numeric(interpreter.global_object());
+}
+
+String ToNumeric::to_string(const Bytecode::Executable&) const
+{
+    return String::formatted("ToNumeric {}, {}", m_dst, m_src);
+}
+
+// Increment and Decrement expect an operand that has already been through ToNumeric.
+void Increment::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto old_value = interpreter.reg(m_src);
+    if (old_value.is_number())
+        interpreter.reg(m_dst) = Value(old_value.as_double() + 1);
+    else
+        interpreter.reg(m_dst) = js_bigint(interpreter.vm().heap(), old_value.as_bigint().big_integer().plus(Crypto::SignedBigInteger { 1 }));
+}
+
+String Increment::to_string(const Bytecode::Executable&) const
+{
+    return String::formatted("Increment {}, {}", m_dst, m_src);
+}
+
+void Decrement::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto old_value = interpreter.reg(m_src);
+    if (old_value.is_number())
+        interpreter.reg(m_dst) = Value(old_value.as_double() - 1);
+    else
+        interpreter.reg(m_dst) = js_bigint(interpreter.vm().heap(), old_value.as_bigint().big_integer().minus(Crypto::SignedBigInteger { 1 }));
+}
+
+String Decrement::to_string(const Bytecode::Executable&) const
+{
+    return String::formatted("Decrement {}, {}", m_dst, m_src);
+}
+
+void ResolveThisBinding::execute(Bytecode::Interpreter& interpreter) const
+{
+    interpreter.reg(m_dst) = interpreter.vm().resolve_this_binding(interpreter.global_object());
+}
+
+String ResolveThisBinding::to_string(const Bytecode::Executable&) const
+{
+    return String::formatted("ResolveThisBinding {}", m_dst);
+}
+
+void Call::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto& vm = interpreter.vm();
+    auto& global_object = interpreter.global_object();
+
+    auto callee = interpreter.reg(m_callee);
+    if (!callee.is_function()
+        || (m_type == CallType::Construct && is<NativeFunction>(callee.as_object()) && !static_cast<NativeFunction&>(callee.as_object()).has_constructor())) {
+        m_expression->throw_type_error_for_callee(global_object, callee);
+        return;
+    }
+    auto& function = callee.as_function();
+
+    MarkedValueList arguments(vm.heap());
+    arguments.ensure_capacity(m_argument_count);
+    for (size_t i = 0; i < m_argument_count; ++i)
+        arguments.append(interpreter.reg(m_arguments[i]));
+
+    vm.call_frame().current_node = m_expression;
+    Value result;
+    if (m_type == CallType::Construct)
+        result = vm.construct(function, function, move(arguments), global_object);
+    else
+        result = vm.call(function, m_has_this_value ? interpreter.reg(m_this_value) : &global_object, move(arguments));
+
+    // The callee may have run bytecode of its own, so only look up the destination register now.
+    interpreter.reg(m_dst) = result;
+}
+
+String Call::to_string(const Bytecode::Executable&) const
+{
+    StringBuilder builder;
+    builder.appendff("{} {}, {}", m_type == CallType::Construct ? "Construct" : "Call", m_dst, m_callee);
+    if (m_has_this_value)
+        builder.appendff(", this:{}", m_this_value);
+    builder.appendff(", ({})", format_register_list(m_arguments, m_argument_count));
+    return builder.to_string();
+}
+
+void Jump::execute(Bytecode::Interpreter& interpreter) const
+{
+    interpreter.jump(m_target);
+}
+
+String Jump::to_string(const Bytecode::Executable&) const
+{
+    return String::formatted("Jump {}", m_target);
+}
+
+void JumpConditional::execute(Bytecode::Interpreter& interpreter) const
+{
+    interpreter.jump(interpreter.reg(m_condition).to_boolean() ? m_true_target : m_false_target);
+}
+
+String JumpConditional::to_string(const Bytecode::Executable&) const
+{
+    return String::formatted("JumpConditional {}, true:{}, false:{}", m_condition, m_true_target, m_false_target);
+}
+
+void JumpNullish::execute(Bytecode::Interpreter& interpreter) const
+{
+    interpreter.jump(interpreter.reg(m_condition).is_nullish() ? m_nullish_target : m_otherwise_target);
+}
+
+String JumpNullish::to_string(const Bytecode::Executable&) const
+{
+    return String::formatted("JumpNullish {}, nullish:{}, otherwise:{}", m_condition, m_nullish_target, m_otherwise_target);
+}
+
+void Return::execute(Bytecode::Interpreter& interpreter) const
+{
+    interpreter.do_return(interpreter.reg(m_value));
+}
+
+String Return::to_string(const Bytecode::Executable&) const
+{
+    return String::formatted("Return {}", m_value);
+}
+
+void EnterScope::execute(Bytecode::Interpreter& interpreter) const
+{
+    interpreter.enter_scope(*m_scope_node, m_scope_type);
+}
+
+String EnterScope::to_string(const Bytecode::Executable&) const
+{
+    return String::formatted("EnterScope {} ({})", m_scope_node->class_name(), m_scope_type == ScopeType::Function ? "function" : "block");
+}
+
+void ExitScope::execute(Bytecode::Interpreter& interpreter) const
+{
+    interpreter.exit_scope(*m_scope_node);
+}
+
+String ExitScope::to_string(const Bytecode::Executable&) const
+{
+    return String::formatted("ExitScope {}", m_scope_node->class_name());
+}
+
+void EvaluateExpression::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto value = m_expression->execute(interpreter.ast_interpreter(), interpreter.global_object());
+    if (interpreter.vm().exception())
+        return;
+    interpreter.reg(m_dst) = value;
+}
+
+String EvaluateExpression::to_string(const Bytecode::Executable&) const
+{
+    return String::formatted("EvaluateExpression {}, {}", m_dst, m_expression->class_name());
+}
+
+void ExecuteStatement::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto& vm = interpreter.vm();
+    auto value = interpreter.ast_interpreter().execute_statement(interpreter.global_object(), *m_statement);
+    if (vm.exception())
+        return;
+    interpreter.reg(m_dst) = value.value_or(js_undefined());
+
+    if (!vm.should_unwind())
+        return;
+
+    if (vm.should_unwind_until(ScopeType::Function)) {
+        vm.stop_unwind();
+        interpreter.do_return(value.is_empty() ? vm.last_value().value_or(js_undefined()) : value);
+        return;
+    }
+
+    if (m_unwind_table != no_unwind_table) {
+        auto& targets = interpreter.current_executable().unwind_tables[m_unwind_table];
+        for (size_t i = targets.size(); i > 0; --i) {
+            auto& target = targets[i - 1];
+            const BasicBlock* destination = nullptr;
+            if (target.continue_target && vm.should_unwind_until(ScopeType::Continuable, target.label))
+                destination = target.continue_target;
+            else if (vm.should_unwind_until(ScopeType::Breakable, target.label))
+                destination = target.break_target;
+            if (!destination)
+                continue;
+            vm.stop_unwind();
+            interpreter.exit_scopes_until_depth(target.scope_depth);
+            interpreter.jump(Label { *destination });
+            return;
+        }
+    }
+
+    // Nobody in this executable is waiting for it, so leave the unwind pending for our caller, just like
+    // the AST interpreter does when a break escapes a function body.
+    interpreter.do_return(js_undefined());
+}
+
+String ExecuteStatement::to_string(const Bytecode::Executable&) const
+{
+    return String::formatted("ExecuteStatement {}, {}", m_dst, m_statement->class_name());
+}
+
+static Value abstract_inequals(GlobalObject& global_object, Value lhs, Value rhs)
+{
+    return Value(!abstract_eq(global_object, lhs, rhs));
+}
+
+static Value abstract_equals(GlobalObject& global_object, Value lhs, Value rhs)
+{
+    return Value(abstract_eq(global_object, lhs, rhs));
+}
+
+static Value typed_inequals(GlobalObject&, Value lhs, Value rhs)
+{
+    return Value(!strict_eq(lhs, rhs));
+}
+
+static Value typed_equals(GlobalObject&, Value lhs, Value rhs)
+{
+    return Value(strict_eq(lhs, rhs));
+}
+
+#define JS_DEFINE_COMMON_BINARY_OP(OpTitleCase, op_snake_case)                                                               \
+    void OpTitleCase::execute(Bytecode::Interpreter& interpreter) const                                                      \
+    {                                                                                                                        \
+        interpreter.reg(m_dst) = op_snake_case(interpreter.global_object(), interpreter.reg(m_lhs), interpreter.reg(m_rhs)); \
+    }                                                                                                                        \
+                                                                                                                             \
+    String OpTitleCase::to_string(const Bytecode::Executable&) const                                                         \
+    {                                                                                                                        \
+        return String::formatted(#OpTitleCase " {}, {}, {}", m_dst, m_lhs, m_rhs);                                           \
+    }
+
+JS_ENUMERATE_COMMON_BINARY_OPS(JS_DEFINE_COMMON_BINARY_OP)
+#undef JS_DEFINE_COMMON_BINARY_OP
+
+static Value not_(GlobalObject&, Value value)
+{
+    return Value(!value.to_boolean());
+}
+
+static Value typeof_(GlobalObject& global_object, Value value)
+{
+    return js_string(global_object.vm(), value.typeof());
+}
+
+#define JS_DEFINE_COMMON_UNARY_OP(OpTitleCase, op_snake_case)                                        \
+    void OpTitleCase::execute(Bytecode::Interpreter& interpreter) const                              \
+    {                                                                                                \
+        interpreter.reg(m_dst) = op_snake_case(interpreter.global_object(), interpreter.reg(m_src)); \
+    }                                                                                                \
+                                                                                                     \
+    String OpTitleCase::to_string(const Bytecode::Executable&) const                                 \
+    {                                                                                                \
+        return String::formatted(#OpTitleCase " {}, {}", m_dst, m_src);                              \
+    }
+
+JS_ENUMERATE_COMMON_UNARY_OPS(JS_DEFINE_COMMON_UNARY_OP)
+#undef JS_DEFINE_COMMON_UNARY_OP
+
+}
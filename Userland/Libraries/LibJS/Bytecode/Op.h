@@ -0,0 +1,549 @@
+/*
+ * Copyright (c) 2021, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/NumericLimits.h>
+#include <AK/Optional.h>
+#include <LibJS/Bytecode/Executable.h>
+#include <LibJS/Bytecode/Instruction.h>
+#include <LibJS/Bytecode/Label.h>
+#include <LibJS/Bytecode/Register.h>
+#include <LibJS/Runtime/VM.h>
+#include <LibJS/Runtime/Value.h>
+
+namespace JS::Bytecode::Op {
+
+class Load final : public Instruction {
+public:
+    Load(Register dst, Register src)
+        : Instruction(Type::Load)
+        , m_dst(dst)
+        , m_src(src)
+    {
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this); }
+
+private:
+    Register m_dst;
+    Register m_src;
+};
+
+class LoadImmediate final : public Instruction {
+public:
+    LoadImmediate(Register dst, Value value)
+        : Instruction(Type::LoadImmediate)
+        , m_dst(dst)
+        , m_value(value)
+    {
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this); }
+
+private:
+    Register m_dst;
+    Value m_value;
+};
+
+class NewString final : public Instruction {
+public:
+    NewString(Register dst, StringTableIndex string)
+        : Instruction(Type::NewString)
+        , m_dst(dst)
+        , m_string(string)
+    {
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this); }
+
+private:
+    Register m_dst;
+    StringTableIndex m_string;
+};
+
+class NewArray final : public Instruction {
+public:
+    NewArray(Register dst, const Vector<Register>& elements)
+        : Instruction(Type::NewArray)
+        , m_dst(dst)
+        , m_element_count(elements.size())
+    {
+        for (size_t i = 0; i < m_element_count; ++i)
+            new (&m_elements[i]) Register(elements[i]);
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this) + sizeof(Register) * m_element_count; }
+
+private:
+    Register m_dst;
+    size_t m_element_count { 0 };
+    Register m_elements[];
+};
+
+class GetVariable final : public Instruction {
+public:
+    GetVariable(Register dst, IdentifierTableIndex identifier)
+        : Instruction(Type::GetVariable)
+        , m_dst(dst)
+        , m_identifier(identifier)
+    {
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this); }
+
+private:
+    Register m_dst;
+    IdentifierTableIndex m_identifier;
+};
+
+class SetVariable final : public Instruction {
+public:
+    SetVariable(IdentifierTableIndex identifier, Register src, bool is_initialization)
+        : Instruction(Type::SetVariable)
+        , m_identifier(identifier)
+        , m_src(src)
+        , m_is_initialization(is_initialization)
+    {
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this); }
+
+private:
+    IdentifierTableIndex m_identifier;
+    Register m_src;
+    bool m_is_initialization { false };
+};
+
+class GetById final : public Instruction {
+public:
+    GetById(Register dst, Register base, IdentifierTableIndex property, PropertyLookupCacheIndex cache)
+        : Instruction(Type::GetById)
+        , m_dst(dst)
+        , m_base(base)
+        , m_property(property)
+        , m_cache(cache)
+    {
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this); }
+
+private:
+    Register m_dst;
+    Register m_base;
+    IdentifierTableIndex m_property;
+    PropertyLookupCacheIndex m_cache;
+};
+
+class PutById final : public Instruction {
+public:
+    PutById(Register base, IdentifierTableIndex property, Register src, PropertyLookupCacheIndex cache)
+        : Instruction(Type::PutById)
+        , m_base(base)
+        , m_property(property)
+        , m_src(src)
+        , m_cache(cache)
+    {
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this); }
+
+private:
+    Register m_base;
+    IdentifierTableIndex m_property;
+    Register m_src;
+    PropertyLookupCacheIndex m_cache;
+};
+
+class GetByValue final : public Instruction {
+public:
+    GetByValue(Register dst, Register base, Register property)
+        : Instruction(Type::GetByValue)
+        , m_dst(dst)
+        , m_base(base)
+        , m_property(property)
+    {
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this); }
+
+private:
+    Register m_dst;
+    Register m_base;
+    Register m_property;
+};
+
+class PutByValue final : public Instruction {
+public:
+    PutByValue(Register base, Register property, Register src)
+        : Instruction(Type::PutByValue)
+        , m_base(base)
+        , m_property(property)
+        , m_src(src)
+    {
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this); }
+
+private:
+    Register m_base;
+    Register m_property;
+    Register m_src;
+};
+
+#define JS_DECLARE_UNARY_CONVERSION_OP(OpTitleCase)          \
+    class OpTitleCase final : public Instruction {           \
+    public:                                                  \
+        OpTitleCase(Register dst, Register src)              \
+            : Instruction(Type::OpTitleCase)                 \
+            , m_dst(dst)                                     \
+            , m_src(src)                                     \
+        {                                                    \
+        }                                                    \
+                                                             \
+        void execute(Bytecode::Interpreter&) const;          \
+        String to_string(const Bytecode::Executable&) const; \
+        size_t length() const { return sizeof(*this); }      \
+                                                             \
+    private:                                                 \
+        Register m_dst;                                      \
+        Register m_src;                                      \
+    };
+
+JS_DECLARE_UNARY_CONVERSION_OP(ToObject)
+JS_DECLARE_UNARY_CONVERSION_OP(ToNumeric)
+JS_DECLARE_UNARY_CONVERSION_OP(Increment)
+JS_DECLARE_UNARY_CONVERSION_OP(Decrement)
+#undef JS_DECLARE_UNARY_CONVERSION_OP
+
+class ResolveThisBinding final : public Instruction {
+public:
+    explicit ResolveThisBinding(Register dst)
+        : Instruction(Type::ResolveThisBinding)
+        , m_dst(dst)
+    {
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this); }
+
+private:
+    Register m_dst;
+};
+
+class Call final : public Instruction {
+public:
+    enum class CallType {
+        Call,
+        Construct,
+    };
+
+    // Without a this value, the callee is called with the global object as this, like the AST interpreter does.
+    Call(CallType type, Register dst, Register callee, Optional<Register> this_value, const CallExpression& expression, const Vector<Register>& arguments)
+        : Instruction(Type::Call)
+        , m_type(type)
+        , m_dst(dst)
+        , m_callee(callee)
+        , m_this_value(this_value.value_or(callee))
+        , m_has_this_value(this_value.has_value())
+        , m_expression(&expression)
+        , m_argument_count(arguments.size())
+    {
+        for (size_t i = 0; i < m_argument_count; ++i)
+            new (&m_arguments[i]) Register(arguments[i]);
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this) + sizeof(Register) * m_argument_count; }
+
+private:
+    CallType m_type;
+    Register m_dst;
+    Register m_callee;
+    Register m_this_value;
+    bool m_has_this_value { false };
+    const CallExpression* m_expression;
+    size_t m_argument_count { 0 };
+    Register m_arguments[];
+};
+
+class Jump final : public Instruction {
+public:
+    static constexpr bool IsTerminator = true;
+
+    explicit Jump(Label target)
+        : Instruction(Type::Jump)
+        , m_target(target)
+    {
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this); }
+
+private:
+    Label m_target;
+};
+
+class JumpConditional final : public Instruction {
+public:
+    static constexpr bool IsTerminator = true;
+
+    JumpConditional(Register condition, Label true_target, Label false_target)
+        : Instruction(Type::JumpConditional)
+        , m_condition(condition)
+        , m_true_target(true_target)
+        , m_false_target(false_target)
+    {
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this); }
+
+private:
+    Register m_condition;
+    Label m_true_target;
+    Label m_false_target;
+};
+
+class JumpNullish final : public Instruction {
+public:
+    static constexpr bool IsTerminator = true;
+
+    JumpNullish(Register condition, Label nullish_target, Label otherwise_target)
+        : Instruction(Type::JumpNullish)
+        , m_condition(condition)
+        , m_nullish_target(nullish_target)
+        , m_otherwise_target(otherwise_target)
+    {
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this); }
+
+private:
+    Register m_condition;
+    Label m_nullish_target;
+    Label m_otherwise_target;
+};
+
+class Return final : public Instruction {
+public:
+    static constexpr bool IsTerminator = true;
+
+    explicit Return(Register value)
+        : Instruction(Type::Return)
+        , m_value(value)
+    {
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this); }
+
+private:
+    Register m_value;
+};
+
+class EnterScope final : public Instruction {
+public:
+    EnterScope(const ScopeNode& scope_node, ScopeType scope_type)
+        : Instruction(Type::EnterScope)
+        , m_scope_node(&scope_node)
+        , m_scope_type(scope_type)
+    {
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this); }
+
+private:
+    const ScopeNode* m_scope_node;
+    ScopeType m_scope_type;
+};
+
+class ExitScope final : public Instruction {
+public:
+    explicit ExitScope(const ScopeNode& scope_node)
+        : Instruction(Type::ExitScope)
+        , m_scope_node(&scope_node)
+    {
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this); }
+
+private:
+    const ScopeNode* m_scope_node;
+};
+
+// Runs an expression the generator doesn't know how to compile yet on the AST interpreter.
+class EvaluateExpression final : public Instruction {
+public:
+    EvaluateExpression(Register dst, const Expression& expression)
+        : Instruction(Type::EvaluateExpression)
+        , m_dst(dst)
+        , m_expression(&expression)
+    {
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this); }
+
+private:
+    Register m_dst;
+    const Expression* m_expression;
+};
+
+// Like EvaluateExpression, but for statements. A break, continue or return coming out of the statement
+// is turned into a jump to the matching target in the unwind table, or into a return.
+class ExecuteStatement final : public Instruction {
+public:
+    static constexpr size_t no_unwind_table = NumericLimits<size_t>::max();
+
+    ExecuteStatement(Register dst, const Statement& statement, size_t unwind_table)
+        : Instruction(Type::ExecuteStatement)
+        , m_dst(dst)
+        , m_statement(&statement)
+        , m_unwind_table(unwind_table)
+    {
+    }
+
+    void execute(Bytecode::Interpreter&) const;
+    String to_string(const Bytecode::Executable&) const;
+    size_t length() const { return sizeof(*this); }
+
+private:
+    Register m_dst;
+    const Statement* m_statement;
+    size_t m_unwind_table { no_unwind_table };
+};
+
+#define JS_ENUMERATE_COMMON_BINARY_OPS(O)       \
+    O(Add, add)                                 \
+    O(Sub, sub)                                 \
+    O(Mul, mul)                                 \
+    O(Div, div)                                 \
+    O(Mod, mod)                                 \
+    O(Exp, exp)                                 \
+    O(GreaterThan, greater_than)                \
+    O(GreaterThanEquals, greater_than_equals)   \
+    O(LessThan, less_than)                      \
+    O(LessThanEquals, less_than_equals)         \
+    O(AbstractInequals, abstract_inequals)      \
+    O(AbstractEquals, abstract_equals)          \
+    O(TypedInequals, typed_inequals)            \
+    O(TypedEquals, typed_equals)                \
+    O(BitwiseAnd, bitwise_and)                  \
+    O(BitwiseOr, bitwise_or)                    \
+    O(BitwiseXor, bitwise_xor)                  \
+    O(LeftShift, left_shift)                    \
+    O(RightShift, right_shift)                  \
+    O(UnsignedRightShift, unsigned_right_shift) \
+    O(In, in)                                   \
+    O(InstanceOf, instance_of)
+
+#define JS_DECLARE_COMMON_BINARY_OP(OpTitleCase, op_snake_case) \
+    class OpTitleCase final : public Instruction {              \
+    public:                                                     \
+        OpTitleCase(Register dst, Register lhs, Register rhs)   \
+            : Instruction(Type::OpTitleCase)                    \
+            , m_dst(dst)                                        \
+            , m_lhs(lhs)                                        \
+            , m_rhs(rhs)                                        \
+        {                                                       \
+        }                                                       \
+                                                                \
+        void execute(Bytecode::Interpreter&) const;             \
+        String to_string(const Bytecode::Executable&) const;    \
+        size_t length() const { return sizeof(*this); }         \
+                                                                \
+    private:                                                    \
+        Register m_dst;                                         \
+        Register m_lhs;                                         \
+        Register m_rhs;                                         \
+    };
+
+JS_ENUMERATE_COMMON_BINARY_OPS(JS_DECLARE_COMMON_BINARY_OP)
+#undef JS_DECLARE_COMMON_BINARY_OP
+
+#define JS_ENUMERATE_COMMON_UNARY_OPS(O) \
+    O(BitwiseNot, bitwise_not)           \
+    O(Not, not_)                         \
+    O(UnaryPlus, unary_plus)             \
+    O(UnaryMinus, unary_minus)           \
+    O(Typeof, typeof_)
+
+#define JS_DECLARE_COMMON_UNARY_OP(OpTitleCase, op_snake_case) \
+    class OpTitleCase final : public Instruction {             \
+    public:                                                    \
+        OpTitleCase(Register dst, Register src)                \
+            : Instruction(Type::OpTitleCase)                   \
+            , m_dst(dst)                                       \
+            , m_src(src)                                       \
+        {                                                      \
+        }                                                      \
+                                                               \
+        void execute(Bytecode::Interpreter&) const;            \
+        String to_string(const Bytecode::Executable&) const;   \
+        size_t length() const { return sizeof(*this); }        \
+                                                               \
+    private:                                                   \
+        Register m_dst;                                        \
+        Register m_src;                                        \
+    };
+
+JS_ENUMERATE_COMMON_UNARY_OPS(JS_DECLARE_COMMON_UNARY_OP)
+#undef JS_DECLARE_COMMON_UNARY_OP
+
+}
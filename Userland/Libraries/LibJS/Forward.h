@@ -178,4 +178,14 @@ JS_ENUMERATE_TYPED_ARRAYS
 template<class T>
 class Handle;
 
+namespace Bytecode {
+class BasicBlock;
+class Generator;
+class Instruction;
+class Interpreter;
+class Label;
+class Register;
+struct Executable;
+}
+
 }
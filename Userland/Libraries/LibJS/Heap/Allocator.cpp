@@ -25,7 +25,9 @@
  */
 
 #include <AK/Badge.h>
+#include <AK/Debug.h>
 #include <LibJS/Heap/Allocator.h>
+#include <LibJS/Heap/Heap.h>
 #include <LibJS/Heap/HeapBlock.h>
 
 namespace JS {
@@ -41,8 +43,12 @@ Allocator::~Allocator()
 
 Cell* Allocator::allocate_cell(Heap& heap)
 {
+    while (m_usable_blocks.is_empty() && has_blocks_to_sweep())
+        sweep_next_block();
+
     if (m_usable_blocks.is_empty()) {
         auto block = HeapBlock::create_with_cell_size(heap, m_cell_size);
+        heap.did_create_heap_block({}, *block);
         m_usable_blocks.append(*block.leak_ptr());
     }
 
@@ -54,16 +60,30 @@ Cell* Allocator::allocate_cell(Heap& heap)
     return cell;
 }
 
-void Allocator::block_did_become_empty(Badge<Heap>, HeapBlock& block)
+void Allocator::queue_all_blocks_for_sweeping(Badge<Heap>)
 {
-    block.m_list_node.remove();
-    delete &block;
+    while (auto* block = m_full_blocks.take_first())
+        m_blocks_to_sweep.append(*block);
+    while (auto* block = m_usable_blocks.take_first())
+        m_blocks_to_sweep.append(*block);
 }
 
-void Allocator::block_did_become_usable(Badge<Heap>, HeapBlock& block)
+HeapBlock::SweepResult Allocator::sweep_next_block()
 {
-    VERIFY(!block.is_full());
-    m_usable_blocks.append(block);
+    auto& block = *m_blocks_to_sweep.take_first();
+    auto result = block.sweep();
+    if (!result.live_cells) {
+#if HEAP_DEBUG
+        dbgln(" - HeapBlock empty @ {}: cell_size={}", &block, block.cell_size());
+#endif
+        block.heap().will_destroy_heap_block({}, block);
+        delete &block;
+    } else if (block.is_full()) {
+        m_full_blocks.append(block);
+    } else {
+        m_usable_blocks.append(block);
+    }
+    return result;
 }
 
 }
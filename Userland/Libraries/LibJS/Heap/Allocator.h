@@ -54,11 +54,18 @@ public:
             if (callback(block) == IterationDecision::Break)
                 return IterationDecision::Break;
         }
+        for (auto& block : m_blocks_to_sweep) {
+            if (callback(block) == IterationDecision::Break)
+                return IterationDecision::Break;
+        }
         return IterationDecision::Continue;
     }
 
-    void block_did_become_empty(Badge<Heap>, HeapBlock&);
-    void block_did_become_usable(Badge<Heap>, HeapBlock&);
+    // After marking, every block is queued up for sweeping. Blocks are then swept one at a time,
+    // either when we run out of usable blocks or in slices between allocations.
+    void queue_all_blocks_for_sweeping(Badge<Heap>);
+    bool has_blocks_to_sweep() const { return !m_blocks_to_sweep.is_empty(); }
+    HeapBlock::SweepResult sweep_next_block();
 
 private:
     const size_t m_cell_size;
@@ -66,6 +73,7 @@ private:
     typedef IntrusiveList<HeapBlock, &HeapBlock::m_list_node> BlockList;
     BlockList m_full_blocks;
     BlockList m_usable_blocks;
+    BlockList m_blocks_to_sweep;
 };
 
 }
@@ -76,6 +76,8 @@ Cell* Heap::allocate_cell(size_t size)
         collect_garbage();
     } else {
         ++m_allocations_since_last_gc;
+        if (m_may_have_blocks_to_sweep && m_allocations_since_last_gc % m_allocations_per_sweep_slice == 0)
+            sweep_next_block();
     }
 
     auto& allocator = allocator_for_size(size);
@@ -89,16 +91,77 @@ void Heap::collect_garbage(CollectionType collection_type, bool print_report)
 
     Core::ElapsedTimer collection_measurement_timer;
     collection_measurement_timer.start();
+
+    if (collection_type == CollectionType::CollectGarbage && m_gc_deferrals) {
+        m_should_gc_when_deferral_ends = true;
+        return;
+    }
+
+    // Whatever is still waiting to be swept from last time has to go first, both because marking
+    // reuses the mark bits, and because a dead cell must not come back to life through a stale
+    // pointer on the stack after the cells it refers to have been freed.
+    finish_sweeping();
+
+    size_t marked_cells = 0;
     if (collection_type == CollectionType::CollectGarbage) {
-        if (m_gc_deferrals) {
-            m_should_gc_when_deferral_ends = true;
-            return;
-        }
         HashTable<Cell*> roots;
         gather_roots(roots);
-        mark_live_cells(roots);
+        marked_cells = mark_live_cells(roots);
+    }
+
+    // Sweeping is spread over the allocations until the next collection, so a larger heap only
+    // makes the pause longer by the time it takes to mark it. Collecting less often as the heap
+    // grows keeps the total amount of work per allocation in check.
+    m_max_allocations_between_gc = max(min_allocations_between_gc, marked_cells);
+    queue_all_blocks_for_sweeping();
+    if (collection_type == CollectionType::CollectEverything || print_report) {
+        auto sweep_result = finish_sweeping();
+        if (print_report) {
+            size_t live_block_count = m_blocks.size();
+            dbgln("Garbage collection report");
+            dbgln("=============================================");
+            dbgln("     Time spent: {} ms", collection_measurement_timer.elapsed());
+            dbgln("     Live cells: {}", sweep_result.live_cells);
+            dbgln("Collected cells: {}", sweep_result.collected_cells);
+            dbgln("    Live blocks: {} ({} bytes)", live_block_count, live_block_count * HeapBlock::block_size);
+            dbgln("=============================================");
+        }
+    }
+}
+
+void Heap::queue_all_blocks_for_sweeping()
+{
+    size_t block_count = m_blocks.size();
+    for (auto& allocator : m_allocators)
+        allocator->queue_all_blocks_for_sweeping({});
+    m_may_have_blocks_to_sweep = block_count > 0;
+    // Aim to be done with sweeping halfway to the next collection.
+    m_allocations_per_sweep_slice = max((size_t)1, m_max_allocations_between_gc / (2 * block_count + 1));
+}
+
+HeapBlock::SweepResult Heap::finish_sweeping()
+{
+    HeapBlock::SweepResult total;
+    for (auto& allocator : m_allocators) {
+        while (allocator->has_blocks_to_sweep()) {
+            auto result = allocator->sweep_next_block();
+            total.live_cells += result.live_cells;
+            total.collected_cells += result.collected_cells;
+        }
+    }
+    m_may_have_blocks_to_sweep = false;
+    return total;
+}
+
+void Heap::sweep_next_block()
+{
+    for (auto& allocator : m_allocators) {
+        if (allocator->has_blocks_to_sweep()) {
+            allocator->sweep_next_block();
+            return;
+        }
     }
-    sweep_dead_cells(print_report, collection_measurement_timer);
+    m_may_have_blocks_to_sweep = false;
 }
 
 void Heap::gather_roots(HashTable<Cell*>& roots)
@@ -134,51 +197,58 @@ __attribute__((no_sanitize("address"))) void Heap::gather_conservative_roots(Has
     jmp_buf buf;
     setjmp(buf);
 
-    HashTable<FlatPtr> possible_pointers;
+    auto add_possible_root = [&](FlatPtr possible_pointer) {
+        if (possible_pointer < m_min_block_address || possible_pointer > m_max_block_address)
+            return;
+#if HEAP_DEBUG
+        dbgln("  ? {}", (const void*)possible_pointer);
+#endif
+        auto* possible_heap_block = HeapBlock::from_cell(reinterpret_cast<const Cell*>(possible_pointer));
+        if (!m_blocks.contains(possible_heap_block))
+            return;
+        auto* cell = possible_heap_block->cell_from_possible_pointer(possible_pointer);
+        if (!cell)
+            return;
+        if (cell->is_live()) {
+#if HEAP_DEBUG
+            dbgln("  ?-> {}", (const void*)cell);
+#endif
+            roots.set(cell);
+        } else {
+#if HEAP_DEBUG
+            dbgln("  #-> {}", (const void*)cell);
+#endif
+        }
+    };
 
     const FlatPtr* raw_jmp_buf = reinterpret_cast<const FlatPtr*>(buf);
 
     for (size_t i = 0; i < ((size_t)sizeof(buf)) / sizeof(FlatPtr); i += sizeof(FlatPtr))
-        possible_pointers.set(raw_jmp_buf[i]);
+        add_possible_root(raw_jmp_buf[i]);
 
     FlatPtr stack_reference = reinterpret_cast<FlatPtr>(&dummy);
     auto& stack_info = m_vm.stack_info();
 
     for (FlatPtr stack_address = stack_reference; stack_address < stack_info.top(); stack_address += sizeof(FlatPtr)) {
         auto data = *reinterpret_cast<FlatPtr*>(stack_address);
-        possible_pointers.set(data);
+        add_possible_root(data);
     }
+}
 
-    HashTable<HeapBlock*> all_live_heap_blocks;
-    for_each_block([&](auto& block) {
-        all_live_heap_blocks.set(&block);
-        return IterationDecision::Continue;
-    });
+void Heap::did_create_heap_block(Badge<Allocator>, HeapBlock& block)
+{
+    m_blocks.set(&block);
+    m_min_block_address = min(m_min_block_address, reinterpret_cast<FlatPtr>(&block));
+    m_max_block_address = max(m_max_block_address, reinterpret_cast<FlatPtr>(&block) + HeapBlock::block_size - 1);
+}
 
-    for (auto possible_pointer : possible_pointers) {
-        if (!possible_pointer)
-            continue;
-#if HEAP_DEBUG
-        dbgln("  ? {}", (const void*)possible_pointer);
-#endif
-        auto* possible_heap_block = HeapBlock::from_cell(reinterpret_cast<const Cell*>(possible_pointer));
-        if (all_live_heap_blocks.contains(possible_heap_block)) {
-            if (auto* cell = possible_heap_block->cell_from_possible_pointer(possible_pointer)) {
-                if (cell->is_live()) {
-#if HEAP_DEBUG
-                    dbgln("  ?-> {}", (const void*)cell);
-#endif
-                    roots.set(cell);
-                } else {
-#if HEAP_DEBUG
-                    dbgln("  #-> {}", (const void*)cell);
-#endif
-                }
-            }
-        }
-    }
+void Heap::will_destroy_heap_block(Badge<Allocator>, HeapBlock& block)
+{
+    VERIFY(m_blocks.contains(&block));
+    m_blocks.remove(&block);
 }
 
+// Marks iteratively using a work list, so that long chains of objects don't recurse deeply.
 class MarkingVisitor final : public Cell::Visitor {
 public:
     MarkingVisitor() { }
@@ -191,11 +261,24 @@ public:
         dbgln("  ! {}", cell);
 #endif
         cell->set_marked(true);
-        cell->visit_edges(*this);
+        ++m_marked_cells;
+        m_work_list.append(cell);
     }
+
+    void mark_all_reachable_cells()
+    {
+        while (!m_work_list.is_empty())
+            m_work_list.take_last()->visit_edges(*this);
+    }
+
+    size_t marked_cells() const { return m_marked_cells; }
+
+private:
+    Vector<Cell*> m_work_list;
+    size_t m_marked_cells { 0 };
 };
 
-void Heap::mark_live_cells(const HashTable<Cell*>& roots)
+size_t Heap::mark_live_cells(const HashTable<Cell*>& roots)
 {
 #if HEAP_DEBUG
     dbgln("mark_live_cells:");
@@ -203,87 +286,8 @@ void Heap::mark_live_cells(const HashTable<Cell*>& roots)
     MarkingVisitor visitor;
     for (auto* root : roots)
         visitor.visit(root);
-}
-
-void Heap::sweep_dead_cells(bool print_report, const Core::ElapsedTimer& measurement_timer)
-{
-#if HEAP_DEBUG
-    dbgln("sweep_dead_cells:");
-#endif
-    Vector<HeapBlock*, 32> empty_blocks;
-    Vector<HeapBlock*, 32> full_blocks_that_became_usable;
-
-    size_t collected_cells = 0;
-    size_t live_cells = 0;
-    size_t collected_cell_bytes = 0;
-    size_t live_cell_bytes = 0;
-
-    for_each_block([&](auto& block) {
-        bool block_has_live_cells = false;
-        bool block_was_full = block.is_full();
-        block.for_each_cell([&](Cell* cell) {
-            if (cell->is_live()) {
-                if (!cell->is_marked()) {
-#if HEAP_DEBUG
-                    dbgln("  ~ {}", cell);
-#endif
-                    block.deallocate(cell);
-                    ++collected_cells;
-                    collected_cell_bytes += block.cell_size();
-                } else {
-                    cell->set_marked(false);
-                    block_has_live_cells = true;
-                    ++live_cells;
-                    live_cell_bytes += block.cell_size();
-                }
-            }
-        });
-        if (!block_has_live_cells)
-            empty_blocks.append(&block);
-        else if (block_was_full != block.is_full())
-            full_blocks_that_became_usable.append(&block);
-        return IterationDecision::Continue;
-    });
-
-    for (auto* block : empty_blocks) {
-#if HEAP_DEBUG
-        dbgln(" - HeapBlock empty @ {}: cell_size={}", block, block->cell_size());
-#endif
-        allocator_for_size(block->cell_size()).block_did_become_empty({}, *block);
-    }
-
-    for (auto* block : full_blocks_that_became_usable) {
-#if HEAP_DEBUG
-        dbgln(" - HeapBlock usable again @ {}: cell_size={}", block, block->cell_size());
-#endif
-        allocator_for_size(block->cell_size()).block_did_become_usable({}, *block);
-    }
-
-#if HEAP_DEBUG
-    for_each_block([&](auto& block) {
-        dbgln(" > Live HeapBlock @ {}: cell_size={}", &block, block.cell_size());
-        return IterationDecision::Continue;
-    });
-#endif
-
-    int time_spent = measurement_timer.elapsed();
-
-    if (print_report) {
-        size_t live_block_count = 0;
-        for_each_block([&](auto&) {
-            ++live_block_count;
-            return IterationDecision::Continue;
-        });
-
-        dbgln("Garbage collection report");
-        dbgln("=============================================");
-        dbgln("     Time spent: {} ms", time_spent);
-        dbgln("     Live cells: {} ({} bytes)", live_cells, live_cell_bytes);
-        dbgln("Collected cells: {} ({} bytes)", collected_cells, collected_cell_bytes);
-        dbgln("    Live blocks: {} ({} bytes)", live_block_count, live_block_count * HeapBlock::block_size);
-        dbgln("   Freed blocks: {} ({} bytes)", empty_blocks.size(), empty_blocks.size() * HeapBlock::block_size);
-        dbgln("=============================================");
-    }
+    visitor.mark_all_reachable_cells();
+    return visitor.marked_cells();
 }
 
 void Heap::did_create_handle(Badge<HandleImpl>, HandleImpl& impl)
@@ -29,12 +29,14 @@
 #include <AK/HashTable.h>
 #include <AK/Noncopyable.h>
 #include <AK/NonnullOwnPtr.h>
+#include <AK/NumericLimits.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
 #include <LibCore/Forward.h>
 #include <LibJS/Forward.h>
 #include <LibJS/Heap/Allocator.h>
 #include <LibJS/Heap/Handle.h>
+#include <LibJS/Heap/HeapBlock.h>
 #include <LibJS/Runtime/Cell.h>
 #include <LibJS/Runtime/Object.h>
 
@@ -92,13 +94,18 @@ public:
     void defer_gc(Badge<DeferGC>);
     void undefer_gc(Badge<DeferGC>);
 
+    void did_create_heap_block(Badge<Allocator>, HeapBlock&);
+    void will_destroy_heap_block(Badge<Allocator>, HeapBlock&);
+
 private:
     Cell* allocate_cell(size_t);
 
     void gather_roots(HashTable<Cell*>&);
     void gather_conservative_roots(HashTable<Cell*>&);
-    void mark_live_cells(const HashTable<Cell*>& live_cells);
-    void sweep_dead_cells(bool print_report, const Core::ElapsedTimer&);
+    size_t mark_live_cells(const HashTable<Cell*>& live_cells);
+    void queue_all_blocks_for_sweeping();
+    HeapBlock::SweepResult finish_sweeping();
+    void sweep_next_block();
 
     Allocator& allocator_for_size(size_t);
 
@@ -111,14 +118,25 @@ private:
         }
     }
 
-    size_t m_max_allocations_between_gc { 10000 };
+    static constexpr size_t min_allocations_between_gc = 10000;
+
+    size_t m_max_allocations_between_gc { min_allocations_between_gc };
     size_t m_allocations_since_last_gc { 0 };
 
+    // Blocks left over from the last collection are swept one per this many allocations.
+    size_t m_allocations_per_sweep_slice { 1 };
+    bool m_may_have_blocks_to_sweep { false };
+
     bool m_should_collect_on_every_allocation { false };
 
     VM& m_vm;
 
     Vector<NonnullOwnPtr<Allocator>> m_allocators;
+
+    // Every HeapBlock we own, for telling apart pointers into the heap when scanning the stack.
+    HashTable<HeapBlock*> m_blocks;
+    FlatPtr m_min_block_address { NumericLimits<FlatPtr>::max() };
+    FlatPtr m_max_block_address { 0 };
     HashTable<HandleImpl*> m_handles;
 
     HashTable<MarkedValueList*> m_marked_value_lists;
@@ -25,6 +25,7 @@
  */
 
 #include <AK/Assertions.h>
+#include <AK/Debug.h>
 #include <AK/NonnullOwnPtr.h>
 #include <LibJS/Heap/HeapBlock.h>
 #include <stdio.h>
@@ -72,6 +73,26 @@ HeapBlock::HeapBlock(Heap& heap, size_t cell_size)
     m_freelist = next;
 }
 
+HeapBlock::SweepResult HeapBlock::sweep()
+{
+    SweepResult result;
+    for_each_cell([&](Cell* cell) {
+        if (!cell->is_live())
+            return;
+        if (!cell->is_marked()) {
+#if HEAP_DEBUG
+            dbgln("  ~ {}", cell);
+#endif
+            deallocate(cell);
+            ++result.collected_cells;
+        } else {
+            cell->set_marked(false);
+            ++result.live_cells;
+        }
+    });
+    return result;
+}
+
 void HeapBlock::deallocate(Cell* cell)
 {
     VERIFY(is_valid_cell_pointer(cell));
@@ -57,6 +57,14 @@ public:
 
     void deallocate(Cell*);
 
+    struct SweepResult {
+        size_t live_cells { 0 };
+        size_t collected_cells { 0 };
+    };
+
+    // Frees every live cell that wasn't marked, and clears the mark on the rest.
+    SweepResult sweep();
+
     template<typename Callback>
     void for_each_cell(Callback callback)
     {
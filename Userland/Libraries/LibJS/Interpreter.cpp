@@ -26,6 +26,8 @@
 
 #include <AK/StringBuilder.h>
 #include <LibJS/AST.h>
+#include <LibJS/Bytecode/Generator.h>
+#include <LibJS/Bytecode/Interpreter.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Runtime/GlobalObject.h>
 #include <LibJS/Runtime/LexicalEnvironment.h>
@@ -54,6 +56,14 @@ Interpreter::~Interpreter()
 {
 }
 
+void Interpreter::set_run_bytecode(bool run_bytecode)
+{
+    if (run_bytecode && !m_bytecode_interpreter)
+        m_bytecode_interpreter = make<Bytecode::Interpreter>(*this);
+    else if (!run_bytecode)
+        m_bytecode_interpreter = nullptr;
+}
+
 void Interpreter::run(GlobalObject& global_object, const Program& program)
 {
     auto& vm = this->vm();
@@ -73,7 +83,12 @@ void Interpreter::run(GlobalObject& global_object, const Program& program)
     global_call_frame.is_strict_mode = program.is_strict_mode();
     vm.push_call_frame(global_call_frame, global_object);
     VERIFY(!vm.exception());
-    program.execute(*this, global_object);
+    if (m_bytecode_interpreter) {
+        auto executable = Bytecode::Generator::generate(program);
+        vm.set_last_value({}, m_bytecode_interpreter->run(*executable));
+    } else {
+        program.execute(*this, global_object);
+    }
     vm.pop_call_frame();
 
     // Whatever the promise jobs do should not affect the effective 'last value'.
@@ -28,6 +28,7 @@
 
 #include <AK/FlyString.h>
 #include <AK/HashMap.h>
+#include <AK/OwnPtr.h>
 #include <AK/String.h>
 #include <AK/Vector.h>
 #include <AK/Weakable.h>
@@ -100,6 +101,10 @@ public:
 
     Value execute_statement(GlobalObject&, const Statement&, ScopeType = ScopeType::Block);
 
+    // When enabled, programs and the bodies of script functions are compiled to bytecode and run by the bytecode interpreter.
+    void set_run_bytecode(bool);
+    Bytecode::Interpreter* bytecode_interpreter() { return m_bytecode_interpreter.ptr(); }
+
 private:
     explicit Interpreter(VM&);
 
@@ -111,6 +116,8 @@ private:
     NonnullRefPtr<VM> m_vm;
 
     Handle<Object> m_global_object;
+
+    OwnPtr<Bytecode::Interpreter> m_bytecode_interpreter;
 };
 
 }
@@ -86,12 +86,20 @@ BoundFunction* Function::bind(Value bound_this_value, Vector<Value> arguments)
     return heap().allocate<BoundFunction>(global_object(), global_object(), target_function, bound_this_object, move(all_bound_arguments), computed_length, constructor_prototype);
 }
 
+Shape& Function::instance_shape(Object& prototype)
+{
+    if (!m_instance_shape || m_instance_shape->prototype() != &prototype)
+        m_instance_shape = global_object().new_object_shape()->create_prototype_transition(&prototype);
+    return *m_instance_shape;
+}
+
 void Function::visit_edges(Visitor& visitor)
 {
     Object::visit_edges(visitor);
 
     visitor.visit(m_home_object);
     visitor.visit(m_bound_this);
+    visitor.visit(m_instance_shape);
 
     for (auto argument : m_bound_arguments)
         visitor.visit(argument);
@@ -62,6 +62,10 @@ public:
 
     virtual bool is_strict_mode() const { return false; }
 
+    // The shape objects constructed with this function as new.target start out with.
+    // Reusing it lets all instances share shapes (and inline cache entries) with each other.
+    Shape& instance_shape(Object& prototype);
+
 protected:
     virtual void visit_edges(Visitor&) override;
 
@@ -74,6 +78,7 @@ private:
     Vector<Value> m_bound_arguments;
     Value m_home_object;
     ConstructorKind m_constructor_kind = ConstructorKind::Base;
+    Shape* m_instance_shape { nullptr };
 };
 
 }
@@ -36,6 +36,7 @@
 #include <LibJS/Runtime/NativeFunction.h>
 #include <LibJS/Runtime/NativeProperty.h>
 #include <LibJS/Runtime/Object.h>
+#include <LibJS/Runtime/ProxyObject.h>
 #include <LibJS/Runtime/Shape.h>
 #include <LibJS/Runtime/StringObject.h>
 #include <LibJS/Runtime/Value.h>
@@ -136,9 +137,11 @@ bool Object::set_prototype(Object* new_prototype)
         return false;
     if (shape().is_unique()) {
         shape().set_prototype_without_transition(new_prototype);
+        did_mutate_shape_in_place();
         return true;
     }
     m_shape = m_shape->create_prototype_transition(new_prototype);
+    did_change_shape();
     return true;
 }
 
@@ -346,6 +349,22 @@ void Object::set_shape(Shape& new_shape)
 {
     m_storage.resize(new_shape.property_count());
     m_shape = &new_shape;
+    did_change_shape();
+}
+
+void Object::did_change_shape()
+{
+    if (!m_is_watched_by_lookup_caches)
+        return;
+    m_shape->set_watched_by_lookup_caches();
+    vm().invalidate_property_lookup_caches();
+}
+
+void Object::did_mutate_shape_in_place()
+{
+    // NOTE: A non-unique shape may be shared with objects that caches were keyed on, so check the shape as well.
+    if (m_is_watched_by_lookup_caches || m_shape->is_watched_by_lookup_caches())
+        vm().invalidate_property_lookup_caches();
 }
 
 bool Object::define_property(const StringOrSymbol& property_name, const Object& descriptor, bool throw_exceptions)
@@ -492,6 +511,7 @@ bool Object::put_own_property(Object& this_object, const StringOrSymbol& propert
         m_shape->add_property_without_transition(property_name, attributes);
         m_storage.resize(m_shape->property_count());
         m_storage[m_shape->property_count() - 1] = value;
+        did_mutate_shape_in_place();
         return true;
     }
 
@@ -517,11 +537,13 @@ bool Object::put_own_property(Object& this_object, const StringOrSymbol& propert
         if (m_shape->is_unique()) {
             m_shape->add_property_to_unique_shape(property_name, attributes);
             m_storage.resize(m_shape->property_count());
+            did_mutate_shape_in_place();
         } else if (m_transitions_enabled) {
             set_shape(*m_shape->create_put_transition(property_name, attributes));
         } else {
             m_shape->add_property_without_transition(property_name, attributes);
             m_storage.resize(m_shape->property_count());
+            did_mutate_shape_in_place();
         }
         metadata = shape().lookup(property_name);
         VERIFY(metadata.has_value());
@@ -539,6 +561,7 @@ bool Object::put_own_property(Object& this_object, const StringOrSymbol& propert
     if (mode == PutOwnPropertyMode::DefineProperty && attributes != metadata.value().attributes) {
         if (m_shape->is_unique()) {
             m_shape->reconfigure_property_in_unique_shape(property_name, attributes);
+            did_mutate_shape_in_place();
         } else {
             set_shape(*m_shape->create_configure_transition(property_name, attributes));
         }
@@ -647,6 +670,7 @@ Value Object::delete_property(const PropertyName& property_name)
 
     shape().remove_property_from_unique_shape(property_name.to_string_or_symbol(), deleted_offset);
     m_storage.remove(deleted_offset);
+    did_mutate_shape_in_place();
     return Value(true);
 }
 
@@ -787,6 +811,125 @@ bool Object::put(const PropertyName& property_name, Value value, Value receiver)
     return put_own_property(*this, string_or_symbol, value, default_attributes, PutOwnPropertyMode::Put);
 }
 
+const PropertyLookupCache::Entry* Object::find_property_lookup_cache_entry(const PropertyLookupCache& cache, bool depends_on_prototype_chain) const
+{
+    auto shape_id = shape().id();
+    for (auto& entry : cache.entries) {
+        if (entry.shape_id != shape_id)
+            continue;
+        if ((depends_on_prototype_chain || entry.holder) && entry.epoch != vm().property_lookup_cache_epoch())
+            return nullptr;
+        return &entry;
+    }
+    return nullptr;
+}
+
+void Object::add_property_lookup_cache_entry(PropertyLookupCache& cache, Object* holder, size_t offset)
+{
+    VERIFY(!shape().is_unique());
+    m_shape->set_watched_by_lookup_caches();
+
+    auto& entry = cache.entries[cache.next_entry_to_replace];
+    cache.next_entry_to_replace = (cache.next_entry_to_replace + 1) % PropertyLookupCache::entry_count;
+    entry.shape_id = shape().id();
+    entry.epoch = vm().property_lookup_cache_epoch();
+    entry.holder = holder;
+    entry.offset = offset;
+}
+
+void Object::watch_prototype_chain_until(const Object* last)
+{
+    for (auto* object = shape().prototype(); object; object = object->shape().prototype()) {
+        object->m_is_watched_by_lookup_caches = true;
+        object->m_shape->set_watched_by_lookup_caches();
+        if (object == last)
+            break;
+    }
+}
+
+Value Object::get_with_cache(const PropertyName& property_name, PropertyLookupCache& cache)
+{
+    VERIFY(property_name.is_valid());
+
+    if (auto* entry = find_property_lookup_cache_entry(cache, false)) {
+        auto value = (entry->holder ? entry->holder : this)->m_storage[entry->offset].value_or(js_undefined());
+        if (value.is_accessor())
+            return value.as_accessor().call_getter(this);
+        if (value.is_native_property())
+            return call_native_property_getter(value.as_native_property(), this);
+        return value;
+    }
+
+    if (shape().is_unique() || is<ProxyObject>(*this) || property_name.is_number())
+        return get(property_name);
+
+    // Find the holder up front and start watching the prototypes in between, so that a getter changing
+    // the layout of anything involved bumps the epoch and keeps us from caching a stale result.
+    auto string_or_symbol = property_name.to_string_or_symbol();
+    Object* holder = this;
+    Optional<PropertyMetadata> metadata;
+    while (holder && !is<ProxyObject>(*holder)) {
+        metadata = holder->shape().lookup(string_or_symbol);
+        if (metadata.has_value())
+            break;
+        holder = holder->shape().prototype();
+    }
+    if (metadata.has_value() && holder != this)
+        watch_prototype_chain_until(holder);
+
+    auto* shape_before_get = m_shape;
+    auto epoch = vm().property_lookup_cache_epoch();
+    auto value = get(property_name);
+    if (vm().exception() || !metadata.has_value() || m_shape != shape_before_get || epoch != vm().property_lookup_cache_epoch())
+        return value;
+
+    add_property_lookup_cache_entry(cache, holder == this ? nullptr : holder, metadata.value().offset);
+    return value;
+}
+
+bool Object::put_with_cache(const PropertyName& property_name, Value value, PropertyLookupCache& cache)
+{
+    VERIFY(property_name.is_valid());
+    VERIFY(!value.is_empty());
+
+    if (auto* entry = find_property_lookup_cache_entry(cache, true)) {
+        auto& value_here = m_storage[entry->offset];
+        if (!value_here.is_accessor() && !value_here.is_native_property()) {
+            value_here = value;
+            return true;
+        }
+    }
+
+    if (shape().is_unique() || is<ProxyObject>(*this) || property_name.is_number())
+        return put(property_name, value);
+
+    // Only plain writes to writable own data properties are cached. Since put() looks for setters
+    // along the whole prototype chain first, the property may not appear on any prototype.
+    auto string_or_symbol = property_name.to_string_or_symbol();
+    auto metadata = shape().lookup(string_or_symbol);
+    bool cacheable = metadata.has_value()
+        && metadata.value().attributes.is_writable()
+        && !metadata.value().attributes.has_getter()
+        && !metadata.value().attributes.has_setter();
+    for (auto* object = shape().prototype(); cacheable && object; object = object->shape().prototype()) {
+        if (is<ProxyObject>(*object) || object->shape().lookup(string_or_symbol).has_value())
+            cacheable = false;
+    }
+
+    if (!cacheable)
+        return put(property_name, value);
+
+    watch_prototype_chain_until(nullptr);
+    auto* shape_before_put = m_shape;
+    auto epoch = vm().property_lookup_cache_epoch();
+    auto success = put(property_name, value);
+    if (vm().exception() || m_shape != shape_before_put || epoch != vm().property_lookup_cache_epoch())
+        return success;
+
+    add_property_lookup_cache_entry(cache, nullptr, metadata.value().offset);
+    return success;
+}
+
 bool Object::define_native_function(const StringOrSymbol& property_name, AK::Function<Value(VM&, GlobalObject&)> native_function, i32 length, PropertyAttributes attribute)
 {
     auto& vm = this->vm();
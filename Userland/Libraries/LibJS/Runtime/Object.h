@@ -33,6 +33,7 @@
 #include <LibJS/Runtime/IndexedProperties.h>
 #include <LibJS/Runtime/MarkedValueList.h>
 #include <LibJS/Runtime/PrimitiveString.h>
+#include <LibJS/Runtime/PropertyLookupCache.h>
 #include <LibJS/Runtime/PropertyName.h>
 #include <LibJS/Runtime/Shape.h>
 #include <LibJS/Runtime/Value.h>
@@ -94,6 +95,11 @@ public:
 
     virtual bool put(const PropertyName&, Value, Value receiver = {});
 
+    // Like get() and put(), but remember where the property lives for the current shape in the given
+    // per-site cache. Only meant for non-computed property names, i.e. never for indices.
+    Value get_with_cache(const PropertyName&, PropertyLookupCache&);
+    bool put_with_cache(const PropertyName&, Value, PropertyLookupCache&);
+
     Value get_own_property(const PropertyName&, Value receiver) const;
     Value get_own_properties(const Object& this_object, PropertyKind, bool only_enumerable_properties = false, GetOwnPropertyReturnType = GetOwnPropertyReturnType::StringOnly) const;
     virtual Optional<PropertyDescriptor> get_own_property_descriptor(const PropertyName&) const;
@@ -114,6 +120,7 @@ public:
     virtual bool is_typed_array() const { return false; }
     virtual bool is_string_object() const { return false; }
     virtual bool is_global_object() const { return false; }
+    virtual bool is_proxy_object() const { return false; }
 
     virtual const char* class_name() const override { return "Object"; }
     virtual void visit_edges(Cell::Visitor&) override;
@@ -175,8 +182,16 @@ private:
 
     void set_shape(Shape&);
 
+    const PropertyLookupCache::Entry* find_property_lookup_cache_entry(const PropertyLookupCache&, bool depends_on_prototype_chain) const;
+    void add_property_lookup_cache_entry(PropertyLookupCache&, Object* holder, size_t offset);
+    void watch_prototype_chain_until(const Object* last);
+
+    void did_change_shape();
+    void did_mutate_shape_in_place();
+
     bool m_is_extensible { true };
     bool m_transitions_enabled { true };
+    bool m_is_watched_by_lookup_caches { false };
     Shape* m_shape { nullptr };
     Vector<Value> m_storage;
     IndexedProperties m_indexed_properties;
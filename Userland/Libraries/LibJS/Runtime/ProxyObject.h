@@ -64,6 +64,7 @@ public:
 private:
     virtual void visit_edges(Visitor&) override;
 
+    virtual bool is_proxy_object() const override { return true; }
     virtual bool is_function() const override { return m_target.is_function(); }
     virtual bool is_array() const override { return m_target.is_array(); };
 
@@ -72,4 +73,7 @@ private:
     bool m_is_revoked { false };
 };
 
+template<>
+inline bool Object::fast_is<ProxyObject>() const { return is_proxy_object(); }
+
 }
@@ -67,7 +67,10 @@ void Reference::put(GlobalObject& global_object, Value value)
     if (!object)
         return;
 
-    object->put(m_name, value);
+    if (m_put_cache)
+        object->put_with_cache(m_name, value, *m_put_cache);
+    else
+        object->put(m_name, value);
 }
 
 void Reference::throw_reference_error(GlobalObject& global_object)
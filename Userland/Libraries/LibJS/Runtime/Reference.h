@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/String.h>
+#include <LibJS/Runtime/PropertyLookupCache.h>
 #include <LibJS/Runtime/PropertyName.h>
 #include <LibJS/Runtime/Value.h>
 
@@ -85,6 +86,9 @@ public:
         return m_global_variable;
     }
 
+    // Lets put() cache where the property lives, for references to non-computed properties.
+    void set_put_cache(PropertyLookupCache* cache) { m_put_cache = cache; }
+
     void put(GlobalObject&, Value);
     Value get(GlobalObject&);
 
@@ -96,6 +100,7 @@ private:
     bool m_strict { false };
     bool m_local_variable { false };
     bool m_global_variable { false };
+    PropertyLookupCache* m_put_cache { nullptr };
 };
 
 }
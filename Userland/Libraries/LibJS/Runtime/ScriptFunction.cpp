@@ -26,6 +26,9 @@
 
 #include <AK/Function.h>
 #include <LibJS/AST.h>
+#include <LibJS/Bytecode/Executable.h>
+#include <LibJS/Bytecode/Generator.h>
+#include <LibJS/Bytecode/Interpreter.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Runtime/Array.h>
 #include <LibJS/Runtime/Error.h>
@@ -147,6 +150,14 @@ Value ScriptFunction::execute_function_body()
         vm.current_scope()->put_to_scope(parameter.name, { argument_value, DeclarationKind::Var });
     }
 
+    if (auto* bytecode_interpreter = interpreter->bytecode_interpreter()) {
+        VERIFY(is<ScopeNode>(*m_body));
+        auto& body = static_cast<const ScopeNode&>(*m_body);
+        if (!body.function_executable())
+            body.set_function_executable(Bytecode::Generator::generate_function_body(body));
+        return bytecode_interpreter->run(*body.function_executable());
+    }
+
     return interpreter->execute_statement(global_object(), m_body, ScopeType::Function);
 }
 
@@ -68,17 +68,22 @@ Shape* Shape::create_prototype_transition(Object* new_prototype)
     return heap().allocate_without_global_object<Shape>(*this, new_prototype);
 }
 
+static u64 s_next_shape_id = 1;
+
 Shape::Shape(ShapeWithoutGlobalObjectTag)
+    : m_id(s_next_shape_id++)
 {
 }
 
 Shape::Shape(Object& global_object)
-    : m_global_object(&global_object)
+    : m_id(s_next_shape_id++)
+    , m_global_object(&global_object)
 {
 }
 
 Shape::Shape(Shape& previous_shape, const StringOrSymbol& property_name, PropertyAttributes attributes, TransitionType transition_type)
-    : m_attributes(attributes)
+    : m_id(s_next_shape_id++)
+    , m_attributes(attributes)
     , m_transition_type(transition_type)
     , m_global_object(previous_shape.m_global_object)
     , m_previous(&previous_shape)
@@ -89,7 +94,8 @@ Shape::Shape(Shape& previous_shape, const StringOrSymbol& property_name, Propert
 }
 
 Shape::Shape(Shape& previous_shape, Object* new_prototype)
-    : m_transition_type(TransitionType::Prototype)
+    : m_id(s_next_shape_id++)
+    , m_transition_type(TransitionType::Prototype)
     , m_global_object(previous_shape.m_global_object)
     , m_previous(&previous_shape)
     , m_prototype(new_prototype)
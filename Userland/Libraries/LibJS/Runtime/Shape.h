@@ -75,6 +75,13 @@ public:
 
     void add_property_without_transition(const StringOrSymbol&, PropertyAttributes);
 
+    // Never reused, unlike the address of a Shape, which makes it safe to key caches on.
+    u64 id() const { return m_id; }
+
+    // Set once a PropertyLookupCache relies on this shape's layout staying put.
+    bool is_watched_by_lookup_caches() const { return m_watched_by_lookup_caches; }
+    void set_watched_by_lookup_caches() { m_watched_by_lookup_caches = true; }
+
     bool is_unique() const { return m_unique; }
     Shape* create_unique_clone() const;
 
@@ -106,9 +113,11 @@ private:
 
     void ensure_property_table() const;
 
+    u64 m_id { 0 };
     PropertyAttributes m_attributes { 0 };
     TransitionType m_transition_type : 6 { TransitionType::Invalid };
     bool m_unique : 1 { false };
+    bool m_watched_by_lookup_caches : 1 { false };
 
     Object* m_global_object { nullptr };
 
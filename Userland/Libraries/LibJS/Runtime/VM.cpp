@@ -29,6 +29,7 @@
 #include <AK/ScopeGuard.h>
 #include <AK/StringBuilder.h>
 #include <AK/TemporaryChange.h>
+#include <LibJS/Bytecode/Interpreter.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Runtime/Array.h>
 #include <LibJS/Runtime/Error.h>
@@ -134,6 +135,11 @@ void VM::gather_roots(HashTable<Cell*>& roots)
     for (auto& symbol : m_global_symbol_map)
         roots.set(symbol.value);
 
+    for (auto* interpreter : m_interpreters) {
+        if (auto* bytecode_interpreter = interpreter->bytecode_interpreter())
+            bytecode_interpreter->gather_roots(roots);
+    }
+
     for (auto* job : m_promise_jobs)
         roots.set(job);
 }
@@ -242,18 +248,16 @@ Value VM::construct(Function& function, Function& new_target, Optional<MarkedVal
 
     Object* new_object = nullptr;
     if (function.constructor_kind() == Function::ConstructorKind::Base) {
-        new_object = Object::create_empty(global_object);
-        environment->bind_this_value(global_object, new_object);
+        auto prototype = new_target.get(names.prototype);
         if (exception())
             return {};
-        auto prototype = new_target.get(names.prototype);
+        if (prototype.is_object())
+            new_object = heap().allocate<Object>(global_object, new_target.instance_shape(prototype.as_object()));
+        else
+            new_object = Object::create_empty(global_object);
+        environment->bind_this_value(global_object, new_object);
         if (exception())
             return {};
-        if (prototype.is_object()) {
-            new_object->set_prototype(&prototype.as_object());
-            if (exception())
-                return {};
-        }
     }
 
     // If we are a Derived constructor, |this| has not been constructed before super is called.
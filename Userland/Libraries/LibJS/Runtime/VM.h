@@ -83,6 +83,10 @@ public:
     Interpreter& interpreter();
     Interpreter* interpreter_if_exists();
 
+    // Bumped whenever an object that PropertyLookupCache entries looked through changes its layout.
+    u64 property_lookup_cache_epoch() const { return m_property_lookup_cache_epoch; }
+    void invalidate_property_lookup_caches() { ++m_property_lookup_cache_epoch; }
+
     void push_interpreter(Interpreter&);
     void pop_interpreter(Interpreter&);
 
@@ -283,6 +287,8 @@ private:
 
     Shape* m_scope_object_shape { nullptr };
 
+    u64 m_property_lookup_cache_epoch { 1 };
+
     bool m_underscore_is_last_value { false };
     bool m_should_log_exceptions { false };
 };
@@ -0,0 +1,131 @@
+function getX(o) {
+    return o.x;
+}
+
+function setX(o, value) {
+    o.x = value;
+}
+
+test("same access site with objects of different shapes", () => {
+    const objects = [{ x: 1 }, { y: 0, x: 2 }, { z: 0, y: 0, x: 3 }, { w: 0, z: 0, y: 0, x: 4 }, { v: 0, x: 5 }];
+    for (let i = 0; i < 3; ++i) {
+        objects.forEach((o, index) => {
+            expect(getX(o)).toBe(index + 1);
+        });
+    }
+});
+
+test("property added to a prototype shadows a cached one further up the chain", () => {
+    class A {
+        foo() {
+            return "A";
+        }
+    }
+    class B extends A {}
+    const b = new B();
+    const callFoo = o => o.foo();
+    expect(callFoo(b)).toBe("A");
+    expect(callFoo(b)).toBe("A");
+    B.prototype.foo = () => "B";
+    expect(callFoo(b)).toBe("B");
+    delete B.prototype.foo;
+    expect(callFoo(b)).toBe("A");
+});
+
+test("changing a cached prototype's property value", () => {
+    const proto = { x: 1 };
+    const o = Object.setPrototypeOf({}, proto);
+    expect(getX(o)).toBe(1);
+    proto.x = 2;
+    expect(getX(o)).toBe(2);
+    Object.defineProperty(proto, "x", {
+        get() {
+            return 3;
+        },
+        configurable: true,
+    });
+    expect(getX(o)).toBe(3);
+});
+
+test("changing the prototype of a cached prototype", () => {
+    const a = { x: "a" };
+    const b = { x: "b" };
+    const middle = Object.setPrototypeOf({}, a);
+    const o = Object.setPrototypeOf({}, middle);
+    expect(getX(o)).toBe("a");
+    Object.setPrototypeOf(middle, b);
+    expect(getX(o)).toBe("b");
+});
+
+test("instances of a class share cached lookups", () => {
+    class Point {
+        constructor(x) {
+            this.x = x;
+        }
+    }
+    for (let i = 0; i < 10; ++i) {
+        const point = new Point(i);
+        expect(getX(point)).toBe(i);
+        setX(point, i * 2);
+        expect(point.x).toBe(i * 2);
+    }
+});
+
+test("cached assignment respects setters added to the prototype chain", () => {
+    const proto = {};
+    const o = Object.setPrototypeOf({}, proto);
+    o.x = 1;
+    setX(o, 2);
+    setX(o, 3);
+    expect(o.x).toBe(3);
+    let setterValue;
+    Object.defineProperty(proto, "x", {
+        set(value) {
+            setterValue = value;
+        },
+        configurable: true,
+    });
+    setX(o, 4);
+    expect(setterValue).toBe(4);
+    expect(o.x).toBe(3);
+});
+
+test("cached assignment respects non-writable properties", () => {
+    const o = { x: 1 };
+    setX(o, 2);
+    setX(o, 3);
+    Object.defineProperty(o, "x", { writable: false });
+    setX(o, 4);
+    expect(o.x).toBe(3);
+});
+
+test("getters are called with the receiver", () => {
+    const proto = {
+        get x() {
+            return this.y;
+        },
+    };
+    const first = Object.setPrototypeOf({}, proto);
+    first.y = 1;
+    const second = Object.setPrototypeOf({}, proto);
+    second.y = 2;
+    expect(getX(first)).toBe(1);
+    expect(getX(second)).toBe(2);
+    expect(getX(first)).toBe(1);
+});
+
+test("proxies are not cached", () => {
+    let count = 0;
+    const proxy = new Proxy(
+        { x: 1 },
+        {
+            get(target, property) {
+                ++count;
+                return target[property];
+            },
+        }
+    );
+    expect(getX(proxy)).toBe(1);
+    expect(getX(proxy)).toBe(1);
+    expect(count).toBe(2);
+});
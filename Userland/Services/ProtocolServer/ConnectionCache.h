@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2021, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Debug.h>
+#include <AK/HashMap.h>
+#include <AK/NonnullOwnPtrVector.h>
+#include <AK/String.h>
+#include <AK/URL.h>
+#include <AK/Vector.h>
+#include <LibCore/TCPSocket.h>
+#include <LibCore/Timer.h>
+#include <LibTLS/TLSv12.h>
+
+namespace ProtocolServer::ConnectionCache {
+
+struct ConnectionKey {
+    String hostname;
+    u16 port { 0 };
+
+    bool operator==(const ConnectionKey& other) const
+    {
+        return hostname == other.hostname && port == other.port;
+    }
+};
+
+}
+
+namespace AK {
+template<>
+struct Traits<ProtocolServer::ConnectionCache::ConnectionKey> : public GenericTraits<ProtocolServer::ConnectionCache::ConnectionKey> {
+    static unsigned hash(const ProtocolServer::ConnectionCache::ConnectionKey& key) { return pair_int_hash(key.hostname.hash(), key.port); }
+};
+}
+
+namespace ProtocolServer::ConnectionCache {
+
+// Requests beyond this many to the same host wait for one of the existing connections to free up.
+constexpr size_t max_connections_per_host = 4;
+constexpr int idle_connection_timeout_ms = 10'000;
+
+template<typename SocketType>
+struct Connection {
+    explicit Connection(NonnullRefPtr<SocketType> socket)
+        : socket(move(socket))
+    {
+    }
+
+    NonnullRefPtr<SocketType> socket;
+    // Jobs waiting for this connection. Each one returns false if its job went away while waiting.
+    Vector<Function<bool(Connection&)>> request_queue;
+    RefPtr<Core::Timer> idle_timer;
+    bool is_busy { false };
+};
+
+template<typename SocketType>
+using ConnectionList = NonnullOwnPtrVector<Connection<SocketType>>;
+
+template<typename SocketType>
+HashMap<ConnectionKey, ConnectionList<SocketType>>& connections()
+{
+    static HashMap<ConnectionKey, ConnectionList<SocketType>> s_connections;
+    return s_connections;
+}
+
+template<typename SocketType>
+void remove_connection(const ConnectionKey& key, Connection<SocketType>& connection)
+{
+    auto it = connections<SocketType>().find(key);
+    if (it == connections<SocketType>().end())
+        return;
+    it->value.remove_first_matching([&](auto& entry) { return entry.ptr() == &connection; });
+    if (it->value.is_empty())
+        connections<SocketType>().remove(it);
+}
+
+template<typename SocketType>
+Connection<SocketType>* find_connection(const ConnectionKey& key, const SocketType& socket)
+{
+    auto it = connections<SocketType>().find(key);
+    if (it == connections<SocketType>().end())
+        return nullptr;
+    for (auto& connection : it->value) {
+        if (connection.socket.ptr() == &socket)
+            return &connection;
+    }
+    return nullptr;
+}
+
+template<typename SocketType>
+void drop_idle_connection(const ConnectionKey& key, Connection<SocketType>& connection)
+{
+    if (connection.is_busy)
+        return;
+    dbgln_if(CONNECTIONCACHE_DEBUG, "ConnectionCache: Dropping idle connection to {}:{}", key.hostname, key.port);
+    remove_connection(key, connection);
+}
+
+template<typename Callback>
+void watch_idle_socket(Core::TCPSocket& socket, Callback callback)
+{
+    socket.on_ready_to_read = [callback] { callback(); };
+}
+
+template<typename Callback>
+void watch_idle_socket(TLS::TLSv12& socket, Callback callback)
+{
+    socket.on_tls_ready_to_read = [callback](auto&) { callback(); };
+    socket.on_tls_error = [callback](auto) { callback(); };
+    socket.on_tls_finished = [callback] { callback(); };
+}
+
+template<typename SocketType>
+void make_idle(const ConnectionKey& key, Connection<SocketType>& connection)
+{
+    connection.is_busy = false;
+    auto* connection_ptr = &connection;
+    // Nothing should arrive on a connection that has no request in flight, so anything that does
+    // is the server closing it (or misbehaving), and the connection is of no more use to us.
+    watch_idle_socket(*connection.socket, [key, connection_ptr] {
+        connection_ptr->socket->deferred_invoke([key, connection_ptr](auto&) {
+            drop_idle_connection(key, *connection_ptr);
+        });
+    });
+    connection.idle_timer->restart(idle_connection_timeout_ms);
+}
+
+template<typename SocketType>
+void did_release_connection(const ConnectionKey&, SocketType&, bool can_reuse_connection);
+
+template<typename JobType, typename SocketType>
+void run_job(const ConnectionKey& key, Connection<SocketType>& connection, JobType& job)
+{
+    connection.is_busy = true;
+    connection.idle_timer->stop();
+    auto* socket = connection.socket.ptr();
+    job.on_socket_released = [key, socket](bool can_reuse_connection) {
+        // The job usually lets go from inside one of the socket's callbacks, so wait for that to return.
+        socket->deferred_invoke([key, can_reuse_connection](auto& object) {
+            did_release_connection(key, static_cast<SocketType&>(object), can_reuse_connection);
+        });
+    };
+    job.start(connection.socket);
+}
+
+template<typename SocketType>
+void did_release_connection(const ConnectionKey& key, SocketType& socket, bool can_reuse_connection)
+{
+    auto* connection = find_connection(key, socket);
+    if (!connection)
+        return;
+
+    if (!can_reuse_connection) {
+        if (connection->request_queue.is_empty()) {
+            dbgln_if(CONNECTIONCACHE_DEBUG, "ConnectionCache: Closing connection to {}:{}", key.hostname, key.port);
+            remove_connection(key, *connection);
+            return;
+        }
+        // Someone is still waiting on this connection, so give them a fresh socket to work with.
+        connection->socket = SocketType::construct(nullptr);
+    }
+
+    while (!connection->request_queue.is_empty()) {
+        auto start_next_job = connection->request_queue.take_first();
+        if (start_next_job(*connection))
+            return;
+    }
+
+    if (!can_reuse_connection) {
+        // All the jobs we made a new socket for went away before getting to use it.
+        remove_connection(key, *connection);
+        return;
+    }
+
+    dbgln_if(CONNECTIONCACHE_DEBUG, "ConnectionCache: Keeping connection to {}:{} around for reuse", key.hostname, key.port);
+    make_idle(key, *connection);
+}
+
+template<typename SocketType>
+Connection<SocketType>& create_connection(const ConnectionKey& key, ConnectionList<SocketType>& list)
+{
+    auto connection = make<Connection<SocketType>>(SocketType::construct(nullptr));
+    auto* connection_ptr = connection.ptr();
+    connection->idle_timer = Core::Timer::create_single_shot(idle_connection_timeout_ms, [key, connection_ptr] {
+        drop_idle_connection(key, *connection_ptr);
+    });
+    list.append(move(connection));
+    return *connection_ptr;
+}
+
+template<typename JobType>
+void start_job(JobType& job, const URL& url)
+{
+    using SocketType = typename JobType::SocketType;
+    // The key only covers the host and port, so connections set up differently can't go into the pool.
+    if constexpr (requires { job.overrides_ca_certificates(); }) {
+        if (job.overrides_ca_certificates()) {
+            job.start();
+            return;
+        }
+    }
+
+    ConnectionKey key { url.host(), url.port() };
+    auto& list = connections<SocketType>().ensure(key);
+
+    for (auto& connection : list) {
+        if (!connection.is_busy) {
+            dbgln_if(CONNECTIONCACHE_DEBUG, "ConnectionCache: Reusing idle connection to {}:{}", key.hostname, key.port);
+            run_job(key, connection, job);
+            return;
+        }
+    }
+
+    if (list.size() < max_connections_per_host) {
+        dbgln_if(CONNECTIONCACHE_DEBUG, "ConnectionCache: Opening connection {} to {}:{}", list.size() + 1, key.hostname, key.port);
+        run_job(key, create_connection(key, list), job);
+        return;
+    }
+
+    // Every connection to this host is busy, so line up behind whichever has the fewest jobs waiting.
+    auto* least_busy_connection = &list.first();
+    for (auto& connection : list) {
+        if (connection.request_queue.size() < least_busy_connection->request_queue.size())
+            least_busy_connection = &connection;
+    }
+    dbgln_if(CONNECTIONCACHE_DEBUG, "ConnectionCache: Queueing request to {}:{} behind {} others", key.hostname, key.port, least_busy_connection->request_queue.size() + 1);
+    least_busy_connection->request_queue.append([key, weak_job = job.template make_weak_ptr<JobType>()](Connection<SocketType>& connection) {
+        if (!weak_job)
+            return false;
+        run_job(key, connection, *weak_job.ptr());
+        return true;
+    });
+}
+
+}
@@ -35,6 +35,7 @@
 #include <AK/Types.h>
 #include <LibHTTP/HttpRequest.h>
 #include <ProtocolServer/ClientConnection.h>
+#include <ProtocolServer/ConnectionCache.h>
 #include <ProtocolServer/Download.h>
 
 namespace ProtocolServer::Detail {
@@ -96,7 +97,7 @@ OwnPtr<Download> start_download(TBadgedProtocol&& protocol, ClientConnection& cl
     auto job = TJob::construct(request, *output_stream);
     auto download = TDownload::create_with_job(forward<TBadgedProtocol>(protocol), client, (TJob&)*job, move(output_stream));
     download->set_download_fd(pipe_result.value().read_fd);
-    job->start();
+    ConnectionCache::start_job(*job, url);
     return download;
 }
 
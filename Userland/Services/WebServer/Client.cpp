@@ -29,15 +29,17 @@
 #include <AK/LexicalPath.h>
 #include <AK/MappedFile.h>
 #include <AK/MemoryStream.h>
+#include <AK/Optional.h>
 #include <AK/StringBuilder.h>
 #include <AK/URLParser.h>
 #include <LibCore/DateTime.h>
 #include <LibCore/DirIterator.h>
 #include <LibCore/File.h>
-#include <LibCore/FileStream.h>
 #include <LibCore/MimeData.h>
 #include <LibHTTP/HttpRequest.h>
+#include <errno.h>
 #include <stdio.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
@@ -67,6 +69,8 @@ void Client::start()
 
         dbgln("Got raw request: '{}'", String::copy(raw_request));
 
+        // The response is written out synchronously, so don't let writes give up when the socket's send buffer fills up.
+        m_socket->set_blocking(true);
         handle_request(raw_request.bytes());
         die();
     };
@@ -127,12 +131,10 @@ void Client::handle_request(ReadonlyBytes raw_request)
         return;
     }
 
-    Core::InputFileStream stream { file };
-
-    send_response(stream, request, Core::guess_mime_type_based_on_filename(real_path));
+    send_file_response(file, request, Core::guess_mime_type_based_on_filename(real_path));
 }
 
-void Client::send_response(InputStream& response, const HTTP::HttpRequest& request, const String& content_type)
+void Client::send_response_headers(const HTTP::HttpRequest& request, const String& content_type, Optional<u64> content_length)
 {
     StringBuilder builder;
     builder.append("HTTP/1.0 200 OK\r\n");
@@ -142,10 +144,43 @@ void Client::send_response(InputStream& response, const HTTP::HttpRequest& reque
     builder.append("Content-Type: ");
     builder.append(content_type);
     builder.append("\r\n");
+    if (content_length.has_value())
+        builder.appendff("Content-Length: {}\r\n", content_length.value());
     builder.append("\r\n");
 
     m_socket->write(builder.to_string());
     log_response(200, request);
+}
+
+void Client::send_file_response(Core::File& file, const HTTP::HttpRequest& request, const String& content_type)
+{
+    struct stat st;
+    if (fstat(file.fd(), &st) < 0) {
+        perror("fstat");
+        send_error_response(500, "Internal server error!", request);
+        return;
+    }
+
+    send_response_headers(request, content_type, st.st_size);
+
+    // Let the kernel move the file contents into the socket without bouncing them through our buffers.
+    off_t offset = 0;
+    while (offset < st.st_size) {
+        ssize_t nsent = sendfile(m_socket->fd(), file.fd(), &offset, st.st_size - offset);
+        if (nsent < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("sendfile");
+            return;
+        }
+        if (nsent == 0)
+            break;
+    }
+}
+
+void Client::send_response(InputStream& response, const HTTP::HttpRequest& request, const String& content_type)
+{
+    send_response_headers(request, content_type);
 
     char buffer[PAGE_SIZE];
     do {
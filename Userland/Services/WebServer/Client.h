@@ -26,6 +26,8 @@
 
 #pragma once
 
+#include <AK/Optional.h>
+#include <LibCore/Forward.h>
 #include <LibCore/Object.h>
 #include <LibCore/TCPSocket.h>
 #include <LibHTTP/Forward.h>
@@ -42,7 +44,9 @@ private:
     Client(NonnullRefPtr<Core::TCPSocket>, const String&, Core::Object* parent);
 
     void handle_request(ReadonlyBytes);
+    void send_response_headers(const HTTP::HttpRequest&, const String& content_type, Optional<u64> content_length = {});
     void send_response(InputStream&, const HTTP::HttpRequest&, const String& content_type);
+    void send_file_response(Core::File&, const HTTP::HttpRequest&, const String& content_type);
     void send_redirect(StringView redirect, const HTTP::HttpRequest& request);
     void send_error_response(unsigned code, const StringView& message, const HTTP::HttpRequest&);
     void die();
@@ -24,59 +24,172 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/MappedFile.h>
+#include <AK/MemoryStream.h>
+#include <AK/NonnullRefPtrVector.h>
 #include <LibCompress/Gzip.h>
 #include <LibCore/ArgsParser.h>
+#include <LibCore/File.h>
 #include <LibCore/FileStream.h>
+#include <LibThread/Thread.h>
 #include <unistd.h>
 
+// Every thread compresses blocks of this size, primed with the end of the preceding block so that back
+// references work across block boundaries just like they would when compressing on a single thread.
+static constexpr size_t parallel_block_size = 128 * KiB;
+
+static ByteBuffer read_block(Core::File& file, size_t size)
+{
+    auto block = ByteBuffer::create_uninitialized(size);
+    size_t nread = 0;
+    while (nread < size) {
+        auto buffer = file.read(size - nread);
+        if (buffer.is_empty())
+            break;
+        nread += buffer.bytes().copy_to(block.bytes().slice(nread));
+    }
+    block.trim(nread);
+    return block;
+}
+
+static bool compress_file(Core::File& input_file, OutputStream& output_stream, Compress::DeflateCompressor::CompressionLevel compression_level)
+{
+    Compress::GzipCompressor gzip_stream { output_stream, compression_level };
+
+    for (;;) {
+        auto block = read_block(input_file, parallel_block_size);
+        if (block.is_empty())
+            break;
+        if (!gzip_stream.write_or_error(block)) {
+            gzip_stream.abandon();
+            return false;
+        }
+    }
+
+    gzip_stream.final_flush();
+    return !gzip_stream.handle_any_error() && !input_file.has_error();
+}
+
+static bool compress_file_in_parallel(Core::File& input_file, OutputStream& output_stream, Compress::DeflateCompressor::CompressionLevel compression_level, size_t thread_count)
+{
+    Compress::GzipCompressor gzip_stream { output_stream, compression_level };
+    ByteBuffer previous_block;
+
+    for (;;) {
+        // We only hold one block per thread (and its output) at a time, so memory use stays bounded for any input size
+        Vector<ByteBuffer> blocks;
+        for (size_t i = 0; i < thread_count; ++i) {
+            auto block = read_block(input_file, parallel_block_size);
+            if (block.is_empty())
+                break;
+            blocks.append(move(block));
+        }
+        if (blocks.is_empty())
+            break;
+
+        Vector<Optional<ByteBuffer>> compressed_blocks;
+        compressed_blocks.resize(blocks.size());
+
+        NonnullRefPtrVector<LibThread::Thread> threads;
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            auto dictionary = i == 0 ? previous_block.bytes() : blocks[i - 1].bytes();
+            threads.append(LibThread::Thread::construct([&, i, dictionary] {
+                DuplexMemoryStream compressed_stream;
+                auto deflate_stream = make<Compress::DeflateCompressor>(compressed_stream, compression_level);
+                deflate_stream->preset_dictionary(dictionary);
+                deflate_stream->write_or_error(blocks[i]);
+                deflate_stream->sync_flush();
+                if (!deflate_stream->handle_any_error())
+                    compressed_blocks[i] = compressed_stream.copy_into_contiguous_buffer();
+                return 0;
+            }));
+            threads.last().start();
+        }
+
+        // The blocks are written in order as their threads finish
+        bool failed = false;
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            [[maybe_unused]] auto result = threads[i].join();
+            // The remaining threads still use the blocks, so we can only bail out once all of them are done
+            if (failed)
+                continue;
+            if (!compressed_blocks[i].has_value() || !gzip_stream.write_precompressed(blocks[i], compressed_blocks[i].value()))
+                failed = true;
+        }
+        if (failed) {
+            gzip_stream.abandon();
+            return false;
+        }
+
+        previous_block = move(blocks.last());
+    }
+
+    gzip_stream.final_flush();
+    return !gzip_stream.handle_any_error() && !input_file.has_error();
+}
+
 int main(int argc, char** argv)
 {
     Vector<const char*> filenames;
     bool keep_input_files { false };
     bool write_to_stdout { false };
+    bool fast { false };
+    bool best { false };
+    int thread_count = sysconf(_SC_NPROCESSORS_ONLN);
 
     Core::ArgsParser args_parser;
     args_parser.add_option(keep_input_files, "Keep (don't delete) input files", "keep", 'k');
     args_parser.add_option(write_to_stdout, "Write to stdout, keep original files unchanged", "stdout", 'c');
+    args_parser.add_option(fast, "Compress faster at the cost of a worse compression ratio", "fast", 0);
+    args_parser.add_option(best, "Compress better at the cost of taking longer", "best", 0);
+    args_parser.add_option(thread_count, "Number of threads to compress with (defaults to the number of processors)", "threads", 'j', "count");
     args_parser.add_positional_argument(filenames, "File to compress", "FILE");
     args_parser.parse(argc, argv);
 
     if (write_to_stdout)
         keep_input_files = true;
 
+    auto compression_level = Compress::DeflateCompressor::CompressionLevel::GOOD;
+    if (fast)
+        compression_level = Compress::DeflateCompressor::CompressionLevel::FAST;
+    else if (best)
+        compression_level = Compress::DeflateCompressor::CompressionLevel::GREAT;
+
     for (const String& input_filename : filenames) {
         auto output_filename = String::formatted("{}.gz", input_filename);
 
-        // We map the whole file instead of streaming to reduce size overhead (gzip header) and increase the deflate block size (better compression)
-        // TODO: automatically fallback to buffered streaming for very large files
-        auto file_or_error = MappedFile::map(input_filename);
-        if (file_or_error.is_error()) {
-            warnln("Failed opening input file for reading: {}", file_or_error.error());
-            return 1;
-        }
-        auto file = file_or_error.value();
-
-        auto compressed_file = Compress::GzipCompressor::compress_all(file->bytes());
-        if (!compressed_file.has_value()) {
-            warnln("Failed gzip compressing input file");
+        auto input_file_or_error = Core::File::open(input_filename, Core::IODevice::ReadOnly);
+        if (input_file_or_error.is_error()) {
+            warnln("Failed opening input file for reading: {}", input_file_or_error.error());
             return 1;
         }
+        auto input_file = input_file_or_error.value();
 
         auto success = false;
+        // The deflate stream is written a few bits at a time, so the output has to be buffered
+        auto compress_to = [&](auto& output_stream) {
+            bool compressed;
+            if (thread_count > 1)
+                compressed = compress_file_in_parallel(*input_file, output_stream, compression_level, thread_count);
+            else
+                compressed = compress_file(*input_file, output_stream, compression_level);
+            output_stream.flush();
+            bool output_failed = output_stream.handle_any_error();
+            return compressed && !output_failed;
+        };
+
         if (write_to_stdout) {
-            auto stdout = Core::OutputFileStream { Core::File::standard_output() };
-            success = stdout.write_or_error(compressed_file.value());
+            auto stdout = Core::OutputFileStream::stdout_buffered();
+            success = compress_to(stdout);
         } else {
-            auto output_stream_result = Core::OutputFileStream::open(output_filename);
+            auto output_stream_result = Core::OutputFileStream::open_buffered(output_filename);
             if (output_stream_result.is_error()) {
                 warnln("Failed opening output file for writing: {}", output_stream_result.error());
                 return 1;
             }
-            success = output_stream_result.value().write_or_error(compressed_file.value());
+            success = compress_to(output_stream_result.value());
         }
         if (!success) {
-            warnln("Failed writing compressed file to output");
+            warnln("Failed gzip compressing input file");
             return 1;
         }
 
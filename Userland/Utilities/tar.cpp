@@ -204,6 +204,8 @@ int main(int argc, char** argv)
         }
 
         tar_stream.finish();
+        if (gzip)
+            gzip_stream.final_flush();
 
         return 0;
     }
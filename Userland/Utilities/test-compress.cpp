@@ -29,6 +29,8 @@
 #include <AK/Array.h>
 #include <AK/MemoryStream.h>
 #include <AK/Random.h>
+#include <AK/String.h>
+#include <AK/StringBuilder.h>
 #include <LibCompress/Deflate.h>
 #include <LibCompress/Gzip.h>
 #include <LibCompress/Zlib.h>
@@ -170,6 +172,95 @@ TEST_CASE(deflate_round_trip_compress_large)
     EXPECT(uncompressed.value() == original);
 }
 
+TEST_CASE(deflate_round_trip_output_much_larger_than_input)
+{
+    // Zeroes compress extremely well, so the output has to outgrow the initial buffer decompress_all() guesses from the input size
+    auto original = ByteBuffer::create_zeroed(1 * MiB);
+    auto compressed = Compress::DeflateCompressor::compress_all(original, Compress::DeflateCompressor::CompressionLevel::FAST);
+    EXPECT(compressed.has_value());
+    EXPECT(compressed.value().size() * 4 < original.size());
+    auto uncompressed = Compress::DeflateDecompressor::decompress_all(compressed.value());
+    EXPECT(uncompressed.has_value());
+    EXPECT(uncompressed.value() == original);
+}
+
+static ByteBuffer generate_text_like_data(size_t size)
+{
+    // A small vocabulary of random "words" compresses like real text: plenty of back references of all lengths
+    // and distances, interleaved with literals.
+    Vector<String> words;
+    for (size_t i = 0; i < 1024; ++i) {
+        u8 letters[13];
+        fill_with_random(letters, sizeof(letters));
+        StringBuilder builder;
+        for (size_t j = 0; j <= letters[0] % 12; ++j)
+            builder.append('a' + letters[j + 1] % 26);
+        words.append(builder.to_string());
+    }
+
+    Vector<u16> picks;
+    picks.resize(size);
+    fill_with_random(picks.data(), picks.size() * sizeof(u16));
+
+    auto data = ByteBuffer::create_uninitialized(size);
+    size_t offset = 0;
+    for (size_t i = 0; offset < size; ++i) {
+        auto& word = words[picks[i] % words.size()];
+        offset += word.bytes().copy_trimmed_to(data.bytes().slice(offset));
+        if (offset < size)
+            data[offset++] = ' ';
+    }
+    return data;
+}
+
+TEST_CASE(deflate_decompress_streaming_matches_all)
+{
+    auto original = generate_text_like_data(256 * KiB);
+    auto compressed = Compress::DeflateCompressor::compress_all(original, Compress::DeflateCompressor::CompressionLevel::FAST);
+    EXPECT(compressed.has_value());
+
+    auto uncompressed = Compress::DeflateDecompressor::decompress_all(compressed.value());
+    EXPECT(uncompressed.has_value());
+    EXPECT(uncompressed.value() == original);
+
+    // Read in odd-sized chunks, so that reads end in the middle of back references.
+    InputMemoryStream memory_stream { compressed.value() };
+    Compress::DeflateDecompressor deflate_stream { memory_stream };
+    auto streamed = ByteBuffer::create_uninitialized(original.size());
+    size_t nread = 0;
+    while (!deflate_stream.has_any_error() && !deflate_stream.unreliable_eof() && nread < streamed.size())
+        nread += deflate_stream.read(streamed.bytes().slice(nread, min<size_t>(777, streamed.size() - nread)));
+    EXPECT(!deflate_stream.handle_any_error());
+    EXPECT(nread == original.size());
+    EXPECT(streamed == original);
+}
+
+TEST_CASE(deflate_round_trip_sync_flushed_pieces)
+{
+    // Pieces compressed separately (with the preceding data as their dictionary) concatenate into a single deflate stream
+    auto original = generate_text_like_data(100 * KiB);
+    auto first_half = original.bytes().trim(original.size() / 2);
+    auto second_half = original.bytes().slice(original.size() / 2);
+
+    DuplexMemoryStream first_stream;
+    auto first_compressor = make<Compress::DeflateCompressor>(first_stream);
+    first_compressor->write_or_error(first_half);
+    first_compressor->sync_flush();
+
+    DuplexMemoryStream second_stream;
+    auto second_compressor = make<Compress::DeflateCompressor>(second_stream);
+    second_compressor->preset_dictionary(first_half);
+    second_compressor->write_or_error(second_half);
+    second_compressor->final_flush();
+
+    auto compressed = first_stream.copy_into_contiguous_buffer();
+    auto second_piece = second_stream.copy_into_contiguous_buffer();
+    compressed.append(second_piece.data(), second_piece.size());
+    auto uncompressed = Compress::DeflateDecompressor::decompress_all(compressed);
+    EXPECT(uncompressed.has_value());
+    EXPECT(uncompressed.value() == original);
+}
+
 TEST_CASE(deflate_compress_literals)
 {
     // This byte array is known to not produce any back references with our lz77 implementation even at the highest compression settings
@@ -268,6 +359,33 @@ TEST_CASE(gzip_decompress_repeat_around_buffer)
     EXPECT(uncompressed == decompressed.value().bytes());
 }
 
+TEST_CASE(gzip_round_trip_streaming)
+{
+    auto original = generate_text_like_data(200 * KiB);
+    DuplexMemoryStream output_stream;
+    Compress::GzipCompressor gzip_stream { output_stream };
+    for (size_t offset = 0; offset < original.size(); offset += 3000)
+        EXPECT(gzip_stream.write_or_error(original.bytes().slice(offset, min<size_t>(3000, original.size() - offset))));
+    gzip_stream.final_flush();
+    EXPECT(!gzip_stream.handle_any_error());
+
+    auto uncompressed = Compress::GzipDecompressor::decompress_all(output_stream.copy_into_contiguous_buffer());
+    EXPECT(uncompressed.has_value());
+    EXPECT(uncompressed.value() == original);
+}
+
+TEST_CASE(gzip_abandon_unfinished_stream)
+{
+    // Callers give up on the stream after a write error, which must not trip the compressors' destructors
+    auto original = generate_text_like_data(200 * KiB);
+    DuplexMemoryStream output_stream;
+    Compress::GzipCompressor gzip_stream { output_stream };
+    EXPECT(gzip_stream.write_or_error(original));
+    gzip_stream.set_fatal_error();
+    gzip_stream.abandon();
+    EXPECT(!gzip_stream.has_any_error());
+}
+
 TEST_CASE(gzip_round_trip)
 {
     auto original = ByteBuffer::create_uninitialized(1024);
@@ -279,4 +397,17 @@ TEST_CASE(gzip_round_trip)
     EXPECT(uncompressed.value() == original);
 }
 
+BENCHMARK_CASE(deflate_decompress_throughput)
+{
+    auto original = generate_text_like_data(4 * MiB);
+    auto compressed = Compress::DeflateCompressor::compress_all(original, Compress::DeflateCompressor::CompressionLevel::FAST);
+    EXPECT(compressed.has_value());
+
+    for (size_t i = 0; i < 10; ++i) {
+        auto uncompressed = Compress::DeflateDecompressor::decompress_all(compressed.value());
+        EXPECT(uncompressed.has_value());
+        EXPECT(uncompressed.value().size() == original.size());
+    }
+}
+
 TEST_MAIN(Compress)
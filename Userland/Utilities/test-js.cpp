@@ -50,6 +50,7 @@
 RefPtr<JS::VM> vm;
 
 static bool collect_on_every_allocation = false;
+static bool run_bytecode = false;
 static String currently_running_test;
 
 struct ParserError {
@@ -279,6 +280,7 @@ JSFileResult TestRunner::run_file_test(const String& test_path)
     JS::VM::InterpreterExecutionScope scope(*interpreter);
 
     interpreter->heap().set_should_collect_on_every_allocation(collect_on_every_allocation);
+    interpreter->set_run_bytecode(run_bytecode);
 
     if (!m_test_program) {
         auto result = parse_file(String::formatted("{}/test-common.js", m_test_root));
@@ -715,6 +717,7 @@ int main(int argc, char** argv)
         },
     });
     args_parser.add_option(collect_on_every_allocation, "Collect garbage after every allocation", "collect-often", 'g');
+    args_parser.add_option(run_bytecode, "Run the tests on the bytecode interpreter", "run-bytecode", 'b');
     args_parser.add_option(test262_parser_tests, "Run test262 parser tests", "test262-parser-tests", 0);
     args_parser.add_positional_argument(specified_test_root, "Tests root directory", "path", Core::ArgsParser::Required::No);
     args_parser.parse(argc, argv);